@@ -34,6 +34,13 @@ serverName = "YurOTS"
 statusTimeout = 5000
 replaceKickOnLogin = true
 maxPacketsPerSecond = 50
+-- NOTE: send queue limits are in bytes/messages waiting to be written
+-- to a client, 0 disables a limit. Above the soft limit some redundant
+-- updates (creature health) are held back, above a max the client is
+-- disconnected.
+sendQueueSoftLimit = 256 * 1024
+maxSendQueueBytes = 4 * 1024 * 1024
+maxSendQueueMessages = 1024
 autoStackCumulatives = true
 moneyRate = 1
 runesCharges = 2
@@ -64,6 +71,31 @@ mysqlPass = ""
 mysqlDatabase = "yurots"
 mysqlPort = 3306
 mysqlSock = ""
+-- NOTE: each database worker opens its own connection. Work for one
+-- player or house always runs on the same worker, in order.
+databaseWorkers = 4
+-- NOTE: small writes such as online status and ban history are committed
+-- in one transaction, up to databaseBatchSize at a time. A batch waits at
+-- most databaseBatchDelay milliseconds for more writes to join it.
+databaseBatchSize = 50
+databaseBatchDelay = 5
+-- NOTE: playerJournal appends the progress of online players to
+-- data/journal/ every playerJournalInterval milliseconds, so a crash loses
+-- at most that much instead of everything since the last save. Whatever a
+-- crashed run left there is written to the database on the next startup.
+playerJournal = true
+playerJournalInterval = 1000
+-- NOTE: accounts, characters and bans are kept in memory so logins do not
+-- query the database. Changes made by the website show up after at most
+-- loginCacheRefreshInterval milliseconds (0 = only at startup), new
+-- accounts and changed passwords are looked up right away.
+loginCacheRefreshInterval = 60000
+-- NOTE: asyncPlayerLoad reads a logging in character on the database
+-- workers in parallel instead of on the game thread. The character an
+-- account will most likely pick is read as soon as it asks for its
+-- character list and kept for playerPrewarmTime milliseconds (0 = never).
+asyncPlayerLoad = true
+playerPrewarmTime = 10000
 
 -- Misc.
 allowChangeOutfit = true
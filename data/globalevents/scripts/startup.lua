@@ -66,8 +66,8 @@ function onStartup()
 	if resultId ~= false then
 		repeat
 			local accountId = result.getDataInt(resultId, "account_id")
-			db.asyncQuery("INSERT INTO `account_ban_history` (`account_id`, `reason`, `banned_at`, `expired_at`, `banned_by`) VALUES (" .. accountId .. ", " .. db.escapeString(result.getDataString(resultId, "reason")) .. ", " .. result.getDataLong(resultId, "banned_at") .. ", " .. result.getDataLong(resultId, "expires_at") .. ", " .. result.getDataInt(resultId, "banned_by") .. ")")
-			db.asyncQuery("DELETE FROM `account_bans` WHERE `account_id` = " .. accountId)
+			db.batchQuery("INSERT INTO `account_ban_history` (`account_id`, `reason`, `banned_at`, `expired_at`, `banned_by`) VALUES (" .. accountId .. ", " .. db.escapeString(result.getDataString(resultId, "reason")) .. ", " .. result.getDataLong(resultId, "banned_at") .. ", " .. result.getDataLong(resultId, "expires_at") .. ", " .. result.getDataInt(resultId, "banned_by") .. ")")
+			db.batchQuery("DELETE FROM `account_bans` WHERE `account_id` = " .. accountId)
 		until not result.next(resultId)
 		result.free(resultId)
 	end
@@ -23,14 +23,6 @@ function onSay(player, words, param)
 		return false
 	end
 
-	resultId = db.storeQuery("SELECT 1 FROM `ip_bans` WHERE `ip` = " .. targetIp)
-	if resultId ~= false then
-		result.free(resultId)
-		return false
-	end
-
-	local timeNow = os.time()
-	db.query("INSERT INTO `ip_bans` (`ip`, `reason`, `banned_at`, `expires_at`, `banned_by`) VALUES (" ..
-			targetIp .. ", '', " .. timeNow .. ", " .. timeNow + (ipBanDays * 86400) .. ", " .. player:getGuid() .. ")")
+	Game.addIpBan(targetIp, "", os.time() + (ipBanDays * 86400), player)
 	return false
 end
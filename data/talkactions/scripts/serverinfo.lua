@@ -1,8 +1,77 @@
+local maxSendQueues = 10
+
+-- decay busy time and clock of the previous report, so each one covers the
+-- time since the one before
+local lastDecayBusyTime = 0
+local lastDecayTime = os.mtime()
+
+-- diagnostic sections shown to staff, "!serverinfo <section>" shows one
+local sections = {
+	{name = "sendqueues", send = function(player, stats)
+		local queues = {}
+		for name, queue in pairs(stats.sendQueues) do
+			queue.name = name
+			table.insert(queues, queue)
+		end
+
+		table.sort(queues, function(a, b) return a.peakBytes > b.peakBytes end)
+
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, "Send queues (current / peak):")
+		for i = 1, math.min(maxSendQueues, #queues) do
+			local queue = queues[i]
+			player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, ("%s: %d msgs, %d bytes / %d msgs, %d bytes"):format(queue.name, queue.messages, queue.bytes, queue.peakMessages, queue.peakBytes))
+		end
+	end},
+	{name = "pools", send = function(player, stats)
+		for _, pool in ipairs(stats.objectPools) do
+			local occupancy = pool.capacity > 0 and pool.inUse * 100 / pool.capacity or 0
+			player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, ("%s (%d B): %d in use (%.1f%% of %d, peak %d), %d allocations, %d outside the pool."):format(pool.name, pool.objectSize, pool.inUse, occupancy, pool.capacity, pool.peakInUse, pool.allocations, pool.fallbacks))
+		end
+	end},
+	{name = "database", send = function(player, stats)
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, "Database workers (queued / peak, executed, busy, commits / batches, latency avg / peak):")
+		for i, worker in ipairs(stats.databaseWorkers) do
+			player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, ("#%d: %d / %d, %d tasks, %d ms, %d / %d, %.1f / %.1f ms"):format(i, worker.queued, worker.peakQueued, worker.executed, worker.busyTime, worker.commits, worker.batches, worker.averageLatency, worker.peakLatency))
+		end
+
+		-- the game thread time is what the other players wait for
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, "Player loads (logins, prewarmed, game thread avg, total avg):")
+		for _, mode in ipairs({"sync", "async"}) do
+			local load = stats.playerLoads[mode]
+			player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, ("%s: %d, %d, %.2f ms, %.2f ms"):format(mode, load.logins, load.prewarmed, load.dispatcherTime, load.totalTime))
+		end
+	end},
+	{name = "decay", send = function(player, stats)
+		local decay = stats.decay
+		local now = os.mtime()
+		local elapsed = math.max(1, now - lastDecayTime)
+		local busy = decay.busyTime - lastDecayBusyTime
+		lastDecayBusyTime = decay.busyTime
+		lastDecayTime = now
+
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, ("Decay: %d items queued, %d expired in %d passes, %.2f ms per pass."):format(decay.queued, decay.expired, decay.passes, decay.passes > 0 and decay.busyTime / decay.passes / 1000 or 0))
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, ("%.2f ms of game thread time per second over the last %d s."):format(busy / elapsed, elapsed / 1000))
+	end}
+}
+
 function onSay(player, words, param)
-	player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, "Server Info:"
-					.. "\nExp rate: " .. Game.getExperienceStage(player:getLevel())
-					.. "\nSkill rate: " .. configManager.getNumber(configKeys.RATE_SKILL)
-					.. "\nMagic rate: " .. configManager.getNumber(configKeys.RATE_MAGIC)
-					.. "\nLoot rate: " .. configManager.getNumber(configKeys.RATE_LOOT))
+	if param == "" then
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, "Server Info:"
+						.. "\nExp rate: " .. Game.getExperienceStage(player:getLevel())
+						.. "\nSkill rate: " .. configManager.getNumber(configKeys.RATE_SKILL)
+						.. "\nMagic rate: " .. configManager.getNumber(configKeys.RATE_MAGIC)
+						.. "\nLoot rate: " .. configManager.getNumber(configKeys.RATE_LOOT))
+	end
+
+	if not player:getGroup():getAccess() then
+		return false
+	end
+
+	local stats = Game.getServerStats()
+	for _, section in ipairs(sections) do
+		if param == "" or param == section.name then
+			section.send(player, stats)
+		end
+	end
 	return false
 end
@@ -8,8 +8,8 @@ function onSay(player, words, param)
 		return false
 	end
 
-	db.asyncQuery("DELETE FROM `account_bans` WHERE `account_id` = " .. result.getDataInt(resultId, "account_id"))
-	db.asyncQuery("DELETE FROM `ip_bans` WHERE `ip` = " .. result.getDataInt(resultId, "lastip"))
+	Game.removeAccountBan(result.getDataInt(resultId, "account_id"))
+	Game.removeIpBan(result.getDataLong(resultId, "lastip"))
 	result.free(resultId)
 	player:sendTextMessage(MESSAGE_EVENT_ADVANCE, param .. " has been unbanned.")
 	return false
@@ -17,6 +17,7 @@
 #include "ban.h"
 #include "database.h"
 #include "databasetasks.h"
+#include "logincache.h"
 #include "tools.h"
 
 bool Ban::acceptConnection(uint32_t clientip)
@@ -55,32 +56,30 @@ bool Ban::acceptConnection(uint32_t clientip)
 
 bool IOBan::isAccountBanned(uint32_t accountId, BanInfo& banInfo)
 {
-	Database* db = Database::getInstance();
-
-	std::ostringstream query;
-	query << "SELECT `reason`, `expires_at`, `banned_at`, `banned_by`, (SELECT `name` FROM `players` WHERE `id` = `banned_by`) AS `name` FROM `account_bans` WHERE `account_id` = " << accountId;
-
-	DBResult_ptr result = db->storeQuery(query.str());
-	if (!result) {
+	CachedBan ban;
+	if (!g_loginCache.getAccountBan(accountId, ban)) {
 		return false;
 	}
 
-	int64_t expiresAt = result->getNumber<int64_t>("expires_at");
-	if (expiresAt != 0 && time(nullptr) > expiresAt) {
+	if (ban.expiresAt != 0 && time(nullptr) > ban.expiresAt) {
 		// Move the ban to history if it has expired
-		query.str(std::string());
-		query << "INSERT INTO `account_ban_history` (`account_id`, `reason`, `banned_at`, `expired_at`, `banned_by`) VALUES (" << accountId << ',' << db->escapeString(result->getString("reason")) << ',' << result->getNumber<time_t>("banned_at") << ',' << expiresAt << ',' << result->getNumber<uint32_t>("banned_by") << ')';
-		g_databaseTasks.addTask(query.str());
+		Database* db = Database::getInstance();
+
+		std::ostringstream query;
+		query << "INSERT INTO `account_ban_history` (`account_id`, `reason`, `banned_at`, `expired_at`, `banned_by`) VALUES (" << accountId << ',' << db->escapeString(ban.reason) << ',' << ban.bannedAt << ',' << ban.expiresAt << ',' << ban.bannedById << ')';
+		g_databaseTasks.addBatchedTask(query.str());
 
 		query.str(std::string());
 		query << "DELETE FROM `account_bans` WHERE `account_id` = " << accountId;
-		g_databaseTasks.addTask(query.str());
+		g_databaseTasks.addBatchedTask(query.str());
+
+		g_loginCache.removeAccountBan(accountId);
 		return false;
 	}
 
-	banInfo.expiresAt = expiresAt;
-	banInfo.reason = result->getString("reason");
-	banInfo.bannedBy = result->getString("name");
+	banInfo.expiresAt = ban.expiresAt;
+	banInfo.reason = ban.reason;
+	banInfo.bannedBy = ban.bannedBy;
 	return true;
 }
 
@@ -90,33 +89,91 @@ bool IOBan::isIpBanned(uint32_t clientip, BanInfo& banInfo)
 		return false;
 	}
 
-	Database* db = Database::getInstance();
-
-	std::ostringstream query;
-	query << "SELECT `reason`, `expires_at`, (SELECT `name` FROM `players` WHERE `id` = `banned_by`) AS `name` FROM `ip_bans` WHERE `ip` = " << clientip;
-
-	DBResult_ptr result = db->storeQuery(query.str());
-	if (!result) {
+	CachedBan ban;
+	if (!g_loginCache.getIpBan(clientip, ban)) {
 		return false;
 	}
 
-	int64_t expiresAt = result->getNumber<int64_t>("expires_at");
-	if (expiresAt != 0 && time(nullptr) > expiresAt) {
-		query.str(std::string());
+	if (ban.expiresAt != 0 && time(nullptr) > ban.expiresAt) {
+		std::ostringstream query;
 		query << "DELETE FROM `ip_bans` WHERE `ip` = " << clientip;
-		g_databaseTasks.addTask(query.str());
+		g_databaseTasks.addBatchedTask(query.str());
+
+		g_loginCache.removeIpBan(clientip);
 		return false;
 	}
 
-	banInfo.expiresAt = expiresAt;
-	banInfo.reason = result->getString("reason");
-	banInfo.bannedBy = result->getString("name");
+	banInfo.expiresAt = ban.expiresAt;
+	banInfo.reason = ban.reason;
+	banInfo.bannedBy = ban.bannedBy;
 	return true;
 }
 
 bool IOBan::isPlayerNamelocked(uint32_t playerId)
+{
+	return g_loginCache.isNamelocked(playerId);
+}
+
+bool IOBan::addAccountBan(uint32_t accountId, const std::string& reason, time_t expiresAt, uint32_t bannedById, const std::string& bannedBy)
+{
+	CachedBan ban;
+	if (g_loginCache.getAccountBan(accountId, ban)) {
+		return false;
+	}
+
+	ban.reason = reason;
+	ban.bannedBy = bannedBy;
+	ban.bannedAt = time(nullptr);
+	ban.expiresAt = expiresAt;
+	ban.bannedById = bannedById;
+
+	Database* db = Database::getInstance();
+
+	std::ostringstream query;
+	query << "INSERT INTO `account_bans` (`account_id`, `reason`, `banned_at`, `expires_at`, `banned_by`) VALUES (" << accountId << ',' << db->escapeString(reason) << ',' << ban.bannedAt << ',' << expiresAt << ',' << bannedById << ')';
+	g_databaseTasks.addBatchedTask(query.str());
+
+	g_loginCache.setAccountBan(accountId, ban);
+	return true;
+}
+
+void IOBan::removeAccountBan(uint32_t accountId)
 {
 	std::ostringstream query;
-	query << "SELECT 1 FROM `player_namelocks` WHERE `player_id` = " << playerId;
-	return Database::getInstance()->storeQuery(query.str()).get() != nullptr;
+	query << "DELETE FROM `account_bans` WHERE `account_id` = " << accountId;
+	g_databaseTasks.addBatchedTask(query.str());
+
+	g_loginCache.removeAccountBan(accountId);
+}
+
+bool IOBan::addIpBan(uint32_t ip, const std::string& reason, time_t expiresAt, uint32_t bannedById, const std::string& bannedBy)
+{
+	CachedBan ban;
+	if (ip == 0 || g_loginCache.getIpBan(ip, ban)) {
+		return false;
+	}
+
+	ban.reason = reason;
+	ban.bannedBy = bannedBy;
+	ban.bannedAt = time(nullptr);
+	ban.expiresAt = expiresAt;
+	ban.bannedById = bannedById;
+
+	Database* db = Database::getInstance();
+
+	std::ostringstream query;
+	query << "INSERT INTO `ip_bans` (`ip`, `reason`, `banned_at`, `expires_at`, `banned_by`) VALUES (" << ip << ',' << db->escapeString(reason) << ',' << ban.bannedAt << ',' << expiresAt << ',' << bannedById << ')';
+	g_databaseTasks.addBatchedTask(query.str());
+
+	g_loginCache.setIpBan(ip, ban);
+	return true;
+}
+
+void IOBan::removeIpBan(uint32_t ip)
+{
+	std::ostringstream query;
+	query << "DELETE FROM `ip_bans` WHERE `ip` = " << ip;
+	g_databaseTasks.addBatchedTask(query.str());
+
+	g_loginCache.removeIpBan(ip);
 }
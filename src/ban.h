@@ -48,6 +48,13 @@ class IOBan
 		static bool isAccountBanned(uint32_t accountId, BanInfo& banInfo);
 		static bool isIpBanned(uint32_t ip, BanInfo& banInfo);
 		static bool isPlayerNamelocked(uint32_t playerId);
+
+		// write the ban and update the login cache, add fails if there is
+		// already a ban
+		static bool addAccountBan(uint32_t accountId, const std::string& reason, time_t expiresAt, uint32_t bannedById, const std::string& bannedBy);
+		static void removeAccountBan(uint32_t accountId);
+		static bool addIpBan(uint32_t ip, const std::string& reason, time_t expiresAt, uint32_t bannedById, const std::string& bannedBy);
+		static void removeIpBan(uint32_t ip);
 };
 
 #endif
@@ -94,22 +94,8 @@ bool BedItem::canUse(Player* player)
 		return false;
 	}
 
-	if (sleeperGUID == 0) {
-		return true;
-	}
-
-	if (house->getHouseAccessLevel(player) == HOUSE_OWNER) {
-		return true;
-	}
-
-	Player sleeper(nullptr);
-	if (!IOLoginData::loadPlayerById(&sleeper, sleeperGUID)) {
-		return false;
-	}
-
-	if (house->getHouseAccessLevel(&sleeper) > house->getHouseAccessLevel(player)) {
-		return false;
-	}
+	// an occupied bed is only freed by its owner, trySleep turns anyone
+	// else away whatever the sleeper's access to the house is
 	return true;
 }
 
@@ -178,14 +164,24 @@ void BedItem::wakeUp(Player* player)
 	}
 
 	if (sleeperGUID != 0) {
+		const uint32_t sleptTime = time(nullptr) - sleepStart;
 		if (!player) {
-			Player regenPlayer(nullptr);
-			if (IOLoginData::loadPlayerById(&regenPlayer, sleeperGUID)) {
-				regeneratePlayer(&regenPlayer);
-				IOLoginData::savePlayer(&regenPlayer);
-			}
+			// the sleeper is read on the database workers and regenerated
+			// once it is in, unless it logged in meanwhile
+			IOLoginData::loadOfflinePlayer(sleeperGUID, [sleptTime](Player* sleeper) {
+				if (!sleeper) {
+					return;
+				}
+
+				regeneratePlayer(sleeper, sleptTime);
+				if (sleeper->isOffline()) {
+					IOLoginData::savePlayer(sleeper);
+				} else {
+					g_game.addCreatureHealth(sleeper);
+				}
+			});
 		} else {
-			regeneratePlayer(player);
+			regeneratePlayer(player, sleptTime);
 			g_game.addCreatureHealth(player);
 		}
 	}
@@ -210,10 +206,8 @@ void BedItem::wakeUp(Player* player)
 	}
 }
 
-void BedItem::regeneratePlayer(Player* player) const
+void BedItem::regeneratePlayer(Player* player, uint32_t sleptTime)
 {
-	const uint32_t sleptTime = time(nullptr) - sleepStart;
-
 	Condition* condition = player->getCondition(CONDITION_REGENERATION, CONDITIONID_DEFAULT);
 	if (condition) {
 		uint32_t regen;
@@ -60,7 +60,7 @@ class BedItem final : public Item
 
 	protected:
 		void updateAppearance(const Player* player);
-		void regeneratePlayer(Player* player) const;
+		static void regeneratePlayer(Player* player, uint32_t sleptTime);
 		void internalSetSleeper(const Player* player);
 		void internalRemoveSleeper();
 
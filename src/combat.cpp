@@ -19,10 +19,27 @@
 #include "game.h"
 #include "configmanager.h"
 #include "monster.h"
+#include "objectpool.h"
 
 extern Game g_game;
 extern ConfigManager g_config;
 
+static ObjectPool& getMagicFieldPool()
+{
+	static ObjectPool& pool = ObjectPool::create("MagicField", sizeof(MagicField));
+	return pool;
+}
+
+void* MagicField::operator new(size_t size)
+{
+	return getMagicFieldPool().allocate(size);
+}
+
+void MagicField::operator delete(void* object, size_t size)
+{
+	getMagicFieldPool().deallocate(object, size);
+}
+
 CombatDamage Combat::getCombatDamage(Creature* creature) const
 {
 	CombatDamage damage;
@@ -369,6 +369,10 @@ class MagicField final : public Item
 	public:
 		explicit MagicField(uint16_t type) : Item(type), createTime(OTSYS_TIME()) {}
 
+		// allocated from the magic field pool
+		static void* operator new(size_t size);
+		static void operator delete(void* object, size_t size);
+
 		MagicField* getMagicField() final {
 			return this;
 		}
@@ -16,9 +16,68 @@
 
 #include "condition.h"
 #include "game.h"
+#include "objectpool.h"
 
 extern Game g_game;
 
+// condition types of the same size share a pool
+static ObjectPool* getConditionPool(size_t size)
+{
+	static const std::map<size_t, ObjectPool*> pools = [] {
+		const std::pair<const char*, size_t> types[] = {
+			{"ConditionGeneric", sizeof(ConditionGeneric)},
+			{"ConditionAttributes", sizeof(ConditionAttributes)},
+			{"ConditionRegeneration", sizeof(ConditionRegeneration)},
+			{"ConditionSoul", sizeof(ConditionSoul)},
+			{"ConditionInvisible", sizeof(ConditionInvisible)},
+			{"ConditionDamage", sizeof(ConditionDamage)},
+			{"ConditionSpeed", sizeof(ConditionSpeed)},
+			{"ConditionOutfit", sizeof(ConditionOutfit)},
+			{"ConditionLight", sizeof(ConditionLight)},
+		};
+
+		std::map<size_t, std::string> names;
+		for (const auto& type : types) {
+			std::string& name = names[type.second];
+			if (!name.empty()) {
+				name.push_back('/');
+			}
+			name += type.first;
+		}
+
+		std::map<size_t, ObjectPool*> pools;
+		for (const auto& it : names) {
+			pools[it.first] = &ObjectPool::create(it.second, it.first);
+		}
+		return pools;
+	}();
+
+	auto it = pools.find(size);
+	if (it == pools.end()) {
+		return nullptr;
+	}
+	return it->second;
+}
+
+void* Condition::operator new(size_t size)
+{
+	ObjectPool* pool = getConditionPool(size);
+	if (!pool) {
+		return ::operator new(size);
+	}
+	return pool->allocate(size);
+}
+
+void Condition::operator delete(void* object, size_t size)
+{
+	ObjectPool* pool = getConditionPool(size);
+	if (!pool) {
+		::operator delete(object);
+		return;
+	}
+	pool->deallocate(object, size);
+}
+
 bool Condition::setParam(ConditionParam_t param, int32_t value)
 {
 	switch (param) {
@@ -71,6 +71,10 @@ class Condition
 			subId(subId), ticks(ticks),	conditionType(type), id(id) {}
 		virtual ~Condition() = default;
 
+		// allocated from the pool of conditions of the same size
+		static void* operator new(size_t size);
+		static void operator delete(void* object, size_t size);
+
 		virtual bool startCondition(Creature* creature);
 		virtual bool executeCondition(Creature* creature, int32_t interval);
 		virtual void endCondition(Creature* creature) = 0;
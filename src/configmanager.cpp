@@ -43,6 +43,7 @@ bool ConfigManager::load()
 	if (!loaded) { //info that must be loaded one time (unless we reset the modules involved)
 		boolean[BIND_ONLY_GLOBAL_ADDRESS] = getGlobalBoolean(L, "bindOnlyGlobalAddress", false);
 		boolean[OPTIMIZE_DATABASE] = getGlobalBoolean(L, "startupDatabaseOptimization", true);
+		boolean[PLAYER_JOURNAL] = getGlobalBoolean(L, "playerJournal", true);
 
 		string[IP] = getGlobalString(L, "ip", "127.0.0.1");
 		string[MAP_NAME] = getGlobalString(L, "mapName", "forgotten");
@@ -55,6 +56,11 @@ bool ConfigManager::load()
 		string[MYSQL_SOCK] = getGlobalString(L, "mysqlSock", "");
 
 		integer[SQL_PORT] = getGlobalNumber(L, "mysqlPort", 3306);
+		integer[DATABASE_WORKERS] = getGlobalNumber(L, "databaseWorkers", 4);
+		integer[DATABASE_BATCH_SIZE] = getGlobalNumber(L, "databaseBatchSize", 50);
+		integer[DATABASE_BATCH_DELAY] = getGlobalNumber(L, "databaseBatchDelay", 5);
+		integer[PLAYER_JOURNAL_INTERVAL] = getGlobalNumber(L, "playerJournalInterval", 1000);
+		integer[LOGIN_CACHE_REFRESH_INTERVAL] = getGlobalNumber(L, "loginCacheRefreshInterval", 60000);
 		integer[GAME_PORT] = getGlobalNumber(L, "gameProtocolPort", 7172);
 		integer[LOGIN_PORT] = getGlobalNumber(L, "loginProtocolPort", 7171);
 		integer[STATUS_PORT] = getGlobalNumber(L, "statusProtocolPort", 7171);
@@ -74,6 +80,7 @@ bool ConfigManager::load()
 	boolean[TELEPORT_NEWBIES] = getGlobalBoolean(L, "teleportNewbies", true);
 	boolean[STACK_CUMULATIVES] = getGlobalBoolean(L, "autoStackCumulatives", false);
 	boolean[QUERY_PLAYER_CONTAINERS] = getGlobalBoolean(L, "queryPlayerContainers", false);
+	boolean[ASYNC_PLAYER_LOAD] = getGlobalBoolean(L, "asyncPlayerLoad", true);
 
 	string[DEFAULT_PRIORITY] = getGlobalString(L, "defaultPriority", "high");
 	string[SERVER_NAME] = getGlobalString(L, "serverName", "");
@@ -102,6 +109,7 @@ bool ConfigManager::load()
 	integer[PROTECTION_LEVEL] = getGlobalNumber(L, "protectionLevel", 1);
 	integer[DEATH_LOSE_PERCENT] = getGlobalNumber(L, "deathLosePercent", -1);
 	integer[STATUSQUERY_TIMEOUT] = getGlobalNumber(L, "statusTimeout", 5000);
+	integer[PLAYER_PREWARM_TIME] = getGlobalNumber(L, "playerPrewarmTime", 10000);
 	integer[WHITE_SKULL_TIME] = getGlobalNumber(L, "whiteSkullTime", 15 * 60);
 	integer[RED_SKULL_TIME] = getGlobalNumber(L, "redSkullTime", 30 * 24 * 60 * 60);
 	integer[KILLS_DAY_RED_SKULL] = getGlobalNumber(L, "killsDayRedSkull", 3);
@@ -116,6 +124,9 @@ bool ConfigManager::load()
 	integer[NEWBIE_TOWN] = getGlobalNumber(L, "newbieTownId", 1);
 	integer[NEWBIE_LEVEL_THRESHOLD] = getGlobalNumber(L, "newbieLevelThreshold", 5);
 	integer[MONEY_RATE] = getGlobalNumber(L, "moneyRate", 1);
+	integer[SEND_QUEUE_SOFT_LIMIT] = getGlobalNumber(L, "sendQueueSoftLimit", 256 * 1024);
+	integer[MAX_SEND_QUEUE_BYTES] = getGlobalNumber(L, "maxSendQueueBytes", 4 * 1024 * 1024);
+	integer[MAX_SEND_QUEUE_MESSAGES] = getGlobalNumber(L, "maxSendQueueMessages", 1024);
 
 
 	loaded = true;
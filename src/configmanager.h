@@ -36,6 +36,8 @@ class ConfigManager
 			TELEPORT_NEWBIES,
 			STACK_CUMULATIVES,
 			QUERY_PLAYER_CONTAINERS,
+			PLAYER_JOURNAL,
+			ASYNC_PLAYER_LOAD,
 
 			LAST_BOOLEAN_CONFIG /* this must be the last one */
 		};
@@ -101,6 +103,15 @@ class ConfigManager
 			MONEY_RATE,
 			EXTRA_ONLINE,
 			RUNES_CHARGES,
+			SEND_QUEUE_SOFT_LIMIT,
+			MAX_SEND_QUEUE_BYTES,
+			MAX_SEND_QUEUE_MESSAGES,
+			DATABASE_WORKERS,
+			DATABASE_BATCH_SIZE,
+			DATABASE_BATCH_DELAY,
+			PLAYER_JOURNAL_INTERVAL,
+			LOGIN_CACHE_REFRESH_INTERVAL,
+			PLAYER_PREWARM_TIME,
 			LAST_INTEGER_CONFIG /* this must be the last one */
 		};
 
@@ -223,16 +223,43 @@ void Connection::send(const OutputMessage_ptr& msg)
 		return;
 	}
 
+	const uint32_t maxBytes = g_config.getNumber(ConfigManager::MAX_SEND_QUEUE_BYTES);
+	const uint32_t maxMessages = g_config.getNumber(ConfigManager::MAX_SEND_QUEUE_MESSAGES);
+	if ((maxBytes != 0 && queueStats.bytes + msg->getLength() > maxBytes) || (maxMessages != 0 && queueStats.messages + 1 > maxMessages)) {
+		std::cout << convertIPToString(getIP()) << " disconnected for exceeding send queue limit (" << queueStats.messages << " messages, " << queueStats.bytes << " bytes pending)." << std::endl;
+		close(FORCE_CLOSE);
+		return;
+	}
+
 	bool noPendingWrite = messageQueue.empty();
 	messageQueue.emplace_back(msg);
+	queueStats.bytes += msg->getLength();
+	queueStats.peakBytes = std::max(queueStats.peakBytes, queueStats.bytes);
+	queueStats.peakMessages = std::max<uint32_t>(queueStats.peakMessages, ++queueStats.messages);
 	if (noPendingWrite) {
 		internalSend(msg);
 	}
 }
 
+bool Connection::isSendQueueCongested()
+{
+	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
+	const uint32_t softLimit = g_config.getNumber(ConfigManager::SEND_QUEUE_SOFT_LIMIT);
+	return softLimit != 0 && queueStats.bytes > softLimit;
+}
+
+SendQueueStats Connection::getSendQueueStats()
+{
+	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
+	return queueStats;
+}
+
 void Connection::internalSend(const OutputMessage_ptr& msg)
 {
+	// headers and padding are only added now, keep the byte count in step
+	const uint32_t unwrappedLength = msg->getLength();
 	protocol->onSendMessage(msg);
+	queueStats.bytes += msg->getLength() - unwrappedLength;
 	try {
 		writeTimer.expires_from_now(boost::posix_time::seconds(CONNECTION_WRITE_TIMEOUT));
 		writeTimer.async_wait(std::bind(&Connection::handleTimeout, std::weak_ptr<Connection>(shared_from_this()),
@@ -265,10 +292,14 @@ void Connection::onWriteOperation(const boost::system::error_code& error)
 {
 	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
 	writeTimer.cancel();
+	queueStats.bytes -= messageQueue.front()->getLength();
+	--queueStats.messages;
 	messageQueue.pop_front();
 
 	if (error) {
 		messageQueue.clear();
+		queueStats.bytes = 0;
+		queueStats.messages = 0;
 		close(FORCE_CLOSE);
 		return;
 	}
@@ -35,6 +35,13 @@ class ServicePort;
 typedef std::shared_ptr<ServicePort> ServicePort_ptr;
 typedef std::shared_ptr<const ServicePort> ConstServicePort_ptr;
 
+struct SendQueueStats {
+	uint32_t bytes = 0;
+	uint32_t messages = 0;
+	uint32_t peakBytes = 0;
+	uint32_t peakMessages = 0;
+};
+
 class ConnectionManager
 {
 	public:
@@ -90,6 +97,11 @@ class Connection : public std::enable_shared_from_this<Connection>
 
 		void send(const OutputMessage_ptr& msg);
 
+		// true while the queued output is above the soft limit, protocols may
+		// then hold back updates that a later packet makes redundant
+		bool isSendQueueCongested();
+		SendQueueStats getSendQueueStats();
+
 		uint32_t getIP();
 
 	private:
@@ -116,6 +128,7 @@ class Connection : public std::enable_shared_from_this<Connection>
 		std::recursive_mutex connectionLock;
 
 		std::list<OutputMessage_ptr> messageQueue;
+		SendQueueStats queueStats;
 
 		ConstServicePort_ptr service_port;
 		Protocol_ptr protocol;
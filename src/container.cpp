@@ -17,9 +17,26 @@
 #include "container.h"
 #include "iomap.h"
 #include "game.h"
+#include "objectpool.h"
 
 extern Game g_game;
 
+static ObjectPool& getContainerPool()
+{
+	static ObjectPool& pool = ObjectPool::create("Container", sizeof(Container));
+	return pool;
+}
+
+void* Container::operator new(size_t size)
+{
+	return getContainerPool().allocate(size);
+}
+
+void Container::operator delete(void* object, size_t size)
+{
+	getContainerPool().deallocate(object, size);
+}
+
 Container::Container(uint16_t type) :
 	Container(type, items[type].maxItems) {}
 
@@ -43,6 +60,9 @@ Item* Container::clone() const
 		clone->addItem(item->clone());
 	}
 	clone->totalWeight = totalWeight;
+	clone->heldItems = heldItems;
+	clone->heldWorth = heldWorth;
+	clone->heldItemCounts = heldItemCounts;
 	return clone;
 }
 
@@ -109,6 +129,7 @@ bool Container::unserializeItemNode(FileLoader& f, NODE node, PropStream& propSt
 
 		addItem(item);
 		updateItemWeight(item->getWeight());
+		updateHeldItems(item, true);
 
 		nodeItem = f.getNextNode(nodeItem, type);
 	}
@@ -123,6 +144,89 @@ void Container::updateItemWeight(int32_t diff)
 	}
 }
 
+// a nested container counts with everything it holds, the change applies
+// to every container up the tree like the weight does
+void Container::updateHeldItems(const Item* item, bool added)
+{
+	const Container* container = item->getContainer();
+	const uint32_t items = 1 + (container ? container->heldItems : 0);
+	const uint64_t worth = item->getWorth() + (container ? container->heldWorth : 0);
+
+	for (Container* parent = this; parent; parent = parent->getParentContainer()) {
+		if (added) {
+			parent->heldItems += items;
+			parent->heldWorth += worth;
+		} else {
+			parent->heldItems -= items;
+			parent->heldWorth -= worth;
+		}
+
+		parent->updateHeldItemCount(item->getID(), item->getItemCount(), added);
+		if (container) {
+			for (const auto& heldItemCount : container->heldItemCounts) {
+				parent->updateHeldItemCount(heldItemCount.first, heldItemCount.second, added);
+			}
+		}
+	}
+}
+
+void Container::updateHeldItemCount(uint16_t itemId, uint32_t count, bool added)
+{
+	if (count == 0) {
+		return;
+	}
+
+	auto it = std::lower_bound(heldItemCounts.begin(), heldItemCounts.end(), itemId,
+		[](const HeldItemCounts::value_type& heldItemCount, uint16_t id) { return heldItemCount.first < id; });
+	if (added) {
+		if (it != heldItemCounts.end() && it->first == itemId) {
+			it->second += count;
+		} else {
+			heldItemCounts.emplace(it, itemId, count);
+		}
+	} else if (it != heldItemCounts.end() && it->first == itemId) {
+		if (it->second > count) {
+			it->second -= count;
+		} else {
+			heldItemCounts.erase(it);
+		}
+	}
+}
+
+uint32_t Container::getHeldItemCount(uint16_t itemId) const
+{
+	auto it = std::lower_bound(heldItemCounts.begin(), heldItemCounts.end(), itemId,
+		[](const HeldItemCounts::value_type& heldItemCount, uint16_t id) { return heldItemCount.first < id; });
+	if (it == heldItemCounts.end() || it->first != itemId) {
+		return 0;
+	}
+	return it->second;
+}
+
+bool Container::checkHeldItems() const
+{
+	uint32_t items = 0;
+	uint64_t worth = 0;
+	std::map<uint16_t, uint32_t> counts;
+	for (ContainerIterator it = iterator(); it.hasNext(); it.advance()) {
+		Item* item = *it;
+		++items;
+		worth += item->getWorth();
+		if (item->getItemCount() != 0) {
+			counts[item->getID()] += item->getItemCount();
+		}
+
+		if (Container* container = item->getContainer()) {
+			if (!container->checkHeldItems()) {
+				return false;
+			}
+		}
+	}
+
+	return items == heldItems && worth == heldWorth &&
+		HeldItemCounts(counts.begin(), counts.end()) == heldItemCounts;
+}
+
 uint32_t Container::getWeight() const
 {
 	return Item::getWeight() + totalWeight;
@@ -168,15 +272,6 @@ Item* Container::getItemByIndex(size_t index) const
 	return itemlist[index];
 }
 
-uint32_t Container::getItemHoldingCount() const
-{
-	uint32_t counter = 0;
-	for (ContainerIterator it = iterator(); it.hasNext(); it.advance()) {
-		++counter;
-	}
-	return counter;
-}
-
 bool Container::isHoldingItem(const Item* item) const
 {
 	for (ContainerIterator it = iterator(); it.hasNext(); it.advance()) {
@@ -449,6 +544,7 @@ void Container::addThing(int32_t index, Thing* thing)
 	item->setParent(this);
 	itemlist.push_front(item);
 	updateItemWeight(item->getWeight());
+	updateHeldItems(item, true);
 
 	//send change to client
 	if (getParent() && (getParent() != VirtualCylinder::virtualCylinder)) {
@@ -460,6 +556,7 @@ void Container::addItemBack(Item* item)
 {
 	addItem(item);
 	updateItemWeight(item->getWeight());
+	updateHeldItems(item, true);
 
 	//send change to client
 	if (getParent() && (getParent() != VirtualCylinder::virtualCylinder)) {
@@ -480,9 +577,11 @@ void Container::updateThing(Thing* thing, uint16_t itemId, uint32_t count)
 	}
 
 	const int32_t oldWeight = item->getWeight();
+	updateHeldItems(item, false);
 	item->setID(itemId);
 	item->setSubType(count);
 	updateItemWeight(-oldWeight + item->getWeight());
+	updateHeldItems(item, true);
 
 	//send change to client
 	if (getParent()) {
@@ -502,9 +601,11 @@ void Container::replaceThing(uint32_t index, Thing* thing)
 		return /*RETURNVALUE_NOTPOSSIBLE*/;
 	}
 
+	updateHeldItems(replacedItem, false);
 	itemlist[index] = item;
 	item->setParent(this);
 	updateItemWeight(-static_cast<int32_t>(replacedItem->getWeight()) + item->getWeight());
+	updateHeldItems(item, true);
 
 	//send change to client
 	if (getParent()) {
@@ -529,8 +630,10 @@ void Container::removeThing(Thing* thing, uint32_t count)
 	if (item->isStackable() && count != item->getItemCount()) {
 		uint8_t newCount = static_cast<uint8_t>(std::max<int32_t>(0, item->getItemCount() - count));
 		const int32_t oldWeight = item->getWeight();
+		updateHeldItems(item, false);
 		item->setItemCount(newCount);
 		updateItemWeight(-oldWeight + item->getWeight());
+		updateHeldItems(item, true);
 
 		//send change to client
 		if (getParent()) {
@@ -538,6 +641,7 @@ void Container::removeThing(Thing* thing, uint32_t count)
 		}
 	} else {
 		updateItemWeight(-static_cast<int32_t>(item->getWeight()));
+		updateHeldItems(item, false);
 
 		//send change to client
 		if (getParent()) {
@@ -640,6 +744,7 @@ void Container::internalAddThing(uint32_t, Thing* thing)
 	item->setParent(this);
 	itemlist.push_front(item);
 	updateItemWeight(item->getWeight());
+	updateHeldItems(item, true);
 }
 
 void Container::startDecaying()
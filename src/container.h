@@ -23,6 +23,9 @@
 class Container;
 class DepotLocker;
 
+// item ids held by a container and their counts, sorted by id
+using HeldItemCounts = std::vector<std::pair<uint16_t, uint32_t>>;
+
 class ContainerIterator
 {
 	public:
@@ -47,6 +50,10 @@ class Container : public Item, public Cylinder
 		Container(uint16_t type, uint16_t size);
 		~Container();
 
+		// allocated from the container pool
+		static void* operator new(size_t size);
+		static void operator delete(void* object, size_t size);
+
 		// non-copyable
 		Container(const Container&) = delete;
 		Container& operator=(const Container&) = delete;
@@ -99,9 +106,31 @@ class Container : public Item, public Cylinder
 		Item* getItemByIndex(size_t index) const;
 		bool isHoldingItem(const Item* item) const;
 
-		uint32_t getItemHoldingCount() const;
+		// items held down the whole tree, kept up to date on every change
+		uint32_t getItemHoldingCount() const {
+			return heldItems;
+		}
+		uint64_t getHeldWorth() const {
+			return heldWorth;
+		}
+		uint32_t getHeldItemCount(uint16_t itemId) const;
+		const HeldItemCounts& getHeldItemCounts() const {
+			return heldItemCounts;
+		}
+
+		// recounts the tree, false if the kept counts went wrong
+		bool checkHeldItems() const;
+
 		uint32_t getWeight() const final;
 
+		// changes whenever this container or anything inside it changes
+		uint32_t getGeneration() const {
+			return generation;
+		}
+		void incrementGeneration() {
+			++generation;
+		}
+
 		//cylinder implementations
 		virtual ReturnValue queryAdd(int32_t index, const Thing& thing, uint32_t count,
 				uint32_t flags, Creature* actor = nullptr) const override;
@@ -141,14 +170,20 @@ class Container : public Item, public Cylinder
 
 		Container* getParentContainer();
 		void updateItemWeight(int32_t diff);
+		void updateHeldItems(const Item* item, bool added);
+		void updateHeldItemCount(uint16_t itemId, uint32_t count, bool added);
 
 	protected:
 		std::ostringstream& getContentDescription(std::ostringstream& os) const;
 
 		uint32_t maxSize;
 		uint32_t totalWeight = 0;
+		uint32_t heldItems = 0;
+		uint64_t heldWorth = 0;
+		HeldItemCounts heldItemCounts;
 		ItemDeque itemlist;
 		uint32_t serializationCount = 0;
+		uint32_t generation = 0;
 
 		friend class ContainerIterator;
 		friend class IOMapSerialize;
@@ -21,8 +21,18 @@
 
 extern ConfigManager g_config;
 
+// my_bool on MariaDB and older MySQL, bool on MySQL 8
+typedef std::remove_pointer<decltype(MYSQL_BIND::is_null)>::type mysql_bool;
+
+static bool isConnectionError(unsigned int error)
+{
+	return error == CR_SERVER_LOST || error == CR_SERVER_GONE_ERROR || error == CR_CONN_HOST_ERROR || error == 1053/*ER_SERVER_SHUTDOWN*/ || error == CR_CONNECTION_ERROR;
+}
+
 Database::~Database()
 {
+	statements.clear();
+
 	if (handle != nullptr) {
 		mysql_close(handle);
 	}
@@ -151,6 +161,17 @@ DBResult_ptr Database::storeQuery(const std::string& query)
 	return result;
 }
 
+DBStatementGuard Database::prepare(const std::string& query)
+{
+	std::unique_lock<std::recursive_mutex> lockUnique(databaseLock);
+
+	std::unique_ptr<DBStatement>& statement = statements[query];
+	if (!statement) {
+		statement.reset(new DBStatement(*this, query));
+	}
+	return DBStatementGuard(*statement, std::move(lockUnique));
+}
+
 std::string Database::escapeString(const std::string& s) const
 {
 	return escapeBlob(s.c_str(), s.length());
@@ -240,17 +261,305 @@ bool DBResult::next()
 	return row != nullptr;
 }
 
-DBInsert::DBInsert(std::string query) : query(std::move(query))
+DBStatement::DBStatement(Database& db, std::string query) : db(db), query(std::move(query)) {}
+
+DBStatement::~DBStatement()
+{
+	if (handle) {
+		mysql_stmt_close(handle);
+	}
+}
+
+DBStatement::Parameter& DBStatement::getParameter(size_t index)
+{
+	if (index >= parameters.size()) {
+		parameters.resize(index + 1);
+	}
+	return parameters[index];
+}
+
+void DBStatement::setBlob(size_t index, const char* value, size_t length)
+{
+	Parameter& parameter = getParameter(index);
+	parameter.type = MYSQL_TYPE_BLOB;
+	parameter.bytes.assign(value, length);
+}
+
+bool DBStatement::prepare(unsigned int& error)
+{
+	handle = mysql_stmt_init(db.handle);
+	if (!handle) {
+		std::cout << "[Error - mysql_stmt_init] Message: " << mysql_error(db.handle) << std::endl;
+		error = mysql_errno(db.handle);
+		return false;
+	}
+
+	if (mysql_stmt_prepare(handle, query.c_str(), query.length()) != 0) {
+		std::cout << "[Error - mysql_stmt_prepare] Query: " << query.substr(0, 256) << std::endl << "Message: " << mysql_stmt_error(handle) << std::endl;
+		error = mysql_stmt_errno(handle);
+		mysql_stmt_close(handle);
+		handle = nullptr;
+		return false;
+	}
+
+	// lets DBStatementResult size its buffers before fetching
+	mysql_bool updateMaxLength = 1;
+	mysql_stmt_attr_set(handle, STMT_ATTR_UPDATE_MAX_LENGTH, &updateMaxLength);
+	return true;
+}
+
+bool DBStatement::run()
+{
+	unsigned int error;
+	while (true) {
+		if (!handle && !prepare(error)) {
+			if (!isConnectionError(error)) {
+				return false;
+			}
+
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+			continue;
+		}
+
+		std::vector<MYSQL_BIND> binds(parameters.size());
+		for (size_t i = 0, size = parameters.size(); i < size; ++i) {
+			Parameter& parameter = parameters[i];
+			MYSQL_BIND& bind = binds[i];
+			bind.buffer_type = parameter.type;
+			if (parameter.type == MYSQL_TYPE_LONGLONG) {
+				bind.buffer = &parameter.number;
+				bind.is_unsigned = parameter.isUnsigned;
+			} else if (parameter.type == MYSQL_TYPE_BLOB) {
+				bind.buffer = const_cast<char*>(parameter.bytes.data());
+				bind.buffer_length = parameter.bytes.length();
+			}
+		}
+
+		if ((binds.empty() || mysql_stmt_bind_param(handle, binds.data()) == 0) && mysql_stmt_execute(handle) == 0) {
+			return true;
+		}
+
+		std::cout << "[Error - mysql_stmt_execute] Query: " << query.substr(0, 256) << std::endl << "Message: " << mysql_stmt_error(handle) << std::endl;
+
+		// a lost connection also loses the statements prepared on it
+		error = mysql_stmt_errno(handle);
+		if (!isConnectionError(error) && error != 1243/*ER_UNKNOWN_STMT_HANDLER*/) {
+			return false;
+		}
+
+		mysql_stmt_close(handle);
+		handle = nullptr;
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+	}
+}
+
+bool DBStatement::execute()
+{
+	std::lock_guard<std::recursive_mutex> lockClass(db.databaseLock);
+	if (!run()) {
+		return false;
+	}
+
+	mysql_stmt_free_result(handle);
+	return true;
+}
+
+DBStatementResult_ptr DBStatement::storeQuery()
+{
+	std::lock_guard<std::recursive_mutex> lockClass(db.databaseLock);
+	if (!run()) {
+		return nullptr;
+	}
+
+	MYSQL_RES* metadata = mysql_stmt_result_metadata(handle);
+	if (!metadata) {
+		std::cout << "[Error - DBStatement::storeQuery] Query: " << query.substr(0, 256) << std::endl << "Message: statement returns no result set" << std::endl;
+		return nullptr;
+	}
+
+	if (mysql_stmt_store_result(handle) != 0) {
+		std::cout << "[Error - mysql_stmt_store_result] Query: " << query.substr(0, 256) << std::endl << "Message: " << mysql_stmt_error(handle) << std::endl;
+		mysql_free_result(metadata);
+		return nullptr;
+	}
+
+	DBStatementResult_ptr result = std::make_shared<DBStatementResult>(handle, metadata);
+	mysql_stmt_free_result(handle);
+	mysql_free_result(metadata);
+
+	if (!result->hasNext()) {
+		return nullptr;
+	}
+	return result;
+}
+
+static bool isIntegerType(enum_field_types type)
+{
+	switch (type) {
+		case MYSQL_TYPE_TINY:
+		case MYSQL_TYPE_SHORT:
+		case MYSQL_TYPE_LONG:
+		case MYSQL_TYPE_LONGLONG:
+		case MYSQL_TYPE_INT24:
+		case MYSQL_TYPE_YEAR:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+DBStatementResult::DBStatementResult(MYSQL_STMT* handle, MYSQL_RES* metadata)
+{
+	const unsigned int columnCount = mysql_num_fields(metadata);
+	MYSQL_FIELD* fields = mysql_fetch_fields(metadata);
+
+	std::vector<MYSQL_BIND> binds(columnCount);
+	std::vector<int64_t> numberBuffers(columnCount);
+	std::vector<std::vector<char>> valueBuffers(columnCount);
+	std::vector<unsigned long> lengths(columnCount);
+	std::unique_ptr<mysql_bool[]> nulls(new mysql_bool[columnCount]());
+
+	columns.reserve(columnCount);
+	for (unsigned int i = 0; i < columnCount; ++i) {
+		const MYSQL_FIELD& field = fields[i];
+		const bool numeric = isIntegerType(field.type);
+		const bool isUnsigned = (field.flags & UNSIGNED_FLAG) != 0;
+		columns.push_back({field.name, numeric, isUnsigned});
+
+		MYSQL_BIND& bind = binds[i];
+		if (numeric) {
+			bind.buffer_type = MYSQL_TYPE_LONGLONG;
+			bind.buffer = &numberBuffers[i];
+			bind.is_unsigned = isUnsigned;
+		} else {
+			valueBuffers[i].resize(std::max<unsigned long>(1, field.max_length));
+			bind.buffer_type = MYSQL_TYPE_BLOB;
+			bind.buffer = valueBuffers[i].data();
+			bind.buffer_length = valueBuffers[i].size();
+		}
+		bind.length = &lengths[i];
+		bind.is_null = &nulls[i];
+	}
+
+	if (columnCount != 0 && mysql_stmt_bind_result(handle, binds.data()) != 0) {
+		std::cout << "[Error - mysql_stmt_bind_result] Message: " << mysql_stmt_error(handle) << std::endl;
+		return;
+	}
+
+	const size_t expectedCells = static_cast<size_t>(mysql_stmt_num_rows(handle)) * columnCount;
+	numbers.reserve(expectedCells);
+	values.reserve(expectedCells);
+
+	int status;
+	while ((status = mysql_stmt_fetch(handle)) == 0 || status == MYSQL_DATA_TRUNCATED) {
+		for (unsigned int i = 0; i < columnCount; ++i) {
+			if (nulls[i]) {
+				numbers.push_back(0);
+				values.emplace_back();
+			} else if (columns[i].numeric) {
+				numbers.push_back(numberBuffers[i]);
+				values.emplace_back();
+			} else if (lengths[i] <= valueBuffers[i].size()) {
+				numbers.push_back(0);
+				values.emplace_back(valueBuffers[i].data(), lengths[i]);
+			} else {
+				// did not fit the buffer sized from max_length, fetch it whole
+				std::string value(lengths[i], '\0');
+				MYSQL_BIND bind = MYSQL_BIND();
+				bind.buffer_type = MYSQL_TYPE_BLOB;
+				bind.buffer = &value[0];
+				bind.buffer_length = value.size();
+				mysql_stmt_fetch_column(handle, &bind, i, 0);
+
+				numbers.push_back(0);
+				values.push_back(std::move(value));
+			}
+		}
+		++rowCount;
+	}
+}
+
+size_t DBStatementResult::getColumnIndex(const std::string& s) const
+{
+	for (size_t i = 0, size = columns.size(); i < size; ++i) {
+		if (columns[i].name == s) {
+			return i;
+		}
+	}
+
+	std::cout << "[Error - DBStatementResult::getColumnIndex] Column '" << s << "' doesn't exist in the result set" << std::endl;
+	return columns.size();
+}
+
+std::string DBStatementResult::getString(size_t column) const
+{
+	if (column >= columns.size()) {
+		return std::string();
+	}
+
+	const size_t cell = currentRow * columns.size() + column;
+	if (columns[column].numeric) {
+		if (columns[column].isUnsigned) {
+			return std::to_string(static_cast<uint64_t>(numbers[cell]));
+		}
+		return std::to_string(numbers[cell]);
+	}
+	return values[cell];
+}
+
+const char* DBStatementResult::getStream(size_t column, unsigned long& size) const
+{
+	if (column >= columns.size() || columns[column].numeric) {
+		size = 0;
+		return nullptr;
+	}
+
+	const std::string& value = values[currentRow * columns.size() + column];
+	size = value.length();
+	return value.data();
+}
+
+bool DBStatementResult::hasNext() const
+{
+	return currentRow < rowCount;
+}
+
+bool DBStatementResult::next()
+{
+	if (currentRow < rowCount) {
+		++currentRow;
+	}
+	return currentRow < rowCount;
+}
+
+DBInsert::DBInsert(std::string query, Database& db) : db(db), query(std::move(query))
 {
 	this->length = this->query.length();
 }
 
+void DBInsert::upsert(const std::vector<std::string>& columns)
+{
+	// rows whose key already exists update these columns instead of failing
+	std::ostringstream ss;
+	ss << " ON DUPLICATE KEY UPDATE ";
+	for (size_t i = 0, size = columns.size(); i < size; ++i) {
+		if (i != 0) {
+			ss << ", ";
+		}
+		ss << '`' << columns[i] << "` = VALUES(`" << columns[i] << "`)";
+	}
+
+	upsertQuery = ss.str();
+	length = query.length() + upsertQuery.length();
+}
+
 bool DBInsert::addRow(const std::string& row)
 {
 	// adds new row to buffer
 	const size_t rowLength = row.length();
 	length += rowLength;
-	if (length > Database::getInstance()->getMaxPacketSize() && !execute()) {
+	if (length > db.getMaxPacketSize() && !execute()) {
 		return false;
 	}
 
@@ -283,8 +592,8 @@ bool DBInsert::execute()
 	}
 
 	// executes buffer
-	bool res = Database::getInstance()->executeQuery(query + values);
+	bool res = db.executeQuery(query + values + upsertQuery);
 	values.clear();
-	length = query.length();
+	length = query.length() + upsertQuery.length();
 	return res;
 }
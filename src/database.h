@@ -21,6 +21,10 @@
 
 class DBResult;
 typedef std::shared_ptr<DBResult> DBResult_ptr;
+class DBStatement;
+class DBStatementResult;
+typedef std::shared_ptr<DBStatementResult> DBStatementResult_ptr;
+class DBStatementGuard;
 
 class Database
 {
@@ -69,6 +73,21 @@ class Database
 		 */
 		DBResult_ptr storeQuery(const std::string& query);
 
+		/**
+		 * Prepared statement for query.
+		 *
+		 * Statements are prepared once per connection and query text, and
+		 * kept until the connection is closed. Use "?" for parameters.
+		 *
+		 * The connection stays locked until the returned guard goes out of
+		 * scope, so another thread cannot bind the same statement between
+		 * setting the parameters and executing it.
+		 *
+		 * @param query command with "?" placeholders
+		 * @return the cached statement, locked
+		 */
+		DBStatementGuard prepare(const std::string& query);
+
 		/**
 		 * Escapes string for query.
 		 *
@@ -129,7 +148,10 @@ class Database
 		std::recursive_mutex databaseLock;
 		uint64_t maxPacketSize = 1048576;
 
+		std::map<std::string, std::unique_ptr<DBStatement>> statements;
+
 	friend class DBTransaction;
+	friend class DBStatement;
 };
 
 class DBResult
@@ -179,31 +201,180 @@ class DBResult
 	friend class Database;
 };
 
+/**
+ * Prepared statement, see Database::prepare.
+ *
+ * Parameters are set by their 0-based position and sent in binary form,
+ * no escaping involved. They keep their values between executions.
+ */
+class DBStatement
+{
+	public:
+		DBStatement(Database& db, std::string query);
+		~DBStatement();
+
+		// non-copyable
+		DBStatement(const DBStatement&) = delete;
+		DBStatement& operator=(const DBStatement&) = delete;
+
+		template<typename T>
+		void setNumber(size_t index, T value)
+		{
+			Parameter& parameter = getParameter(index);
+			parameter.type = MYSQL_TYPE_LONGLONG;
+			parameter.number = static_cast<int64_t>(value);
+			parameter.isUnsigned = std::is_unsigned<T>::value;
+		}
+
+		void setString(size_t index, const std::string& value)
+		{
+			setBlob(index, value.data(), value.length());
+		}
+		void setBlob(size_t index, const char* value, size_t length);
+
+		bool execute();
+		DBStatementResult_ptr storeQuery();
+
+	private:
+		struct Parameter {
+			enum_field_types type = MYSQL_TYPE_NULL;
+			int64_t number = 0;
+			bool isUnsigned = false;
+			std::string bytes;
+		};
+
+		Parameter& getParameter(size_t index);
+		bool prepare(unsigned int& error);
+		bool run();
+
+		Database& db;
+		std::string query;
+		MYSQL_STMT* handle = nullptr;
+		std::vector<Parameter> parameters;
+};
+
+/**
+ * A prepared statement with its connection locked, see Database::prepare.
+ */
+class DBStatementGuard
+{
+	public:
+		DBStatementGuard(DBStatement& statement, std::unique_lock<std::recursive_mutex> lockUnique) :
+			statement(&statement), lockUnique(std::move(lockUnique)) {}
+
+		DBStatement* operator->() const {
+			return statement;
+		}
+
+	private:
+		DBStatement* statement;
+		std::unique_lock<std::recursive_mutex> lockUnique;
+};
+
+/**
+ * Result of a prepared statement, fetched into memory in binary form.
+ *
+ * Integer columns are read without parsing text. Columns can be looked up
+ * by name, or by an index from getColumnIndex taken once per result.
+ */
+class DBStatementResult
+{
+	public:
+		DBStatementResult(MYSQL_STMT* handle, MYSQL_RES* metadata);
+
+		// non-copyable
+		DBStatementResult(const DBStatementResult&) = delete;
+		DBStatementResult& operator=(const DBStatementResult&) = delete;
+
+		size_t getColumnIndex(const std::string& s) const;
+
+		template<typename T>
+		T getNumber(size_t column) const
+		{
+			if (column >= columns.size()) {
+				return static_cast<T>(0);
+			}
+
+			const size_t cell = currentRow * columns.size() + column;
+			if (columns[column].numeric) {
+				return static_cast<T>(numbers[cell]);
+			}
+
+			T data;
+			try {
+				data = boost::lexical_cast<T>(values[cell]);
+			} catch (boost::bad_lexical_cast&) {
+				data = 0;
+			}
+			return data;
+		}
+
+		template<typename T>
+		T getNumber(const std::string& s) const
+		{
+			return getNumber<T>(getColumnIndex(s));
+		}
+
+		std::string getString(size_t column) const;
+		std::string getString(const std::string& s) const {
+			return getString(getColumnIndex(s));
+		}
+
+		const char* getStream(size_t column, unsigned long& size) const;
+		const char* getStream(const std::string& s, unsigned long& size) const {
+			return getStream(getColumnIndex(s), size);
+		}
+
+		size_t size() const {
+			return rowCount;
+		}
+		bool hasNext() const;
+		bool next();
+
+	private:
+		struct Column {
+			std::string name;
+			bool numeric;
+			bool isUnsigned;
+		};
+
+		std::vector<Column> columns;
+		// one cell per row and column, numbers for integer columns and
+		// values for everything else
+		std::vector<int64_t> numbers;
+		std::vector<std::string> values;
+		size_t rowCount = 0;
+		size_t currentRow = 0;
+};
+
 /**
  * INSERT statement.
  */
 class DBInsert
 {
 	public:
-		explicit DBInsert(std::string query);
+		explicit DBInsert(std::string query, Database& db = *Database::getInstance());
+		void upsert(const std::vector<std::string>& columns);
 		bool addRow(const std::string& row);
 		bool addRow(std::ostringstream& row);
 		bool execute();
 
 	protected:
+		Database& db;
 		std::string query;
 		std::string values;
+		std::string upsertQuery;
 		size_t length;
 };
 
 class DBTransaction
 {
 	public:
-		constexpr DBTransaction() = default;
+		explicit DBTransaction(Database& db = *Database::getInstance()) : db(db) {}
 
 		~DBTransaction() {
 			if (state == STATE_START) {
-				Database::getInstance()->rollback();
+				db.rollback();
 			}
 		}
 
@@ -213,7 +384,7 @@ class DBTransaction
 
 		bool begin() {
 			state = STATE_START;
-			return Database::getInstance()->beginTransaction();
+			return db.beginTransaction();
 		}
 
 		bool commit() {
@@ -222,7 +393,7 @@ class DBTransaction
 			}
 
 			state = STEATE_COMMIT;
-			return Database::getInstance()->commit();
+			return db.commit();
 		}
 
 	private:
@@ -232,6 +403,7 @@ class DBTransaction
 			STEATE_COMMIT,
 		};
 
+		Database& db;
 		TransactionStates_t state = STATE_NO_START;
 };
 
@@ -15,57 +15,116 @@
 #include "otpch.h"
 
 #include "databasetasks.h"
+#include "configmanager.h"
 #include "tasks.h"
 
+extern ConfigManager g_config;
 extern Dispatcher g_dispatcher;
 
-
-void DatabaseTasks::start()
+bool DatabaseWorker::connect()
 {
-	db.connect();
-	ThreadHolder::start();
+	return db.connect();
 }
 
-void DatabaseTasks::threadMain()
+void DatabaseWorker::threadMain()
 {
+	std::vector<DatabaseTask> batch;
 	std::unique_lock<std::mutex> taskLockUnique(taskLock, std::defer_lock);
-	while (getState() != THREAD_STATE_TERMINATED) {
+	while (true) {
 		taskLockUnique.lock();
 		if (tasks.empty()) {
+			// queued writes are drained before the thread terminates
+			if (getState() == THREAD_STATE_TERMINATED) {
+				taskLockUnique.unlock();
+				break;
+			}
 			taskSignal.wait(taskLockUnique);
 		}
 
-		if (!tasks.empty()) {
+		if (tasks.empty()) {
+			taskLockUnique.unlock();
+			continue;
+		}
+
+		if (!tasks.front().batchable || batchSize <= 1) {
 			DatabaseTask task = std::move(tasks.front());
 			tasks.pop_front();
 			taskLockUnique.unlock();
+
+			const auto start = std::chrono::steady_clock::now();
 			runTask(task);
-		} else {
-			taskLockUnique.unlock();
+			busyTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+			continue;
 		}
+
+		// take the run of batchable writes at the front of the queue, and
+		// while it is short and nothing else is queued behind it wait for
+		// more until the oldest one has waited batchDelay
+		const auto deadline = tasks.front().queuedAt + batchDelay;
+		while (true) {
+			while (!tasks.empty() && tasks.front().batchable && batch.size() < batchSize) {
+				batch.push_back(std::move(tasks.front()));
+				tasks.pop_front();
+			}
+
+			if (batch.size() >= batchSize || !tasks.empty() || getState() == THREAD_STATE_TERMINATED || std::chrono::steady_clock::now() >= deadline) {
+				break;
+			}
+			taskSignal.wait_until(taskLockUnique, deadline);
+		}
+		taskLockUnique.unlock();
+
+		const auto start = std::chrono::steady_clock::now();
+		runBatch(batch);
+		busyTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		batch.clear();
 	}
 }
 
-void DatabaseTasks::addTask(const std::string& query, const std::function<void(DBResult_ptr, bool)>& callback/* = nullptr*/, bool store/* = false*/)
+bool DatabaseWorker::addTask(DatabaseTask&& task)
 {
 	bool signal = false;
+	bool queued = false;
+	task.queuedAt = std::chrono::steady_clock::now();
 	taskLock.lock();
 	if (getState() == THREAD_STATE_RUNNING) {
 		signal = tasks.empty();
-		tasks.emplace_back(query, callback, store);
+		tasks.emplace_back(std::move(task));
+		peakQueued = std::max(peakQueued, tasks.size());
+		queued = true;
 	}
 	taskLock.unlock();
 
 	if (signal) {
 		taskSignal.notify_one();
 	}
+	return queued;
 }
 
-void DatabaseTasks::runTask(const DatabaseTask& task)
+DatabaseWorkerStats DatabaseWorker::getStats()
+{
+	DatabaseWorkerStats stats;
+	taskLock.lock();
+	stats.queued = tasks.size();
+	stats.peakQueued = peakQueued;
+	taskLock.unlock();
+
+	stats.executed = executed;
+	stats.busyTime = busyTime;
+	stats.commits = commits;
+	stats.batches = batches;
+	stats.latency = latency;
+	stats.peakLatency = peakLatency;
+	return stats;
+}
+
+void DatabaseWorker::runTask(const DatabaseTask& task)
 {
 	bool success;
 	DBResult_ptr result;
-	if (task.store) {
+	if (task.job) {
+		success = task.job(db);
+	} else if (task.store) {
 		result = db.storeQuery(task.query);
 		success = true;
 	} else {
@@ -73,24 +132,181 @@ void DatabaseTasks::runTask(const DatabaseTask& task)
 		success = db.executeQuery(task.query);
 	}
 
-	if (task.callback) {
-		g_dispatcher.addTask(createTask(std::bind(task.callback, result, success)));
+	++commits;
+	finishTask(task, result, success);
+}
+
+void DatabaseWorker::runBatch(const std::vector<DatabaseTask>& batch)
+{
+	if (batch.size() == 1) {
+		runTask(batch.front());
+		return;
+	}
+
+	// one transaction, so the server flushes its log once for the whole run
+	bool executed = false;
+	bool committed = false;
+	{
+		DBTransaction transaction(db);
+		if (transaction.begin()) {
+			executed = true;
+			for (const DatabaseTask& task : batch) {
+				if (!db.executeQuery(task.query)) {
+					executed = false;
+					break;
+				}
+			}
+			committed = executed && transaction.commit();
+		}
+	}
+
+	if (committed) {
+		++commits;
+		++batches;
+		for (const DatabaseTask& task : batch) {
+			finishTask(task, nullptr, true);
+		}
+		return;
+	}
+
+	// the COMMIT itself failed, the server may have applied the writes
+	// before the connection dropped and running them again could insert
+	// rows twice
+	if (executed) {
+		for (const DatabaseTask& task : batch) {
+			finishTask(task, nullptr, false);
+		}
+		return;
+	}
+
+	// the transaction was rolled back before COMMIT, run every write on its
+	// own so a bad one only fails itself
+	for (const DatabaseTask& task : batch) {
+		runTask(task);
 	}
 }
 
-void DatabaseTasks::flush()
+void DatabaseWorker::finishTask(const DatabaseTask& task, DBResult_ptr result, bool success)
 {
-	while (!tasks.empty()) {
-		runTask(tasks.front());
-		tasks.pop_front();
+	const uint64_t taskLatency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - task.queuedAt).count();
+	latency += taskLatency;
+	if (taskLatency > peakLatency) {
+		// only this thread writes it
+		peakLatency = taskLatency;
+	}
+	++executed;
+
+	if (task.callback) {
+		g_dispatcher.addTask(createTask(std::bind(task.callback, result, success)));
 	}
 }
 
-void DatabaseTasks::shutdown()
+void DatabaseWorker::shutdown()
 {
 	taskLock.lock();
 	setState(THREAD_STATE_TERMINATED);
-	flush();
 	taskLock.unlock();
 	taskSignal.notify_one();
 }
+
+bool DatabaseTasks::start()
+{
+	const int32_t workerCount = std::max<int32_t>(1, g_config.getNumber(ConfigManager::DATABASE_WORKERS));
+	const size_t batchSize = std::max<int32_t>(1, g_config.getNumber(ConfigManager::DATABASE_BATCH_SIZE));
+	const std::chrono::milliseconds batchDelay(std::max<int32_t>(0, g_config.getNumber(ConfigManager::DATABASE_BATCH_DELAY)));
+	for (int32_t i = 0; i < workerCount; ++i) {
+		workers.emplace_back(new DatabaseWorker(batchSize, batchDelay));
+
+		DatabaseWorker& worker = *workers.back();
+		if (!worker.connect()) {
+			return false;
+		}
+		worker.start();
+	}
+	return true;
+}
+
+void DatabaseTasks::stop()
+{
+	for (auto& worker : workers) {
+		worker->stop();
+	}
+}
+
+void DatabaseTasks::shutdown()
+{
+	for (auto& worker : workers) {
+		worker->shutdown();
+	}
+}
+
+void DatabaseTasks::join()
+{
+	for (auto& worker : workers) {
+		worker->join();
+	}
+}
+
+DatabaseWorker& DatabaseTasks::getWorker(uint32_t key)
+{
+	// unkeyed tasks get the first worker to themselves when there is more
+	// than one, so they never queue behind keyed bulk work like saves
+	const size_t workerCount = workers.size();
+	if (key == 0 || workerCount == 1) {
+		return *workers.front();
+	}
+	return *workers[1 + (key % (workerCount - 1))];
+}
+
+void DatabaseTasks::addTask(const std::string& query, const std::function<void(DBResult_ptr, bool)>& callback/* = nullptr*/, bool store/* = false*/, uint32_t key/* = 0*/)
+{
+	if (workers.empty()) {
+		return;
+	}
+	getWorker(key).addTask(DatabaseTask(query, callback, store));
+}
+
+void DatabaseTasks::addBatchedTask(const std::string& query, const std::function<void(DBResult_ptr, bool)>& callback/* = nullptr*/, uint32_t key/* = 0*/)
+{
+	if (workers.empty()) {
+		return;
+	}
+	getWorker(key).addTask(DatabaseTask(query, callback, false, true));
+}
+
+bool DatabaseTasks::addJob(const std::function<bool(Database&)>& job, const std::function<void(DBResult_ptr, bool)>& callback/* = nullptr*/, uint32_t key/* = 0*/)
+{
+	if (workers.empty()) {
+		return false;
+	}
+	return getWorker(key).addTask(DatabaseTask(job, callback));
+}
+
+bool DatabaseTasks::addBarrier(const std::function<void()>& callback)
+{
+	if (workers.empty()) {
+		return false;
+	}
+
+	auto remaining = std::make_shared<std::atomic<size_t>>(workers.size());
+	bool queued = true;
+	for (auto& worker : workers) {
+		queued = worker->addTask(DatabaseTask([remaining, callback](Database&) {
+			if (--(*remaining) == 0) {
+				g_dispatcher.addTask(createTask(callback));
+			}
+			return true;
+		}, nullptr)) && queued;
+	}
+	return queued;
+}
+
+std::vector<DatabaseWorkerStats> DatabaseTasks::getStats()
+{
+	std::vector<DatabaseWorkerStats> stats;
+	stats.reserve(workers.size());
+	for (auto& worker : workers) {
+		stats.push_back(worker->getStats());
+	}
+	return stats;
+}
@@ -21,33 +21,100 @@
 #include "enums.h"
 
 struct DatabaseTask {
-	DatabaseTask(std::string query, std::function<void(DBResult_ptr, bool)> callback, bool store) :
-		query(std::move(query)), callback(std::move(callback)), store(store) {}
+	DatabaseTask(std::string query, std::function<void(DBResult_ptr, bool)> callback, bool store, bool batchable = false) :
+		query(std::move(query)), callback(std::move(callback)), store(store), batchable(batchable) {}
+	DatabaseTask(std::function<bool(Database&)> job, std::function<void(DBResult_ptr, bool)> callback) :
+		job(std::move(job)), callback(std::move(callback)), store(false), batchable(false) {}
 
 	std::string query;
+	// runs instead of query, against the connection of the worker
+	std::function<bool(Database&)> job;
 	std::function<void(DBResult_ptr, bool)> callback;
+	std::chrono::steady_clock::time_point queuedAt;
 	bool store;
+	// a write that may share one transaction with the writes queued around it
+	bool batchable;
 };
 
-class DatabaseTasks : public ThreadHolder<DatabaseTasks>
+struct DatabaseWorkerStats {
+	size_t queued;
+	size_t peakQueued;
+	uint64_t executed;
+	uint64_t busyTime; // microseconds spent running tasks
+	uint64_t commits; // transactions and autocommitted statements
+	uint64_t batches; // transactions that carried batched writes
+	uint64_t latency; // microseconds from queueing to completion, summed over executed
+	uint64_t peakLatency;
+};
+
+// One database connection and the thread that runs its queue in order
+class DatabaseWorker : public ThreadHolder<DatabaseWorker>
 {
 	public:
-		DatabaseTasks() = default;
-		void start();
-		void flush();
+		DatabaseWorker(size_t batchSize, std::chrono::milliseconds batchDelay) :
+			batchSize(batchSize), batchDelay(batchDelay) {}
+		bool connect();
 		void shutdown();
 
-		void addTask(const std::string& query, const std::function<void(DBResult_ptr, bool)>& callback = nullptr, bool store = false);
+		bool addTask(DatabaseTask&& task);
+		DatabaseWorkerStats getStats();
 
 		void threadMain();
 	private:
 		void runTask(const DatabaseTask& task);
+		void runBatch(const std::vector<DatabaseTask>& batch);
+		void finishTask(const DatabaseTask& task, DBResult_ptr result, bool success);
 
 		Database db;
-		std::thread thread;
 		std::list<DatabaseTask> tasks;
 		std::mutex taskLock;
 		std::condition_variable taskSignal;
+
+		const size_t batchSize;
+		const std::chrono::milliseconds batchDelay;
+
+		size_t peakQueued = 0;
+		std::atomic<uint64_t> executed{0};
+		std::atomic<uint64_t> busyTime{0};
+		std::atomic<uint64_t> commits{0};
+		std::atomic<uint64_t> batches{0};
+		std::atomic<uint64_t> latency{0};
+		std::atomic<uint64_t> peakLatency{0};
+};
+
+/**
+ * Pool of database workers, each with its own connection.
+ *
+ * Tasks sharing a key (a player guid, a house id) always run on the same
+ * worker and so in the order they were added, unrelated keys run in
+ * parallel. Tasks without a key share one worker and keep the strict
+ * ordering a single database thread used to give them.
+ */
+class DatabaseTasks
+{
+	public:
+		DatabaseTasks() = default;
+		bool start();
+		void stop();
+		void shutdown();
+		void join();
+
+		void addTask(const std::string& query, const std::function<void(DBResult_ptr, bool)>& callback = nullptr, bool store = false, uint32_t key = 0);
+		// a write without a result that may be committed together with the
+		// batchable writes queued right before or after it on its worker
+		void addBatchedTask(const std::string& query, const std::function<void(DBResult_ptr, bool)>& callback = nullptr, uint32_t key = 0);
+		bool addJob(const std::function<bool(Database&)>& job, const std::function<void(DBResult_ptr, bool)>& callback = nullptr, uint32_t key = 0);
+
+		// calls callback on the dispatcher once every task added before it,
+		// on every worker, has run
+		bool addBarrier(const std::function<void()>& callback);
+
+		std::vector<DatabaseWorkerStats> getStats();
+
+	private:
+		DatabaseWorker& getWorker(uint32_t key);
+
+		std::vector<std::unique_ptr<DatabaseWorker>> workers;
 };
 
 extern DatabaseTasks g_databaseTasks;
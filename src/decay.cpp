@@ -0,0 +1,133 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#include "otpch.h"
+
+#include "decay.h"
+#include "tools.h"
+
+static int64_t getTick(int64_t time)
+{
+	// rounded to the closest tick, an item decays at most half a tick early
+	return (time + DecayQueue::TICK / 2) / DecayQueue::TICK;
+}
+
+void DecayQueue::add(Item* item, int64_t decayTime)
+{
+	++count;
+
+	if (lastTick < 0) {
+		lastTick = getTick(OTSYS_TIME()) - 1;
+	}
+
+	// the near wheel holds the rest of the turn the next tick is in
+	const int64_t nextTick = lastTick + 1;
+	const int64_t tick = std::max<int64_t>(nextTick, getTick(decayTime));
+	if (tick / NEAR_SLOTS == nextTick / NEAR_SLOTS) {
+		nearSlots[tick % NEAR_SLOTS].push_back({item, decayTime});
+		return;
+	}
+
+	// entries further out than the far wheel reaches wait in its last slot
+	// and are put back once it comes up
+	const int64_t turn = std::min<int64_t>(tick / NEAR_SLOTS, nextTick / NEAR_SLOTS + FAR_SLOTS - 1);
+	farSlots[turn % FAR_SLOTS].push_back({item, decayTime});
+}
+
+bool DecayQueue::removeFrom(std::vector<DecayEntry>& slot, Item* item, int64_t decayTime)
+{
+	for (DecayEntry& entry : slot) {
+		if (entry.item == item && entry.decayTime == decayTime) {
+			// entries in a slot have no order
+			entry = slot.back();
+			slot.pop_back();
+			--count;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool DecayQueue::remove(Item* item, int64_t decayTime)
+{
+	if (lastTick < 0) {
+		return false;
+	}
+
+	// the same slot add would pick now; entries for earlier ticks were taken
+	const int64_t nextTick = lastTick + 1;
+	const int64_t tick = std::max<int64_t>(nextTick, getTick(decayTime));
+	if (tick / NEAR_SLOTS == nextTick / NEAR_SLOTS) {
+		return removeFrom(nearSlots[tick % NEAR_SLOTS], item, decayTime);
+	}
+
+	const int64_t turn = std::min<int64_t>(tick / NEAR_SLOTS, nextTick / NEAR_SLOTS + FAR_SLOTS - 1);
+	if (removeFrom(farSlots[turn % FAR_SLOTS], item, decayTime)) {
+		return true;
+	}
+
+	// an entry that was out of the far wheel's reach when it was added
+	// waits in whatever slot was the last one back then
+	for (std::vector<DecayEntry>& slot : farSlots) {
+		if (removeFrom(slot, item, decayTime)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void DecayQueue::cascade(int64_t tick)
+{
+	std::vector<DecayEntry>& slot = farSlots[(tick / NEAR_SLOTS) % FAR_SLOTS];
+	if (slot.empty()) {
+		return;
+	}
+
+	std::vector<DecayEntry> entries;
+	entries.swap(slot);
+	count -= entries.size();
+
+	for (const DecayEntry& entry : entries) {
+		add(entry.item, entry.decayTime);
+	}
+
+	// give the slot its capacity back for the next turn
+	entries.clear();
+	if (slot.empty()) {
+		slot.swap(entries);
+	}
+}
+
+void DecayQueue::takeExpired(int64_t now, std::vector<DecayEntry>& expired)
+{
+	const int64_t nowTick = getTick(now);
+	if (lastTick < 0) {
+		lastTick = nowTick;
+		return;
+	}
+
+	while (lastTick < nowTick) {
+		const int64_t tick = lastTick + 1;
+		if (tick % NEAR_SLOTS == 0) {
+			cascade(tick);
+		}
+		lastTick = tick;
+
+		std::vector<DecayEntry>& slot = nearSlots[tick % NEAR_SLOTS];
+		count -= slot.size();
+		expired.insert(expired.end(), slot.begin(), slot.end());
+		slot.clear();
+	}
+}
@@ -0,0 +1,76 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#ifndef FS_DECAY_H_3C7A1E9F5B2D4C8E6A0F1B3D5E7C9A2B
+#define FS_DECAY_H_3C7A1E9F5B2D4C8E6A0F1B3D5E7C9A2B
+
+class Item;
+
+struct DecayStats {
+	uint64_t queued;
+	uint64_t passes;
+	uint64_t expired;
+	uint64_t busyTime; // microseconds
+};
+
+struct DecayEntry {
+	Item* item;
+	int64_t decayTime;
+};
+
+/**
+ * Decaying items ordered by the time they decay at, in a two level timing
+ * wheel.
+ *
+ * The near wheel has a slot per decay interval, the far wheel a slot per
+ * turn of the near one; a far slot is spread over the near wheel when the
+ * near wheel reaches it. Taking the expired entries only visits the slots
+ * between the last pass and now, so an item is touched when it is queued,
+ * at most once more when it moves from the far wheel and when it expires.
+ * Slots keep their capacity, entries are not allocated one by one.
+ *
+ * An entry holds a reference to its item, whoever takes it releases it.
+ */
+class DecayQueue
+{
+	public:
+		void add(Item* item, int64_t decayTime);
+		// unlinks the entry added with that time, false if there is none; the
+		// caller releases the item of a removed entry
+		bool remove(Item* item, int64_t decayTime);
+		// moves every entry that decays at or before now into expired
+		void takeExpired(int64_t now, std::vector<DecayEntry>& expired);
+
+		size_t size() const {
+			return count;
+		}
+
+		static constexpr int64_t TICK = 250; // ms, one Game::checkDecay pass
+		static constexpr size_t NEAR_SLOTS = 1024;
+		static constexpr size_t FAR_SLOTS = 1024;
+
+	private:
+		void cascade(int64_t tick);
+		bool removeFrom(std::vector<DecayEntry>& slot, Item* item, int64_t decayTime);
+
+		std::vector<DecayEntry> nearSlots[NEAR_SLOTS];
+		std::vector<DecayEntry> farSlots[FAR_SLOTS];
+
+		// last tick taken, entries for it or earlier go into the next one
+		int64_t lastTick = -1;
+		size_t count = 0;
+};
+
+#endif
@@ -23,6 +23,7 @@
 #include "game.h"
 #include "actions.h"
 #include "iologindata.h"
+#include "iomapserialize.h"
 #include "talkaction.h"
 #include "spells.h"
 #include "configmanager.h"
@@ -31,6 +32,8 @@
 #include "bed.h"
 #include "scheduler.h"
 #include "databasetasks.h"
+#include "journal.h"
+#include "logincache.h"
 
 extern ConfigManager g_config;
 extern Actions* g_actions;
@@ -54,6 +57,14 @@ void Game::start(ServiceManager* manager)
 	g_scheduler.addEvent(createSchedulerTask(EVENT_LIGHTINTERVAL, std::bind(&Game::checkLight, this)));
 	g_scheduler.addEvent(createSchedulerTask(EVENT_CREATURE_THINK_INTERVAL, std::bind(&Game::checkCreatures, this, 0)));
 	g_scheduler.addEvent(createSchedulerTask(EVENT_DECAYINTERVAL, std::bind(&Game::checkDecay, this)));
+
+	if (g_journal.isEnabled()) {
+		g_scheduler.addEvent(createSchedulerTask(g_config.getNumber(ConfigManager::PLAYER_JOURNAL_INTERVAL), std::bind(&Game::checkJournal, this)));
+	}
+
+	if (g_config.getNumber(ConfigManager::LOGIN_CACHE_REFRESH_INTERVAL) > 0) {
+		g_scheduler.addEvent(createSchedulerTask(g_config.getNumber(ConfigManager::LOGIN_CACHE_REFRESH_INTERVAL), std::bind(&Game::checkLoginCache, this)));
+	}
 }
 
 GameState_t Game::getGameState() const
@@ -108,6 +119,21 @@ void Game::setGameState(GameState_t newState)
 				it = players.begin();
 			}
 
+			// house items keep their time left through the downtime, like
+			// the items of the players kicked above
+			for (const auto& it : map.houses.getHouses()) {
+				for (HouseTile* tile : it.second->getTiles()) {
+					TileItemVector* items = tile->getItemList();
+					if (!items) {
+						continue;
+					}
+
+					for (Item* item : *items) {
+						stopDecay(item);
+					}
+				}
+			}
+
 			saveMotdNum();
 			saveGameState();
 
@@ -141,23 +167,96 @@ void Game::setGameState(GameState_t newState)
 	}
 }
 
-void Game::saveGameState()
+struct ServerSaveProgress {
+	int64_t start;
+	int64_t freezeTime = 0;
+	uint64_t playerRowsBefore;
+	uint64_t houseRowsBefore;
+	uint64_t houseBytesBefore;
+	uint64_t journalSegment;
+	size_t players = 0;
+	size_t houses = 0;
+	size_t total = 0;
+	size_t done = 0;
+	size_t failed = 0;
+	size_t nextReport = 1;
+	bool queuing = true;
+};
+
+static void finishServerSave(const ServerSaveProgress& progress)
+{
+	std::cout << "> Saved " << progress.players << " players and " << progress.houses << " houses in " << (OTSYS_TIME() - progress.start) / (1000.) << " s, "
+	          << (IOLoginData::getSavedRows() - progress.playerRowsBefore) << " player rows and "
+	          << (IOMapSerialize::getSavedRows() - progress.houseRowsBefore) << " house rows ("
+	          << (IOMapSerialize::getSavedBytes() - progress.houseBytesBefore) << " bytes) written";
+	if (progress.failed != 0) {
+		std::cout << ", " << progress.failed << " failed";
+	}
+	std::cout << ". The game was held for " << progress.freezeTime << " ms." << std::endl;
+
+	// everything journaled before the save is in the database now
+	if (progress.failed == 0) {
+		g_journal.release(progress.journalSegment);
+	}
+}
+
+// runs on the dispatcher as each player or house of a server save is written
+static void onServerSaveStep(ServerSaveProgress& progress, bool success)
 {
-	if (gameState == GAME_STATE_NORMAL) {
-		setGameState(GAME_STATE_MAINTAIN);
+	++progress.done;
+	if (!success) {
+		++progress.failed;
+	}
+
+	// saves written synchronously while the snapshots are still being taken
+	if (progress.queuing) {
+		return;
 	}
 
+	if (progress.done < progress.total) {
+		// report every quarter of the way
+		if (progress.done * 4 >= progress.total * progress.nextReport) {
+			std::cout << "> Save progress: " << (progress.done * 100 / progress.total) << "% (" << progress.done << '/' << progress.total << ")." << std::endl;
+			++progress.nextReport;
+		}
+		return;
+	}
+
+	finishServerSave(progress);
+}
+
+void Game::saveGameState()
+{
 	std::cout << "Saving server..." << std::endl;
 
+	// only the snapshots are taken here, the database workers write them
+	// while the game keeps running
+	auto progress = std::make_shared<ServerSaveProgress>();
+	progress->start = OTSYS_TIME();
+	// logout saves overlapping this one are counted as well
+	progress->playerRowsBefore = IOLoginData::getSavedRows();
+	progress->houseRowsBefore = IOMapSerialize::getSavedRows();
+	progress->houseBytesBefore = IOMapSerialize::getSavedBytes();
+	progress->journalSegment = g_journal.rotate();
+
+	auto callback = [progress](bool success) {
+		onServerSaveStep(*progress, success);
+	};
+
 	for (const auto& it : players) {
 		it.second->loginPosition = it.second->getPosition();
-		IOLoginData::savePlayer(it.second);
+		IOLoginData::savePlayer(it.second, callback);
 	}
+	progress->players = players.size();
+	progress->houses = Map::save(callback);
+	progress->total = progress->players + progress->houses;
 
-	Map::save();
+	progress->freezeTime = OTSYS_TIME() - progress->start;
+	progress->queuing = false;
+	std::cout << "> Save snapshot took " << progress->freezeTime << " ms, writing " << progress->players << " players and " << progress->houses << " changed houses in the background." << std::endl;
 
-	if (gameState == GAME_STATE_MAINTAIN) {
-		setGameState(GAME_STATE_NORMAL);
+	if (progress->done == progress->total) {
+		finishServerSave(*progress);
 	}
 }
 
@@ -520,13 +619,20 @@ bool Game::removeCreature(Creature* creature, bool isLogout/* = true*/)
 
 	Tile* tile = creature->getTile();
 
+	bool stackposPerViewer;
+	const int32_t stackpos = tile->getStackposOfCreature(creature, stackposPerViewer);
+
 	std::vector<int32_t> oldStackPosVector;
 
 	SpectatorVec list;
 	map.getSpectators(list, tile->getPosition(), true);
 	for (Creature* spectator : list) {
 		if (Player* player = spectator->getPlayer()) {
-			oldStackPosVector.push_back(player->canSeeCreature(creature) ? tile->getStackposOfCreature(player, creature) : -1);
+			if (!player->canSeeCreature(creature)) {
+				oldStackPosVector.push_back(-1);
+			} else {
+				oldStackPosVector.push_back(stackposPerViewer ? tile->getStackposOfCreature(player, creature) : stackpos);
+			}
 		}
 	}
 
@@ -1379,6 +1485,8 @@ bool Game::removeMoney(Cylinder* cylinder, uint64_t money, uint32_t flags /*= 0*
 		return true;
 	}
 
+	// containers know the worth of the coins they hold, the ones without any
+	// are not walked
 	std::vector<Container*> containers;
 
 	std::multimap<uint32_t, Item*> moneyMap;
@@ -1397,7 +1505,10 @@ bool Game::removeMoney(Cylinder* cylinder, uint64_t money, uint32_t flags /*= 0*
 
 		Container* container = item->getContainer();
 		if (container) {
-			containers.push_back(container);
+			if (container->getHeldWorth() != 0) {
+				moneyCount += container->getHeldWorth();
+				containers.push_back(container);
+			}
 		} else {
 			const uint32_t worth = item->getWorth();
 			if (worth != 0) {
@@ -1407,27 +1518,28 @@ bool Game::removeMoney(Cylinder* cylinder, uint64_t money, uint32_t flags /*= 0*
 		}
 	}
 
+	if (moneyCount < money) {
+		return false;
+	}
+
 	size_t i = 0;
 	while (i < containers.size()) {
 		Container* container = containers[i++];
 		for (Item* item : container->getItemList()) {
 			Container* tmpContainer = item->getContainer();
 			if (tmpContainer) {
-				containers.push_back(tmpContainer);
+				if (tmpContainer->getHeldWorth() != 0) {
+					containers.push_back(tmpContainer);
+				}
 			} else {
 				const uint32_t worth = item->getWorth();
 				if (worth != 0) {
-					moneyCount += worth;
 					moneyMap.emplace(worth, item);
 				}
 			}
 		}
 	}
 
-	if (moneyCount < money) {
-		return false;
-	}
-
 	for (const auto& moneyEntry : moneyMap) {
 		Item* item = moneyEntry.second;
 		if (moneyEntry.first < money) {
@@ -1566,6 +1678,7 @@ Item* Game::transformItem(Item* item, uint16_t newId, int32_t newCount /*= -1*/)
 
 					item->setParent(nullptr);
 					cylinder->postRemoveNotification(item, cylinder, itemIndex);
+					stopDecay(item);
 					ReleaseItem(item);
 					return newItem;
 				} else {
@@ -1612,6 +1725,7 @@ Item* Game::transformItem(Item* item, uint16_t newId, int32_t newCount /*= -1*/)
 
 	item->setParent(nullptr);
 	cylinder->postRemoveNotification(item, cylinder, itemIndex);
+	stopDecay(item);
 	ReleaseItem(item);
 
 	return newItem;
@@ -3856,14 +3970,54 @@ void Game::startDecay(Item* item)
 	}
 
 	if (item->getDuration() > 0) {
-		item->incrementReferenceCounter();
 		item->setDecaying(DECAYING_TRUE);
-		toDecayItems.push_front(item);
+		queueDecay(item);
 	} else {
 		internalDecayItem(item);
 	}
 }
 
+void Game::queueDecay(Item* item)
+{
+	item->incrementReferenceCounter();
+	decayItems.add(item, item->getDecayTime());
+}
+
+void Game::stopDecay(Item* item)
+{
+	auto stop = [this](Item* item) {
+		if (item->getDecaying() != DECAYING_TRUE) {
+			return;
+		}
+
+		const int64_t decayTime = item->getDecayTime();
+		item->setDecaying(DECAYING_PENDING);
+
+		// an entry this pass already took is skipped by checkDecay
+		if (decayItems.remove(item, decayTime)) {
+			ReleaseItem(item);
+		}
+	};
+
+	stop(item);
+
+	Container* container = item->getContainer();
+	if (!container) {
+		return;
+	}
+
+	for (ContainerIterator it = container->iterator(); it.hasNext(); it.advance()) {
+		stop(*it);
+	}
+}
+
+DecayStats Game::getDecayStats() const
+{
+	DecayStats stats = decayStats;
+	stats.queued = decayItems.size();
+	return stats;
+}
+
 void Game::internalDecayItem(Item* item)
 {
 	const ItemType& it = Item::items[item->getID()];
@@ -3878,48 +4032,48 @@ void Game::internalDecayItem(Item* item)
 	}
 }
 
-void Game::checkDecay()
+void Game::checkJournal()
 {
-	g_scheduler.addEvent(createSchedulerTask(EVENT_DECAYINTERVAL, std::bind(&Game::checkDecay, this)));
+	g_scheduler.addEvent(createSchedulerTask(g_config.getNumber(ConfigManager::PLAYER_JOURNAL_INTERVAL), std::bind(&Game::checkJournal, this)));
+	g_journal.recordPlayers();
+}
 
-	size_t bucket = (lastBucket + 1) % EVENT_DECAY_BUCKETS;
+void Game::checkLoginCache()
+{
+	g_scheduler.addEvent(createSchedulerTask(g_config.getNumber(ConfigManager::LOGIN_CACHE_REFRESH_INTERVAL), std::bind(&Game::checkLoginCache, this)));
+	g_loginCache.refresh();
+}
 
-	auto it = decayItems[bucket].begin(), end = decayItems[bucket].end();
-	while (it != end) {
-		Item* item = *it;
-		if (!item->canDecay()) {
-			item->setDecaying(DECAYING_FALSE);
-			ReleaseItem(item);
-			it = decayItems[bucket].erase(it);
-			continue;
-		}
+void Game::checkDecay()
+{
+	g_scheduler.addEvent(createSchedulerTask(EVENT_DECAYINTERVAL, std::bind(&Game::checkDecay, this)));
 
-		int32_t duration = item->getDuration();
-		int32_t decreaseTime = std::min<int32_t>(EVENT_DECAYINTERVAL * EVENT_DECAY_BUCKETS, duration);
+	const auto start = std::chrono::steady_clock::now();
 
-		duration -= decreaseTime;
-		item->decreaseDuration(decreaseTime);
+	// items queued while these decay (the ones they turn into) are only
+	// taken by a later pass
+	decayItems.takeExpired(OTSYS_TIME(), expiredDecayItems);
+	for (const DecayEntry& entry : expiredDecayItems) {
+		Item* item = entry.item;
 
-		if (duration <= 0) {
-			it = decayItems[bucket].erase(it);
-			internalDecayItem(item);
-			ReleaseItem(item);
-		} else if (duration < EVENT_DECAYINTERVAL * EVENT_DECAY_BUCKETS) {
-			it = decayItems[bucket].erase(it);
-			size_t newBucket = (bucket + ((duration + EVENT_DECAYINTERVAL / 2) / 1000)) % EVENT_DECAY_BUCKETS;
-			if (newBucket == bucket) {
+		// a new entry was queued when the item's time changed, or it
+		// stopped decaying since
+		if (item->getDecaying() == DECAYING_TRUE && item->getDecayTime() == entry.decayTime) {
+			item->setDecaying(DECAYING_FALSE);
+			if (item->canDecay()) {
 				internalDecayItem(item);
-				ReleaseItem(item);
-			} else {
-				decayItems[newBucket].push_back(item);
 			}
-		} else {
-			++it;
 		}
+		ReleaseItem(item);
 	}
 
-	lastBucket = bucket;
+	decayStats.expired += expiredDecayItems.size();
+	expiredDecayItems.clear();
+
 	cleanup();
+
+	++decayStats.passes;
+	decayStats.busyTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
 }
 
 void Game::checkLight()
@@ -4031,15 +4185,6 @@ void Game::cleanup()
 	}
 	ToReleaseItems.clear();
 
-	for (Item* item : toDecayItems) {
-		const uint32_t dur = item->getDuration();
-		if (dur >= EVENT_DECAYINTERVAL * EVENT_DECAY_BUCKETS) {
-			decayItems[lastBucket].push_back(item);
-		} else {
-			decayItems[(lastBucket + 1 + dur / 1000) % EVENT_DECAY_BUCKETS].push_back(item);
-		}
-	}
-	toDecayItems.clear();
 }
 
 void Game::ReleaseCreature(Creature* creature)
@@ -23,6 +23,7 @@
 #include "position.h"
 #include "item.h"
 #include "container.h"
+#include "decay.h"
 #include "player.h"
 #include "raids.h"
 #include "npc.h"
@@ -82,8 +83,7 @@ struct RuleViolation {
 };
 
 static constexpr int32_t EVENT_LIGHTINTERVAL = 10000;
-static constexpr int32_t EVENT_DECAYINTERVAL = 250;
-static constexpr int32_t EVENT_DECAY_BUCKETS = 4;
+static constexpr int32_t EVENT_DECAYINTERVAL = DecayQueue::TICK;
 
 /**
   * Main Game class.
@@ -448,6 +448,12 @@ class Game
 		void resetCommandTag();
 
 		void startDecay(Item* item);
+		// queues the item at the time it decays at, see Item::setDuration
+		void queueDecay(Item* item);
+		// pauses the item and everything inside it, their time left is kept
+		// and they are unlinked from the queue
+		void stopDecay(Item* item);
+		DecayStats getDecayStats() const;
 		int32_t getLightHour() const {
 			return lightHour;
 		}
@@ -496,6 +502,8 @@ class Game
 		bool playerSpeakTo(Player* player, SpeakClasses type, const std::string& receiver, const std::string& text);
 
 		void checkDecay();
+		void checkJournal();
+		void checkLoginCache();
 		void internalDecayItem(Item* item);
 
 		//list of reported rule violations, for correct channel listing
@@ -506,16 +514,15 @@ class Game
 		std::unordered_map<uint32_t, Guild*> guilds;
 		std::map<uint32_t, float> stages;
 
-		std::list<Item*> decayItems[EVENT_DECAY_BUCKETS];
+		DecayQueue decayItems;
+		std::vector<DecayEntry> expiredDecayItems;
+		DecayStats decayStats = {};
 		std::list<Creature*> checkCreatureLists[EVENT_CREATURECOUNT];
 
-		std::forward_list<Item*> toDecayItems;
-
 		std::vector<Creature*> ToReleaseCreatures;
 		std::vector<Item*> ToReleaseItems;
 		std::vector<char> commandTags;
 
-		size_t lastBucket = 0;
 
 		WildcardTreeNode wildcardTree { false };
 
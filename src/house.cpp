@@ -94,6 +94,7 @@ void House::setOwner(uint32_t guid, bool updateDatabase/* = true*/, Player* play
 		}
 	}
 
+	markInfoModified();
 	updateDoorDescription();
 }
 
@@ -171,6 +172,7 @@ void House::setAccessList(uint32_t listId, const std::string& textlist)
 	} else if (listId == SUBOWNER_LIST) {
 		subOwnerList.parseList(textlist);
 	} else {
+		// the door marks the house itself
 		Door* door = getDoorByNumber(listId);
 		if (door) {
 			door->setAccessList(textlist);
@@ -180,6 +182,8 @@ void House::setAccessList(uint32_t listId, const std::string& textlist)
 		return;
 	}
 
+	markInfoModified();
+
 	//kick uninvited players
 	for (HouseTile* tile : houseTiles) {
 		if (CreatureVector* creatures = tile->getCreatures()) {
@@ -201,17 +205,30 @@ bool House::transferToDepot() const
 
 	Player* player = g_game.getPlayerByGUID(owner);
 	if (player) {
-		transferToDepot(player);
-	} else {
-		Player tmpPlayer(nullptr);
-		if (!IOLoginData::loadPlayerById(&tmpPlayer, owner)) {
-			return false;
-		}
-
-		transferToDepot(&tmpPlayer);
-		IOLoginData::savePlayer(&tmpPlayer);
+		return transferToDepot(player);
 	}
 
+	// the items leave the house now and wait in a locker of their own
+	// until the owner has been read on the database workers
+	DepotLocker* items = new DepotLocker(ITEM_LOCKER1);
+	items->incrementReferenceCounter();
+	transferItems(items);
+
+	const uint32_t depotId = townId;
+	IOLoginData::loadOfflinePlayer(owner, [items, depotId](Player* player) {
+		if (player) {
+			DepotLocker* depotLocker = player->getDepotLocker(depotId, true);
+			ItemDeque itemList = items->getItemList();
+			for (Item* item : itemList) {
+				g_game.internalMoveItem(items, depotLocker, INDEX_WHEREEVER, item, item->getItemCount(), nullptr, FLAG_NOLIMIT);
+			}
+
+			if (player->isOffline()) {
+				IOLoginData::savePlayer(player);
+			}
+		}
+		items->decrementReferenceCounter();
+	});
 	return true;
 }
 
@@ -221,6 +238,12 @@ bool House::transferToDepot(Player* player) const
 		return false;
 	}
 
+	transferItems(player->getDepotLocker(getTownId(), true));
+	return true;
+}
+
+void House::transferItems(Cylinder* toCylinder) const
+{
 	ItemList moveItemList;
 	for (HouseTile* tile : houseTiles) {
 		if (const TileItemVector* items = tile->getItemList()) {
@@ -240,10 +263,8 @@ bool House::transferToDepot(Player* player) const
 	}
 
 	for (Item* item : moveItemList) {
-		g_game.internalMoveItem(item->getParent(), player->getDepotLocker(getTownId(), true), INDEX_WHEREEVER, item, item->getItemCount(), nullptr, FLAG_NOLIMIT);
+		g_game.internalMoveItem(item->getParent(), toCylinder, INDEX_WHEREEVER, item, item->getItemCount(), nullptr, FLAG_NOLIMIT);
 	}
-
-	return true;
 }
 
 bool House::getAccessList(uint32_t listId, std::string& list) const
@@ -555,6 +576,10 @@ void Door::setAccessList(const std::string& textlist)
 	}
 
 	accessList->parseList(textlist);
+
+	if (house) {
+		house->markInfoModified();
+	}
 }
 
 bool Door::getAccessList(std::string& list) const
@@ -631,6 +656,66 @@ bool Houses::loadHousesXML(const std::string& filename)
 	return true;
 }
 
+static void payRent(House* house, Player* player, RentPeriod_t rentPeriod, time_t currentTime)
+{
+	if (g_game.removeMoney(player->getDepotLocker(house->getTownId(), true), house->getRent(), FLAG_NOLIMIT)) {
+		time_t paidUntil = currentTime;
+		switch (rentPeriod) {
+			case RENTPERIOD_DAILY:
+				paidUntil += 24 * 60 * 60;
+				break;
+			case RENTPERIOD_WEEKLY:
+				paidUntil += 24 * 60 * 60 * 7;
+				break;
+			case RENTPERIOD_MONTHLY:
+				paidUntil += 24 * 60 * 60 * 30;
+				break;
+			case RENTPERIOD_YEARLY:
+				paidUntil += 24 * 60 * 60 * 365;
+				break;
+			default:
+				break;
+		}
+		house->setPaidUntil(paidUntil);
+	} else {
+		if (house->getPayRentWarnings() < 7) {
+			int32_t daysLeft = 7 - house->getPayRentWarnings();
+
+			Item* letter = Item::CreateItem(ITEM_LETTER_STAMPED);
+			std::string period;
+
+			switch (rentPeriod) {
+				case RENTPERIOD_DAILY:
+					period = "daily";
+					break;
+
+				case RENTPERIOD_WEEKLY:
+					period = "weekly";
+					break;
+
+				case RENTPERIOD_MONTHLY:
+					period = "monthly";
+					break;
+
+				case RENTPERIOD_YEARLY:
+					period = "annual";
+					break;
+
+				default:
+					break;
+			}
+
+			std::ostringstream ss;
+			ss << "Warning! \nThe " << period << " rent of " << house->getRent() << " gold for your house \"" << house->getName() << "\" is payable. Have it within " << daysLeft << " days or you will lose this house.";
+			letter->setText(ss.str());
+			g_game.internalAddItem(player->getDepotLocker(house->getTownId(), true), letter, INDEX_WHEREEVER, FLAG_NOLIMIT);
+			house->setPayRentWarnings(house->getPayRentWarnings() + 1);
+		} else {
+			house->setOwner(0, true, player);
+		}
+	}
+}
+
 void Houses::payHouses(RentPeriod_t rentPeriod) const
 {
 	if (rentPeriod == RENTPERIOD_NEVER) {
@@ -655,70 +740,22 @@ void Houses::payHouses(RentPeriod_t rentPeriod) const
 			continue;
 		}
 
-		Player player(nullptr);
-		if (!IOLoginData::loadPlayerById(&player, ownerId)) {
-			// Player doesn't exist, reset house owner
-			house->setOwner(0);
-			continue;
-		}
-
-		if (g_game.removeMoney(player.getDepotLocker(house->getTownId(), true), house->getRent(), FLAG_NOLIMIT)) {
-			time_t paidUntil = currentTime;
-			switch (rentPeriod) {
-				case RENTPERIOD_DAILY:
-					paidUntil += 24 * 60 * 60;
-					break;
-				case RENTPERIOD_WEEKLY:
-					paidUntil += 24 * 60 * 60 * 7;
-					break;
-				case RENTPERIOD_MONTHLY:
-					paidUntil += 24 * 60 * 60 * 30;
-					break;
-				case RENTPERIOD_YEARLY:
-					paidUntil += 24 * 60 * 60 * 365;
-					break;
-				default:
-					break;
+		// the owner is read on the database workers, the rent is charged once
+		// it is in unless the house was paid or changed hands meanwhile
+		const uint32_t rentWarnings = house->getPayRentWarnings();
+		IOLoginData::loadOfflinePlayer(ownerId, [house, ownerId, rentWarnings, rentPeriod, currentTime](Player* player) {
+			if (house->getOwner() != ownerId || house->getPaidUntil() > currentTime || house->getPayRentWarnings() != rentWarnings) {
+				return;
 			}
-			house->setPaidUntil(paidUntil);
-		} else {
-			if (house->getPayRentWarnings() < 7) {
-				int32_t daysLeft = 7 - house->getPayRentWarnings();
-
-				Item* letter = Item::CreateItem(ITEM_LETTER_STAMPED);
-				std::string period;
 
-				switch (rentPeriod) {
-					case RENTPERIOD_DAILY:
-						period = "daily";
-						break;
-
-					case RENTPERIOD_WEEKLY:
-						period = "weekly";
-						break;
-
-					case RENTPERIOD_MONTHLY:
-						period = "monthly";
-						break;
-
-					case RENTPERIOD_YEARLY:
-						period = "annual";
-						break;
-
-					default:
-						break;
-				}
-
-				std::ostringstream ss;
-				ss << "Warning! \nThe " << period << " rent of " << house->getRent() << " gold for your house \"" << house->getName() << "\" is payable. Have it within " << daysLeft << " days or you will lose this house.";
-				letter->setText(ss.str());
-				g_game.internalAddItem(player.getDepotLocker(house->getTownId(), true), letter, INDEX_WHEREEVER, FLAG_NOLIMIT);
-				house->setPayRentWarnings(house->getPayRentWarnings() + 1);
-			} else {
-				house->setOwner(0, true, &player);
+			if (!player) {
+				// Player doesn't exist, reset house owner
+				house->setOwner(0);
+				return;
 			}
-		}
 
-		IOLoginData::savePlayer(&player);
+			payRent(house, player, rentPeriod, currentTime);
+			IOLoginData::savePlayer(player);
+		});
 	}
 }
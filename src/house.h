@@ -164,6 +164,7 @@ class House
 
 		void setPaidUntil(time_t paid) {
 			paidUntil = paid;
+			markInfoModified();
 		}
 		time_t getPaidUntil() const {
 			return paidUntil;
@@ -178,6 +179,7 @@ class House
 
 		void setPayRentWarnings(uint32_t warnings) {
 			rentWarnings = warnings;
+			markInfoModified();
 		}
 		uint32_t getPayRentWarnings() const {
 			return rentWarnings;
@@ -219,9 +221,37 @@ class House
 			return static_cast<uint32_t>(std::ceil(bedsList.size() / 2.)); //each bed takes 2 sqms of space, ceil is just for bad maps
 		}
 
+		// bumped by every change a save has to write, a house is dirty while
+		// a generation differs from the one last written to the database
+		void markItemsModified() {
+			++itemsGeneration;
+		}
+		void markInfoModified() {
+			++infoGeneration;
+		}
+		uint32_t getItemsGeneration() const {
+			return itemsGeneration;
+		}
+		uint32_t getInfoGeneration() const {
+			return infoGeneration;
+		}
+		bool isItemsModified() const {
+			return itemsGeneration != savedItemsGeneration;
+		}
+		bool isInfoModified() const {
+			return infoGeneration != savedInfoGeneration;
+		}
+		void setSavedItemsGeneration(uint32_t generation) {
+			savedItemsGeneration = generation;
+		}
+		void setSavedInfoGeneration(uint32_t generation) {
+			savedInfoGeneration = generation;
+		}
+
 	private:
 		bool transferToDepot() const;
 		bool transferToDepot(Player* player) const;
+		void transferItems(Cylinder* toCylinder) const;
 
 		AccessList guestList;
 		AccessList subOwnerList;
@@ -245,6 +275,11 @@ class House
 		uint32_t rent = 0;
 		uint32_t townId = 0;
 
+		uint32_t itemsGeneration = 0;
+		uint32_t savedItemsGeneration = 0;
+		uint32_t infoGeneration = 0;
+		uint32_t savedInfoGeneration = 0;
+
 		Position posEntry = {};
 
 		bool isLoaded = false;
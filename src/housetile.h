@@ -34,7 +34,7 @@ class HouseTile final : public DynamicTile
 		void addThing(int32_t index, Thing* thing) final;
 		void internalAddThing(uint32_t index, Thing* thing) final;
 
-		House* getHouse() {
+		House* getHouse() final {
 			return house;
 		}
 
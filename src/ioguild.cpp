@@ -32,11 +32,16 @@ uint32_t IOGuild::getGuildIdByName(const std::string& name)
 }
 
 void IOGuild::getWarList(uint32_t guildId, GuildWarList& guildWarList)
+{
+	getWarList(*Database::getInstance(), guildId, guildWarList);
+}
+
+void IOGuild::getWarList(Database& db, uint32_t guildId, GuildWarList& guildWarList)
 {
 	std::ostringstream query;
 	query << "SELECT `guild1`, `guild2` FROM `guild_wars` WHERE (`guild1` = " << guildId << " OR `guild2` = " << guildId << ") AND `ended` = 0 AND `status` = 1";
 
-	DBResult_ptr result = Database::getInstance()->storeQuery(query.str());
+	DBResult_ptr result = db.storeQuery(query.str());
 	if (!result) {
 		return;
 	}
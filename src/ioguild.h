@@ -15,6 +15,8 @@
 #ifndef FS_IOGUILD_H_EF9ACEBA0B844C388B70FF52E69F1AFF
 #define FS_IOGUILD_H_EF9ACEBA0B844C388B70FF52E69F1AFF
 
+class Database;
+
 typedef std::vector<uint32_t> GuildWarList;
 
 class IOGuild
@@ -22,6 +24,7 @@ class IOGuild
 	public:
 		static uint32_t getGuildIdByName(const std::string& name);
 		static void getWarList(uint32_t guildId, GuildWarList& guildWarList);
+		static void getWarList(Database& db, uint32_t guildId, GuildWarList& guildWarList);
 };
 
 #endif
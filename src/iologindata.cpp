@@ -17,13 +17,70 @@
 #include "iologindata.h"
 #include "configmanager.h"
 #include "game.h"
+#include "databasetasks.h"
+#include "journal.h"
+#include "logincache.h"
+
+#include <atomic>
+#include <condition_variable>
 
 extern ConfigManager g_config;
 extern Game g_game;
+extern DatabaseTasks g_databaseTasks;
+
+struct PendingSave {
+	uint32_t count = 0;
+	std::string name;
+};
+
+// saves handed to the database thread that have not been written yet, so a
+// load of the same player never reads rows older than its last logout
+static std::mutex pendingSaveLock;
+static std::condition_variable pendingSaveSignal;
+static std::map<uint32_t, PendingSave> pendingSaves;
+
+// rows written by player saves since startup
+static std::atomic<uint64_t> savedRows(0);
+
+// depot items are numbered in a fixed sid range per locker, so one locker
+// can be rewritten without touching the rows of the others
+static constexpr int32_t DEPOT_SID_RANGE = 1 << 20;
+
+static int32_t getDepotSidBase(uint32_t depotId)
+{
+	return static_cast<int32_t>(depotId + 1) * DEPOT_SID_RANGE;
+}
+
+static void addPendingSave(uint32_t guid, const std::string& name)
+{
+	std::lock_guard<std::mutex> lockClass(pendingSaveLock);
+	PendingSave& pendingSave = pendingSaves[guid];
+	++pendingSave.count;
+	pendingSave.name = asLowerCaseString(name);
+}
+
+static void removePendingSave(uint32_t guid)
+{
+	{
+		std::lock_guard<std::mutex> lockClass(pendingSaveLock);
+		auto it = pendingSaves.find(guid);
+		if (it == pendingSaves.end()) {
+			return;
+		}
+
+		if (--it->second.count == 0) {
+			pendingSaves.erase(it);
+		}
+	}
+	pendingSaveSignal.notify_all();
+}
 
 Account IOLoginData::loadAccount(uint32_t accno)
 {
 	Account account;
+	if (g_loginCache.getAccount(accno, account)) {
+		return account;
+	}
 
 	std::ostringstream query;
 	query << "SELECT `id`, `password`, `type`, `premdays`, `lastday` FROM `accounts` WHERE `id` = " << accno;
@@ -43,11 +100,25 @@ bool IOLoginData::saveAccount(const Account& acc)
 {
 	std::ostringstream query;
 	query << "UPDATE `accounts` SET `premdays` = " << acc.premiumDays << ", `lastday` = " << acc.lastDay << " WHERE `id` = " << acc.id;
-	return Database::getInstance()->executeQuery(query.str());
+	if (!Database::getInstance()->executeQuery(query.str())) {
+		return false;
+	}
+
+	g_loginCache.setPremium(acc.id, acc.premiumDays, acc.lastDay);
+	return true;
 }
 
 bool IOLoginData::loginserverAuthentication(uint32_t accountNumber, const std::string& password, Account& account)
 {
+	const std::string passwordHash = transformToSHA1(password);
+
+	// a password changed outside the server is seen at the next reload,
+	// until then only a failed check goes to the database
+	std::string cachedPassword;
+	if (g_loginCache.getAccount(accountNumber, account, cachedPassword) && cachedPassword == passwordHash) {
+		return true;
+	}
+
 	Database* db = Database::getInstance();
 
 	std::ostringstream query;
@@ -57,10 +128,11 @@ bool IOLoginData::loginserverAuthentication(uint32_t accountNumber, const std::s
 		return false;
 	}
 
-	if (transformToSHA1(password) != result->getString("password")) {
+	if (passwordHash != result->getString("password")) {
 		return false;
 	}
 
+	account = Account();
 	account.id = result->getNumber<uint32_t>("id");
 	account.accountType = static_cast<AccountType_t>(result->getNumber<int32_t>("type"));
 	account.premiumDays = result->getNumber<uint16_t>("premdays");
@@ -77,42 +149,69 @@ bool IOLoginData::loginserverAuthentication(uint32_t accountNumber, const std::s
 		} while (result->next());
 		std::sort(account.characters.begin(), account.characters.end());
 	}
+
+	g_loginCache.setAccount(account, passwordHash);
 	return true;
 }
 
 uint32_t IOLoginData::gameworldAuthentication(uint32_t accountNumber, const std::string& password, std::string& characterName)
 {
+	const std::string passwordHash = transformToSHA1(password);
+
 	Database* db = Database::getInstance();
 
-	std::ostringstream query;
-	query << "SELECT `id`, `password` FROM `accounts` WHERE `id` = " << accountNumber;
-	DBResult_ptr result = db->storeQuery(query.str());
-	if (!result) {
-		return 0;
-	}
+	uint32_t accountId;
+	Account account;
+	std::string cachedPassword;
+	if (g_loginCache.getAccount(accountNumber, account, cachedPassword) && cachedPassword == passwordHash) {
+		accountId = account.id;
+	} else {
+		std::ostringstream query;
+		query << "SELECT `id`, `password` FROM `accounts` WHERE `id` = " << accountNumber;
+		DBResult_ptr result = db->storeQuery(query.str());
+		if (!result) {
+			return 0;
+		}
 
-	if (transformToSHA1(password) != result->getString("password")) {
-		return 0;
+		if (passwordHash != result->getString("password")) {
+			return 0;
+		}
+
+		accountId = result->getNumber<uint32_t>("id");
+		g_loginCache.setPassword(accountId, passwordHash);
 	}
 
-	uint32_t accountId = result->getNumber<uint32_t>("id");
+	CachedCharacter character;
+	if (!g_loginCache.getCharacter(characterName, character)) {
+		std::ostringstream query;
+		query << "SELECT `id`, `account_id`, `name`, `group_id`, `deletion` FROM `players` WHERE `name` = " << db->escapeString(characterName);
+		DBResult_ptr result = db->storeQuery(query.str());
+		if (!result) {
+			return 0;
+		}
 
-	query.str(std::string());
-	query << "SELECT `account_id`, `name`, `deletion` FROM `players` WHERE `name` = " << db->escapeString(characterName);
-	result = db->storeQuery(query.str());
-	if (!result) {
-		return 0;
+		character.guid = result->getNumber<uint32_t>("id");
+		character.name = result->getString("name");
+		character.accountId = result->getNumber<uint32_t>("account_id");
+		character.groupId = result->getNumber<uint16_t>("group_id");
+		character.deleted = result->getNumber<uint64_t>("deletion") != 0;
+		g_loginCache.setCharacter(character);
 	}
 
-	if (result->getNumber<uint32_t>("account_id") != accountId || result->getNumber<uint64_t>("deletion") != 0) {
+	if (character.accountId != accountId || character.deleted) {
 		return 0;
 	}
-	characterName = result->getString("name");
+	characterName = character.name;
 	return accountId;
 }
 
 AccountType_t IOLoginData::getAccountType(uint32_t accountId)
 {
+	Account account;
+	if (g_loginCache.getAccount(accountId, account)) {
+		return account.accountType;
+	}
+
 	std::ostringstream query;
 	query << "SELECT `type` FROM `accounts` WHERE `id` = " << accountId;
 	DBResult_ptr result = Database::getInstance()->storeQuery(query.str());
@@ -127,6 +226,7 @@ void IOLoginData::setAccountType(uint32_t accountId, AccountType_t accountType)
 	std::ostringstream query;
 	query << "UPDATE `accounts` SET `type` = " << static_cast<uint16_t>(accountType) << " WHERE `id` = " << accountId;
 	Database::getInstance()->executeQuery(query.str());
+	g_loginCache.setAccountType(accountId, accountType);
 }
 
 void IOLoginData::updateOnlineStatus(uint32_t guid, bool login)
@@ -141,11 +241,36 @@ void IOLoginData::updateOnlineStatus(uint32_t guid, bool login)
 	} else {
 		query << "DELETE FROM `players_online` WHERE `player_id` = " << guid;
 	}
-	Database::getInstance()->executeQuery(query.str());
+	g_databaseTasks.addBatchedTask(query.str(), nullptr, guid);
 }
 
 bool IOLoginData::preloadPlayer(Player* player, const std::string& name)
 {
+	CachedCharacter character;
+	Account account;
+	if (g_loginCache.getCharacter(name, character) && g_loginCache.getAccount(character.accountId, account)) {
+		if (character.deleted) {
+			return false;
+		}
+
+		Group* group = g_game.groups.getGroup(character.groupId);
+		if (!group) {
+			std::cout << "[Error - IOLoginData::preloadPlayer] " << player->name << " has Group ID " << character.groupId << " which doesn't exist." << std::endl;
+			return false;
+		}
+
+		player->setGUID(character.guid);
+		player->setGroup(group);
+		player->accountNumber = character.accountId;
+		player->accountType = account.accountType;
+		if (!g_config.getBoolean(ConfigManager::FREE_PREMIUM)) {
+			player->premiumDays = account.premiumDays;
+		} else {
+			player->premiumDays = std::numeric_limits<uint16_t>::max();
+		}
+		return true;
+	}
+
 	Database* db = Database::getInstance();
 
 	std::ostringstream query;
@@ -180,35 +305,290 @@ bool IOLoginData::preloadPlayer(Player* player, const std::string& name)
 	return true;
 }
 
-bool IOLoginData::loadPlayerById(Player* player, uint32_t id)
+// the players row read by every load, a WHERE clause is appended
+static const std::string PLAYER_SELECT = "SELECT `id`, `name`, `account_id`, `group_id`, `sex`, `vocation`, `experience`, `level`, `maglevel`, `health`, `healthmax`, `blessings`, `mana`, `manamax`, `manaspent`, `soul`, `lookbody`, `lookfeet`, `lookhead`, `looklegs`, `looktype`, `posx`, `posy`, `posz`, `cap`, `lastlogin`, `lastlogout`, `lastip`, `conditions`, `skulltime`, `skull`, `town_id`, `balance`, `skill_fist`, `skill_fist_tries`, `skill_club`, `skill_club_tries`, `skill_sword`, `skill_sword_tries`, `skill_axe`, `skill_axe_tries`, `skill_dist`, `skill_dist_tries`, `skill_shielding`, `skill_shielding_tries`, `skill_fishing`, `skill_fishing_tries` FROM `players` WHERE ";
+
+bool IOLoginData::loadPlayerByName(Player* player, const std::string& name)
 {
-	std::ostringstream query;
-	query << "SELECT `id`, `name`, `account_id`, `group_id`, `sex`, `vocation`, `experience`, `level`, `maglevel`, `health`, `healthmax`, `blessings`, `mana`, `manamax`, `manaspent`, `soul`, `lookbody`, `lookfeet`, `lookhead`, `looklegs`, `looktype`, `posx`, `posy`, `posz`, `cap`, `lastlogin`, `lastlogout`, `lastip`, `conditions`, `skulltime`, `skull`, `town_id`, `balance`, `skill_fist`, `skill_fist_tries`, `skill_club`, `skill_club_tries`, `skill_sword`, `skill_sword_tries`, `skill_axe`, `skill_axe_tries`, `skill_dist`, `skill_dist_tries`, `skill_shielding`, `skill_shielding_tries`, `skill_fishing`, `skill_fishing_tries` FROM `players` WHERE `id` = " << id;
-	return loadPlayer(player, Database::getInstance()->storeQuery(query.str()));
+	DBStatementGuard statement = Database::getInstance()->prepare(PLAYER_SELECT + "`name` = ?");
+	statement->setString(0, name);
+	return loadPlayer(player, statement->storeQuery());
 }
 
-bool IOLoginData::loadPlayerByName(Player* player, const std::string& name)
+bool IOLoginData::loadPlayer(Player* player, DBStatementResult_ptr result)
 {
-	Database* db = Database::getInstance();
-	std::ostringstream query;
-	query << "SELECT `id`, `name`, `account_id`, `group_id`, `sex`, `vocation`, `experience`, `level`, `maglevel`, `health`, `healthmax`, `blessings`, `mana`, `manamax`, `manaspent`, `soul`, `lookbody`, `lookfeet`, `lookhead`, `looklegs`, `looktype`, `posx`, `posy`, `posz`, `cap`, `lastlogin`, `lastlogout`, `lastip`, `conditions`, `skulltime`, `skull`, `town_id`, `balance`, `skill_fist`, `skill_fist_tries`, `skill_club`, `skill_club_tries`, `skill_sword`, `skill_sword_tries`, `skill_axe`, `skill_axe_tries`, `skill_dist`, `skill_dist_tries`, `skill_shielding`, `skill_shielding_tries`, `skill_fishing`, `skill_fishing_tries` FROM `players` WHERE `name` = " << db->escapeString(name);
-	return loadPlayer(player, db->storeQuery(query.str()));
+	PlayerLoadData data;
+	if (!readPlayer(*Database::getInstance(), result, data)) {
+		return false;
+	}
+	return applyPlayerLoad(player, data);
+}
+
+bool IOLoginData::readPlayer(Database& db, DBStatementResult_ptr result, PlayerLoadData& data)
+{
+	if (!readPlayerRow(result, data)) {
+		return false;
+	}
+
+	const uint32_t guid = data.row.guid;
+	queryPlayerLists(db, guid, data);
+	queryAccountData(db, guid, data.accountId, data);
+	queryInventory(db, guid, data);
+	queryDepot(db, guid, data);
+	return true;
+}
+
+bool IOLoginData::readPlayer(Database& db, uint32_t guid, PlayerLoadData& data)
+{
+	DBStatementGuard statement = db.prepare(PLAYER_SELECT + "`id` = ?");
+	statement->setNumber(0, guid);
+	return readPlayer(db, statement->storeQuery(), data);
+}
+
+static void finishOfflinePlayerLoad(uint32_t guid, PlayerLoadData& data, const std::function<void(Player*)>& callback)
+{
+	// logged in while it was read, what was read may already be outdated
+	if (Player* player = g_game.getPlayerByGUID(guid)) {
+		callback(player);
+		return;
+	}
+
+	if (!data.found) {
+		callback(nullptr);
+		return;
+	}
+
+	Player* player = new Player(nullptr);
+	player->incrementReferenceCounter();
+	if (IOLoginData::applyPlayerLoad(player, data)) {
+		callback(player);
+	} else {
+		callback(nullptr);
+	}
+	player->decrementReferenceCounter();
 }
 
-bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
+void IOLoginData::loadOfflinePlayer(uint32_t guid, const std::function<void(Player*)>& callback)
+{
+	// the job shares the key of the player's saves, so it reads only once
+	// every save queued before it has been written
+	auto data = std::make_shared<PlayerLoadData>();
+	bool queued = g_databaseTasks.addJob([guid, data](Database& db) {
+		readPlayer(db, guid, *data);
+		return true;
+	}, [guid, data, callback](DBResult_ptr, bool) {
+		finishOfflinePlayerLoad(guid, *data, callback);
+	}, guid);
+
+	if (queued) {
+		return;
+	}
+
+	// the database workers are shutting down, read on this thread once
+	// they have written what they still hold for the player
+	waitForPendingSave(guid);
+
+	readPlayer(*Database::getInstance(), guid, *data);
+	finishOfflinePlayerLoad(guid, *data, callback);
+}
+
+void IOLoginData::loadOfflinePlayer(const std::string& name, const std::function<void(Player*)>& callback)
+{
+	// the guid is looked up first, the player is then read on its key
+	auto guid = std::make_shared<uint32_t>(0);
+	bool queued = g_databaseTasks.addJob([name, guid](Database& db) {
+		DBStatementGuard statement = db.prepare("SELECT `id` FROM `players` WHERE `name` = ?");
+		statement->setString(0, name);
+		if (DBStatementResult_ptr result = statement->storeQuery()) {
+			*guid = result->getNumber<uint32_t>("id");
+		}
+		return true;
+	}, [guid, callback](DBResult_ptr, bool) {
+		if (*guid == 0) {
+			callback(nullptr);
+		} else {
+			loadOfflinePlayer(*guid, callback);
+		}
+	});
+
+	if (!queued) {
+		const uint32_t id = getGuidByName(name);
+		if (id == 0) {
+			callback(nullptr);
+		} else {
+			loadOfflinePlayer(id, callback);
+		}
+	}
+}
+
+bool IOLoginData::readPlayerRow(DBStatementResult_ptr result, PlayerLoadData& data)
 {
 	if (!result) {
 		return false;
 	}
 
-	Database* db = Database::getInstance();
+	PlayerSaveSnapshot& row = data.row;
+	row.guid = result->getNumber<uint32_t>("id");
+	row.name = result->getString("name");
+	data.accountId = result->getNumber<uint32_t>("account_id");
+
+	row.groupId = result->getNumber<uint16_t>("group_id");
+	row.vocationId = result->getNumber<uint16_t>("vocation");
+	row.sex = static_cast<PlayerSex_t>(result->getNumber<uint16_t>("sex"));
+	row.level = result->getNumber<uint32_t>("level");
+	row.experience = result->getNumber<uint64_t>("experience");
+	row.magLevel = result->getNumber<uint32_t>("maglevel");
+	row.manaSpent = result->getNumber<uint64_t>("manaspent");
+	row.health = result->getNumber<int32_t>("health");
+	row.healthMax = result->getNumber<int32_t>("healthmax");
+	row.mana = result->getNumber<uint32_t>("mana");
+	row.manaMax = result->getNumber<uint32_t>("manamax");
+	row.soul = result->getNumber<uint16_t>("soul");
+	row.capacity = result->getNumber<uint32_t>("cap");
+	row.blessings = result->getNumber<uint16_t>("blessings");
+	row.bankBalance = result->getNumber<uint64_t>("balance");
+
+	row.outfit.lookType = result->getNumber<uint16_t>("looktype");
+	row.outfit.lookHead = result->getNumber<uint16_t>("lookhead");
+	row.outfit.lookBody = result->getNumber<uint16_t>("lookbody");
+	row.outfit.lookLegs = result->getNumber<uint16_t>("looklegs");
+	row.outfit.lookFeet = result->getNumber<uint16_t>("lookfeet");
+
+	row.skullTime = result->getNumber<time_t>("skulltime");
+	row.skull = static_cast<Skulls_t>(result->getNumber<uint16_t>("skull"));
+
+	row.loginPosition.x = result->getNumber<uint16_t>("posx");
+	row.loginPosition.y = result->getNumber<uint16_t>("posy");
+	row.loginPosition.z = result->getNumber<uint16_t>("posz");
+	row.townId = result->getNumber<uint32_t>("town_id");
+
+	row.lastLoginSaved = result->getNumber<time_t>("lastlogin");
+	row.lastLogout = result->getNumber<time_t>("lastlogout");
 
-	uint32_t accno = result->getNumber<uint32_t>("account_id");
-	Account acc = loadAccount(accno);
+	unsigned long conditionsSize;
+	const char* conditions = result->getStream("conditions", conditionsSize);
+	row.conditions.assign(conditions, conditionsSize);
 
-	player->setGUID(result->getNumber<uint32_t>("id"));
-	player->name = result->getString("name");
-	player->accountNumber = accno;
+	static const std::string skillNames[] = {"skill_fist", "skill_club", "skill_sword", "skill_axe", "skill_dist", "skill_shielding", "skill_fishing"};
+	static const std::string skillNameTries[] = {"skill_fist_tries", "skill_club_tries", "skill_sword_tries", "skill_axe_tries", "skill_dist_tries", "skill_shielding_tries", "skill_fishing_tries"};
+	static constexpr size_t size = sizeof(skillNames) / sizeof(std::string);
+	for (uint8_t i = 0; i < size; ++i) {
+		row.skills[i].level = result->getNumber<uint16_t>(skillNames[i]);
+		row.skills[i].tries = result->getNumber<uint64_t>(skillNameTries[i]);
+	}
+
+	data.found = true;
+	return true;
+}
+
+void IOLoginData::queryPlayerLists(Database& db, uint32_t guid, PlayerLoadData& data)
+{
+	DBStatementGuard murdersStatement = db.prepare("SELECT `date` FROM `player_murders` WHERE `player_id` = ? ORDER BY `date` ASC");
+	murdersStatement->setNumber(0, guid);
+	DBStatementResult_ptr result;
+	if ((result = murdersStatement->storeQuery())) {
+		do {
+			data.row.murders.push_back(result->getNumber<time_t>(0));
+		} while (result->next());
+	}
+
+	DBStatementGuard spellsStatement = db.prepare("SELECT `name` FROM `player_spells` WHERE `player_id` = ?");
+	spellsStatement->setNumber(0, guid);
+	if ((result = spellsStatement->storeQuery())) {
+		do {
+			data.row.learnedSpells.push_back(result->getString(0));
+		} while (result->next());
+	}
+}
+
+void IOLoginData::queryAccountData(Database& db, uint32_t guid, uint32_t accountId, PlayerLoadData& data)
+{
+	DBStatementGuard storageStatement = db.prepare("SELECT `key`, `value` FROM `player_storage` WHERE `player_id` = ?");
+	storageStatement->setNumber(0, guid);
+	DBStatementResult_ptr result;
+	if ((result = storageStatement->storeQuery())) {
+		do {
+			data.row.storage.emplace_back(result->getNumber<uint32_t>(0), result->getNumber<int32_t>(1));
+		} while (result->next());
+	}
+
+	std::ostringstream query;
+	DBResult_ptr queryResult;
+
+	//load vip
+	query << "SELECT `player_id` FROM `account_viplist` WHERE `account_id` = " << accountId;
+	if ((queryResult = db.storeQuery(query.str()))) {
+		do {
+			data.vipList.push_back(queryResult->getNumber<uint32_t>("player_id"));
+		} while (queryResult->next());
+	}
+
+	// the guild itself is read every time, whether the game already knows
+	// it is only known on the dispatcher
+	query.str(std::string());
+	query << "SELECT `guild_id`, `rank_id`, `nick` FROM `guild_membership` WHERE `player_id` = " << guid;
+	if (!(queryResult = db.storeQuery(query.str()))) {
+		return;
+	}
+
+	data.guildId = queryResult->getNumber<uint32_t>("guild_id");
+	data.guildRankId = queryResult->getNumber<uint32_t>("rank_id");
+	data.guildNick = queryResult->getString("nick");
+
+	query.str(std::string());
+	query << "SELECT `name` FROM `guilds` WHERE `id` = " << data.guildId;
+	if ((queryResult = db.storeQuery(query.str()))) {
+		data.guildName = queryResult->getString("name");
+	}
+
+	query.str(std::string());
+	query << "SELECT `id`, `name`, `level` FROM `guild_ranks` WHERE `guild_id` = " << data.guildId;
+	if ((queryResult = db.storeQuery(query.str()))) {
+		do {
+			data.guildRanks.emplace_back(queryResult->getNumber<uint32_t>("id"), queryResult->getString("name"), queryResult->getNumber<uint16_t>("level"));
+		} while (queryResult->next());
+	}
+
+	query.str(std::string());
+	query << "SELECT COUNT(*) AS `members` FROM `guild_membership` WHERE `guild_id` = " << data.guildId;
+	if ((queryResult = db.storeQuery(query.str()))) {
+		data.guildMemberCount = queryResult->getNumber<uint32_t>("members");
+	}
+
+	IOGuild::getWarList(db, data.guildId, data.guildWars);
+}
+
+void IOLoginData::queryInventory(Database& db, uint32_t guid, PlayerLoadData& data)
+{
+	DBStatementGuard itemsStatement = db.prepare("SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_items` WHERE `player_id` = ? ORDER BY `sid` DESC");
+	itemsStatement->setNumber(0, guid);
+	if (DBStatementResult_ptr result = itemsStatement->storeQuery()) {
+		readItemRows(result, data.row.items);
+	}
+}
+
+void IOLoginData::queryDepot(Database& db, uint32_t guid, PlayerLoadData& data)
+{
+	DBStatementGuard depotStatement = db.prepare("SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_depotitems` WHERE `player_id` = ? ORDER BY `sid` DESC");
+	depotStatement->setNumber(0, guid);
+	if (DBStatementResult_ptr result = depotStatement->storeQuery()) {
+		readItemRows(result, data.row.depotItems);
+	}
+}
+
+bool IOLoginData::applyPlayerLoad(Player* player, PlayerLoadData& data)
+{
+	if (!data.found) {
+		return false;
+	}
+
+	const PlayerSaveSnapshot& row = data.row;
+
+	Account acc = loadAccount(data.accountId);
+
+	player->setGUID(row.guid);
+	player->name = row.name;
+	player->accountNumber = data.accountId;
 
 	player->accountType = acc.accountType;
 
@@ -218,19 +598,19 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 		player->premiumDays = acc.premiumDays;
 	}
 
-	Group* group = g_game.groups.getGroup(result->getNumber<uint16_t>("group_id"));
+	Group* group = g_game.groups.getGroup(row.groupId);
 	if (!group) {
-		std::cout << "[Error - IOLoginData::loadPlayer] " << player->name << " has Group ID " << result->getNumber<uint16_t>("group_id") << " which doesn't exist" << std::endl;
+		std::cout << "[Error - IOLoginData::loadPlayer] " << player->name << " has Group ID " << row.groupId << " which doesn't exist" << std::endl;
 		return false;
 	}
 	player->setGroup(group);
 
-	player->bankBalance = result->getNumber<uint64_t>("balance");
+	player->bankBalance = row.bankBalance;
 
-	player->setSex(static_cast<PlayerSex_t>(result->getNumber<uint16_t>("sex")));
-	player->level = std::max<uint32_t>(1, result->getNumber<uint32_t>("level"));
+	player->setSex(row.sex);
+	player->level = std::max<uint32_t>(1, row.level);
 
-	uint64_t experience = result->getNumber<uint64_t>("experience");
+	uint64_t experience = row.experience;
 
 	uint64_t currExpCount = Player::getExpForLevel(player->level);
 	uint64_t nextExpCount = Player::getExpForLevel(player->level + 1);
@@ -246,14 +626,12 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 		player->levelPercent = 0;
 	}
 
-	player->soul = result->getNumber<uint16_t>("soul");
-	player->capacity = std::max<uint32_t>(400, result->getNumber<uint32_t>("cap")) * 100;
-	player->blessings = result->getNumber<uint16_t>("blessings");
+	player->soul = row.soul;
+	player->capacity = std::max<uint32_t>(400, row.capacity) * 100;
+	player->blessings = row.blessings;
 
-	unsigned long conditionsSize;
-	const char* conditions = result->getStream("conditions", conditionsSize);
 	PropStream propStream;
-	propStream.init(conditions, conditionsSize);
+	propStream.init(row.conditions.data(), row.conditions.size());
 
 	Condition* condition = Condition::createCondition(propStream);
 	while (condition) {
@@ -265,17 +643,17 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 		condition = Condition::createCondition(propStream);
 	}
 
-	if (!player->setVocation(result->getNumber<uint16_t>("vocation"))) {
-		std::cout << "[Error - IOLoginData::loadPlayer] " << player->name << " has Vocation ID " << result->getNumber<uint16_t>("vocation") << " which doesn't exist" << std::endl;
+	if (!player->setVocation(row.vocationId)) {
+		std::cout << "[Error - IOLoginData::loadPlayer] " << player->name << " has Vocation ID " << row.vocationId << " which doesn't exist" << std::endl;
 		return false;
 	}
 
-	player->mana = result->getNumber<uint32_t>("mana");
-	player->manaMax = result->getNumber<uint32_t>("manamax");
-	player->magLevel = result->getNumber<uint32_t>("maglevel");
+	player->mana = row.mana;
+	player->manaMax = row.manaMax;
+	player->magLevel = row.magLevel;
 
 	uint64_t nextManaCount = player->vocation->getReqMana(player->magLevel + 1);
-	uint64_t manaSpent = result->getNumber<uint64_t>("manaspent");
+	uint64_t manaSpent = row.manaSpent;
 	if (manaSpent > nextManaCount) {
 		manaSpent = 0;
 	}
@@ -283,21 +661,16 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 	player->manaSpent = manaSpent;
 	player->magLevelPercent = Player::getPercentLevel(player->manaSpent, nextManaCount);
 
-	player->health = result->getNumber<int32_t>("health");
-	player->healthMax = result->getNumber<int32_t>("healthmax");
+	player->health = row.health;
+	player->healthMax = row.healthMax;
 
-	player->defaultOutfit.lookType = result->getNumber<uint16_t>("looktype");
-	player->defaultOutfit.lookHead = result->getNumber<uint16_t>("lookhead");
-	player->defaultOutfit.lookBody = result->getNumber<uint16_t>("lookbody");
-	player->defaultOutfit.lookLegs = result->getNumber<uint16_t>("looklegs");
-	player->defaultOutfit.lookFeet = result->getNumber<uint16_t>("lookfeet");
+	player->defaultOutfit = row.outfit;
 	player->currentOutfit = player->defaultOutfit;
 
 	if (g_game.getWorldType() != WORLD_TYPE_PVP_ENFORCED) {
-		player->playerKillerEnd = result->getNumber<time_t>("skulltime");
+		player->playerKillerEnd = row.skullTime;
 
-		uint16_t skull = result->getNumber<uint16_t>("skull");
-		if (skull == SKULL_RED) {
+		if (row.skull == SKULL_RED) {
 			player->skull = SKULL_RED;
 		}
 
@@ -306,16 +679,14 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 		}
 	}
 
-	player->loginPosition.x = result->getNumber<uint16_t>("posx");
-	player->loginPosition.y = result->getNumber<uint16_t>("posy");
-	player->loginPosition.z = result->getNumber<uint16_t>("posz");
+	player->loginPosition = row.loginPosition;
 
-	player->lastLoginSaved = result->getNumber<time_t>("lastlogin");
-	player->lastLogout = result->getNumber<time_t>("lastlogout");
+	player->lastLoginSaved = row.lastLoginSaved;
+	player->lastLogout = row.lastLogout;
 
-	Town* town = g_game.map.towns.getTown(result->getNumber<uint32_t>("town_id"));
+	Town* town = g_game.map.towns.getTown(row.townId);
 	if (!town) {
-		std::cout << "[Error - IOLoginData::loadPlayer] " << player->name << " has Town ID " << result->getNumber<uint32_t>("town_id") << " which doesn't exist" << std::endl;
+		std::cout << "[Error - IOLoginData::loadPlayer] " << player->name << " has Town ID " << row.townId << " which doesn't exist" << std::endl;
 		return false;
 	}
 
@@ -326,12 +697,9 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 		player->loginPosition = player->getTemplePosition();
 	}
 
-	static const std::string skillNames[] = {"skill_fist", "skill_club", "skill_sword", "skill_axe", "skill_dist", "skill_shielding", "skill_fishing"};
-	static const std::string skillNameTries[] = {"skill_fist_tries", "skill_club_tries", "skill_sword_tries", "skill_axe_tries", "skill_dist_tries", "skill_shielding_tries", "skill_fishing_tries"};
-	static constexpr size_t size = sizeof(skillNames) / sizeof(std::string);
-	for (uint8_t i = 0; i < size; ++i) {
-		uint16_t skillLevel = result->getNumber<uint16_t>(skillNames[i]);
-		uint64_t skillTries = result->getNumber<uint64_t>(skillNameTries[i]);
+	for (uint8_t i = SKILL_FIRST; i <= SKILL_LAST; ++i) {
+		uint16_t skillLevel = row.skills[i].level;
+		uint64_t skillTries = row.skills[i].tries;
 		uint64_t nextSkillTries = player->vocation->getReqSkillTries(i, skillLevel + 1);
 		if (skillTries > nextSkillTries) {
 			skillTries = 0;
@@ -342,178 +710,358 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 		player->skills[i].percent = Player::getPercentLevel(skillTries, nextSkillTries);
 	}
 
-	std::ostringstream query;
+	player->murderTimeStamps.assign(row.murders.begin(), row.murders.end());
 
-	query << "SELECT `date` FROM `player_murders` WHERE `player_id` = " << player->getGUID() << " ORDER BY `date` ASC";
-	if ((result = db->storeQuery(query.str()))) {
-		do {
-			player->murderTimeStamps.push_back(result->getNumber<time_t>("date"));
-		} while (result->next());
-	}
+	if (data.guildId != 0) {
+		player->guildNick = data.guildNick;
 
-	query.str(std::string());
-	query << "SELECT `guild_id`, `rank_id`, `nick` FROM `guild_membership` WHERE `player_id` = " << player->getGUID();
-	if ((result = db->storeQuery(query.str()))) {
-		uint32_t guildId = result->getNumber<uint32_t>("guild_id");
-		uint32_t playerRankId = result->getNumber<uint32_t>("rank_id");
-		player->guildNick = result->getString("nick");
-
-		Guild* guild = g_game.getGuild(guildId);
-		if (!guild) {
-			query.str(std::string());
-			query << "SELECT `name` FROM `guilds` WHERE `id` = " << guildId;
-			if ((result = db->storeQuery(query.str()))) {
-				guild = new Guild(guildId, result->getString("name"));
-				g_game.addGuild(guild);
-
-				query.str(std::string());
-				query << "SELECT `id`, `name`, `level` FROM `guild_ranks` WHERE `guild_id` = " << guildId;
-
-				if ((result = db->storeQuery(query.str()))) {
-					do {
-						guild->addRank(result->getNumber<uint32_t>("id"), result->getString("name"), result->getNumber<uint16_t>("level"));
-					} while (result->next());
-				}
+		Guild* guild = g_game.getGuild(data.guildId);
+		if (!guild && !data.guildName.empty()) {
+			guild = new Guild(data.guildId, data.guildName);
+			g_game.addGuild(guild);
+
+			for (const GuildRank& rank : data.guildRanks) {
+				guild->addRank(rank.id, rank.name, rank.level);
 			}
 		}
 
 		if (guild) {
 			player->guild = guild;
-			const GuildRank* rank = guild->getRankById(playerRankId);
+			const GuildRank* rank = guild->getRankById(data.guildRankId);
 			if (!rank) {
-				query.str(std::string());
-				query << "SELECT `id`, `name`, `level` FROM `guild_ranks` WHERE `id` = " << playerRankId;
-
-				if ((result = db->storeQuery(query.str()))) {
-					guild->addRank(result->getNumber<uint32_t>("id"), result->getString("name"), result->getNumber<uint16_t>("level"));
+				for (const GuildRank& loadedRank : data.guildRanks) {
+					if (loadedRank.id == data.guildRankId) {
+						guild->addRank(loadedRank.id, loadedRank.name, loadedRank.level);
+						break;
+					}
 				}
 
-				rank = guild->getRankById(playerRankId);
+				rank = guild->getRankById(data.guildRankId);
 				if (!rank) {
 					player->guild = nullptr;
 				}
 			}
 
 			player->guildRank = rank;
-
-			IOGuild::getWarList(guildId, player->guildWarList);
-
-			query.str(std::string());
-			query << "SELECT COUNT(*) AS `members` FROM `guild_membership` WHERE `guild_id` = " << guildId;
-			if ((result = db->storeQuery(query.str()))) {
-				guild->setMemberCount(result->getNumber<uint32_t>("members"));
-			}
+			player->guildWarList = data.guildWars;
+			guild->setMemberCount(data.guildMemberCount);
 		}
 	}
 
-	query.str(std::string());
-	query << "SELECT `player_id`, `name` FROM `player_spells` WHERE `player_id` = " << player->getGUID();
-	if ((result = db->storeQuery(query.str()))) {
-		do {
-			player->learnedInstantSpellList.emplace_front(result->getString("name"));
-		} while (result->next());
+	for (const std::string& spellName : row.learnedSpells) {
+		player->learnedInstantSpellList.emplace_front(spellName);
 	}
 
 	//load inventory items
 	ItemMap itemMap;
+	loadItems(itemMap, row.items);
+
+	for (ItemMap::const_reverse_iterator it = itemMap.rbegin(), end = itemMap.rend(); it != end; ++it) {
+		const std::pair<Item*, int32_t>& pair = it->second;
+		Item* item = pair.first;
+		int32_t pid = pair.second;
+		if (pid >= 1 && pid <= 10) {
+			player->internalAddThing(pid, item);
+			continue;
+		}
 
-	query.str(std::string());
-	query << "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_items` WHERE `player_id` = " << player->getGUID() << " ORDER BY `sid` DESC";
-	if ((result = db->storeQuery(query.str()))) {
-		loadItems(itemMap, result);
-
-		for (ItemMap::const_reverse_iterator it = itemMap.rbegin(), end = itemMap.rend(); it != end; ++it) {
-			const std::pair<Item*, int32_t>& pair = it->second;
-			Item* item = pair.first;
-			int32_t pid = pair.second;
-			if (pid >= 1 && pid <= 10) {
-				player->internalAddThing(pid, item);
-			} else {
-				ItemMap::const_iterator it2 = itemMap.find(pid);
-				if (it2 == itemMap.end()) {
-					continue;
-				}
-
-				Container* container = it2->second.first->getContainer();
-				if (container) {
-					container->internalAddThing(item);
-				}
-			}
+		ItemMap::const_iterator it2 = itemMap.find(pid);
+		Container* container = it2 != itemMap.end() ? it2->second.first->getContainer() : nullptr;
+		if (container) {
+			container->internalAddThing(item);
+		} else {
+			item->decrementReferenceCounter();
 		}
 	}
 
 	//load depot items
+	bool legacyDepotRows = false;
+
 	itemMap.clear();
+	loadItems(itemMap, row.depotItems);
 
-	query.str(std::string());
-	query << "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_depotitems` WHERE `player_id` = " << player->getGUID() << " ORDER BY `sid` DESC";
-	if ((result = db->storeQuery(query.str()))) {
-		loadItems(itemMap, result);
-
-		for (ItemMap::const_reverse_iterator it = itemMap.rbegin(), end = itemMap.rend(); it != end; ++it) {
-			const std::pair<Item*, int32_t>& pair = it->second;
-			Item* item = pair.first;
-
-			int32_t pid = pair.second;
-			if (pid >= 0 && pid < 100) {
-				Container* itemContainer = item->getContainer();
-				if (itemContainer) {
-					DepotLocker* locker = itemContainer->getDepotLocker();
-					if (locker) {
-						DepotLocker* existingLocker = player->getDepotLocker(pid, false);
-						if (!existingLocker) {
-							player->depotLockerMap[pid] = locker;
-						}
-					}
-				}
-			} else {
-				ItemMap::const_iterator it2 = itemMap.find(pid);
-				if (it2 == itemMap.end()) {
-					continue;
-				}
+	for (ItemMap::const_reverse_iterator it = itemMap.rbegin(), end = itemMap.rend(); it != end; ++it) {
+		const std::pair<Item*, int32_t>& pair = it->second;
+		Item* item = pair.first;
 
-				Container* container = it2->second.first->getContainer();
-				if (container) {
-					container->internalAddThing(item);
-				}
+		int32_t pid = pair.second;
+		if (it->first < DEPOT_SID_RANGE) {
+			legacyDepotRows = true;
+		}
+
+		if (pid >= 0 && pid < 100) {
+			Container* itemContainer = item->getContainer();
+			DepotLocker* locker = itemContainer ? itemContainer->getDepotLocker() : nullptr;
+			if (!locker || !player->depotLockerMap.emplace(pid, locker).second) {
+				item->decrementReferenceCounter();
 			}
+			continue;
+		}
+
+		ItemMap::const_iterator it2 = itemMap.find(pid);
+		Container* container = it2 != itemMap.end() ? it2->second.first->getContainer() : nullptr;
+		if (container) {
+			container->internalAddThing(item);
+		} else {
+			item->decrementReferenceCounter();
 		}
 	}
 
 	//load storage map
-	query.str(std::string());
-	query << "SELECT `key`, `value` FROM `player_storage` WHERE `player_id` = " << player->getGUID();
-	if ((result = db->storeQuery(query.str()))) {
-		do {
-			player->addStorageValue(result->getNumber<uint32_t>("key"), result->getNumber<int32_t>("value"));
-		} while (result->next());
-	}
+	player->storage.load(row.storage);
 
 	//load vip
-	query.str(std::string());
-	query << "SELECT `player_id` FROM `account_viplist` WHERE `account_id` = " << player->getAccount();
-	if ((result = db->storeQuery(query.str()))) {
-		do {
-			player->addVIPInternal(result->getNumber<uint32_t>("player_id"));
-		} while (result->next());
+	for (uint32_t guid : data.vipList) {
+		player->addVIPInternal(guid);
 	}
 
 	player->updateBaseSpeed();
 	player->updateInventoryWeight();
 	player->updateItemsLight(true);
+
+	resetModified(player);
+	player->storage.clearChanges(PlayerStorage::CHANGE_JOURNAL);
+
+	// rows saved before depots were numbered per locker are renumbered by
+	// rewriting all of them once
+	player->fullSaveRequired = legacyDepotRows;
 	return true;
 }
 
-bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList, DBInsert& query_insert, PropWriteStream& propWriteStream)
+struct PlayerLoad {
+	std::shared_ptr<PlayerLoadData> data;
+	std::function<void(const std::shared_ptr<PlayerLoadData>&)> callback;
+	uint32_t accountId = 0;
+	int64_t expiresAt = 0;
+	bool reading = false;
+	bool stale = false;
+};
+
+struct LastCharacter {
+	uint32_t guid;
+	int64_t loginTime;
+};
+
+// loads running on the database workers or finished ahead of a login that
+// was expected, by guid, and the character each account last logged in with
+// (dispatcher thread only)
+static std::map<uint32_t, std::shared_ptr<PlayerLoad>> playerLoads;
+static std::map<uint32_t, LastCharacter> lastCharacters;
+static int64_t nextLastCharactersSweep = 0;
+static PlayerLoadStats playerLoadStats[2];
+
+// an account not seen for this long is no longer worth a prewarm, its last
+// character is forgotten on the next sweep
+static constexpr int64_t LAST_CHARACTER_TIME = 24 * 60 * 60 * 1000;
+static constexpr int64_t LAST_CHARACTERS_SWEEP_INTERVAL = 60 * 1000;
+
+static void finishPlayerLoad(uint32_t guid, const std::shared_ptr<PlayerLoad>& load);
+
+static void startPlayerLoad(uint32_t guid, const std::shared_ptr<PlayerLoad>& load)
 {
-	std::ostringstream ss;
+	auto data = std::make_shared<PlayerLoadData>();
+	load->data = data;
+	load->reading = true;
+
+	// on the player's key, so it only reads once every save of the player
+	// queued before it has been written
+	bool queued = g_databaseTasks.addJob([guid, data](Database& db) {
+		IOLoginData::readPlayer(db, guid, *data);
+		return true;
+	}, [guid, load](DBResult_ptr, bool) {
+		finishPlayerLoad(guid, load);
+	}, guid);
+
+	if (!queued) {
+		finishPlayerLoad(guid, load);
+	}
+}
+
+static void finishPlayerLoad(uint32_t guid, const std::shared_ptr<PlayerLoad>& load)
+{
+	load->reading = false;
+
+	auto it = playerLoads.find(guid);
+	if (it == playerLoads.end() || it->second != load) {
+		return;
+	}
+
+	if (!load->callback) {
+		if (load->stale) {
+			playerLoads.erase(it);
+		}
+		return;
+	}
+
+	// a save was queued while reading, what was read may predate it
+	if (load->stale) {
+		load->stale = false;
+		startPlayerLoad(guid, load);
+		return;
+	}
+
+	playerLoads.erase(it);
+	load->callback(load->data);
+}
+
+void IOLoginData::loadPlayerData(uint32_t guid, uint32_t accountId, const std::function<void(const std::shared_ptr<PlayerLoadData>&)>& callback)
+{
+	lastCharacters[accountId] = {guid, OTSYS_TIME()};
+
+	auto it = playerLoads.find(guid);
+	if (it != playerLoads.end()) {
+		std::shared_ptr<PlayerLoad> load = it->second;
+		if (!load->reading && !load->stale && load->expiresAt >= OTSYS_TIME()) {
+			playerLoads.erase(it);
+			++playerLoadStats[1].prewarmed;
+			callback(load->data);
+			return;
+		}
+
+		if (load->reading) {
+			// the prewarm is still reading, the login takes it over
+			load->callback = callback;
+			return;
+		}
+
+		playerLoads.erase(it);
+	}
+
+	auto load = std::make_shared<PlayerLoad>();
+	load->callback = callback;
+	load->accountId = accountId;
+	playerLoads[guid] = load;
+	startPlayerLoad(guid, load);
+}
+
+bool IOLoginData::isPlayerLoading(uint32_t guid)
+{
+	auto it = playerLoads.find(guid);
+	return it != playerLoads.end() && it->second->callback;
+}
 
+void IOLoginData::invalidatePlayerLoad(uint32_t guid)
+{
+	auto it = playerLoads.find(guid);
+	if (it == playerLoads.end()) {
+		return;
+	}
+
+	if (!it->second->reading) {
+		playerLoads.erase(it);
+	} else {
+		it->second->stale = true;
+	}
+}
+
+void IOLoginData::invalidateAccountLoads(uint32_t accountId)
+{
+	for (auto it = playerLoads.begin(); it != playerLoads.end(); ) {
+		const std::shared_ptr<PlayerLoad>& load = it->second;
+		if (load->accountId != accountId) {
+			++it;
+		} else if (!load->reading) {
+			it = playerLoads.erase(it);
+		} else {
+			load->stale = true;
+			++it;
+		}
+	}
+}
+
+void IOLoginData::prewarmPlayer(const Account& account)
+{
+	const int32_t prewarmTime = g_config.getNumber(ConfigManager::PLAYER_PREWARM_TIME);
+	if (prewarmTime <= 0 || !g_config.getBoolean(ConfigManager::ASYNC_PLAYER_LOAD)) {
+		return;
+	}
+
+	const int64_t now = OTSYS_TIME();
+	for (auto it = playerLoads.begin(); it != playerLoads.end(); ) {
+		const std::shared_ptr<PlayerLoad>& load = it->second;
+		if (!load->callback && !load->reading && load->expiresAt < now) {
+			it = playerLoads.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	if (nextLastCharactersSweep <= now) {
+		nextLastCharactersSweep = now + LAST_CHARACTERS_SWEEP_INTERVAL;
+		for (auto it = lastCharacters.begin(); it != lastCharacters.end(); ) {
+			if (it->second.loginTime + LAST_CHARACTER_TIME < now) {
+				it = lastCharacters.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	// the character list does not say which character will be chosen, the
+	// only one or the one the account last played with is the likely pick
+	uint32_t guid = 0;
+	if (account.characters.size() == 1) {
+		CachedCharacter character;
+		if (g_loginCache.getCharacter(account.characters.front(), character)) {
+			guid = character.guid;
+		}
+	} else {
+		auto lastIt = lastCharacters.find(account.id);
+		if (lastIt != lastCharacters.end()) {
+			guid = lastIt->second.guid;
+		}
+	}
+
+	if (guid == 0 || g_game.getPlayerByGUID(guid)) {
+		return;
+	}
+
+	auto it = playerLoads.find(guid);
+	if (it != playerLoads.end()) {
+		it->second->expiresAt = now + prewarmTime;
+		return;
+	}
+
+	auto load = std::make_shared<PlayerLoad>();
+	load->accountId = account.id;
+	load->expiresAt = now + prewarmTime;
+	playerLoads[guid] = load;
+	startPlayerLoad(guid, load);
+}
+
+void IOLoginData::addLoginTime(uint64_t dispatcherTime, uint64_t totalTime, bool async)
+{
+	PlayerLoadStats& stats = playerLoadStats[async ? 1 : 0];
+	++stats.logins;
+	stats.dispatcherTime += dispatcherTime;
+	stats.totalTime += totalTime;
+}
+
+PlayerLoadStats IOLoginData::getLoadStats(bool async)
+{
+	return playerLoadStats[async ? 1 : 0];
+}
+
+void IOLoginData::resetModified(Player* player)
+{
+	player->savedInventoryGeneration = player->inventoryGeneration;
+
+	player->savedDepotGenerations.clear();
+	for (const auto& it : player->depotLockerMap) {
+		player->savedDepotGenerations[it.first] = it.second->getGeneration();
+	}
+
+	player->storage.clearChanges(PlayerStorage::CHANGE_SAVE);
+	player->spellsModified = false;
+	player->murdersModified = false;
+	player->fullSaveRequired = false;
+}
+
+void IOLoginData::snapshotItems(const ItemBlockList& itemList, std::vector<PlayerItemRow>& rows, PropWriteStream& propWriteStream, int32_t runningId/* = 100*/)
+{
 	typedef std::pair<Container*, int32_t> containerBlock;
 	std::list<containerBlock> queue;
 
-	int32_t runningId = 100;
-
-	Database* db = Database::getInstance();
 	for (const auto& it : itemList) {
 		int32_t pid = it.first;
 		Item* item = it.second;
@@ -524,11 +1072,7 @@ bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList,
 
 		size_t attributesSize;
 		const char* attributes = propWriteStream.getStream(attributesSize);
-
-		ss << player->getGUID() << ',' << pid << ',' << runningId << ',' << item->getID() << ',' << item->getSubType() << ',' << db->escapeBlob(attributes, attributesSize);
-		if (!query_insert.addRow(ss)) {
-			return false;
-		}
+		rows.emplace_back(pid, runningId, item->getID(), item->getSubType(), std::string(attributes, attributesSize));
 
 		if (Container* container = item->getContainer()) {
 			queue.emplace_back(container, runningId);
@@ -554,36 +1098,31 @@ bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList,
 
 			size_t attributesSize;
 			const char* attributes = propWriteStream.getStream(attributesSize);
+			rows.emplace_back(parentId, runningId, item->getID(), item->getSubType(), std::string(attributes, attributesSize));
+		}
+	}
+}
 
-			ss << player->getGUID() << ',' << parentId << ',' << runningId << ',' << item->getID() << ',' << item->getSubType() << ',' << db->escapeBlob(attributes, attributesSize);
-			if (!query_insert.addRow(ss)) {
-				return false;
-			}
+bool IOLoginData::saveItems(uint32_t guid, const std::vector<PlayerItemRow>& rows, DBInsert& query_insert, Database& db)
+{
+	std::ostringstream ss;
+	for (const PlayerItemRow& row : rows) {
+		ss << guid << ',' << row.pid << ',' << row.sid << ',' << row.itemType << ',' << row.count << ',' << db.escapeBlob(row.attributes.data(), row.attributes.size());
+		if (!query_insert.addRow(ss)) {
+			return false;
 		}
 	}
 	return query_insert.execute();
 }
 
-bool IOLoginData::savePlayer(Player* player)
+void IOLoginData::snapshotPlayer(Player* player, PlayerSaveSnapshot& snapshot)
 {
 	if (player->getHealth() <= 0) {
 		player->changeHealth(1);
 	}
 
-	Database* db = Database::getInstance();
-
-	std::ostringstream query;
-	query << "SELECT `save` FROM `players` WHERE `id` = " << player->getGUID();
-	DBResult_ptr result = db->storeQuery(query.str());
-	if (!result) {
-		return false;
-	}
-
-	if (result->getNumber<uint16_t>("save") == 0) {
-		query.str(std::string());
-		query << "UPDATE `players` SET `lastlogin` = " << player->lastLoginSaved << ", `lastip` = " << player->lastIP << " WHERE `id` = " << player->getGUID();
-		return db->executeQuery(query.str());
-	}
+	snapshot.guid = player->getGUID();
+	snapshot.name = player->getName();
 
 	//serialize conditions
 	PropWriteStream propWriteStream;
@@ -596,248 +1135,447 @@ bool IOLoginData::savePlayer(Player* player)
 
 	size_t conditionsSize;
 	const char* conditions = propWriteStream.getStream(conditionsSize);
-
-	//First, an UPDATE query to write the player itself
-	query.str(std::string());
-	query << "UPDATE `players` SET ";
-	query << "`level` = " << player->level << ',';
-	query << "`group_id` = " << player->group->id << ',';
-	query << "`vocation` = " << player->getVocationId() << ',';
-	query << "`health` = " << player->health << ',';
-	query << "`healthmax` = " << player->healthMax << ',';
-	query << "`experience` = " << player->experience << ',';
-	query << "`lookbody` = " << static_cast<uint32_t>(player->defaultOutfit.lookBody) << ',';
-	query << "`lookfeet` = " << static_cast<uint32_t>(player->defaultOutfit.lookFeet) << ',';
-	query << "`lookhead` = " << static_cast<uint32_t>(player->defaultOutfit.lookHead) << ',';
-	query << "`looklegs` = " << static_cast<uint32_t>(player->defaultOutfit.lookLegs) << ',';
-	query << "`looktype` = " << player->defaultOutfit.lookType << ',';
-	query << "`maglevel` = " << player->magLevel << ',';
-	query << "`mana` = " << player->mana << ',';
-	query << "`manamax` = " << player->manaMax << ',';
-	query << "`manaspent` = " << player->manaSpent << ',';
-	query << "`soul` = " << static_cast<uint16_t>(player->soul) << ',';
-	query << "`town_id` = " << player->town->getID() << ',';
-
-	const Position& loginPosition = player->getLoginPosition();
-	query << "`posx` = " << loginPosition.getX() << ',';
-	query << "`posy` = " << loginPosition.getY() << ',';
-	query << "`posz` = " << loginPosition.getZ() << ',';
-
-	query << "`cap` = " << (player->capacity / 100) << ',';
-	query << "`sex` = " << player->sex << ',';
-
-	if (player->lastLoginSaved != 0) {
-		query << "`lastlogin` = " << player->lastLoginSaved << ',';
-	}
-
-	if (player->lastIP != 0) {
-		query << "`lastip` = " << player->lastIP << ',';
-	}
-
-	query << "`conditions` = " << db->escapeBlob(conditions, conditionsSize) << ',';
+	snapshot.conditions.assign(conditions, conditionsSize);
+
+	snapshot.level = player->level;
+	snapshot.groupId = player->group->id;
+	snapshot.vocationId = player->getVocationId();
+	snapshot.health = player->health;
+	snapshot.healthMax = player->healthMax;
+	snapshot.experience = player->experience;
+	snapshot.outfit = player->defaultOutfit;
+	snapshot.magLevel = player->magLevel;
+	snapshot.mana = player->mana;
+	snapshot.manaMax = player->manaMax;
+	snapshot.manaSpent = player->manaSpent;
+	snapshot.soul = player->soul;
+	snapshot.townId = player->town->getID();
+	snapshot.loginPosition = player->getLoginPosition();
+	snapshot.capacity = player->capacity;
+	snapshot.sex = player->sex;
+	snapshot.lastLoginSaved = player->lastLoginSaved;
+	snapshot.lastIP = player->lastIP;
 
 	if (g_game.getWorldType() != WORLD_TYPE_PVP_ENFORCED) {
-		query << "`skulltime` = " << player->getPlayerKillerEnd() << ',';
-
-		Skulls_t skull = SKULL_NONE;
-		if (player->skull == SKULL_RED) {
-			skull = SKULL_RED;
-		}
+		snapshot.saveSkull = true;
+		snapshot.skullTime = player->getPlayerKillerEnd();
+		snapshot.skull = player->skull == SKULL_RED ? SKULL_RED : SKULL_NONE;
+	}
 
-		query << "`skull` = " << static_cast<uint32_t>(skull) << ',';
+	snapshot.lastLogout = player->getLastLogout();
+	snapshot.bankBalance = player->bankBalance;
+	for (uint8_t i = SKILL_FIRST; i <= SKILL_LAST; ++i) {
+		snapshot.skills[i] = player->skills[i];
 	}
 
-	query << "`lastlogout` = " << player->getLastLogout() << ',';
-	query << "`balance` = " << player->bankBalance << ',';
+	snapshot.online = !player->isOffline();
+	if (snapshot.online) {
+		snapshot.onlineTime = time(nullptr) - player->lastLoginSaved;
+	}
+	snapshot.blessings = player->blessings;
 
-	query << "`skill_fist` = " << player->skills[SKILL_FIST].level << ',';
-	query << "`skill_fist_tries` = " << player->skills[SKILL_FIST].tries << ',';
-	query << "`skill_club` = " << player->skills[SKILL_CLUB].level << ',';
-	query << "`skill_club_tries` = " << player->skills[SKILL_CLUB].tries << ',';
-	query << "`skill_sword` = " << player->skills[SKILL_SWORD].level << ',';
-	query << "`skill_sword_tries` = " << player->skills[SKILL_SWORD].tries << ',';
-	query << "`skill_axe` = " << player->skills[SKILL_AXE].level << ',';
-	query << "`skill_axe_tries` = " << player->skills[SKILL_AXE].tries << ',';
-	query << "`skill_dist` = " << player->skills[SKILL_DISTANCE].level << ',';
-	query << "`skill_dist_tries` = " << player->skills[SKILL_DISTANCE].tries << ',';
-	query << "`skill_shielding` = " << player->skills[SKILL_SHIELD].level << ',';
-	query << "`skill_shielding_tries` = " << player->skills[SKILL_SHIELD].tries << ',';
-	query << "`skill_fishing` = " << player->skills[SKILL_FISHING].level << ',';
-	query << "`skill_fishing_tries` = " << player->skills[SKILL_FISHING].tries << ',';
+	const bool fullSave = player->fullSaveRequired;
+	snapshot.fullSave = fullSave;
 
+	if (fullSave || player->spellsModified) {
+		snapshot.saveSpells = true;
+		snapshot.learnedSpells.assign(player->learnedInstantSpellList.begin(), player->learnedInstantSpellList.end());
+	}
 
-	if (!player->isOffline()) {
-		query << "`onlinetime` = `onlinetime` + " << (time(nullptr) - player->lastLoginSaved) << ',';
+	if (fullSave || player->murdersModified) {
+		snapshot.saveMurders = true;
+		snapshot.murders.assign(player->murderTimeStamps.begin(), player->murderTimeStamps.end());
 	}
-	query << "`blessings` = " << static_cast<uint32_t>(player->blessings);
-	query << " WHERE `id` = " << player->getGUID();
 
-	DBTransaction transaction;
-	if (!transaction.begin()) {
-		return false;
+	if (fullSave) {
+		player->storage.getValues(snapshot.storage);
+	} else {
+		player->storage.getChanges(PlayerStorage::CHANGE_SAVE, snapshot.storage, snapshot.removedStorageKeys);
 	}
 
-	if (!db->executeQuery(query.str())) {
-		return false;
+	if (fullSave || player->inventoryGeneration != player->savedInventoryGeneration) {
+		snapshot.saveItems = true;
+		snapshotInventory(player, snapshot.items, propWriteStream);
 	}
 
-	// learned spells
-	query.str(std::string());
-	query << "DELETE FROM `player_spells` WHERE `player_id` = " << player->getGUID();
-	if (!db->executeQuery(query.str())) {
-		return false;
+	for (const auto& it : player->depotLockerMap) {
+		if (!fullSave) {
+			auto savedIt = player->savedDepotGenerations.find(it.first);
+			if (savedIt != player->savedDepotGenerations.end() && savedIt->second == it.second->getGeneration()) {
+				continue;
+			}
+		}
+
+		snapshot.savedDepots.push_back(it.first);
+		snapshotDepot(it.first, it.second, snapshot.depotItems, propWriteStream);
 	}
 
-	query.str(std::string());
+	resetModified(player);
+}
 
-	DBInsert spellsQuery("INSERT INTO `player_spells` (`player_id`, `name` ) VALUES ");
-	for (const std::string& spellName : player->learnedInstantSpellList) {
-		query << player->getGUID() << ',' << db->escapeString(spellName);
-		if (!spellsQuery.addRow(query)) {
-			return false;
+void IOLoginData::snapshotInventory(const Player* player, std::vector<PlayerItemRow>& rows, PropWriteStream& stream)
+{
+	ItemBlockList itemList;
+	for (int32_t slotId = 1; slotId <= 10; ++slotId) {
+		Item* item = player->inventory[slotId];
+		if (item) {
+			itemList.emplace_back(slotId, item);
 		}
 	}
+	snapshotItems(itemList, rows, stream);
+}
 
-	if (!spellsQuery.execute()) {
-		return false;
-	}
+void IOLoginData::snapshotDepot(uint32_t depotId, DepotLocker* locker, std::vector<PlayerItemRow>& rows, PropWriteStream& stream)
+{
+	ItemBlockList itemList;
+	itemList.emplace_back(depotId, locker);
+	snapshotItems(itemList, rows, stream, getDepotSidBase(depotId));
+}
 
-	query.str(std::string());
-	query << "DELETE FROM `player_murders` WHERE `player_id` = " << player->getGUID();
-	
-	if (!db->executeQuery(query.str())) {
+bool IOLoginData::savePlayerSnapshot(Database& db, const PlayerSaveSnapshot& snapshot)
+{
+	DBStatementGuard saveStatement = db.prepare("SELECT `save` FROM `players` WHERE `id` = ?");
+	saveStatement->setNumber(0, snapshot.guid);
+	DBStatementResult_ptr result = saveStatement->storeQuery();
+	if (!result) {
 		return false;
 	}
 
-	query.str(std::string());
-
-	DBInsert murdersQuery("INSERT INTO `player_murders`(`id`, `player_id`, `date`) VALUES ");
-	for (time_t timestamp : player->murderTimeStamps) {
-		query << "NULL," << player->getGUID() << ',' << timestamp;
-		if (!murdersQuery.addRow(query)) {
+	if (result->getNumber<uint16_t>(0) == 0) {
+		DBStatementGuard loginStatement = db.prepare("UPDATE `players` SET `lastlogin` = ?, `lastip` = ? WHERE `id` = ?");
+		loginStatement->setNumber(0, snapshot.lastLoginSaved);
+		loginStatement->setNumber(1, snapshot.lastIP);
+		loginStatement->setNumber(2, snapshot.guid);
+		if (!loginStatement->execute()) {
 			return false;
 		}
+
+		++savedRows;
+		return true;
 	}
 
-	if (!murdersQuery.execute()) {
-		return false;
+	//First, an UPDATE query to write the player itself. The optional columns
+	//select one of a handful of statement texts, each prepared once per connection
+	std::ostringstream query;
+	query << "UPDATE `players` SET `level` = ?, `group_id` = ?, `vocation` = ?, `health` = ?, `healthmax` = ?, `experience` = ?, ";
+	query << "`lookbody` = ?, `lookfeet` = ?, `lookhead` = ?, `looklegs` = ?, `looktype` = ?, `maglevel` = ?, `mana` = ?, `manamax` = ?, ";
+	query << "`manaspent` = ?, `soul` = ?, `town_id` = ?, `posx` = ?, `posy` = ?, `posz` = ?, `cap` = ?, `sex` = ?, ";
+	if (snapshot.lastLoginSaved != 0) {
+		query << "`lastlogin` = ?, ";
 	}
 
-	//item saving
-	query.str(std::string());
-	query << "DELETE FROM `player_items` WHERE `player_id` = " << player->getGUID();
-	if (!db->executeQuery(query.str())) {
-		return false;
+	if (snapshot.lastIP != 0) {
+		query << "`lastip` = ?, ";
+	}
+
+	query << "`conditions` = ?, ";
+	if (snapshot.saveSkull) {
+		query << "`skulltime` = ?, `skull` = ?, ";
 	}
 
-	DBInsert itemsQuery("INSERT INTO `player_items` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
+	query << "`lastlogout` = ?, `balance` = ?, `skill_fist` = ?, `skill_fist_tries` = ?, `skill_club` = ?, `skill_club_tries` = ?, ";
+	query << "`skill_sword` = ?, `skill_sword_tries` = ?, `skill_axe` = ?, `skill_axe_tries` = ?, `skill_dist` = ?, `skill_dist_tries` = ?, ";
+	query << "`skill_shielding` = ?, `skill_shielding_tries` = ?, `skill_fishing` = ?, `skill_fishing_tries` = ?, ";
+	if (snapshot.online) {
+		query << "`onlinetime` = `onlinetime` + ?, ";
+	}
+	query << "`blessings` = ? WHERE `id` = ?";
 
-	ItemBlockList itemList;
-	for (int32_t slotId = 1; slotId <= 10; ++slotId) {
-		Item* item = player->inventory[slotId];
-		if (item) {
-			itemList.emplace_back(slotId, item);
-		}
+	DBStatementGuard playerStatement = db.prepare(query.str());
+	size_t index = 0;
+	playerStatement->setNumber(index++, snapshot.level);
+	playerStatement->setNumber(index++, snapshot.groupId);
+	playerStatement->setNumber(index++, snapshot.vocationId);
+	playerStatement->setNumber(index++, snapshot.health);
+	playerStatement->setNumber(index++, snapshot.healthMax);
+	playerStatement->setNumber(index++, snapshot.experience);
+	playerStatement->setNumber(index++, static_cast<uint32_t>(snapshot.outfit.lookBody));
+	playerStatement->setNumber(index++, static_cast<uint32_t>(snapshot.outfit.lookFeet));
+	playerStatement->setNumber(index++, static_cast<uint32_t>(snapshot.outfit.lookHead));
+	playerStatement->setNumber(index++, static_cast<uint32_t>(snapshot.outfit.lookLegs));
+	playerStatement->setNumber(index++, snapshot.outfit.lookType);
+	playerStatement->setNumber(index++, snapshot.magLevel);
+	playerStatement->setNumber(index++, snapshot.mana);
+	playerStatement->setNumber(index++, snapshot.manaMax);
+	playerStatement->setNumber(index++, snapshot.manaSpent);
+	playerStatement->setNumber(index++, static_cast<uint16_t>(snapshot.soul));
+	playerStatement->setNumber(index++, snapshot.townId);
+
+	const Position& loginPosition = snapshot.loginPosition;
+	playerStatement->setNumber(index++, loginPosition.getX());
+	playerStatement->setNumber(index++, loginPosition.getY());
+	playerStatement->setNumber(index++, static_cast<uint16_t>(loginPosition.getZ()));
+
+	playerStatement->setNumber(index++, snapshot.capacity / 100);
+	playerStatement->setNumber(index++, static_cast<uint32_t>(snapshot.sex));
+
+	if (snapshot.lastLoginSaved != 0) {
+		playerStatement->setNumber(index++, snapshot.lastLoginSaved);
 	}
 
-	if (!saveItems(player, itemList, itemsQuery, propWriteStream)) {
-		return false;
+	if (snapshot.lastIP != 0) {
+		playerStatement->setNumber(index++, snapshot.lastIP);
 	}
 
-	//save depot items
-	query.str(std::string());
-	query << "DELETE FROM `player_depotitems` WHERE `player_id` = " << player->getGUID();
+	playerStatement->setBlob(index++, snapshot.conditions.data(), snapshot.conditions.size());
 
-	if (!db->executeQuery(query.str())) {
-		return false;
+	if (snapshot.saveSkull) {
+		playerStatement->setNumber(index++, snapshot.skullTime);
+		playerStatement->setNumber(index++, static_cast<uint32_t>(snapshot.skull));
 	}
 
-	DBInsert depotQuery("INSERT INTO `player_depotitems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
-	itemList.clear();
+	playerStatement->setNumber(index++, snapshot.lastLogout);
+	playerStatement->setNumber(index++, snapshot.bankBalance);
 
-	for (const auto& it : player->depotLockerMap) {
-		itemList.emplace_back(it.first, it.second);
+	for (uint8_t skill : {SKILL_FIST, SKILL_CLUB, SKILL_SWORD, SKILL_AXE, SKILL_DISTANCE, SKILL_SHIELD, SKILL_FISHING}) {
+		playerStatement->setNumber(index++, snapshot.skills[skill].level);
+		playerStatement->setNumber(index++, snapshot.skills[skill].tries);
+	}
+
+	if (snapshot.online) {
+		playerStatement->setNumber(index++, snapshot.onlineTime);
 	}
+	playerStatement->setNumber(index++, static_cast<uint32_t>(snapshot.blessings));
+	playerStatement->setNumber(index++, snapshot.guid);
 
-	if (!saveItems(player, itemList, depotQuery, propWriteStream)) {
+	DBTransaction transaction(db);
+	if (!transaction.begin()) {
 		return false;
 	}
 
-	query.str(std::string());
-	query << "DELETE FROM `player_storage` WHERE `player_id` = " << player->getGUID();
-	if (!db->executeQuery(query.str())) {
+	if (!playerStatement->execute()) {
 		return false;
 	}
 
-	query.str(std::string());
+	uint64_t rows = 1;
 
-	DBInsert storageQuery("INSERT INTO `player_storage` (`player_id`, `key`, `value`) VALUES ");
+	// learned spells
+	if (snapshot.saveSpells) {
+		DBStatementGuard deleteStatement = db.prepare("DELETE FROM `player_spells` WHERE `player_id` = ?");
+		deleteStatement->setNumber(0, snapshot.guid);
+		if (!deleteStatement->execute()) {
+			return false;
+		}
 
-	for (const auto& it : player->storageMap) {
-		query << player->getGUID() << ',' << it.first << ',' << it.second;
-		if (!storageQuery.addRow(query)) {
+		query.str(std::string());
+
+		DBInsert spellsQuery("INSERT INTO `player_spells` (`player_id`, `name` ) VALUES ", db);
+		for (const std::string& spellName : snapshot.learnedSpells) {
+			query << snapshot.guid << ',' << db.escapeString(spellName);
+			if (!spellsQuery.addRow(query)) {
+				return false;
+			}
+		}
+
+		if (!spellsQuery.execute()) {
 			return false;
 		}
+		rows += snapshot.learnedSpells.size();
 	}
 
-	for (int townId = 1; townId <= 11; townId++){		
-		Cylinder* BalanceCylinder = player->getDepotLocker(townId, true);
-		
-		std::vector<Container*> containers;
-		uint64_t moneyCount = 0;
-		for (size_t i = BalanceCylinder->getFirstIndex(), j = BalanceCylinder->getLastIndex(); i < j; ++i) {
-			Thing* thing = BalanceCylinder->getThing(i);
-			if (!thing) {
-				continue;
-			}
+	if (snapshot.saveMurders) {
+		DBStatementGuard deleteStatement = db.prepare("DELETE FROM `player_murders` WHERE `player_id` = ?");
+		deleteStatement->setNumber(0, snapshot.guid);
+		if (!deleteStatement->execute()) {
+			return false;
+		}
 
-			Item* item = thing->getItem();
-			if (!item) {
-				continue;
-			}
+		query.str(std::string());
 
-			Container* container = item->getContainer();
-			if (container) {
-				containers.push_back(container);
-			} else {
-				const uint32_t worth = item->getWorth();
-				if (worth != 0) {
-					moneyCount += worth;
-				}
+		DBInsert murdersQuery("INSERT INTO `player_murders`(`id`, `player_id`, `date`) VALUES ", db);
+		for (time_t timestamp : snapshot.murders) {
+			query << "NULL," << snapshot.guid << ',' << timestamp;
+			if (!murdersQuery.addRow(query)) {
+				return false;
 			}
 		}
 
-		size_t i = 0;
-		while (i < containers.size()) {
-			Container* container = containers[i++];
-			for (Item* item : container->getItemList()) {
-				Container* tmpContainer = item->getContainer();
-				if (tmpContainer) {
-					containers.push_back(tmpContainer);
-				} else {
-					const uint32_t worth = item->getWorth();
-					if (worth != 0) {
-						moneyCount += worth;
-					}
-				}
+		if (!murdersQuery.execute()) {
+			return false;
+		}
+		rows += snapshot.murders.size();
+	}
+
+	//item saving
+	if (snapshot.saveItems) {
+		DBStatementGuard deleteStatement = db.prepare("DELETE FROM `player_items` WHERE `player_id` = ?");
+		deleteStatement->setNumber(0, snapshot.guid);
+		if (!deleteStatement->execute()) {
+			return false;
+		}
+
+		DBInsert itemsQuery("INSERT INTO `player_items` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ", db);
+		if (!saveItems(snapshot.guid, snapshot.items, itemsQuery, db)) {
+			return false;
+		}
+		rows += snapshot.items.size();
+	}
+
+	//save depot items, only the lockers that changed unless this is a full save
+	if (snapshot.fullSave) {
+		DBStatementGuard deleteStatement = db.prepare("DELETE FROM `player_depotitems` WHERE `player_id` = ?");
+		deleteStatement->setNumber(0, snapshot.guid);
+		if (!deleteStatement->execute()) {
+			return false;
+		}
+	} else {
+		DBStatementGuard deleteStatement = db.prepare("DELETE FROM `player_depotitems` WHERE `player_id` = ? AND `sid` >= ? AND `sid` < ?");
+		for (uint32_t depotId : snapshot.savedDepots) {
+			const int32_t sidBase = getDepotSidBase(depotId);
+
+			deleteStatement->setNumber(0, snapshot.guid);
+			deleteStatement->setNumber(1, sidBase);
+			deleteStatement->setNumber(2, sidBase + DEPOT_SID_RANGE);
+			if (!deleteStatement->execute()) {
+				return false;
 			}
 		}
+	}
 
-		/* 
+	DBInsert depotQuery("INSERT INTO `player_depotitems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ", db);
+	if (!saveItems(snapshot.guid, snapshot.depotItems, depotQuery, db)) {
+		return false;
+	}
+	rows += snapshot.depotItems.size();
+
+	//save storage, keyed upserts and deletes unless this is a full save
+	if (snapshot.fullSave) {
+		DBStatementGuard deleteStatement = db.prepare("DELETE FROM `player_storage` WHERE `player_id` = ?");
+		deleteStatement->setNumber(0, snapshot.guid);
+		if (!deleteStatement->execute()) {
+			return false;
+		}
+	} else if (!snapshot.removedStorageKeys.empty()) {
 		query.str(std::string());
-		query << "UPDATE `players_balance` SET `town_" << townId << "` = " << moneyCount << " WHERE `player_id` = " << player->getGUID(); 
-		db->executeQuery(query.str());
-		*/
+		query << "DELETE FROM `player_storage` WHERE `player_id` = " << snapshot.guid << " AND `key` IN (";
+		for (size_t i = 0, size = snapshot.removedStorageKeys.size(); i < size; ++i) {
+			if (i != 0) {
+				query << ',';
+			}
+			query << snapshot.removedStorageKeys[i];
+		}
+		query << ')';
+
+		if (!db.executeQuery(query.str())) {
+			return false;
+		}
+		rows += snapshot.removedStorageKeys.size();
 	}
 
+	query.str(std::string());
+
+	DBInsert storageQuery("INSERT INTO `player_storage` (`player_id`, `key`, `value`) VALUES ", db);
+	if (!snapshot.fullSave) {
+		storageQuery.upsert({"value"});
+	}
 
+	for (const auto& it : snapshot.storage) {
+		query << snapshot.guid << ',' << it.first << ',' << it.second;
+		if (!storageQuery.addRow(query)) {
+			return false;
+		}
+	}
 
 	if (!storageQuery.execute()) {
 		return false;
 	}
+	rows += snapshot.storage.size();
 
 	//End the transaction
-	return transaction.commit();
+	if (!transaction.commit()) {
+		return false;
+	}
+
+	savedRows += rows;
+	return true;
+}
+
+bool IOLoginData::savePlayer(Player* player, const std::function<void(bool)>& callback)
+{
+	// the journal gets what this save carries first, so a save that fails
+	// can still be recovered from it and one that succeeds covers it
+	g_journal.recordPlayer(player);
+	const uint64_t journalSequence = g_journal.getSequence();
+
+	auto snapshot = std::make_shared<PlayerSaveSnapshot>();
+	snapshotPlayer(player, *snapshot);
+
+	const uint32_t guid = snapshot->guid;
+	addPendingSave(guid, snapshot->name);
+	invalidatePlayerLoad(guid);
+	g_loginCache.setCharacterGroup(snapshot->name, snapshot->groupId);
+
+	if (player->isOffline()) {
+		g_journal.forgetPlayer(guid);
+	}
+
+	bool queued = g_databaseTasks.addJob([snapshot, journalSequence](Database& db) {
+		bool saved = false;
+		for (uint32_t tries = 0; tries < 3 && !saved; ++tries) {
+			saved = savePlayerSnapshot(db, *snapshot);
+		}
+
+		if (saved) {
+			g_journal.markSaved(snapshot->guid, journalSequence);
+		} else {
+			std::cout << "Error while saving player: " << snapshot->name << std::endl;
+			g_journal.markFailed();
+		}
+
+		removePendingSave(snapshot->guid);
+		return saved;
+	}, [guid, callback](DBResult_ptr, bool success) {
+		// what this save carried is no longer known to be in the database
+		if (!success) {
+			if (Player* player = g_game.getPlayerByGUID(guid)) {
+				player->fullSaveRequired = true;
+			}
+		}
+
+		if (callback) {
+			callback(success);
+		}
+	}, guid);
+
+	if (queued) {
+		return true;
+	}
+
+	// the database thread is no longer accepting work (shutting down), so
+	// write on this thread once whatever it still holds for us is done
+	removePendingSave(guid);
+	waitForPendingSave(guid);
+	bool saved = savePlayerSnapshot(*Database::getInstance(), *snapshot);
+	if (saved) {
+		g_journal.markSaved(guid, journalSequence);
+	} else {
+		player->fullSaveRequired = true;
+		g_journal.markFailed();
+	}
+
+	if (callback) {
+		callback(saved);
+	}
+	return saved;
+}
+
+uint64_t IOLoginData::getSavedRows()
+{
+	return savedRows;
+}
+
+bool IOLoginData::hasPendingSave(uint32_t guid)
+{
+	std::lock_guard<std::mutex> lockClass(pendingSaveLock);
+	return pendingSaves.find(guid) != pendingSaves.end();
+}
+
+void IOLoginData::waitForPendingSave(uint32_t guid)
+{
+	std::unique_lock<std::mutex> lockUnique(pendingSaveLock);
+	pendingSaveSignal.wait(lockUnique, [guid]() {
+		return pendingSaves.find(guid) == pendingSaves.end();
+	});
 }
 
 std::string IOLoginData::getNameByGuid(uint32_t guid)
@@ -906,37 +1644,58 @@ bool IOLoginData::formatPlayerName(std::string& name)
 	return true;
 }
 
-void IOLoginData::loadItems(ItemMap& itemMap, DBResult_ptr result)
+void IOLoginData::readItemRows(DBStatementResult_ptr result, std::vector<PlayerItemRow>& rows)
 {
-	do {
-		uint32_t sid = result->getNumber<uint32_t>("sid");
-		uint32_t pid = result->getNumber<uint32_t>("pid");
-		uint16_t type = result->getNumber<uint16_t>("itemtype");
-		uint16_t count = result->getNumber<uint16_t>("count");
+	const size_t sidColumn = result->getColumnIndex("sid");
+	const size_t pidColumn = result->getColumnIndex("pid");
+	const size_t typeColumn = result->getColumnIndex("itemtype");
+	const size_t countColumn = result->getColumnIndex("count");
+	const size_t attributesColumn = result->getColumnIndex("attributes");
 
+	rows.reserve(result->size());
+	do {
 		unsigned long attrSize;
-		const char* attr = result->getStream("attributes", attrSize);
+		const char* attr = result->getStream(attributesColumn, attrSize);
+		rows.emplace_back(result->getNumber<int32_t>(pidColumn), result->getNumber<int32_t>(sidColumn), result->getNumber<uint16_t>(typeColumn), result->getNumber<uint16_t>(countColumn), std::string(attr ? attr : "", attrSize));
+	} while (result->next());
+}
 
+void IOLoginData::loadItems(ItemMap& itemMap, const std::vector<PlayerItemRow>& rows)
+{
+	for (const PlayerItemRow& row : rows) {
 		PropStream propStream;
-		propStream.init(attr, attrSize);
+		propStream.init(row.attributes.data(), row.attributes.size());
 
-		Item* item = Item::CreateItem(type, count);
+		Item* item = Item::CreateItem(row.itemType, row.count);
 		if (item) {
 			if (!item->unserializeAttr(propStream)) {
 				std::cout << "WARNING: Serialize error in IOLoginData::loadItems" << std::endl;
 			}
 
-			std::pair<Item*, uint32_t> pair(item, pid);
-			itemMap[sid] = pair;
+			std::pair<Item*, uint32_t> pair(item, row.pid);
+			itemMap[row.sid] = pair;
 		}
-	} while (result->next());
+	}
 }
 
 void IOLoginData::increaseBankBalance(uint32_t guid, uint64_t bankBalance)
 {
 	std::ostringstream query;
 	query << "UPDATE `players` SET `balance` = `balance` + " << bankBalance << " WHERE `id` = " << guid;
-	Database::getInstance()->executeQuery(query.str());
+
+	// queued on the player's key, behind any save of it still being written
+	const std::string update = query.str();
+	bool queued = g_databaseTasks.addJob([update](Database& db) {
+		return db.executeQuery(update);
+	}, nullptr, guid);
+
+	if (!queued) {
+		waitForPendingSave(guid);
+		Database::getInstance()->executeQuery(update);
+	}
+
+	// a load already reading goes stale and reads the row again, after this
+	invalidatePlayerLoad(guid);
 }
 
 bool IOLoginData::hasBiddedOnHouse(uint32_t guid)
@@ -974,6 +1733,7 @@ void IOLoginData::addVIPEntry(uint32_t accountId, uint32_t guid)
 	std::ostringstream query;
 	query << "INSERT INTO `account_viplist` (`account_id`, `player_id`) VALUES (" << accountId << ',' << guid << ')';
 	db->executeQuery(query.str());
+	invalidateAccountLoads(accountId);
 }
 
 void IOLoginData::removeVIPEntry(uint32_t accountId, uint32_t guid)
@@ -981,6 +1741,7 @@ void IOLoginData::removeVIPEntry(uint32_t accountId, uint32_t guid)
 	std::ostringstream query;
 	query << "DELETE FROM `account_viplist` WHERE `account_id` = " << accountId << " AND `player_id` = " << guid;
 	Database::getInstance()->executeQuery(query.str());
+	invalidateAccountLoads(accountId);
 }
 
 void IOLoginData::addPremiumDays(uint32_t accountId, int32_t addDays)
@@ -988,6 +1749,7 @@ void IOLoginData::addPremiumDays(uint32_t accountId, int32_t addDays)
 	std::ostringstream query;
 	query << "UPDATE `accounts` SET `premdays` = `premdays` + " << addDays << " WHERE `id` = " << accountId;
 	Database::getInstance()->executeQuery(query.str());
+	g_loginCache.addPremiumDays(accountId, addDays);
 }
 
 void IOLoginData::removePremiumDays(uint32_t accountId, int32_t removeDays)
@@ -995,4 +1757,5 @@ void IOLoginData::removePremiumDays(uint32_t accountId, int32_t removeDays)
 	std::ostringstream query;
 	query << "UPDATE `accounts` SET `premdays` = `premdays` - " << removeDays << " WHERE `id` = " << accountId;
 	Database::getInstance()->executeQuery(query.str());
+	g_loginCache.addPremiumDays(accountId, -removeDays);
 }
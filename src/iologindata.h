@@ -21,6 +21,107 @@
 
 typedef std::list<std::pair<int32_t, Item*>> ItemBlockList;
 
+// one row of player_items or player_depotitems
+struct PlayerItemRow
+{
+	PlayerItemRow(int32_t pid, int32_t sid, uint16_t itemType, uint16_t count, std::string attributes) :
+		pid(pid), sid(sid), itemType(itemType), count(count), attributes(std::move(attributes)) {}
+
+	int32_t pid;
+	int32_t sid;
+	uint16_t itemType;
+	uint16_t count;
+	std::string attributes;
+};
+
+// Everything savePlayer writes, copied out of the player on the dispatcher
+// so the queries can be built and executed on the database thread.
+struct PlayerSaveSnapshot
+{
+	uint32_t guid = 0;
+	std::string name;
+
+	uint32_t level = 1;
+	uint16_t groupId = 0;
+	uint16_t vocationId = 0;
+	int32_t health = 0;
+	int32_t healthMax = 0;
+	uint64_t experience = 0;
+	Outfit_t outfit;
+	uint32_t magLevel = 0;
+	uint32_t mana = 0;
+	uint32_t manaMax = 0;
+	uint64_t manaSpent = 0;
+	uint8_t soul = 0;
+	uint32_t townId = 0;
+	Position loginPosition;
+	uint32_t capacity = 0;
+	PlayerSex_t sex = PLAYERSEX_FEMALE;
+	time_t lastLoginSaved = 0;
+	uint32_t lastIP = 0;
+	std::string conditions;
+	bool saveSkull = false;
+	time_t skullTime = 0;
+	Skulls_t skull = SKULL_NONE;
+	time_t lastLogout = 0;
+	uint64_t bankBalance = 0;
+	Skill skills[SKILL_LAST + 1];
+	bool online = false;
+	time_t onlineTime = 0;
+	uint8_t blessings = 0;
+
+	// categories below are only written when they changed since the last
+	// save, fullSave rewrites all of them the way older saves did
+	bool fullSave = false;
+	bool saveSpells = false;
+	bool saveMurders = false;
+	bool saveItems = false;
+
+	std::vector<std::string> learnedSpells;
+	std::vector<time_t> murders;
+	std::vector<PlayerItemRow> items;
+	std::vector<uint32_t> savedDepots;
+	std::vector<PlayerItemRow> depotItems;
+	std::vector<std::pair<uint32_t, int32_t>> storage;
+	std::vector<uint32_t> removedStorageKeys;
+};
+
+// A player's rows read on the database workers, handed to the player on the
+// dispatcher by IOLoginData::applyPlayerLoad. The players row, spells,
+// murders, storage and item rows use the fields of the save snapshot they
+// are written from. Items are only created from their rows on the
+// dispatcher, where the item types can be reloaded.
+struct PlayerLoadData
+{
+	PlayerLoadData() = default;
+
+	// non-copyable
+	PlayerLoadData(const PlayerLoadData&) = delete;
+	PlayerLoadData& operator=(const PlayerLoadData&) = delete;
+
+	PlayerSaveSnapshot row;
+	uint32_t accountId = 0;
+	bool found = false;
+
+	uint32_t guildId = 0;
+	uint32_t guildRankId = 0;
+	uint32_t guildMemberCount = 0;
+	std::string guildNick;
+	std::string guildName;
+	std::vector<GuildRank> guildRanks;
+	GuildWarList guildWars;
+
+	std::vector<uint32_t> vipList;
+};
+
+struct PlayerLoadStats
+{
+	uint64_t logins = 0;
+	uint64_t prewarmed = 0;
+	uint64_t dispatcherTime = 0; // microseconds
+	uint64_t totalTime = 0; // microseconds
+};
+
 class IOLoginData
 {
 	public:
@@ -35,10 +136,36 @@ class IOLoginData
 		static void updateOnlineStatus(uint32_t guid, bool login);
 		static bool preloadPlayer(Player* player, const std::string& name);
 
-		static bool loadPlayerById(Player* player, uint32_t id);
+		// reads on this thread, only when no save of the player is queued
 		static bool loadPlayerByName(Player* player, const std::string& name);
-		static bool loadPlayer(Player* player, DBResult_ptr result);
-		static bool savePlayer(Player* player);
+		static bool loadPlayer(Player* player, DBStatementResult_ptr result);
+
+		// reads a player on the database workers, after the saves of it
+		// queued before, and calls callback on the dispatcher with it. That
+		// is the online player when it logged in meanwhile and nullptr when
+		// there is none, an offline player is freed once callback returns
+		static void loadOfflinePlayer(uint32_t guid, const std::function<void(Player*)>& callback);
+		static void loadOfflinePlayer(const std::string& name, const std::function<void(Player*)>& callback);
+
+		// reads the player on the database workers, callback runs on the
+		// dispatcher with data->found false when it could not be read
+		static void loadPlayerData(uint32_t guid, uint32_t accountId, const std::function<void(const std::shared_ptr<PlayerLoadData>&)>& callback);
+		static bool readPlayer(Database& db, uint32_t guid, PlayerLoadData& data);
+		static bool isPlayerLoading(uint32_t guid);
+		static bool applyPlayerLoad(Player* player, PlayerLoadData& data);
+		// starts reading the character the account will probably choose
+		static void prewarmPlayer(const Account& account);
+		static void addLoginTime(uint64_t dispatcherTime, uint64_t totalTime, bool async);
+		static PlayerLoadStats getLoadStats(bool async);
+
+		static bool savePlayer(Player* player, const std::function<void(bool)>& callback = nullptr);
+		static void snapshotPlayer(Player* player, PlayerSaveSnapshot& snapshot);
+		static void snapshotInventory(const Player* player, std::vector<PlayerItemRow>& rows, PropWriteStream& stream);
+		static void snapshotDepot(uint32_t depotId, DepotLocker* locker, std::vector<PlayerItemRow>& rows, PropWriteStream& stream);
+		static bool savePlayerSnapshot(Database& db, const PlayerSaveSnapshot& snapshot);
+		static bool hasPendingSave(uint32_t guid);
+		static void waitForPendingSave(uint32_t guid);
+		static uint64_t getSavedRows();
 		static uint32_t getGuidByName(const std::string& name);
 		static bool getGuidByNameEx(uint32_t& guid, bool& specialVip, std::string& name);
 		static std::string getNameByGuid(uint32_t guid);
@@ -56,8 +183,19 @@ class IOLoginData
 	protected:
 		typedef std::map<uint32_t, std::pair<Item*, uint32_t>> ItemMap;
 
-		static void loadItems(ItemMap& itemMap, DBResult_ptr result);
-		static bool saveItems(const Player* player, const ItemBlockList& itemList, DBInsert& query_insert, PropWriteStream& stream);
+		static void readItemRows(DBStatementResult_ptr result, std::vector<PlayerItemRow>& rows);
+		static void loadItems(ItemMap& itemMap, const std::vector<PlayerItemRow>& rows);
+		static bool readPlayer(Database& db, DBStatementResult_ptr result, PlayerLoadData& data);
+		static bool readPlayerRow(DBStatementResult_ptr result, PlayerLoadData& data);
+		static void queryPlayerLists(Database& db, uint32_t guid, PlayerLoadData& data);
+		static void queryAccountData(Database& db, uint32_t guid, uint32_t accountId, PlayerLoadData& data);
+		static void queryInventory(Database& db, uint32_t guid, PlayerLoadData& data);
+		static void queryDepot(Database& db, uint32_t guid, PlayerLoadData& data);
+		static void invalidatePlayerLoad(uint32_t guid);
+		static void invalidateAccountLoads(uint32_t accountId);
+		static void snapshotItems(const ItemBlockList& itemList, std::vector<PlayerItemRow>& rows, PropWriteStream& stream, int32_t runningId = 100);
+		static void resetModified(Player* player);
+		static bool saveItems(uint32_t guid, const std::vector<PlayerItemRow>& rows, DBInsert& query_insert, Database& db);
 };
 
 #endif
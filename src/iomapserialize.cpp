@@ -17,9 +17,13 @@
 #include "iomapserialize.h"
 #include "game.h"
 #include "bed.h"
+#include "databasetasks.h"
 
 extern Game g_game;
 
+static std::atomic<uint64_t> savedRows{0};
+static std::atomic<uint64_t> savedBytes{0};
+
 void IOMapSerialize::loadHouseItems(Map* map)
 {
 	int64_t start = OTSYS_TIME();
@@ -59,55 +63,6 @@ void IOMapSerialize::loadHouseItems(Map* map)
 	std::cout << "> Loaded house items in: " << (OTSYS_TIME() - start) / (1000.) << " s" << std::endl;
 }
 
-bool IOMapSerialize::saveHouseItems()
-{
-	int64_t start = OTSYS_TIME();
-	Database* db = Database::getInstance();
-	std::ostringstream query;
-
-	//Start the transaction
-	DBTransaction transaction;
-	if (!transaction.begin()) {
-		return false;
-	}
-
-	//clear old tile data
-	if (!db->executeQuery("DELETE FROM `tile_store`")) {
-		return false;
-	}
-
-	DBInsert stmt("INSERT INTO `tile_store` (`house_id`, `data`) VALUES ");
-
-	PropWriteStream stream;
-	for (const auto& it : g_game.map.houses.getHouses()) {
-		//save house items
-		House* house = it.second;
-		for (HouseTile* tile : house->getTiles()) {
-			saveTile(stream, tile);
-
-			size_t attributesSize;
-			const char* attributes = stream.getStream(attributesSize);
-			if (attributesSize > 0) {
-				query << house->getId() << ',' << db->escapeBlob(attributes, attributesSize);
-				if (!stmt.addRow(query)) {
-					return false;
-				}
-				stream.clear();
-			}
-		}
-	}
-
-	if (!stmt.execute()) {
-		return false;
-	}
-
-	//End the transaction
-	bool success = transaction.commit();
-	std::cout << "> Saved house items in: " <<
-	          (OTSYS_TIME() - start) / (1000.) << " s" << std::endl;
-	return success;
-}
-
 bool IOMapSerialize::loadContainer(PropStream& propStream, Container* container)
 {
 	while (container->serializationCount > 0) {
@@ -293,75 +248,217 @@ bool IOMapSerialize::loadHouseInfo()
 	return true;
 }
 
-bool IOMapSerialize::saveHouseInfo()
+void IOMapSerialize::snapshotHouse(House* house, HouseSaveSnapshot& snapshot, bool fullSave)
 {
-	Database* db = Database::getInstance();
+	snapshot.id = house->getId();
+	snapshot.saveInfo = fullSave || house->isInfoModified();
+	snapshot.saveItems = fullSave || house->isItemsModified();
+	snapshot.infoGeneration = house->getInfoGeneration();
+	snapshot.itemsGeneration = house->getItemsGeneration();
+
+	if (snapshot.saveInfo) {
+		snapshot.owner = house->getOwner();
+		snapshot.paidUntil = house->getPaidUntil();
+		snapshot.payRentWarnings = house->getPayRentWarnings();
+		snapshot.name = house->getName();
+		snapshot.townId = house->getTownId();
+		snapshot.rent = house->getRent();
+		snapshot.size = house->getTiles().size();
+		snapshot.beds = house->getBedCount();
 
-	DBTransaction transaction;
-	if (!transaction.begin()) {
-		return false;
+		std::string listText;
+		if (house->getAccessList(GUEST_LIST, listText) && !listText.empty()) {
+			snapshot.accessLists.emplace_back(GUEST_LIST, std::move(listText));
+			listText.clear();
+		}
+
+		if (house->getAccessList(SUBOWNER_LIST, listText) && !listText.empty()) {
+			snapshot.accessLists.emplace_back(SUBOWNER_LIST, std::move(listText));
+			listText.clear();
+		}
+
+		for (Door* door : house->getDoors()) {
+			if (door->getAccessList(listText) && !listText.empty()) {
+				snapshot.accessLists.emplace_back(door->getDoorId(), std::move(listText));
+				listText.clear();
+			}
+		}
 	}
 
-	if (!db->executeQuery("DELETE FROM `house_lists`")) {
+	if (snapshot.saveItems) {
+		PropWriteStream stream;
+		for (HouseTile* tile : house->getTiles()) {
+			saveTile(stream, tile);
+
+			size_t attributesSize;
+			const char* attributes = stream.getStream(attributesSize);
+			if (attributesSize > 0) {
+				snapshot.tiles.emplace_back(attributes, attributesSize);
+				stream.clear();
+			}
+		}
+	}
+}
+
+bool IOMapSerialize::saveHouseSnapshot(Database& db, const HouseSaveSnapshot& snapshot)
+{
+	DBTransaction transaction(db);
+	if (!transaction.begin()) {
 		return false;
 	}
 
 	std::ostringstream query;
-	for (const auto& it : g_game.map.houses.getHouses()) {
-		House* house = it.second;
-		query << "SELECT `id` FROM `houses` WHERE `id` = " << house->getId();
-		DBResult_ptr result = db->storeQuery(query.str());
-		if (result) {
-			query.str(std::string());
-			query << "UPDATE `houses` SET `owner` = " << house->getOwner() << ", `paid` = " << house->getPaidUntil() << ", `warnings` = " << house->getPayRentWarnings() << ", `name` = " << db->escapeString(house->getName()) << ", `town_id` = " << house->getTownId() << ", `rent` = " << house->getRent() << ", `size` = " << house->getTiles().size() << ", `beds` = " << house->getBedCount() << " WHERE `id` = " << house->getId();
-		} else {
-			query.str(std::string());
-			query << "INSERT INTO `houses` (`id`, `owner`, `paid`, `warnings`, `name`, `town_id`, `rent`, `size`, `beds`) VALUES (" << house->getId() << ',' << house->getOwner() << ',' << house->getPaidUntil() << ',' << house->getPayRentWarnings() << ',' << db->escapeString(house->getName()) << ',' << house->getTownId() << ',' << house->getRent() << ',' << house->getTiles().size() << ',' << house->getBedCount() << ')';
+	uint64_t rows = 0, bytes = 0;
+
+	if (snapshot.saveInfo) {
+		DBStatementGuard houseStatement = db.prepare("INSERT INTO `houses` (`id`, `owner`, `paid`, `warnings`, `name`, `town_id`, `rent`, `size`, `beds`) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?) ON DUPLICATE KEY UPDATE `owner` = VALUES(`owner`), `paid` = VALUES(`paid`), `warnings` = VALUES(`warnings`), `name` = VALUES(`name`), `town_id` = VALUES(`town_id`), `rent` = VALUES(`rent`), `size` = VALUES(`size`), `beds` = VALUES(`beds`)");
+		houseStatement->setNumber(0, snapshot.id);
+		houseStatement->setNumber(1, snapshot.owner);
+		houseStatement->setNumber(2, snapshot.paidUntil);
+		houseStatement->setNumber(3, snapshot.payRentWarnings);
+		houseStatement->setString(4, snapshot.name);
+		houseStatement->setNumber(5, snapshot.townId);
+		houseStatement->setNumber(6, snapshot.rent);
+		houseStatement->setNumber(7, snapshot.size);
+		houseStatement->setNumber(8, snapshot.beds);
+		if (!houseStatement->execute()) {
+			return false;
 		}
+		++rows;
 
-		db->executeQuery(query.str());
-		query.str(std::string());
-	}
+		DBStatementGuard listsStatement = db.prepare("DELETE FROM `house_lists` WHERE `house_id` = ?");
+		listsStatement->setNumber(0, snapshot.id);
+		if (!listsStatement->execute()) {
+			return false;
+		}
 
-	DBInsert stmt("INSERT INTO `house_lists` (`house_id` , `listid` , `list`) VALUES ");
+		DBInsert listsQuery("INSERT INTO `house_lists` (`house_id` , `listid` , `list`) VALUES ", db);
+		for (const auto& it : snapshot.accessLists) {
+			query << snapshot.id << ',' << it.first << ',' << db.escapeString(it.second);
+			if (!listsQuery.addRow(query)) {
+				return false;
+			}
+			bytes += it.second.size();
+		}
 
-	for (const auto& it : g_game.map.houses.getHouses()) {
-		House* house = it.second;
+		if (!listsQuery.execute()) {
+			return false;
+		}
+		rows += snapshot.accessLists.size();
+	}
 
-		std::string listText;
-		if (house->getAccessList(GUEST_LIST, listText) && !listText.empty()) {
-			query << house->getId() << ',' << GUEST_LIST << ',' << db->escapeString(listText);
-			if (!stmt.addRow(query)) {
+	if (snapshot.saveItems) {
+		DBStatementGuard tilesStatement = db.prepare("DELETE FROM `tile_store` WHERE `house_id` = ?");
+		tilesStatement->setNumber(0, snapshot.id);
+		if (!tilesStatement->execute()) {
+			return false;
+		}
+
+		DBInsert tilesQuery("INSERT INTO `tile_store` (`house_id`, `data`) VALUES ", db);
+		for (const std::string& tile : snapshot.tiles) {
+			query << snapshot.id << ',' << db.escapeBlob(tile.data(), tile.size());
+			if (!tilesQuery.addRow(query)) {
 				return false;
 			}
+			bytes += tile.size();
+		}
 
-			listText.clear();
+		if (!tilesQuery.execute()) {
+			return false;
 		}
+		rows += snapshot.tiles.size();
+	}
 
-		if (house->getAccessList(SUBOWNER_LIST, listText) && !listText.empty()) {
-			query << house->getId() << ',' << SUBOWNER_LIST << ',' << db->escapeString(listText);
-			if (!stmt.addRow(query)) {
-				return false;
+	if (!transaction.commit()) {
+		return false;
+	}
+
+	savedRows += rows;
+	savedBytes += bytes;
+	return true;
+}
+
+size_t IOMapSerialize::saveHouses(const std::function<void(bool)>& callback)
+{
+	const auto& houses = g_game.map.houses.getHouses();
+	if (houses.empty()) {
+		return 0;
+	}
+
+	// the first save after startup writes every house, the map may have
+	// changed the size, rent or name of any of them
+	static bool fullSaveDone = false;
+	const bool fullSave = !fullSaveDone;
+	if (fullSave) {
+		// tiles of houses that are no longer on the map would otherwise be
+		// loaded back onto whatever took their place
+		std::ostringstream query;
+		query << "DELETE FROM `tile_store` WHERE `house_id` NOT IN (";
+		for (auto it = houses.begin(); it != houses.end(); ++it) {
+			if (it != houses.begin()) {
+				query << ',';
 			}
+			query << it->first;
+		}
+		query << ')';
+		g_databaseTasks.addTask(query.str());
+		fullSaveDone = true;
+	}
 
-			listText.clear();
+	size_t queued = 0;
+	for (const auto& it : houses) {
+		House* house = it.second;
+		if (!fullSave && !house->isInfoModified() && !house->isItemsModified()) {
+			continue;
 		}
 
-		for (Door* door : house->getDoors()) {
-			if (door->getAccessList(listText) && !listText.empty()) {
-				query << house->getId() << ',' << door->getDoorId() << ',' << db->escapeString(listText);
-				if (!stmt.addRow(query)) {
-					return false;
+		auto snapshot = std::make_shared<HouseSaveSnapshot>();
+		snapshotHouse(house, *snapshot, fullSave);
+
+		// only what this save carried is known to be in the database
+		std::function<void(bool)> onSaved = [house, snapshot, callback](bool success) {
+			if (success) {
+				if (snapshot->saveInfo) {
+					house->setSavedInfoGeneration(snapshot->infoGeneration);
 				}
+				if (snapshot->saveItems) {
+					house->setSavedItemsGeneration(snapshot->itemsGeneration);
+				}
+			}
 
-				listText.clear();
+			if (callback) {
+				callback(success);
+			}
+		};
+
+		bool added = g_databaseTasks.addJob([snapshot](Database& db) {
+			for (uint32_t tries = 0; tries < 3; ++tries) {
+				if (saveHouseSnapshot(db, *snapshot)) {
+					return true;
+				}
 			}
+
+			std::cout << "Error while saving house: " << snapshot->id << std::endl;
+			return false;
+		}, [onSaved](DBResult_ptr, bool success) {
+			onSaved(success);
+		}, snapshot->id);
+
+		if (!added) {
+			// the workers are no longer accepting work (shutting down)
+			onSaved(saveHouseSnapshot(*Database::getInstance(), *snapshot));
 		}
+		++queued;
 	}
+	return queued;
+}
 
-	if (!stmt.execute()) {
-		return false;
-	}
+uint64_t IOMapSerialize::getSavedRows()
+{
+	return savedRows;
+}
 
-	return transaction.commit();
+uint64_t IOMapSerialize::getSavedBytes()
+{
+	return savedBytes;
 }
@@ -18,13 +18,45 @@
 #include "database.h"
 #include "map.h"
 
+// Everything a house save writes, copied out of the house on the dispatcher
+struct HouseSaveSnapshot {
+	uint32_t id = 0;
+	uint32_t owner = 0;
+	time_t paidUntil = 0;
+	uint32_t payRentWarnings = 0;
+	std::string name;
+	uint32_t townId = 0;
+	uint32_t rent = 0;
+	uint32_t size = 0;
+	uint32_t beds = 0;
+
+	std::vector<std::pair<uint32_t, std::string>> accessLists;
+	std::vector<std::string> tiles; // serialized tile_store rows
+
+	// the parts a save writes, and the house generations they were taken at
+	bool saveInfo = true;
+	bool saveItems = true;
+	uint32_t infoGeneration = 0;
+	uint32_t itemsGeneration = 0;
+};
+
 class IOMapSerialize
 {
 	public:
 		static void loadHouseItems(Map* map);
-		static bool saveHouseItems();
 		static bool loadHouseInfo();
-		static bool saveHouseInfo();
+
+		// snapshots every house changed since its last save and queues one save
+		// per house on the database workers, callback runs on the dispatcher as
+		// each one is written. Returns the number of houses queued
+		static size_t saveHouses(const std::function<void(bool)>& callback);
+
+		static void snapshotHouse(House* house, HouseSaveSnapshot& snapshot, bool fullSave);
+		static bool saveHouseSnapshot(Database& db, const HouseSaveSnapshot& snapshot);
+
+		// totals over every house save of this process
+		static uint64_t getSavedRows();
+		static uint64_t getSavedBytes();
 
 	protected:
 		static void saveItem(PropWriteStream& stream, const Item* item);
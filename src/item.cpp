@@ -21,6 +21,7 @@
 #include "house.h"
 #include "game.h"
 #include "bed.h"
+#include "objectpool.h"
 
 #include "actions.h"
 #include "spells.h"
@@ -31,6 +32,28 @@ extern Vocations g_vocations;
 
 Items Item::items;
 
+// the attribute of the lowest bit set in bits
+static itemAttrTypes getLowestAttribute(uint32_t bits)
+{
+	return static_cast<itemAttrTypes>(bits & (~bits + 1));
+}
+
+static ObjectPool& getItemPool()
+{
+	static ObjectPool& pool = ObjectPool::create("Item", sizeof(Item));
+	return pool;
+}
+
+void* Item::operator new(size_t size)
+{
+	return getItemPool().allocate(size);
+}
+
+void Item::operator delete(void* object, size_t size)
+{
+	getItemPool().deallocate(object, size);
+}
+
 Item* Item::CreateItem(const uint16_t type, uint16_t count /*= 0*/)
 {
 	Item* newItem = nullptr;
@@ -184,6 +207,11 @@ Item* Item::clone() const
 	Item* item = Item::CreateItem(id, count);
 	if (attributes) {
 		item->attributes.reset(new ItemAttributes(*attributes));
+
+		// the copy is not queued, it decays from the time left once started
+		if (item->getDecaying() == DECAYING_TRUE) {
+			item->setDecaying(DECAYING_PENDING);
+		}
 	}
 	return item;
 }
@@ -203,21 +231,17 @@ bool Item::equals(const Item* otherItem) const
 		return false;
 	}
 
-	const auto& attributeList = attributes->attributes;
-	const auto& otherAttributeList = otherAttributes->attributes;
-	for (const auto& attribute : attributeList) {
-		if (ItemAttributes::isStrAttrType(attribute.type)) {
-			for (const auto& otherAttribute : otherAttributeList) {
-				if (attribute.type == otherAttribute.type && *attribute.value.string != *otherAttribute.value.string) {
-					return false;
-				}
-			}
-		} else {
-			for (const auto& otherAttribute : otherAttributeList) {
-				if (attribute.type == otherAttribute.type && attribute.value.integer != otherAttribute.value.integer) {
-					return false;
-				}
+	// same bits, so the values are in the same slots
+	const ItemAttributes::Value* values = attributes->getValues();
+	const ItemAttributes::Value* otherValues = otherAttributes->getValues();
+	for (uint32_t bits = attributes->attributeBits, index = 0; bits != 0; bits &= bits - 1, ++index) {
+		if (ItemAttributes::isStrAttrType(getLowestAttribute(bits))) {
+			// interned, the same text is the same entry
+			if (values[index].text != otherValues[index].text) {
+				return false;
 			}
+		} else if (values[index].integer != otherValues[index].integer) {
+			return false;
 		}
 	}
 	return true;
@@ -241,12 +265,18 @@ void Item::setDefaultSubtype()
 void Item::onRemoved()
 {
 	ScriptEnvironment::removeTempItem(this);
+
+	// a partly removed stack is still in place
+	if (isRemoved()) {
+		g_game.stopDecay(this);
+	}
 }
 
 void Item::setID(uint16_t newid)
 {
 	const ItemType& prevIt = Item::items[id];
 	id = newid;
+	markModified();
 
 	const ItemType& it = Item::items[newid];
 	uint32_t newDuration = it.decayTime * 1000;
@@ -264,6 +294,42 @@ void Item::setID(uint16_t newid)
 	}
 }
 
+void Item::setDuration(int32_t time)
+{
+	if (getDecaying() != DECAYING_TRUE) {
+		setIntAttr(ITEM_ATTRIBUTE_DURATION, time);
+		return;
+	}
+
+	// the queue entry for the old time is dropped once it comes up
+	getAttributes()->setIntAttr(ITEM_ATTRIBUTE_DURATION, OTSYS_TIME() + time);
+	markModified();
+	g_game.queueDecay(this);
+}
+
+uint32_t Item::getDuration() const
+{
+	if (!attributes) {
+		return 0;
+	}
+
+	if (getDecaying() != DECAYING_TRUE) {
+		return getIntAttr(ITEM_ATTRIBUTE_DURATION);
+	}
+	return std::max<int64_t>(0, getDecayTime() - OTSYS_TIME());
+}
+
+void Item::setDecaying(ItemDecayState_t decayState)
+{
+	const bool decaying = getDecaying() == DECAYING_TRUE;
+	if (decaying && decayState != DECAYING_TRUE) {
+		setIntAttr(ITEM_ATTRIBUTE_DURATION, getDuration());
+	} else if (!decaying && decayState == DECAYING_TRUE) {
+		getAttributes()->setIntAttr(ITEM_ATTRIBUTE_DURATION, OTSYS_TIME() + getDuration());
+	}
+	setIntAttr(ITEM_ATTRIBUTE_DECAYSTATE, decayState);
+}
+
 Cylinder* Item::getTopParent()
 {
 	Cylinder* aux = getParent();
@@ -348,6 +414,48 @@ Player* Item::getHoldingPlayer() const
 	return nullptr;
 }
 
+static void markTreeModified(Thing* thing)
+{
+	while (thing) {
+		if (Container* container = thing->getContainer()) {
+			container->incrementGeneration();
+		} else if (Creature* creature = thing->getCreature()) {
+			if (Player* player = creature->getPlayer()) {
+				player->incrementInventoryGeneration();
+			}
+			return;
+		} else if (!thing->getItem()) {
+			// the tile the tree lies on, house tiles are saved per house
+			Tile* tile = thing->getTile();
+			if (tile) {
+				if (House* house = tile->getHouse()) {
+					house->markItemsModified();
+				}
+			}
+			return;
+		}
+
+		thing = thing->getParent();
+	}
+}
+
+void Item::markModified()
+{
+	markTreeModified(this);
+}
+
+void Item::setParent(Cylinder* cylinder)
+{
+	if (parent) {
+		markTreeModified(parent);
+	}
+
+	parent = cylinder;
+	if (cylinder) {
+		markTreeModified(cylinder);
+	}
+}
+
 void Item::setSubType(uint16_t n)
 {
 	const ItemType& it = items[id];
@@ -456,6 +564,16 @@ Attr_ReadValue Item::readAttr(AttrTypes_t attr, PropStream& propStream)
 			break;
 		}
 
+		case ATTR_DECAY_TIME: {
+			int64_t decayTime;
+			if (!propStream.read<int64_t>(decayTime)) {
+				return ATTR_READ_ERROR;
+			}
+
+			setDuration(std::min<int64_t>(std::numeric_limits<int32_t>::max(), std::max<int64_t>(0, decayTime - OTSYS_TIME())));
+			break;
+		}
+
 		case ATTR_DECAYING_STATE: {
 			uint8_t state;
 			if (!propStream.read<uint8_t>(state)) {
@@ -783,12 +901,17 @@ void Item::serializeAttr(PropWriteStream& propWriteStream) const
 		propWriteStream.writeString(specialDesc);
 	}
 
-	if (hasAttribute(ITEM_ATTRIBUTE_DURATION)) {
+	ItemDecayState_t decayState = getDecaying();
+	if (decayState == DECAYING_TRUE) {
+		// the time it decays at, a tree saved before stays right however
+		// long it is kept unchanged
+		propWriteStream.write<uint8_t>(ATTR_DECAY_TIME);
+		propWriteStream.write<int64_t>(getDecayTime());
+	} else if (hasAttribute(ITEM_ATTRIBUTE_DURATION)) {
 		propWriteStream.write<uint8_t>(ATTR_DURATION);
-		propWriteStream.write<uint32_t>(getIntAttr(ITEM_ATTRIBUTE_DURATION));
+		propWriteStream.write<uint32_t>(getDuration());
 	}
 
-	ItemDecayState_t decayState = getDecaying();
 	if (decayState == DECAYING_TRUE || decayState == DECAYING_PENDING) {
 		propWriteStream.write<uint8_t>(ATTR_DECAYING_STATE);
 		propWriteStream.write<uint8_t>(decayState);
@@ -889,27 +1012,6 @@ void Item::serializeAttr(PropWriteStream& propWriteStream) const
 	}
 }
 
-bool Item::hasProperty(ITEMPROPERTY prop) const
-{
-	const ItemType& it = items[id];
-	switch (prop) {
-		case CONST_PROP_BLOCKSOLID: return it.blockSolid;
-		case CONST_PROP_MOVEABLE: return it.moveable;
-		case CONST_PROP_HASHEIGHT: return it.hasHeight;
-		case CONST_PROP_BLOCKPROJECTILE: return it.blockProjectile;
-		case CONST_PROP_BLOCKPATH: return it.blockPathFind;
-		case CONST_PROP_ISVERTICAL: return it.isVertical;
-		case CONST_PROP_ISHORIZONTAL: return it.isHorizontal;
-		case CONST_PROP_IMMOVABLEBLOCKSOLID: return it.blockSolid && !it.moveable;
-		case CONST_PROP_IMMOVABLEBLOCKPATH: return it.blockPathFind && !it.moveable;
-		case CONST_PROP_IMMOVABLENOFIELDBLOCKPATH: return !it.isMagicField() && it.blockPathFind && !it.moveable;
-		case CONST_PROP_NOFIELDBLOCKPATH: return !it.isMagicField() && it.blockPathFind;
-		case CONST_PROP_SUPPORTHANGABLE: return it.isHorizontal || it.isVertical;
-		case CONST_PROP_UNLAY: return !it.allowPickupable;
-		default: return false;
-	}
-}
-
 uint32_t Item::getWeight() const
 {
 	uint32_t weight = getBaseWeight();
@@ -1336,6 +1438,61 @@ void Item::getLight(LightInfo& lightInfo) const
 }
 
 std::string ItemAttributes::emptyString;
+ItemAttributes::TextMap& ItemAttributes::getTexts()
+{
+	// never destroyed, items of other static objects can outlive it
+	static TextMap* texts = new TextMap;
+	return *texts;
+}
+
+ItemAttributes::Text* ItemAttributes::acquireText(const std::string& value)
+{
+	Text& text = *getTexts().emplace(value, 0).first;
+	++text.second;
+	return &text;
+}
+
+void ItemAttributes::releaseText(Text* text)
+{
+	if (--text->second == 0) {
+		TextMap& texts = getTexts();
+		texts.erase(texts.find(text->first));
+	}
+}
+
+ItemAttributes::~ItemAttributes()
+{
+	Value* values = getValues();
+	for (uint32_t bits = attributeBits, index = 0; bits != 0; bits &= bits - 1, ++index) {
+		if (isStrAttrType(getLowestAttribute(bits))) {
+			releaseText(values[index].text);
+		}
+	}
+
+	if (capacity > INLINE_VALUES) {
+		delete[] heapValues;
+	}
+}
+
+ItemAttributes::ItemAttributes(const ItemAttributes& other) : attributeBits(other.attributeBits)
+{
+	const uint8_t count = std::bitset<32>(attributeBits).count();
+	if (count > capacity) {
+		capacity = count;
+		heapValues = new Value[capacity];
+	}
+
+	Value* values = getValues();
+	const Value* otherValues = other.getValues();
+	for (uint32_t bits = attributeBits, index = 0; bits != 0; bits &= bits - 1, ++index) {
+		if (isStrAttrType(getLowestAttribute(bits))) {
+			values[index].text = otherValues[index].text;
+			++values[index].text->second;
+		} else {
+			values[index] = otherValues[index];
+		}
+	}
+}
 
 const std::string& ItemAttributes::getStrAttr(itemAttrTypes type) const
 {
@@ -1343,11 +1500,11 @@ const std::string& ItemAttributes::getStrAttr(itemAttrTypes type) const
 		return emptyString;
 	}
 
-	const Attribute* attr = getExistingAttr(type);
+	const Value* attr = getExistingAttr(type);
 	if (!attr) {
 		return emptyString;
 	}
-	return *attr->value.string;
+	return attr->text->first;
 }
 
 void ItemAttributes::setStrAttr(itemAttrTypes type, const std::string& value)
@@ -1360,9 +1517,12 @@ void ItemAttributes::setStrAttr(itemAttrTypes type, const std::string& value)
 		return;
 	}
 
-	Attribute& attr = getAttr(type);
-	delete attr.value.string;
-	attr.value.string = new std::string(value);
+	Text* text = acquireText(value);
+	Value& attr = getAttr(type);
+	if (attr.text) {
+		releaseText(attr.text);
+	}
+	attr.text = text;
 }
 
 void ItemAttributes::removeAttribute(itemAttrTypes type)
@@ -1371,19 +1531,14 @@ void ItemAttributes::removeAttribute(itemAttrTypes type)
 		return;
 	}
 
-	auto prev_it = attributes.cbegin();
-	if ((*prev_it).type == type) {
-		attributes.pop_front();
-	} else {
-		auto it = prev_it, end = attributes.cend();
-		while (++it != end) {
-			if ((*it).type == type) {
-				attributes.erase_after(prev_it);
-				break;
-			}
-			prev_it = it;
-		}
+	Value* values = getValues();
+	const size_t index = getIndex(type);
+	if (isStrAttrType(type)) {
+		releaseText(values[index].text);
 	}
+
+	const size_t count = std::bitset<32>(attributeBits).count();
+	std::move(values + index + 1, values + count, values + index);
 	attributeBits &= ~type;
 }
 
@@ -1393,11 +1548,11 @@ int64_t ItemAttributes::getIntAttr(itemAttrTypes type) const
 		return 0;
 	}
 
-	const Attribute* attr = getExistingAttr(type);
+	const Value* attr = getExistingAttr(type);
 	if (!attr) {
 		return 0;
 	}
-	return attr->value.integer;
+	return attr->integer;
 }
 
 void ItemAttributes::setIntAttr(itemAttrTypes type, int64_t value)
@@ -1406,7 +1561,7 @@ void ItemAttributes::setIntAttr(itemAttrTypes type, int64_t value)
 		return;
 	}
 
-	getAttr(type).value.integer = value;
+	getAttr(type).integer = value;
 }
 
 void ItemAttributes::increaseIntAttr(itemAttrTypes type, int64_t value)
@@ -1415,34 +1570,43 @@ void ItemAttributes::increaseIntAttr(itemAttrTypes type, int64_t value)
 		return;
 	}
 
-	getAttr(type).value.integer += value;
+	getAttr(type).integer += value;
 }
 
-const ItemAttributes::Attribute* ItemAttributes::getExistingAttr(itemAttrTypes type) const
+const ItemAttributes::Value* ItemAttributes::getExistingAttr(itemAttrTypes type) const
 {
-	if (hasAttribute(type)) {
-		for (const Attribute& attribute : attributes) {
-			if (attribute.type == type) {
-				return &attribute;
-			}
-		}
+	if (!hasAttribute(type)) {
+		return nullptr;
 	}
-	return nullptr;
+	return &getValues()[getIndex(type)];
 }
 
-ItemAttributes::Attribute& ItemAttributes::getAttr(itemAttrTypes type)
+ItemAttributes::Value& ItemAttributes::getAttr(itemAttrTypes type)
 {
+	const size_t index = getIndex(type);
 	if (hasAttribute(type)) {
-		for (Attribute& attribute : attributes) {
-			if (attribute.type == type) {
-				return attribute;
-			}
+		return getValues()[index];
+	}
+
+	const size_t count = std::bitset<32>(attributeBits).count();
+	if (count == capacity) {
+		const uint8_t newCapacity = capacity * 2;
+		Value* newValues = new Value[newCapacity];
+		std::copy(getValues(), getValues() + count, newValues);
+		if (capacity > INLINE_VALUES) {
+			delete[] heapValues;
 		}
+
+		heapValues = newValues;
+		capacity = newCapacity;
 	}
 
+	Value* values = getValues();
+	std::move_backward(values + index, values + count, values + count + 1);
+	values[index].integer = 0;
+	values[index].text = nullptr;
 	attributeBits |= type;
-	attributes.emplace_front(type);
-	return attributes.front();
+	return values[index];
 }
 
 void Item::startDecaying()
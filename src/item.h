@@ -22,6 +22,7 @@
 #include "luascript.h"
 #include "tools.h"
 #include <typeinfo>
+#include <bitset>
 
 #include <boost/variant.hpp>
 #include <boost/lexical_cast.hpp>
@@ -37,22 +38,6 @@ class Door;
 class MagicField;
 class BedItem;
 
-enum ITEMPROPERTY {
-	CONST_PROP_BLOCKSOLID = 0,
-	CONST_PROP_HASHEIGHT,
-	CONST_PROP_BLOCKPROJECTILE,
-	CONST_PROP_BLOCKPATH,
-	CONST_PROP_ISVERTICAL,
-	CONST_PROP_ISHORIZONTAL,
-	CONST_PROP_MOVEABLE,
-	CONST_PROP_IMMOVABLEBLOCKSOLID,
-	CONST_PROP_IMMOVABLEBLOCKPATH,
-	CONST_PROP_IMMOVABLENOFIELDBLOCKPATH,
-	CONST_PROP_NOFIELDBLOCKPATH,
-	CONST_PROP_SUPPORTHANGABLE,
-	CONST_PROP_UNLAY,
-};
-
 enum TradeEvents_t {
 	ON_TRADE_TRANSFER,
 	ON_TRADE_CANCEL,
@@ -109,6 +94,7 @@ enum AttrTypes_t {
 	ATTR_CRITICAL = 41,
 	ATTR_CUSTOM_ATTRIBUTES = 42,
 	ATTR_REFLECTION = 43,
+	ATTR_DECAY_TIME = 44,
 };
 
 enum Attr_ReadValue {
@@ -121,6 +107,10 @@ class ItemAttributes
 {
 	public:
 		ItemAttributes() = default;
+		~ItemAttributes();
+
+		ItemAttributes(const ItemAttributes& other);
+		ItemAttributes& operator=(const ItemAttributes&) = delete;
 
 		void setSpecialDescription(const std::string& desc) {
 			setStrAttr(ITEM_ATTRIBUTE_DESCRIPTION, desc);
@@ -288,63 +278,42 @@ class ItemAttributes
 
 		static std::string emptyString;
 
-		struct Attribute
-		{
-			union {
-				int64_t integer;
-				std::string* string;
-			} value;
-			itemAttrTypes type;
+		// texts are interned, items holding the same text share one copy and
+		// copying an item only counts a reference; like the rest of the item
+		// they are only touched by the dispatcher
+		using TextMap = std::unordered_map<std::string, uint32_t>;
+		using Text = TextMap::value_type;
+		static TextMap& getTexts();
 
-			explicit Attribute(itemAttrTypes type) : type(type) {
-				memset(&value, 0, sizeof(value));
-			}
-			Attribute(const Attribute& i) {
-				type = i.type;
-				if (ItemAttributes::isIntAttrType(type)) {
-					value.integer = i.value.integer;
-				} else if (ItemAttributes::isStrAttrType(type)) {
-					value.string = new std::string(*i.value.string);
-				} else {
-					memset(&value, 0, sizeof(value));
-				}
-			}
-			Attribute(Attribute&& attribute) : value(attribute.value), type(attribute.type) {
-				memset(&attribute.value, 0, sizeof(value));
-				attribute.type = ITEM_ATTRIBUTE_NONE;
-			}
-			~Attribute() {
-				if (ItemAttributes::isStrAttrType(type)) {
-					delete value.string;
-				}
-			}
-			Attribute& operator=(Attribute other) {
-				Attribute::swap(*this, other);
-				return *this;
-			}
-			Attribute& operator=(Attribute&& other) {
-				if (this != &other) {
-					if (ItemAttributes::isStrAttrType(type)) {
-						delete value.string;
-					}
-
-					value = other.value;
-					type = other.type;
-
-					memset(&other.value, 0, sizeof(value));
-					other.type = ITEM_ATTRIBUTE_NONE;
-				}
-				return *this;
-			}
+		static Text* acquireText(const std::string& value);
+		static void releaseText(Text* text);
 
-			static void swap(Attribute& first, Attribute& second) {
-				std::swap(first.value, second.value);
-				std::swap(first.type, second.type);
-			}
+		union Value {
+			int64_t integer;
+			Text* text;
 		};
 
-		std::forward_list<Attribute> attributes;
+		// values are kept in the order of their bit in attributeBits, so the
+		// slot of one is the number of attributes set below it; the first few
+		// are stored inline, more move everything to the heap
+		static constexpr uint8_t INLINE_VALUES = 3;
+
+		union {
+			Value inlineValues[INLINE_VALUES];
+			Value* heapValues;
+		};
 		uint32_t attributeBits = 0;
+		uint8_t capacity = INLINE_VALUES;
+
+		Value* getValues() {
+			return capacity > INLINE_VALUES ? heapValues : inlineValues;
+		}
+		const Value* getValues() const {
+			return capacity > INLINE_VALUES ? heapValues : inlineValues;
+		}
+		size_t getIndex(itemAttrTypes type) const {
+			return std::bitset<32>(attributeBits & (static_cast<uint32_t>(type) - 1)).count();
+		}
 
 		const std::string& getStrAttr(itemAttrTypes type) const;
 		void setStrAttr(itemAttrTypes type, const std::string& value);
@@ -353,8 +322,8 @@ class ItemAttributes
 		void setIntAttr(itemAttrTypes type, int64_t value);
 		void increaseIntAttr(itemAttrTypes type, int64_t value);
 
-		const Attribute* getExistingAttr(itemAttrTypes type) const;
-		Attribute& getAttr(itemAttrTypes type);
+		const Value* getExistingAttr(itemAttrTypes type) const;
+		Value& getAttr(itemAttrTypes type);
 
 	public:
 		inline static bool isIntAttrType(itemAttrTypes type) {
@@ -367,10 +336,6 @@ class ItemAttributes
 			return (type & 0x80000000) != 0;
 		}
 
-		const std::forward_list<Attribute>& getList() const {
-			return attributes;
-		}
-
 	friend class Item;
 };
 
@@ -390,6 +355,10 @@ class Item : virtual public Thing
 
 		virtual ~Item() = default;
 
+		// allocated from the item pool
+		static void* operator new(size_t size);
+		static void operator delete(void* object, size_t size);
+
 		// non-assignable
 		Item& operator=(const Item&) = delete;
 
@@ -440,6 +409,7 @@ class Item : virtual public Thing
 		}
 		void setStrAttr(itemAttrTypes type, const std::string& value) {
 			getAttributes()->setStrAttr(type, value);
+			markModified();
 		}
 
 		int32_t getIntAttr(itemAttrTypes type) const {
@@ -450,14 +420,17 @@ class Item : virtual public Thing
 		}
 		void setIntAttr(itemAttrTypes type, int32_t value) {
 			getAttributes()->setIntAttr(type, value);
+			markModified();
 		}
 		void increaseIntAttr(itemAttrTypes type, int32_t value) {
 			getAttributes()->increaseIntAttr(type, value);
+			markModified();
 		}
 
 		void removeAttribute(itemAttrTypes type) {
 			if (attributes) {
 				attributes->removeAttribute(type);
+				markModified();
 			}
 		}
 		bool hasAttribute(itemAttrTypes type) const {
@@ -601,22 +574,18 @@ class Item : virtual public Thing
 			return getIntAttr(ITEM_ATTRIBUTE_CORPSEOWNER);
 		}
 
-		void setDuration(int32_t time) {
-			setIntAttr(ITEM_ATTRIBUTE_DURATION, time);
-		}
-		void decreaseDuration(int32_t time) {
-			increaseIntAttr(ITEM_ATTRIBUTE_DURATION, -time);
-		}
-		uint32_t getDuration() const {
+		// while the item is decaying its duration attribute holds the time it
+		// decays at rather than the time left, the decay queue is ordered by it
+		void setDuration(int32_t time);
+		uint32_t getDuration() const;
+		int64_t getDecayTime() const {
 			if (!attributes) {
 				return 0;
 			}
-			return getIntAttr(ITEM_ATTRIBUTE_DURATION);
+			return attributes->getIntAttr(ITEM_ATTRIBUTE_DURATION);
 		}
 
-		void setDecaying(ItemDecayState_t decayState) {
-			setIntAttr(ITEM_ATTRIBUTE_DECAYSTATE, decayState);
-		}
+		void setDecaying(ItemDecayState_t decayState);
 		ItemDecayState_t getDecaying() const {
 			if (!attributes) {
 				return DECAYING_FALSE;
@@ -654,6 +623,11 @@ class Item : virtual public Thing
 		// Returns the player that is holding this item in his inventory
 		Player* getHoldingPlayer() const;
 
+		// Bumps the generation of every container holding this item, and of
+		// the inventory of the player carrying it, so saves can skip item
+		// trees that did not change
+		void markModified();
+
 		CombatType_t getDamageType() const {
 			return items[id].damageType;
 		}
@@ -741,18 +715,20 @@ class Item : virtual public Thing
 		uint32_t getWorth() const;
 		void getLight(LightInfo& lightInfo) const;
 
-		bool hasProperty(ITEMPROPERTY prop) const;
+		bool hasProperty(ITEMPROPERTY prop) const {
+			return items.getHot(id).hasProperty(prop);
+		}
 		bool isBlocking() const {
-			return items[id].blockSolid;
+			return items.getHot(id).hasProperty(CONST_PROP_BLOCKSOLID);
 		}
 		bool isStackable() const {
-			return items[id].stackable;
+			return items.getHot(id).hasFlag(ITEMTYPE_STACKABLE);
 		}
 		bool isAlwaysOnTop() const {
-			return items[id].alwaysOnTop;
+			return items.getHot(id).hasFlag(ITEMTYPE_ALWAYSONTOP);
 		}
 		bool isGroundTile() const {
-			return items[id].isGroundTile();
+			return items.getHot(id).hasFlag(ITEMTYPE_GROUNDTILE);
 		}
 		bool isQuiver() const {
 			return items[id].isQuiver();
@@ -767,16 +743,16 @@ class Item : virtual public Thing
 			return items[id].isWeapon();
 		}
 		bool isMagicField() const {
-			return items[id].isMagicField();
+			return items.getHot(id).hasFlag(ITEMTYPE_MAGICFIELD);
 		}
 		bool isSplash() const {
-			return items[id].isSplash();
+			return items.getHot(id).hasFlag(ITEMTYPE_SPLASH);
 		}
 		bool isMoveable() const {
-			return items[id].moveable;
+			return items.getHot(id).hasProperty(CONST_PROP_MOVEABLE);
 		}
 		bool isPickupable() const {
-			return items[id].pickupable;
+			return items.getHot(id).hasFlag(ITEMTYPE_PICKUPABLE);
 		}
 		bool isHangable() const {
 			return items[id].isHangable;
@@ -835,6 +811,7 @@ class Item : virtual public Thing
 		}
 		void setItemCount(uint8_t n) {
 			count = n;
+			markModified();
 		}
 
 		static uint32_t countByType(const Item* i, int32_t subType);
@@ -891,9 +868,7 @@ class Item : virtual public Thing
 		Cylinder* getParent() const {
 			return parent;
 		}
-		void setParent(Cylinder* cylinder) {
-			parent = cylinder;
-		}
+		void setParent(Cylinder* cylinder);
 		Cylinder* getTopParent();
 		const Cylinder* getTopParent() const;
 		Tile* getTile();
@@ -21,6 +21,8 @@
 
 #include "pugicast.h"
 
+#include <fstream>
+
 extern MoveEvents* g_moveEvents;
 
 Items::Items()
@@ -32,6 +34,7 @@ Items::Items()
 void Items::clear()
 {
 	items.clear();
+	hotItems.clear();
 	nameToItems.clear();
 }
 
@@ -46,14 +49,432 @@ bool Items::reload()
 	return true;
 }
 
-bool Items::loadItems()
+// what items.srv sets, both the text and the cached load come down to a
+// list of these applied in order
+enum ItemsSrvKey_t : uint8_t {
+	ITEMSRV_NONE,
+
+	ITEMSRV_NAME,
+	ITEMSRV_DESCRIPTION,
+
+	ITEMSRV_FLAG_BANK,
+	ITEMSRV_FLAG_CLIP,
+	ITEMSRV_FLAG_BOTTOM,
+	ITEMSRV_FLAG_TOP,
+	ITEMSRV_FLAG_CONTAINER,
+	ITEMSRV_FLAG_QUIVER,
+	ITEMSRV_FLAG_MULTIWEAPON,
+	ITEMSRV_FLAG_MULTISHOT,
+	ITEMSRV_FLAG_CHEST,
+	ITEMSRV_FLAG_CUMULATIVE,
+	ITEMSRV_FLAG_CHANGEUSE,
+	ITEMSRV_FLAG_FORCEUSE,
+	ITEMSRV_FLAG_KEY,
+	ITEMSRV_FLAG_DOOR,
+	ITEMSRV_FLAG_BED,
+	ITEMSRV_FLAG_RUNE,
+	ITEMSRV_FLAG_DEPOT,
+	ITEMSRV_FLAG_MAILBOX,
+	ITEMSRV_FLAG_ALLOWDISTREAD,
+	ITEMSRV_FLAG_TEXT,
+	ITEMSRV_FLAG_WRITE,
+	ITEMSRV_FLAG_WRITEONCE,
+	ITEMSRV_FLAG_FLUIDCONTAINER,
+	ITEMSRV_FLAG_SPLASH,
+	ITEMSRV_FLAG_UNPASS,
+	ITEMSRV_FLAG_UNMOVE,
+	ITEMSRV_FLAG_UNTHROW,
+	ITEMSRV_FLAG_UNLAY,
+	ITEMSRV_FLAG_AVOID,
+	ITEMSRV_FLAG_MAGICFIELD,
+	ITEMSRV_FLAG_TAKE,
+	ITEMSRV_FLAG_HANG,
+	ITEMSRV_FLAG_HOOKSOUTH,
+	ITEMSRV_FLAG_HOOKEAST,
+	ITEMSRV_FLAG_ROTATE,
+	ITEMSRV_FLAG_DESTROY,
+	ITEMSRV_FLAG_CORPSE,
+	ITEMSRV_FLAG_EXPIRE,
+	ITEMSRV_FLAG_EXPIRESTOP,
+	ITEMSRV_FLAG_WEAPON,
+	ITEMSRV_FLAG_SHIELD,
+	ITEMSRV_FLAG_DISTANCE,
+	ITEMSRV_FLAG_WAND,
+	ITEMSRV_FLAG_AMMO,
+	ITEMSRV_FLAG_ARMOR,
+	ITEMSRV_FLAG_HEIGHT,
+	ITEMSRV_FLAG_DISGUISE,
+	ITEMSRV_FLAG_SHOWDETAIL,
+	ITEMSRV_FLAG_NOREPLACE,
+	ITEMSRV_FLAG_COLLISIONEVENT,
+	ITEMSRV_FLAG_SEPARATIONEVENT,
+	ITEMSRV_FLAG_USEEVENT,
+	ITEMSRV_FLAG_DISTUSE,
+	ITEMSRV_FLAG_MULTIUSE,
+
+	ITEMSRV_ATTR_WAYPOINTS,
+	ITEMSRV_ATTR_CAPACITY,
+	ITEMSRV_ATTR_CHANGETARGET,
+	ITEMSRV_ATTR_NUTRITION,
+	ITEMSRV_ATTR_MAXLENGTH,
+	ITEMSRV_ATTR_FLUIDSOURCE,
+	ITEMSRV_ATTR_AVOIDDAMAGETYPES,
+	ITEMSRV_ATTR_DAMAGETYPE,
+	ITEMSRV_ATTR_ATTACKSTRENGTH,
+	ITEMSRV_ATTR_REFLECT,
+	ITEMSRV_ATTR_CRITICAL,
+	ITEMSRV_ATTR_LIFELEECH,
+	ITEMSRV_ATTR_MANALEECH,
+	ITEMSRV_ATTR_ATTACKVARIATION,
+	ITEMSRV_ATTR_MANACONSUMPTION,
+	ITEMSRV_ATTR_MINIMUMLEVEL,
+	ITEMSRV_ATTR_MAGES,
+	ITEMSRV_ATTR_VOCATIONS,
+	ITEMSRV_ATTR_WEAPONSPECIALEFFECT,
+	ITEMSRV_ATTR_BEDDIRECTION,
+	ITEMSRV_ATTR_BEDTARGET,
+	ITEMSRV_ATTR_BEDFREE,
+	ITEMSRV_ATTR_WEIGHT,
+	ITEMSRV_ATTR_ROTATETARGET,
+	ITEMSRV_ATTR_DESTROYTARGET,
+	ITEMSRV_ATTR_SLOTTYPE,
+	ITEMSRV_ATTR_SPEEDBOOST,
+	ITEMSRV_ATTR_FISTBOOST,
+	ITEMSRV_ATTR_SWORDBOOST,
+	ITEMSRV_ATTR_CLUBBOOST,
+	ITEMSRV_ATTR_AXEBOOST,
+	ITEMSRV_ATTR_SHIELDBOOST,
+	ITEMSRV_ATTR_DISTANCEBOOST,
+	ITEMSRV_ATTR_MAGICBOOST,
+	ITEMSRV_ATTR_PERCENTHP,
+	ITEMSRV_ATTR_PERCENTMP,
+	ITEMSRV_ATTR_SUPPRESSDRUNK,
+	ITEMSRV_ATTR_SUPPRESSFREEZE,
+	ITEMSRV_ATTR_SUPPRESSCURSE,
+	ITEMSRV_ATTR_SUPPRESSDAZZLE,
+	ITEMSRV_ATTR_INVISIBLE,
+	ITEMSRV_ATTR_MANASHIELD,
+	ITEMSRV_ATTR_HEALTHTICKS,
+	ITEMSRV_ATTR_HEALTHGAIN,
+	ITEMSRV_ATTR_MANATICKS,
+	ITEMSRV_ATTR_MANAGAIN,
+	ITEMSRV_ATTR_ABSORBMAGIC,
+	ITEMSRV_ATTR_ABSORBENERGY,
+	ITEMSRV_ATTR_ABSORBFIRE,
+	ITEMSRV_ATTR_ABSORBPOISON,
+	ITEMSRV_ATTR_ABSORBLIFEDRAIN,
+	ITEMSRV_ATTR_ABSORBMANADRAIN,
+	ITEMSRV_ATTR_ABSORBICE,
+	ITEMSRV_ATTR_ABSORBHOLY,
+	ITEMSRV_ATTR_ABSORBDEATH,
+	ITEMSRV_ATTR_ABSORBPHYSICAL,
+	ITEMSRV_ATTR_ABSORBHEALING,
+	ITEMSRV_ATTR_ABSORBUNDEFINED,
+	ITEMSRV_ATTR_ABSORBFIREFIELD,
+	ITEMSRV_ATTR_BRIGHTNESS,
+	ITEMSRV_ATTR_LIGHTCOLOR,
+	ITEMSRV_ATTR_TOTALEXPIRETIME,
+	ITEMSRV_ATTR_EXPIRETARGET,
+	ITEMSRV_ATTR_TOTALUSES,
+	ITEMSRV_ATTR_WEAPONTYPE,
+	ITEMSRV_ATTR_ATTACK,
+	ITEMSRV_ATTR_DEFENSE,
+	ITEMSRV_ATTR_RANGE,
+	ITEMSRV_ATTR_AMMOTYPE,
+	ITEMSRV_ATTR_MISSILEEFFECT,
+	ITEMSRV_ATTR_FRAGILITY,
+	ITEMSRV_ATTR_ARMORVALUE,
+	ITEMSRV_ATTR_DISGUISETARGET,
+	ITEMSRV_ATTR_EQUIPTARGET,
+	ITEMSRV_ATTR_DEEQUIPTARGET,
+
+	// slot types are resolved while parsing, righthand and lefthand clear bits
+	ITEMSRV_SLOT_ADD,
+	ITEMSRV_SLOT_REMOVE,
+
+	ITEMSRV_FIELD_TYPE,
+	ITEMSRV_FIELD_COUNT,
+	ITEMSRV_FIELD_DAMAGE,
+	ITEMSRV_FIELD_END,
+};
+
+// identifiers naming enums (fluid, combat and ammo types, directions) are
+// resolved to their value while parsing, only names and descriptions are text
+struct ItemsSrvEntry {
+	ItemsSrvEntry(uint16_t id, ItemsSrvKey_t key, int32_t value = 0) : id(id), key(key), value(value) {}
+	ItemsSrvEntry(uint16_t id, ItemsSrvKey_t key, std::string text) : id(id), key(key), text(std::move(text)) {}
+
+	bool operator==(const ItemsSrvEntry& other) const {
+		return id == other.id && key == other.key && value == other.value && text == other.text;
+	}
+
+	uint16_t id;
+	ItemsSrvKey_t key;
+	int32_t value = 0;
+	std::string text;
+};
+
+// Maps identifiers to keys with a single probe: the seed is searched once so
+// that every identifier hashes to a slot of its own, a lookup hashes and
+// compares one string.
+class IdentifierTable
+{
+	public:
+		IdentifierTable(std::initializer_list<std::pair<const char*, ItemsSrvKey_t>> identifiers) {
+			size_t size = 1;
+			while (size < identifiers.size() * 2) {
+				size <<= 1;
+			}
+
+			while (true) {
+				slots.assign(size, std::make_pair(std::string(), ITEMSRV_NONE));
+				mask = size - 1;
+
+				bool collision = false;
+				for (const auto& identifier : identifiers) {
+					auto& slot = slots[hash(identifier.first) & mask];
+					if (slot.second != ITEMSRV_NONE) {
+						collision = true;
+						break;
+					}
+					slot = identifier;
+				}
+
+				if (!collision) {
+					break;
+				}
+
+				// a table twice the size makes a free seed far more likely
+				if (++seed % 1024 == 0) {
+					size <<= 1;
+				}
+			}
+		}
+
+		ItemsSrvKey_t find(const std::string& identifier) const {
+			const auto& slot = slots[hash(identifier) & mask];
+			if (slot.first != identifier) {
+				return ITEMSRV_NONE;
+			}
+			return slot.second;
+		}
+
+	private:
+		uint32_t hash(const std::string& identifier) const {
+			uint32_t value = 2166136261U ^ seed;
+			for (char c : identifier) {
+				value = (value ^ static_cast<uint8_t>(c)) * 16777619U;
+			}
+			return value;
+		}
+
+		std::vector<std::pair<std::string, ItemsSrvKey_t>> slots;
+		uint32_t seed = 0;
+		uint32_t mask = 0;
+};
+
+static const IdentifierTable& getFlagTable()
+{
+	static const IdentifierTable table {
+		{"bank", ITEMSRV_FLAG_BANK}, {"clip", ITEMSRV_FLAG_CLIP}, {"bottom", ITEMSRV_FLAG_BOTTOM},
+		{"top", ITEMSRV_FLAG_TOP}, {"container", ITEMSRV_FLAG_CONTAINER}, {"quiver", ITEMSRV_FLAG_QUIVER},
+		{"multiweapon", ITEMSRV_FLAG_MULTIWEAPON}, {"multishot", ITEMSRV_FLAG_MULTISHOT}, {"chest", ITEMSRV_FLAG_CHEST},
+		{"cumulative", ITEMSRV_FLAG_CUMULATIVE}, {"changeuse", ITEMSRV_FLAG_CHANGEUSE}, {"forceuse", ITEMSRV_FLAG_FORCEUSE},
+		{"key", ITEMSRV_FLAG_KEY}, {"door", ITEMSRV_FLAG_DOOR}, {"bed", ITEMSRV_FLAG_BED},
+		{"rune", ITEMSRV_FLAG_RUNE}, {"depot", ITEMSRV_FLAG_DEPOT}, {"mailbox", ITEMSRV_FLAG_MAILBOX},
+		{"allowdistread", ITEMSRV_FLAG_ALLOWDISTREAD}, {"text", ITEMSRV_FLAG_TEXT}, {"write", ITEMSRV_FLAG_WRITE},
+		{"writeonce", ITEMSRV_FLAG_WRITEONCE}, {"fluidcontainer", ITEMSRV_FLAG_FLUIDCONTAINER}, {"splash", ITEMSRV_FLAG_SPLASH},
+		{"unpass", ITEMSRV_FLAG_UNPASS}, {"unmove", ITEMSRV_FLAG_UNMOVE}, {"unthrow", ITEMSRV_FLAG_UNTHROW},
+		{"unlay", ITEMSRV_FLAG_UNLAY}, {"avoid", ITEMSRV_FLAG_AVOID}, {"magicfield", ITEMSRV_FLAG_MAGICFIELD},
+		{"take", ITEMSRV_FLAG_TAKE}, {"hang", ITEMSRV_FLAG_HANG}, {"hooksouth", ITEMSRV_FLAG_HOOKSOUTH},
+		{"hookeast", ITEMSRV_FLAG_HOOKEAST}, {"rotate", ITEMSRV_FLAG_ROTATE}, {"destroy", ITEMSRV_FLAG_DESTROY},
+		{"corpse", ITEMSRV_FLAG_CORPSE}, {"expire", ITEMSRV_FLAG_EXPIRE}, {"expirestop", ITEMSRV_FLAG_EXPIRESTOP},
+		{"weapon", ITEMSRV_FLAG_WEAPON}, {"shield", ITEMSRV_FLAG_SHIELD}, {"distance", ITEMSRV_FLAG_DISTANCE},
+		{"wand", ITEMSRV_FLAG_WAND}, {"ammo", ITEMSRV_FLAG_AMMO}, {"armor", ITEMSRV_FLAG_ARMOR},
+		{"height", ITEMSRV_FLAG_HEIGHT}, {"disguise", ITEMSRV_FLAG_DISGUISE}, {"showdetail", ITEMSRV_FLAG_SHOWDETAIL},
+		{"noreplace", ITEMSRV_FLAG_NOREPLACE}, {"collisionevent", ITEMSRV_FLAG_COLLISIONEVENT}, {"separationevent", ITEMSRV_FLAG_SEPARATIONEVENT},
+		{"useevent", ITEMSRV_FLAG_USEEVENT}, {"distuse", ITEMSRV_FLAG_DISTUSE}, {"multiuse", ITEMSRV_FLAG_MULTIUSE},
+	};
+	return table;
+}
+
+static const IdentifierTable& getAttributeTable()
+{
+	static const IdentifierTable table {
+		{"waypoints", ITEMSRV_ATTR_WAYPOINTS}, {"capacity", ITEMSRV_ATTR_CAPACITY}, {"changetarget", ITEMSRV_ATTR_CHANGETARGET},
+		{"nutrition", ITEMSRV_ATTR_NUTRITION}, {"maxlength", ITEMSRV_ATTR_MAXLENGTH}, {"fluidsource", ITEMSRV_ATTR_FLUIDSOURCE},
+		{"avoiddamagetypes", ITEMSRV_ATTR_AVOIDDAMAGETYPES}, {"damagetype", ITEMSRV_ATTR_DAMAGETYPE}, {"attackstrength", ITEMSRV_ATTR_ATTACKSTRENGTH},
+		{"reflect", ITEMSRV_ATTR_REFLECT}, {"critical", ITEMSRV_ATTR_CRITICAL}, {"lifeleech", ITEMSRV_ATTR_LIFELEECH},
+		{"manaleech", ITEMSRV_ATTR_MANALEECH}, {"attackvariation", ITEMSRV_ATTR_ATTACKVARIATION}, {"manaconsumption", ITEMSRV_ATTR_MANACONSUMPTION},
+		{"minimumlevel", ITEMSRV_ATTR_MINIMUMLEVEL}, {"mages", ITEMSRV_ATTR_MAGES}, {"vocations", ITEMSRV_ATTR_VOCATIONS},
+		{"weaponspecialeffect", ITEMSRV_ATTR_WEAPONSPECIALEFFECT}, {"beddirection", ITEMSRV_ATTR_BEDDIRECTION}, {"bedtarget", ITEMSRV_ATTR_BEDTARGET},
+		{"bedfree", ITEMSRV_ATTR_BEDFREE}, {"weight", ITEMSRV_ATTR_WEIGHT}, {"rotatetarget", ITEMSRV_ATTR_ROTATETARGET},
+		{"destroytarget", ITEMSRV_ATTR_DESTROYTARGET}, {"slottype", ITEMSRV_ATTR_SLOTTYPE}, {"speedboost", ITEMSRV_ATTR_SPEEDBOOST},
+		{"fistboost", ITEMSRV_ATTR_FISTBOOST}, {"swordboost", ITEMSRV_ATTR_SWORDBOOST}, {"clubboost", ITEMSRV_ATTR_CLUBBOOST},
+		{"axeboost", ITEMSRV_ATTR_AXEBOOST}, {"shieldboost", ITEMSRV_ATTR_SHIELDBOOST}, {"distanceboost", ITEMSRV_ATTR_DISTANCEBOOST},
+		{"magicboost", ITEMSRV_ATTR_MAGICBOOST}, {"percenthp", ITEMSRV_ATTR_PERCENTHP}, {"percentmp", ITEMSRV_ATTR_PERCENTMP},
+		{"suppressdrunk", ITEMSRV_ATTR_SUPPRESSDRUNK}, {"suppressfreeze", ITEMSRV_ATTR_SUPPRESSFREEZE}, {"suppresscurse", ITEMSRV_ATTR_SUPPRESSCURSE},
+		{"suppressdazzle", ITEMSRV_ATTR_SUPPRESSDAZZLE}, {"invisible", ITEMSRV_ATTR_INVISIBLE}, {"manashield", ITEMSRV_ATTR_MANASHIELD},
+		{"healthticks", ITEMSRV_ATTR_HEALTHTICKS}, {"healthgain", ITEMSRV_ATTR_HEALTHGAIN}, {"manaticks", ITEMSRV_ATTR_MANATICKS},
+		{"managain", ITEMSRV_ATTR_MANAGAIN}, {"absorbmagic", ITEMSRV_ATTR_ABSORBMAGIC}, {"absorbenergy", ITEMSRV_ATTR_ABSORBENERGY},
+		{"absorbfire", ITEMSRV_ATTR_ABSORBFIRE}, {"absorbpoison", ITEMSRV_ATTR_ABSORBPOISON}, {"absorblifedrain", ITEMSRV_ATTR_ABSORBLIFEDRAIN},
+		{"absorbmanadrain", ITEMSRV_ATTR_ABSORBMANADRAIN}, {"absorbice", ITEMSRV_ATTR_ABSORBICE}, {"absorbholy", ITEMSRV_ATTR_ABSORBHOLY},
+		{"absorbdeath", ITEMSRV_ATTR_ABSORBDEATH}, {"absorbphysical", ITEMSRV_ATTR_ABSORBPHYSICAL}, {"absorbhealing", ITEMSRV_ATTR_ABSORBHEALING},
+		{"absorbundefined", ITEMSRV_ATTR_ABSORBUNDEFINED}, {"absorbfirefield", ITEMSRV_ATTR_ABSORBFIREFIELD}, {"brightness", ITEMSRV_ATTR_BRIGHTNESS},
+		{"lightcolor", ITEMSRV_ATTR_LIGHTCOLOR}, {"totalexpiretime", ITEMSRV_ATTR_TOTALEXPIRETIME}, {"expiretarget", ITEMSRV_ATTR_EXPIRETARGET},
+		{"totaluses", ITEMSRV_ATTR_TOTALUSES}, {"weapontype", ITEMSRV_ATTR_WEAPONTYPE}, {"attack", ITEMSRV_ATTR_ATTACK},
+		{"defense", ITEMSRV_ATTR_DEFENSE}, {"range", ITEMSRV_ATTR_RANGE}, {"ammotype", ITEMSRV_ATTR_AMMOTYPE},
+		{"missileeffect", ITEMSRV_ATTR_MISSILEEFFECT}, {"fragility", ITEMSRV_ATTR_FRAGILITY}, {"armorvalue", ITEMSRV_ATTR_ARMORVALUE},
+		{"disguisetarget", ITEMSRV_ATTR_DISGUISETARGET}, {"equiptarget", ITEMSRV_ATTR_EQUIPTARGET}, {"deequiptarget", ITEMSRV_ATTR_DEEQUIPTARGET},
+	};
+	return table;
+}
+
+static const IdentifierTable& getMagicFieldTable()
+{
+	static const IdentifierTable table {
+		{"type", ITEMSRV_FIELD_TYPE}, {"count", ITEMSRV_FIELD_COUNT}, {"damage", ITEMSRV_FIELD_DAMAGE},
+	};
+	return table;
+}
+
+// reads the comma separated list of a flags, attributes or magicfield block,
+// function returns false on an error it reported
+template <typename Function>
+static bool readBlock(ScriptReader& script, Function function)
+{
+	script.readSymbol('{');
+	while (true) {
+		script.nextToken();
+		if (script.Token == SPECIAL) {
+			if (script.getSpecial() == '}') {
+				return true;
+			}
+			continue;
+		}
+
+		if (script.Token == ENDOFFILE) {
+			script.error("'}' expected");
+			return false;
+		}
+
+		if (!function(script.getIdentifier())) {
+			return false;
+		}
+	}
+}
+
+static bool parseSlotType(ScriptReader& script, uint16_t id, std::vector<ItemsSrvEntry>& entries)
+{
+	static const std::unordered_map<std::string, uint32_t> slots {
+		{"head", SLOTP_HEAD}, {"body", SLOTP_ARMOR}, {"legs", SLOTP_LEGS}, {"feet", SLOTP_FEET},
+		{"backpack", SLOTP_BACKPACK}, {"twohanded", SLOTP_TWO_HAND}, {"necklace", SLOTP_NECKLACE},
+		{"ring", SLOTP_RING}, {"ammo", SLOTP_AMMO}, {"hand", SLOTP_HAND},
+	};
+
+	const std::string identifier = asLowerCaseString(script.readIdentifier());
+	if (identifier == "righthand") {
+		entries.emplace_back(id, ITEMSRV_SLOT_REMOVE, SLOTP_LEFT);
+		return true;
+	} else if (identifier == "lefthand") {
+		entries.emplace_back(id, ITEMSRV_SLOT_REMOVE, SLOTP_RIGHT);
+		return true;
+	}
+
+	auto it = slots.find(identifier);
+	if (it == slots.end()) {
+		script.error("Unknown slot position");
+		return false;
+	}
+
+	entries.emplace_back(id, ITEMSRV_SLOT_ADD, it->second);
+	return true;
+}
+
+static bool parseWeaponType(ScriptReader& script, uint16_t id, std::vector<ItemsSrvEntry>& entries)
+{
+	static const std::unordered_map<std::string, WeaponType_t> weaponTypes {
+		{"sword", WEAPON_SWORD}, {"club", WEAPON_CLUB}, {"axe", WEAPON_AXE}, {"shield", WEAPON_SHIELD},
+		{"distance", WEAPON_DISTANCE}, {"wand", WEAPON_WAND}, {"ammunition", WEAPON_AMMO},
+	};
+
+	auto it = weaponTypes.find(script.readIdentifier());
+	if (it == weaponTypes.end()) {
+		script.error("Unknown weapon type");
+		return false;
+	}
+
+	entries.emplace_back(id, ITEMSRV_ATTR_WEAPONTYPE, it->second);
+	return true;
+}
+
+static bool parseAttribute(ScriptReader& script, uint16_t id, ItemsSrvKey_t key, std::vector<ItemsSrvEntry>& entries)
+{
+	switch (key) {
+		case ITEMSRV_ATTR_FLUIDSOURCE:
+			entries.emplace_back(id, key, getFluidType(script.readIdentifier()));
+			return true;
+
+		case ITEMSRV_ATTR_AVOIDDAMAGETYPES:
+		case ITEMSRV_ATTR_DAMAGETYPE:
+			entries.emplace_back(id, key, getCombatType(script.readIdentifier()));
+			return true;
+
+		case ITEMSRV_ATTR_BEDDIRECTION:
+			entries.emplace_back(id, key, getDirection(script.readIdentifier()));
+			return true;
+
+		case ITEMSRV_ATTR_SLOTTYPE:
+			return parseSlotType(script, id, entries);
+
+		case ITEMSRV_ATTR_WEAPONTYPE:
+			return parseWeaponType(script, id, entries);
+
+		case ITEMSRV_ATTR_AMMOTYPE: {
+			Ammo_t ammoType = getAmmoType(script.readIdentifier());
+			if (ammoType == AMMO_NONE) {
+				script.error("Unknown ammo type");
+				return false;
+			}
+			entries.emplace_back(id, key, ammoType);
+			return true;
+		}
+
+		default:
+			entries.emplace_back(id, key, script.readNumber());
+			return true;
+	}
+}
+
+static bool parseMagicField(ScriptReader& script, uint16_t id, ItemsSrvKey_t key, std::vector<ItemsSrvEntry>& entries)
+{
+	if (key != ITEMSRV_FIELD_TYPE) {
+		entries.emplace_back(id, key, script.readNumber());
+		return true;
+	}
+
+	const std::string type = script.readIdentifier();
+	if (type == "fire") {
+		entries.emplace_back(id, key, CONDITION_FIRE);
+	} else if (type == "energy") {
+		entries.emplace_back(id, key, CONDITION_ENERGY);
+	} else if (type == "poison") {
+		entries.emplace_back(id, key, CONDITION_POISON);
+	} else {
+		script.error("unknown magicfield type");
+		return false;
+	}
+	return true;
+}
+
+static bool parseItemsSrv(const std::string& fileName, std::vector<ItemsSrvEntry>& entries)
 {
 	ScriptReader script;
-	if (!script.open("data/items/items.srv")) {
+	if (!script.open(fileName)) {
 		return false;
 	}
 
-	std::string identifier;
+	std::vector<bool> defined;
 	uint16_t id = 0;
 	while (true) {
 		script.nextToken();
@@ -66,558 +487,529 @@ bool Items::loadItems()
 			return false;
 		}
 
-		identifier = script.getIdentifier();
+		const std::string identifier = script.getIdentifier();
 		script.readSymbol('=');
 
+		bool success = true;
 		if (identifier == "typeid") {
 			id = script.readNumber();
-			if (id >= items.size()) {
-				items.resize(id + 1);
+			if (id >= defined.size()) {
+				defined.resize(id + 1);
 			}
 
-			if (items[id].id) {
+			if (defined[id]) {
 				script.error("item type already defined");
 				return false;
 			}
 
-			items[id].id = id;
+			defined[id] = true;
+			entries.emplace_back(id, ITEMSRV_NONE);
 		} else if (identifier == "name") {
-			items[id].name = script.readString();
+			entries.emplace_back(id, ITEMSRV_NAME, script.readString());
 		} else if (identifier == "description") {
-			items[id].description = script.readString();
+			entries.emplace_back(id, ITEMSRV_DESCRIPTION, script.readString());
 		} else if (identifier == "flags") {
-			script.readSymbol('{');
-			while (true) {
-				while (true) {
-					script.nextToken();
-					if (script.Token == SPECIAL) {
-						break;
-					}
-
-					identifier = script.getIdentifier();
-					
-					if (identifier == "bank") {
-						items[id].group = ITEM_GROUP_GROUND;
-					} else if (identifier == "clip") {
-						items[id].alwaysOnTop = true;
-						items[id].alwaysOnTopOrder = 1;
-					} else if (identifier == "bottom") {
-						items[id].alwaysOnTop = true;
-						items[id].alwaysOnTopOrder = 2;
-					} else if (identifier == "top") {
-						items[id].alwaysOnTop = true;
-						items[id].alwaysOnTopOrder = 3;
-					} else if (identifier == "container") {
-						items[id].type = ITEM_TYPE_CONTAINER;
-					} else if (identifier == "quiver") {
-						items[id].group = ITEM_GROUP_QUIVER;
-					} else if (identifier == "multiweapon") {
-						items[id].group = ITEM_GROUP_MULTIWEAPON;
-					} else if (identifier == "multishot") {
-						items[id].group = ITEM_GROUP_MULTISHOT;
-					} else if (identifier == "chest") {
-						items[id].type = ITEM_TYPE_CHEST;
-					} else if (identifier == "cumulative") {
-						items[id].stackable = true;
-					} else if (identifier == "changeuse") {
-						items[id].changeUse = true;
-					} else if (identifier == "forceuse") {
-						items[id].forceUse = true;
-					} else if (identifier == "key") {
-						items[id].type = ITEM_TYPE_KEY;
-						items[id].group = ITEM_GROUP_KEY;
-					} else if (identifier == "door") {
-						items[id].type = ITEM_TYPE_DOOR;
-					} else if (identifier == "bed") {
-						items[id].type = ITEM_TYPE_BED;
-					} else if (identifier == "rune") {
-						items[id].type = ITEM_TYPE_RUNE;
-					} else if (identifier == "depot") {
-						items[id].type = ITEM_TYPE_DEPOT;
-					} else if (identifier == "mailbox") {
-						items[id].type = ITEM_TYPE_MAILBOX;
-					} else if (identifier == "allowdistread") {
-						items[id].allowDistRead = true;
-					} else if (identifier == "text") {
-						items[id].canReadText = true;
-					} else if (identifier == "write") {
-						items[id].canWriteText = true;
-					} else if (identifier == "writeonce") {
-						items[id].canWriteText = true;
-						items[id].writeOnceItemId = id;
-					} else if (identifier == "fluidcontainer") {
-						items[id].group = ITEM_GROUP_FLUID;
-					} else if (identifier == "splash") {
-						items[id].group = ITEM_GROUP_SPLASH;
-					} else if (identifier == "unpass") {
-						items[id].blockSolid = true;
-					} else if (identifier == "unmove") {
-						items[id].moveable = false;
-					} else if (identifier == "unthrow") {
-						items[id].blockProjectile = true;
-					} else if (identifier == "unlay") {
-						items[id].allowPickupable = false;
-					} else if (identifier == "avoid") {
-						items[id].blockPathFind = true;
-					} else if (identifier == "magicfield") {
-						items[id].type = ITEM_TYPE_MAGICFIELD;
-						items[id].group = ITEM_GROUP_MAGICFIELD;
-					} else if (identifier == "take") {
-						items[id].pickupable = true;
-					} else if (identifier == "hang") {
-						items[id].isHangable = true;
-					} else if (identifier == "hooksouth") {
-						items[id].isHorizontal = true;
-					} else if (identifier == "hookeast") {
-						items[id].isVertical = true;
-					} else if (identifier == "rotate") {
-						items[id].rotatable = true;
-					} else if (identifier == "destroy") {
-						items[id].destroy = true;
-					} else if (identifier == "corpse") {
-						items[id].corpse = true;
-					} else if (identifier == "expire") {
-						items[id].stopTime = false;
-					} else if (identifier == "expirestop") {
-						items[id].stopTime = true;
-					} else if (identifier == "weapon") {
-						items[id].group = ITEM_GROUP_WEAPON;
-					} else if (identifier == "shield") {
-						items[id].weaponType = WEAPON_SHIELD;
-					} else if (identifier == "distance") {
-						items[id].weaponType = WEAPON_DISTANCE;
-					} else if (identifier == "wand") {
-						items[id].weaponType = WEAPON_WAND;
-					} else if (identifier == "ammo") {
-						items[id].weaponType = WEAPON_AMMO;
-					} else if (identifier == "armor") {
-						items[id].group = ITEM_GROUP_ARMOR;
-					} else if (identifier == "height") {
-						items[id].hasHeight = true;
-					} else if (identifier == "disguise") {
-						items[id].disguise = true;
-					} else if (identifier == "showdetail") {
-						items[id].showDuration = true;
-					} else if (identifier == "noreplace") {
-						items[id].replaceable = false;
-					} else if (identifier == "collisionevent") {
-						items[id].collisionEvent = true;
-					} else if (identifier == "separationevent") {
-						items[id].separationEvent = true;
-					} else if (identifier == "useevent") {
-						items[id].useEvent = true;
-					} else if (identifier == "distuse") {
-						items[id].distUse = true;
-					} else if (identifier == "multiuse") {
-						items[id].multiUseEvent = true;
-					} else {
-						script.error("Unknown flag");
-						return false;
-					}
+			success = readBlock(script, [&](const std::string& name) -> bool {
+				ItemsSrvKey_t key = getFlagTable().find(name);
+				if (key == ITEMSRV_NONE) {
+					script.error("Unknown flag");
+					return false;
 				}
 
-				if (script.getSpecial() == '}') {
-					break;
+				entries.emplace_back(id, key);
+				return true;
+			});
+		} else if (identifier == "attributes") {
+			success = readBlock(script, [&](const std::string& name) -> bool {
+				ItemsSrvKey_t key = getAttributeTable().find(name);
+				if (key == ITEMSRV_NONE) {
+					script.error("Unknown attribute");
+					return false;
 				}
 
-				if (script.Token != SPECIAL || script.getSpecial() != ',') {
-					continue;
+				script.readSymbol('=');
+				return parseAttribute(script, id, key, entries);
+			});
+		} else if (identifier == "magicfield") {
+			success = readBlock(script, [&](const std::string& name) -> bool {
+				ItemsSrvKey_t key = getMagicFieldTable().find(name);
+				if (key == ITEMSRV_NONE) {
+					script.error("unknown identifier");
+					return false;
 				}
+
+				script.readSymbol('=');
+				return parseMagicField(script, id, key, entries);
+			});
+			entries.emplace_back(id, ITEMSRV_FIELD_END);
+		}
+
+		if (!success) {
+			return false;
+		}
+	}
+
+	script.close();
+	return true;
+}
+
+static std::string getVocationString(const std::list<std::string>& vocationStringList)
+{
+	std::string vocationString;
+	for (const std::string& str : vocationStringList) {
+		if (!vocationString.empty()) {
+			if (str != vocationStringList.back()) {
+				vocationString.push_back(',');
+				vocationString.push_back(' ');
+			} else {
+				vocationString += " and ";
 			}
-		} else if (identifier == "attributes") {
-			script.readSymbol('{');
-			while (true) {
-				while (true) {
-					script.nextToken();
-					if (script.Token == SPECIAL) {
-						break;
-					}
+		}
 
-					identifier = script.getIdentifier();
-					script.readSymbol('=');
-
-					if (identifier == "waypoints") {
-						items[id].speed = script.readNumber();
-					} else if (identifier == "capacity") {
-						items[id].maxItems = script.readNumber();
-					} else if (identifier == "changetarget") {
-						items[id].transformToOnUse = script.readNumber();
-					} else if (identifier == "nutrition") {
-						items[id].nutrition = script.readNumber();
-					} else if (identifier == "maxlength") {
-						items[id].maxTextLen = script.readNumber();
-					} else if (identifier == "fluidsource") {
-						items[id].fluidSource = getFluidType(script.readIdentifier());
-					} else if (identifier == "avoiddamagetypes") {
-						items[id].combatType = getCombatType(script.readIdentifier());
-					} else if (identifier == "damagetype") {
-						items[id].damageType = getCombatType(script.readIdentifier());
-					} else if (identifier == "attackstrength") {
-						items[id].attackStrength = script.readNumber();
-					} else if (identifier == "reflect") {
-						items[id].reflect = script.readNumber();
-					} else if (identifier == "critical") {
-						items[id].critical = script.readNumber();
-					} else if (identifier == "lifeleech") {
-						items[id].lifeLeech = script.readNumber();
-					} else if (identifier == "manaleech") {
-						items[id].manaLeech = script.readNumber();
-					} else if (identifier == "attackvariation") {
-						items[id].attackVariation = script.readNumber();
-					} else if (identifier == "manaconsumption") {
-						items[id].manaConsumption = script.readNumber();
-					} else if (identifier == "minimumlevel") {
-						items[id].minReqLevel = script.readNumber();
-						items[id].wieldInfo |= WIELDINFO_LEVEL;
-					} else if (identifier == "mages") {
-						items[id].mages = script.readNumber();
-
-						std::list<std::string> vocationStringList;
-
-						std::string vocationString;
-						vocationStringList.push_back("sorcerer");
-						vocationStringList.push_back("druid");
-
-						for (const std::string& str : vocationStringList) {
-							if (!vocationString.empty()) {
-								if (str != vocationStringList.back()) {
-									vocationString.push_back(',');
-									vocationString.push_back(' ');
-								} else {
-									vocationString += " and ";
-								}
-							}
-
-							vocationString += str;
-							vocationString.push_back('s');
-						}
-
-						items[id].wieldInfo |= WIELDINFO_VOCREQ;
-						items[id].vocationString = vocationString;
-					} else if (identifier == "vocations") {
-						int32_t vocations = script.readNumber();
-						items[id].vocations = vocations;
-
-						std::list<std::string> vocationStringList;
-
-						if (hasBitSet(VOCATION_SORCERER, vocations)) {
-							vocationStringList.push_back("sorcerer");
-						}
-
-						if (hasBitSet(VOCATION_DRUID, vocations)) {
-							vocationStringList.push_back("druid");
-						}
-
-						if (hasBitSet(VOCATION_PALADIN, vocations)) {
-							vocationStringList.push_back("paladin");
-						}
-
-						if (hasBitSet(VOCATION_KNIGHT, vocations)) {
-							vocationStringList.push_back("knight");
-						}
-
-						std::string vocationString;
-						for (const std::string& str : vocationStringList) {
-							if (!vocationString.empty()) {
-								if (str != vocationStringList.back()) {
-									vocationString.push_back(',');
-									vocationString.push_back(' ');
-								} else {
-									vocationString += " and ";
-								}
-							}
-
-							vocationString += str;
-							vocationString.push_back('s');
-						}
-
-						items[id].wieldInfo |= WIELDINFO_VOCREQ;
-						items[id].vocationString = vocationString;
-					} else if (identifier == "weaponspecialeffect") {
-						items[id].weaponSpecialEffect = script.readNumber();
-					} else if (identifier == "beddirection") {
-						items[id].bedPartnerDir = getDirection(script.readIdentifier());
-					} else if (identifier == "bedtarget") {
-						items[id].transformToOnUse = script.readNumber();
-					} else if (identifier == "bedfree") {
-						items[id].transformToFree = script.readNumber();
-					} else if (identifier == "weight") {
-						items[id].weight = script.readNumber();
-					} else if (identifier == "rotatetarget") {
-						items[id].rotateTo = script.readNumber();
-					} else if (identifier == "destroytarget") {
-						items[id].destroyTarget = script.readNumber();
-					} else if (identifier == "slottype") {
-						identifier = asLowerCaseString(script.readIdentifier());
-						if (identifier == "head") {
-							items[id].slotPosition |= SLOTP_HEAD;
-						} else if (identifier == "body") {
-							items[id].slotPosition |= SLOTP_ARMOR;
-						} else if (identifier == "legs") {
-							items[id].slotPosition |= SLOTP_LEGS;
-						} else if (identifier == "feet") {
-							items[id].slotPosition |= SLOTP_FEET;
-						} else if (identifier == "backpack") {
-							items[id].slotPosition |= SLOTP_BACKPACK;
-						} else if (identifier == "twohanded") {
-							items[id].slotPosition |= SLOTP_TWO_HAND;
-						} else if (identifier == "righthand") {
-							items[id].slotPosition &= ~SLOTP_LEFT;
-						} else if (identifier == "lefthand") {
-							items[id].slotPosition &= ~SLOTP_RIGHT;
-						} else if (identifier == "necklace") {
-							items[id].slotPosition |= SLOTP_NECKLACE;
-						} else if (identifier == "ring") {
-							items[id].slotPosition |= SLOTP_RING;
-						} else if (identifier == "ammo") {
-							items[id].slotPosition |= SLOTP_AMMO;
-						} else if (identifier == "hand") {
-							items[id].slotPosition |= SLOTP_HAND;
-						} else {
-							script.error("Unknown slot position");
-							return false;
-						}
-					} else if (identifier == "speedboost") {
-						items[id].getAbilities().speed = script.readNumber();
-					} else if (identifier == "fistboost") {
-						items[id].getAbilities().skills[SKILL_FIST] = script.readNumber();
-					} else if (identifier == "swordboost") {
-						items[id].getAbilities().skills[SKILL_SWORD] = script.readNumber();
-					} else if (identifier == "clubboost") {
-						items[id].getAbilities().skills[SKILL_CLUB] = script.readNumber();
-					} else if (identifier == "axeboost") {
-						items[id].getAbilities().skills[SKILL_AXE] = script.readNumber();
-					} else if (identifier == "shieldboost") {
-						items[id].getAbilities().skills[SKILL_SHIELD] = script.readNumber();
-					} else if (identifier == "distanceboost") {
-						items[id].getAbilities().skills[SKILL_DISTANCE] = script.readNumber();
-					} else if (identifier == "magicboost") {
-						items[id].getAbilities().stats[STAT_MAGICPOINTS] = script.readNumber();
-					} else if (identifier == "percenthp") {
-						int32_t currentPoint = script.readNumber(); 
-						items[id].maxPoints = currentPoint;
-						items[id].getAbilities().statsPercent[STAT_MAXHITPOINTS] = currentPoint;
-					} else if (identifier == "percentmp") {
-						int32_t currentPoint = script.readNumber(); 
-						items[id].maxPoints = currentPoint;
-						items[id].getAbilities().statsPercent[STAT_MAXMANAPOINTS] = currentPoint;
-					} else if (identifier == "suppressdrunk") {
-						if (script.readNumber()) {
-							items[id].getAbilities().conditionSuppressions |= CONDITION_DRUNK;
-						}
-					} else if (identifier == "suppressfreeze") {
-						if (script.readNumber()) {
-							items[id].getAbilities().conditionSuppressions |= CONDITION_FREEZING;
-						}
-					} else if (identifier == "suppresscurse") {
-						if (script.readNumber()) {
-							items[id].getAbilities().conditionSuppressions |= CONDITION_CURSED;
-						}
-					} else if (identifier == "suppressdazzle") {
-						if (script.readNumber()) {
-							items[id].getAbilities().conditionSuppressions |= CONDITION_DAZZLED;
-						}
-					} else if (identifier == "invisible") {
-						if (script.readNumber()) {
-							items[id].getAbilities().invisible = true;
-						}
-					} else if (identifier == "manashield") {
-						if (script.readNumber()) {
-							items[id].getAbilities().manaShield = true;
-						}
-					} else if (identifier == "healthticks") {
-						Abilities& abilities = items[id].getAbilities();
-						abilities.regeneration = true;
-						abilities.healthTicks = script.readNumber();
-					} else if (identifier == "healthgain") {
-						Abilities& abilities = items[id].getAbilities();
-						abilities.regeneration = true;
-						abilities.healthGain = script.readNumber();
-					} else if (identifier == "manaticks") {
-						Abilities& abilities = items[id].getAbilities();
-						abilities.regeneration = true;
-						abilities.manaTicks = script.readNumber();
-					} else if (identifier == "managain") {
-						Abilities& abilities = items[id].getAbilities();
-						abilities.regeneration = true;
-						abilities.manaGain = script.readNumber();
-					} else if (identifier == "absorbmagic") {
-						int32_t percent = script.readNumber();
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_ENERGYDAMAGE)] += percent;
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_FIREDAMAGE)] += percent;
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_EARTHDAMAGE)] += percent;
-					} else if (identifier == "absorbenergy") {
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_ENERGYDAMAGE)] += script.readNumber();
-					} else if (identifier == "absorbfire") {
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_FIREDAMAGE)] += script.readNumber();
-					} else if (identifier == "absorbpoison") {
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_EARTHDAMAGE)] += script.readNumber();
-					} else if (identifier == "absorblifedrain") {
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_LIFEDRAIN)] += script.readNumber();
-					} else if (identifier == "absorbmanadrain") {
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_MANADRAIN)] += script.readNumber();
-					} else if (identifier == "absorbice") {
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_ICEDAMAGE)] += script.readNumber();
-					} else if (identifier == "absorbholy") {
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_HOLYDAMAGE)] += script.readNumber();
-					} else if (identifier == "absorbdeath") {
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_DEATHDAMAGE)] += script.readNumber();
-					} else if (identifier == "absorbphysical") {
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_PHYSICALDAMAGE)] += script.readNumber();
-					} else if (identifier == "absorbhealing") {
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_HEALING)] += script.readNumber();
-					} else if (identifier == "absorbundefined") {
-						items[id].getAbilities().absorbPercent[combatTypeToIndex(COMBAT_UNDEFINEDDAMAGE)] += script.readNumber();
-					} else if (identifier == "absorbfirefield") {
-						items[id].getAbilities().fieldAbsorbPercent[combatTypeToIndex(COMBAT_FIREDAMAGE)] += static_cast<int16_t>(script.readNumber());
-					} else if (identifier == "brightness") {
-						items[id].lightLevel = script.readNumber();
-					} else if (identifier == "lightcolor") {
-						items[id].lightColor = script.readNumber();
-					} else if (identifier == "totalexpiretime") {
-						items[id].decayTime = script.readNumber();
-					} else if (identifier == "expiretarget") {
-						items[id].decayTo = script.readNumber();
-					} else if (identifier == "totaluses") {
-						items[id].charges = script.readNumber();
-					} else if (identifier == "weapontype") {
-						identifier = script.readIdentifier();
-						if (identifier == "sword") {
-							items[id].weaponType = WEAPON_SWORD;
-						} else if (identifier == "club") {
-							items[id].weaponType = WEAPON_CLUB;
-						} else if (identifier == "axe") {
-							items[id].weaponType = WEAPON_AXE;
-						} else if (identifier == "shield") {
-							items[id].weaponType = WEAPON_SHIELD;
-						} else if (identifier == "distance") {
-							items[id].weaponType = WEAPON_DISTANCE;
-						} else if (identifier == "wand") {
-							items[id].weaponType = WEAPON_WAND;
-						} else if (identifier == "ammunition") {
-							items[id].weaponType = WEAPON_AMMO;
-						} else {
-							script.error("Unknown weapon type");
-							return false;
-						}
-					} else if (identifier == "attack") {
-						items[id].attack = script.readNumber();
-					} else if (identifier == "defense") {
-						items[id].defense = script.readNumber();
-					} else if (identifier == "range") {
-						items[id].shootRange = static_cast<uint8_t>(script.readNumber());
-					} else if (identifier == "ammotype") {
-						items[id].ammoType = getAmmoType(script.readIdentifier());
-						if (items[id].ammoType == AMMO_NONE) {
-							script.error("Unknown ammo type");
-							return false;
-						}
-					} else if (identifier == "missileeffect") {
-						items[id].shootType = static_cast<ShootType_t>(script.readNumber());
-					} else if (identifier == "fragility") {
-						items[id].fragility = script.readNumber();
-					} else if (identifier == "armorvalue") {
-						items[id].armor = script.readNumber();
-					} else if (identifier == "disguisetarget") {
-						items[id].disguiseId = script.readNumber();
-					} else if (identifier == "equiptarget") {
-						items[id].transformEquipTo = script.readNumber();
-					} else if (identifier == "deequiptarget") {
-						items[id].transformDeEquipTo = script.readNumber();
-					} else {
-						script.error("Unknown attribute");
-						return false;
-					}
-				}
+		vocationString += str;
+		vocationString.push_back('s');
+	}
+	return vocationString;
+}
 
-				if (script.getSpecial() == '}') {
-					break;
-				}
+// what a magicfield block sets up, applied once the block ends
+struct MagicFieldEntries {
+	ConditionType_t conditionType = CONDITION_NONE;
+	int32_t cycles = 0;
+	int32_t hitDamage = 0;
+};
 
-				if (script.Token != SPECIAL || script.getSpecial() != ',') {
-					continue;
-				}
+static void applyMagicField(ItemType& it, const MagicFieldEntries& field)
+{
+	CombatType_t combatType;
+	int32_t cycles = field.cycles;
+	int32_t count = 3;
+	switch (field.conditionType) {
+		case CONDITION_FIRE:
+			combatType = COMBAT_FIREDAMAGE;
+			cycles /= 10;
+			count = 8;
+			break;
+
+		case CONDITION_ENERGY:
+			combatType = COMBAT_ENERGYDAMAGE;
+			cycles /= 20;
+			count = 10;
+			break;
+
+		case CONDITION_POISON:
+			combatType = COMBAT_EARTHDAMAGE;
+			break;
+
+		default:
+			return;
+	}
+
+	ConditionDamage* conditionDamage = new ConditionDamage(CONDITIONID_COMBAT, field.conditionType);
+	if (field.conditionType == CONDITION_POISON) {
+		conditionDamage->setParam(CONDITION_PARAM_DELAYED, true);
+	}
+
+	conditionDamage->setParam(CONDITION_PARAM_CYCLE, cycles);
+	conditionDamage->setParam(CONDITION_PARAM_COUNT, count);
+	conditionDamage->setParam(CONDITION_PARAM_MAX_COUNT, count);
+	conditionDamage->setParam(CONDITION_PARAM_HIT_DAMAGE, field.hitDamage);
+	conditionDamage->setParam(CONDITION_PARAM_FIELD, 1);
+
+	it.combatType = combatType;
+	it.conditionDamage.reset(conditionDamage);
+}
+
+static void applyEntry(std::vector<ItemType>& items, MagicFieldEntries& field, const ItemsSrvEntry& entry)
+{
+	const uint16_t id = entry.id;
+	if (id >= items.size()) {
+		items.resize(id + 1);
+	}
+
+	ItemType& it = items[id];
+	it.id = id;
+
+	const int32_t value = entry.value;
+	switch (entry.key) {
+		case ITEMSRV_NONE: break;
+
+		case ITEMSRV_NAME: it.name = entry.text; break;
+		case ITEMSRV_DESCRIPTION: it.description = entry.text; break;
+
+		case ITEMSRV_FLAG_BANK: it.group = ITEM_GROUP_GROUND; break;
+		case ITEMSRV_FLAG_CLIP: it.alwaysOnTop = true; it.alwaysOnTopOrder = 1; break;
+		case ITEMSRV_FLAG_BOTTOM: it.alwaysOnTop = true; it.alwaysOnTopOrder = 2; break;
+		case ITEMSRV_FLAG_TOP: it.alwaysOnTop = true; it.alwaysOnTopOrder = 3; break;
+		case ITEMSRV_FLAG_CONTAINER: it.type = ITEM_TYPE_CONTAINER; break;
+		case ITEMSRV_FLAG_QUIVER: it.group = ITEM_GROUP_QUIVER; break;
+		case ITEMSRV_FLAG_MULTIWEAPON: it.group = ITEM_GROUP_MULTIWEAPON; break;
+		case ITEMSRV_FLAG_MULTISHOT: it.group = ITEM_GROUP_MULTISHOT; break;
+		case ITEMSRV_FLAG_CHEST: it.type = ITEM_TYPE_CHEST; break;
+		case ITEMSRV_FLAG_CUMULATIVE: it.stackable = true; break;
+		case ITEMSRV_FLAG_CHANGEUSE: it.changeUse = true; break;
+		case ITEMSRV_FLAG_FORCEUSE: it.forceUse = true; break;
+		case ITEMSRV_FLAG_KEY: it.type = ITEM_TYPE_KEY; it.group = ITEM_GROUP_KEY; break;
+		case ITEMSRV_FLAG_DOOR: it.type = ITEM_TYPE_DOOR; break;
+		case ITEMSRV_FLAG_BED: it.type = ITEM_TYPE_BED; break;
+		case ITEMSRV_FLAG_RUNE: it.type = ITEM_TYPE_RUNE; break;
+		case ITEMSRV_FLAG_DEPOT: it.type = ITEM_TYPE_DEPOT; break;
+		case ITEMSRV_FLAG_MAILBOX: it.type = ITEM_TYPE_MAILBOX; break;
+		case ITEMSRV_FLAG_ALLOWDISTREAD: it.allowDistRead = true; break;
+		case ITEMSRV_FLAG_TEXT: it.canReadText = true; break;
+		case ITEMSRV_FLAG_WRITE: it.canWriteText = true; break;
+		case ITEMSRV_FLAG_WRITEONCE: it.canWriteText = true; it.writeOnceItemId = id; break;
+		case ITEMSRV_FLAG_FLUIDCONTAINER: it.group = ITEM_GROUP_FLUID; break;
+		case ITEMSRV_FLAG_SPLASH: it.group = ITEM_GROUP_SPLASH; break;
+		case ITEMSRV_FLAG_UNPASS: it.blockSolid = true; break;
+		case ITEMSRV_FLAG_UNMOVE: it.moveable = false; break;
+		case ITEMSRV_FLAG_UNTHROW: it.blockProjectile = true; break;
+		case ITEMSRV_FLAG_UNLAY: it.allowPickupable = false; break;
+		case ITEMSRV_FLAG_AVOID: it.blockPathFind = true; break;
+		case ITEMSRV_FLAG_MAGICFIELD: it.type = ITEM_TYPE_MAGICFIELD; it.group = ITEM_GROUP_MAGICFIELD; break;
+		case ITEMSRV_FLAG_TAKE: it.pickupable = true; break;
+		case ITEMSRV_FLAG_HANG: it.isHangable = true; break;
+		case ITEMSRV_FLAG_HOOKSOUTH: it.isHorizontal = true; break;
+		case ITEMSRV_FLAG_HOOKEAST: it.isVertical = true; break;
+		case ITEMSRV_FLAG_ROTATE: it.rotatable = true; break;
+		case ITEMSRV_FLAG_DESTROY: it.destroy = true; break;
+		case ITEMSRV_FLAG_CORPSE: it.corpse = true; break;
+		case ITEMSRV_FLAG_EXPIRE: it.stopTime = false; break;
+		case ITEMSRV_FLAG_EXPIRESTOP: it.stopTime = true; break;
+		case ITEMSRV_FLAG_WEAPON: it.group = ITEM_GROUP_WEAPON; break;
+		case ITEMSRV_FLAG_SHIELD: it.weaponType = WEAPON_SHIELD; break;
+		case ITEMSRV_FLAG_DISTANCE: it.weaponType = WEAPON_DISTANCE; break;
+		case ITEMSRV_FLAG_WAND: it.weaponType = WEAPON_WAND; break;
+		case ITEMSRV_FLAG_AMMO: it.weaponType = WEAPON_AMMO; break;
+		case ITEMSRV_FLAG_ARMOR: it.group = ITEM_GROUP_ARMOR; break;
+		case ITEMSRV_FLAG_HEIGHT: it.hasHeight = true; break;
+		case ITEMSRV_FLAG_DISGUISE: it.disguise = true; break;
+		case ITEMSRV_FLAG_SHOWDETAIL: it.showDuration = true; break;
+		case ITEMSRV_FLAG_NOREPLACE: it.replaceable = false; break;
+		case ITEMSRV_FLAG_COLLISIONEVENT: it.collisionEvent = true; break;
+		case ITEMSRV_FLAG_SEPARATIONEVENT: it.separationEvent = true; break;
+		case ITEMSRV_FLAG_USEEVENT: it.useEvent = true; break;
+		case ITEMSRV_FLAG_DISTUSE: it.distUse = true; break;
+		case ITEMSRV_FLAG_MULTIUSE: it.multiUseEvent = true; break;
+
+		case ITEMSRV_ATTR_WAYPOINTS: it.speed = value; break;
+		case ITEMSRV_ATTR_CAPACITY: it.maxItems = value; break;
+		case ITEMSRV_ATTR_CHANGETARGET: it.transformToOnUse = value; break;
+		case ITEMSRV_ATTR_NUTRITION: it.nutrition = value; break;
+		case ITEMSRV_ATTR_MAXLENGTH: it.maxTextLen = value; break;
+		case ITEMSRV_ATTR_FLUIDSOURCE: it.fluidSource = static_cast<FluidTypes_t>(value); break;
+		case ITEMSRV_ATTR_AVOIDDAMAGETYPES: it.combatType = static_cast<CombatType_t>(value); break;
+		case ITEMSRV_ATTR_DAMAGETYPE: it.damageType = static_cast<CombatType_t>(value); break;
+		case ITEMSRV_ATTR_ATTACKSTRENGTH: it.attackStrength = value; break;
+		case ITEMSRV_ATTR_REFLECT: it.reflect = value; break;
+		case ITEMSRV_ATTR_CRITICAL: it.critical = value; break;
+		case ITEMSRV_ATTR_LIFELEECH: it.lifeLeech = value; break;
+		case ITEMSRV_ATTR_MANALEECH: it.manaLeech = value; break;
+		case ITEMSRV_ATTR_ATTACKVARIATION: it.attackVariation = value; break;
+		case ITEMSRV_ATTR_MANACONSUMPTION: it.manaConsumption = value; break;
+
+		case ITEMSRV_ATTR_MINIMUMLEVEL:
+			it.minReqLevel = value;
+			it.wieldInfo |= WIELDINFO_LEVEL;
+			break;
+
+		case ITEMSRV_ATTR_MAGES:
+			it.mages = value;
+			it.wieldInfo |= WIELDINFO_VOCREQ;
+			it.vocationString = getVocationString({"sorcerer", "druid"});
+			break;
+
+		case ITEMSRV_ATTR_VOCATIONS: {
+			it.vocations = value;
+
+			std::list<std::string> vocationStringList;
+			if (hasBitSet(VOCATION_SORCERER, value)) {
+				vocationStringList.push_back("sorcerer");
 			}
-		} else if (identifier == "magicfield") {
-			script.readSymbol('{');
 
-			CombatType_t combatType = COMBAT_NONE;
-			ConditionDamage* conditionDamage = nullptr;
+			if (hasBitSet(VOCATION_DRUID, value)) {
+				vocationStringList.push_back("druid");
+			}
 
-			int32_t cycles = 0;
-			int32_t hit_damage = 0;
+			if (hasBitSet(VOCATION_PALADIN, value)) {
+				vocationStringList.push_back("paladin");
+			}
 
-			while (true) {
-				while (true) {
-					script.nextToken();
-					if (script.Token == SPECIAL) {
-						break;
-					}
+			if (hasBitSet(VOCATION_KNIGHT, value)) {
+				vocationStringList.push_back("knight");
+			}
 
-					identifier = script.getIdentifier();
-					script.readSymbol('=');
-
-					if (identifier == "type") {
-						identifier = script.readIdentifier();
-						if (identifier == "fire") {
-							conditionDamage = new ConditionDamage(CONDITIONID_COMBAT, CONDITION_FIRE);
-							combatType = COMBAT_FIREDAMAGE;
-							items[id].combatType = combatType;
-							items[id].conditionDamage.reset(conditionDamage);
-						} else if (identifier == "energy") {
-							conditionDamage = new ConditionDamage(CONDITIONID_COMBAT, CONDITION_ENERGY);
-							combatType = COMBAT_ENERGYDAMAGE;
-							items[id].combatType = combatType;
-							items[id].conditionDamage.reset(conditionDamage);
-						} else if (identifier == "poison") {
-							conditionDamage = new ConditionDamage(CONDITIONID_COMBAT, CONDITION_POISON);
-							conditionDamage->setParam(CONDITION_PARAM_DELAYED, true);
-							combatType = COMBAT_EARTHDAMAGE;
-							items[id].combatType = combatType;
-							items[id].conditionDamage.reset(conditionDamage);
-						} else {
-							script.error("unknown magicfield type");
-							return false;
-						}
-					} else if (identifier == "count") {
-						cycles = script.readNumber();
-					} else if (identifier == "damage") {
-						hit_damage = script.readNumber();
-					} else {
-						script.error("unknown identifier");
-						return false;
-					}
-				}
+			it.wieldInfo |= WIELDINFO_VOCREQ;
+			it.vocationString = getVocationString(vocationStringList);
+			break;
+		}
 
-				if (script.getSpecial() == '}') {
-					break;
-				}
+		case ITEMSRV_ATTR_WEAPONSPECIALEFFECT: it.weaponSpecialEffect = value; break;
+		case ITEMSRV_ATTR_BEDDIRECTION: it.bedPartnerDir = static_cast<Direction>(value); break;
+		case ITEMSRV_ATTR_BEDTARGET: it.transformToOnUse = value; break;
+		case ITEMSRV_ATTR_BEDFREE: it.transformToFree = value; break;
+		case ITEMSRV_ATTR_WEIGHT: it.weight = value; break;
+		case ITEMSRV_ATTR_ROTATETARGET: it.rotateTo = value; break;
+		case ITEMSRV_ATTR_DESTROYTARGET: it.destroyTarget = value; break;
+		case ITEMSRV_ATTR_SLOTTYPE: break;
+		case ITEMSRV_SLOT_ADD: it.slotPosition |= value; break;
+		case ITEMSRV_SLOT_REMOVE: it.slotPosition &= ~value; break;
+		case ITEMSRV_ATTR_SPEEDBOOST: it.getAbilities().speed = value; break;
+		case ITEMSRV_ATTR_FISTBOOST: it.getAbilities().skills[SKILL_FIST] = value; break;
+		case ITEMSRV_ATTR_SWORDBOOST: it.getAbilities().skills[SKILL_SWORD] = value; break;
+		case ITEMSRV_ATTR_CLUBBOOST: it.getAbilities().skills[SKILL_CLUB] = value; break;
+		case ITEMSRV_ATTR_AXEBOOST: it.getAbilities().skills[SKILL_AXE] = value; break;
+		case ITEMSRV_ATTR_SHIELDBOOST: it.getAbilities().skills[SKILL_SHIELD] = value; break;
+		case ITEMSRV_ATTR_DISTANCEBOOST: it.getAbilities().skills[SKILL_DISTANCE] = value; break;
+		case ITEMSRV_ATTR_MAGICBOOST: it.getAbilities().stats[STAT_MAGICPOINTS] = value; break;
 
-				if (script.Token != SPECIAL || script.getSpecial() != ',') {
-					continue;
-				}
+		case ITEMSRV_ATTR_PERCENTHP:
+			it.maxPoints = value;
+			it.getAbilities().statsPercent[STAT_MAXHITPOINTS] = value;
+			break;
+
+		case ITEMSRV_ATTR_PERCENTMP:
+			it.maxPoints = value;
+			it.getAbilities().statsPercent[STAT_MAXMANAPOINTS] = value;
+			break;
+
+		case ITEMSRV_ATTR_SUPPRESSDRUNK:
+			if (value) {
+				it.getAbilities().conditionSuppressions |= CONDITION_DRUNK;
 			}
+			break;
 
-			int32_t count = 3;
+		case ITEMSRV_ATTR_SUPPRESSFREEZE:
+			if (value) {
+				it.getAbilities().conditionSuppressions |= CONDITION_FREEZING;
+			}
+			break;
 
-			if (combatType == COMBAT_FIREDAMAGE) {
-				cycles /= 10;
-				count = 8;
-			} else if (combatType == COMBAT_ENERGYDAMAGE) {
-				cycles /= 20;
-				count = 10;
+		case ITEMSRV_ATTR_SUPPRESSCURSE:
+			if (value) {
+				it.getAbilities().conditionSuppressions |= CONDITION_CURSED;
 			}
+			break;
+
+		case ITEMSRV_ATTR_SUPPRESSDAZZLE:
+			if (value) {
+				it.getAbilities().conditionSuppressions |= CONDITION_DAZZLED;
+			}
+			break;
 
-			conditionDamage->setParam(CONDITION_PARAM_CYCLE, cycles);
-			conditionDamage->setParam(CONDITION_PARAM_COUNT, count);
-			conditionDamage->setParam(CONDITION_PARAM_MAX_COUNT, count);
-			conditionDamage->setParam(CONDITION_PARAM_HIT_DAMAGE, hit_damage);
+		case ITEMSRV_ATTR_INVISIBLE:
+			if (value) {
+				it.getAbilities().invisible = true;
+			}
+			break;
 
-			conditionDamage->setParam(CONDITION_PARAM_FIELD, 1);
+		case ITEMSRV_ATTR_MANASHIELD:
+			if (value) {
+				it.getAbilities().manaShield = true;
+			}
+			break;
+
+		case ITEMSRV_ATTR_HEALTHTICKS: it.getAbilities().regeneration = true; it.getAbilities().healthTicks = value; break;
+		case ITEMSRV_ATTR_HEALTHGAIN: it.getAbilities().regeneration = true; it.getAbilities().healthGain = value; break;
+		case ITEMSRV_ATTR_MANATICKS: it.getAbilities().regeneration = true; it.getAbilities().manaTicks = value; break;
+		case ITEMSRV_ATTR_MANAGAIN: it.getAbilities().regeneration = true; it.getAbilities().manaGain = value; break;
+
+		case ITEMSRV_ATTR_ABSORBMAGIC: {
+			Abilities& abilities = it.getAbilities();
+			abilities.absorbPercent[combatTypeToIndex(COMBAT_ENERGYDAMAGE)] += value;
+			abilities.absorbPercent[combatTypeToIndex(COMBAT_FIREDAMAGE)] += value;
+			abilities.absorbPercent[combatTypeToIndex(COMBAT_EARTHDAMAGE)] += value;
+			break;
 		}
+
+		case ITEMSRV_ATTR_ABSORBENERGY: it.getAbilities().absorbPercent[combatTypeToIndex(COMBAT_ENERGYDAMAGE)] += value; break;
+		case ITEMSRV_ATTR_ABSORBFIRE: it.getAbilities().absorbPercent[combatTypeToIndex(COMBAT_FIREDAMAGE)] += value; break;
+		case ITEMSRV_ATTR_ABSORBPOISON: it.getAbilities().absorbPercent[combatTypeToIndex(COMBAT_EARTHDAMAGE)] += value; break;
+		case ITEMSRV_ATTR_ABSORBLIFEDRAIN: it.getAbilities().absorbPercent[combatTypeToIndex(COMBAT_LIFEDRAIN)] += value; break;
+		case ITEMSRV_ATTR_ABSORBMANADRAIN: it.getAbilities().absorbPercent[combatTypeToIndex(COMBAT_MANADRAIN)] += value; break;
+		case ITEMSRV_ATTR_ABSORBICE: it.getAbilities().absorbPercent[combatTypeToIndex(COMBAT_ICEDAMAGE)] += value; break;
+		case ITEMSRV_ATTR_ABSORBHOLY: it.getAbilities().absorbPercent[combatTypeToIndex(COMBAT_HOLYDAMAGE)] += value; break;
+		case ITEMSRV_ATTR_ABSORBDEATH: it.getAbilities().absorbPercent[combatTypeToIndex(COMBAT_DEATHDAMAGE)] += value; break;
+		case ITEMSRV_ATTR_ABSORBPHYSICAL: it.getAbilities().absorbPercent[combatTypeToIndex(COMBAT_PHYSICALDAMAGE)] += value; break;
+		case ITEMSRV_ATTR_ABSORBHEALING: it.getAbilities().absorbPercent[combatTypeToIndex(COMBAT_HEALING)] += value; break;
+		case ITEMSRV_ATTR_ABSORBUNDEFINED: it.getAbilities().absorbPercent[combatTypeToIndex(COMBAT_UNDEFINEDDAMAGE)] += value; break;
+		case ITEMSRV_ATTR_ABSORBFIREFIELD: it.getAbilities().fieldAbsorbPercent[combatTypeToIndex(COMBAT_FIREDAMAGE)] += static_cast<int16_t>(value); break;
+
+		case ITEMSRV_ATTR_BRIGHTNESS: it.lightLevel = value; break;
+		case ITEMSRV_ATTR_LIGHTCOLOR: it.lightColor = value; break;
+		case ITEMSRV_ATTR_TOTALEXPIRETIME: it.decayTime = value; break;
+		case ITEMSRV_ATTR_EXPIRETARGET: it.decayTo = value; break;
+		case ITEMSRV_ATTR_TOTALUSES: it.charges = value; break;
+		case ITEMSRV_ATTR_WEAPONTYPE: it.weaponType = static_cast<WeaponType_t>(value); break;
+		case ITEMSRV_ATTR_ATTACK: it.attack = value; break;
+		case ITEMSRV_ATTR_DEFENSE: it.defense = value; break;
+		case ITEMSRV_ATTR_RANGE: it.shootRange = static_cast<uint8_t>(value); break;
+		case ITEMSRV_ATTR_AMMOTYPE: it.ammoType = static_cast<Ammo_t>(value); break;
+		case ITEMSRV_ATTR_MISSILEEFFECT: it.shootType = static_cast<ShootType_t>(value); break;
+		case ITEMSRV_ATTR_FRAGILITY: it.fragility = value; break;
+		case ITEMSRV_ATTR_ARMORVALUE: it.armor = value; break;
+		case ITEMSRV_ATTR_DISGUISETARGET: it.disguiseId = value; break;
+		case ITEMSRV_ATTR_EQUIPTARGET: it.transformEquipTo = value; break;
+		case ITEMSRV_ATTR_DEEQUIPTARGET: it.transformDeEquipTo = value; break;
+
+		case ITEMSRV_FIELD_TYPE: field.conditionType = static_cast<ConditionType_t>(value); break;
+		case ITEMSRV_FIELD_COUNT: field.cycles = value; break;
+		case ITEMSRV_FIELD_DAMAGE: field.hitDamage = value; break;
+
+		case ITEMSRV_FIELD_END:
+			applyMagicField(it, field);
+			field = MagicFieldEntries();
+			break;
+	}
+}
+
+static bool readFile(const std::string& name, std::string& contents)
+{
+	std::ifstream fileStream(name, std::ios::binary);
+	if (!fileStream.is_open()) {
+		return false;
+	}
+
+	contents.assign(std::istreambuf_iterator<char>(fileStream), std::istreambuf_iterator<char>());
+	return true;
+}
+
+static uint64_t getContentHash(const std::string& contents)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (char c : contents) {
+		hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+static constexpr uint32_t ITEMS_CACHE_MAGIC = 0x43535249; // "IRSC"
+static constexpr uint32_t ITEMS_CACHE_VERSION = 1;
+
+static bool isTextEntry(ItemsSrvKey_t key)
+{
+	return key == ITEMSRV_NAME || key == ITEMSRV_DESCRIPTION;
+}
+
+static std::string serializeEntries(uint64_t sourceHash, const std::vector<ItemsSrvEntry>& entries)
+{
+	PropWriteStream propWriteStream;
+	propWriteStream.write<uint32_t>(ITEMS_CACHE_MAGIC);
+	propWriteStream.write<uint32_t>(ITEMS_CACHE_VERSION);
+	propWriteStream.write<uint64_t>(sourceHash);
+	propWriteStream.write<uint32_t>(entries.size());
+
+	for (const ItemsSrvEntry& entry : entries) {
+		propWriteStream.write<uint16_t>(entry.id);
+		propWriteStream.write<uint8_t>(entry.key);
+		if (isTextEntry(entry.key)) {
+			propWriteStream.writeString(entry.text);
+		} else {
+			propWriteStream.write<int32_t>(entry.value);
+		}
+	}
+
+	size_t size;
+	const char* data = propWriteStream.getStream(size);
+	return std::string(data, size);
+}
+
+// false if the cache is not of this version or was compiled from another items.srv
+static bool unserializeEntries(const std::string& contents, uint64_t sourceHash, std::vector<ItemsSrvEntry>& entries)
+{
+	PropStream propStream;
+	propStream.init(contents.data(), contents.size());
+
+	uint32_t magic, version, count;
+	uint64_t hash;
+	if (!propStream.read<uint32_t>(magic) || magic != ITEMS_CACHE_MAGIC ||
+			!propStream.read<uint32_t>(version) || version != ITEMS_CACHE_VERSION ||
+			!propStream.read<uint64_t>(hash) || hash != sourceHash || !propStream.read<uint32_t>(count)) {
+		return false;
+	}
+
+	entries.clear();
+	entries.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		uint16_t id;
+		uint8_t key;
+		if (!propStream.read<uint16_t>(id) || !propStream.read<uint8_t>(key) || key > ITEMSRV_FIELD_END) {
+			return false;
+		}
+
+		if (isTextEntry(static_cast<ItemsSrvKey_t>(key))) {
+			std::string text;
+			if (!propStream.readString(text)) {
+				return false;
+			}
+			entries.emplace_back(id, static_cast<ItemsSrvKey_t>(key), std::move(text));
+		} else {
+			int32_t value;
+			if (!propStream.read<int32_t>(value)) {
+				return false;
+			}
+			entries.emplace_back(id, static_cast<ItemsSrvKey_t>(key), value);
+		}
+	}
+	return propStream.size() == 0;
+}
+
+// the cache is written next to items.srv and read back before it is trusted
+static void writeItemsCache(const std::string& fileName, uint64_t sourceHash, const std::vector<ItemsSrvEntry>& entries)
+{
+	const std::string contents = serializeEntries(sourceHash, entries);
+	const std::string tempName = fileName + ".tmp";
+	{
+		std::ofstream fileStream(tempName, std::ios::binary | std::ios::trunc);
+		if (!fileStream.write(contents.data(), contents.size())) {
+			std::cout << "[Warning - Items::loadItems] Unable to write " << tempName << std::endl;
+			return;
+		}
+	}
+
+	std::string written;
+	std::vector<ItemsSrvEntry> writtenEntries;
+	if (!readFile(tempName, written) || !unserializeEntries(written, sourceHash, writtenEntries) || writtenEntries != entries) {
+		std::cout << "[Warning - Items::loadItems] " << tempName << " does not read back as written, not using it." << std::endl;
+		std::remove(tempName.c_str());
+		return;
+	}
+
+	boost::system::error_code ec;
+	boost::filesystem::rename(tempName, fileName, ec);
+	if (ec) {
+		std::cout << "[Warning - Items::loadItems] Unable to replace " << fileName << ": " << ec.message() << std::endl;
+	}
+}
+
+bool Items::loadItems()
+{
+	const std::string sourceName = "data/items/items.srv";
+	const std::string cacheName = "data/items/items.srv.cache";
+
+	std::string source;
+	if (!readFile(sourceName, source)) {
+		std::cout << "[Error - Items::loadItems] Unable to read " << sourceName << std::endl;
+		return false;
+	}
+
+	const uint64_t sourceHash = getContentHash(source);
+
+	std::string cache;
+	std::vector<ItemsSrvEntry> entries;
+	if (!readFile(cacheName, cache) || !unserializeEntries(cache, sourceHash, entries)) {
+		entries.clear();
+		if (!parseItemsSrv(sourceName, entries)) {
+			return false;
+		}
+		writeItemsCache(cacheName, sourceHash, entries);
+	}
+
+	MagicFieldEntries field;
+	for (const ItemsSrvEntry& entry : entries) {
+		applyEntry(items, field, entry);
 	}
 
-	script.close();
 	items.shrink_to_fit();
 
 	for (ItemType& type : items) {
@@ -632,9 +1024,63 @@ bool Items::loadItems()
 		}
 	}
 
+	buildHotTable();
 	return true;
 }
 
+void Items::buildHotTable()
+{
+	hotItems.clear();
+	hotItems.resize(items.size());
+
+	for (size_t id = 0, size = items.size(); id < size; ++id) {
+		const ItemType& it = items[id];
+		ItemTypeHot& hot = hotItems[id];
+
+		const bool blockPath = it.blockPathFind;
+		const bool immovable = !it.moveable;
+		const bool field = it.isMagicField();
+
+		const std::pair<ITEMPROPERTY, bool> properties[] = {
+			{CONST_PROP_BLOCKSOLID, it.blockSolid},
+			{CONST_PROP_HASHEIGHT, it.hasHeight},
+			{CONST_PROP_BLOCKPROJECTILE, it.blockProjectile},
+			{CONST_PROP_BLOCKPATH, blockPath},
+			{CONST_PROP_ISVERTICAL, it.isVertical},
+			{CONST_PROP_ISHORIZONTAL, it.isHorizontal},
+			{CONST_PROP_MOVEABLE, it.moveable},
+			{CONST_PROP_IMMOVABLEBLOCKSOLID, it.blockSolid && immovable},
+			{CONST_PROP_IMMOVABLEBLOCKPATH, blockPath && immovable},
+			{CONST_PROP_IMMOVABLENOFIELDBLOCKPATH, !field && blockPath && immovable},
+			{CONST_PROP_NOFIELDBLOCKPATH, !field && blockPath},
+			{CONST_PROP_SUPPORTHANGABLE, it.isHorizontal || it.isVertical},
+			{CONST_PROP_UNLAY, !it.allowPickupable},
+		};
+		for (const auto& property : properties) {
+			if (property.second) {
+				hot.properties |= 1U << property.first;
+			}
+		}
+
+		const std::pair<ItemTypeHotFlags, bool> flags[] = {
+			{ITEMTYPE_STACKABLE, it.stackable},
+			{ITEMTYPE_ALWAYSONTOP, it.alwaysOnTop},
+			{ITEMTYPE_PICKUPABLE, it.pickupable},
+			{ITEMTYPE_ALLOWPICKUPABLE, it.allowPickupable},
+			{ITEMTYPE_GROUNDTILE, it.isGroundTile()},
+			{ITEMTYPE_MAGICFIELD, field},
+			{ITEMTYPE_SPLASH, it.isSplash()},
+		};
+		for (const auto& flag : flags) {
+			if (flag.second) {
+				hot.flags |= flag.first;
+			}
+		}
+
+		hot.alwaysOnTopOrder = it.alwaysOnTopOrder;
+	}
+}
+
 ItemType& Items::getItemType(size_t id)
 {
 	if (id < items.size()) {
@@ -37,6 +37,22 @@ enum SlotPositionBits : uint32_t {
 	SLOTP_HAND = (SLOTP_LEFT | SLOTP_RIGHT)
 };
 
+enum ITEMPROPERTY {
+	CONST_PROP_BLOCKSOLID = 0,
+	CONST_PROP_HASHEIGHT,
+	CONST_PROP_BLOCKPROJECTILE,
+	CONST_PROP_BLOCKPATH,
+	CONST_PROP_ISVERTICAL,
+	CONST_PROP_ISHORIZONTAL,
+	CONST_PROP_MOVEABLE,
+	CONST_PROP_IMMOVABLEBLOCKSOLID,
+	CONST_PROP_IMMOVABLEBLOCKPATH,
+	CONST_PROP_IMMOVABLENOFIELDBLOCKPATH,
+	CONST_PROP_NOFIELDBLOCKPATH,
+	CONST_PROP_SUPPORTHANGABLE,
+	CONST_PROP_UNLAY,
+};
+
 enum ItemTypes_t {
 	ITEM_TYPE_NONE,
 	ITEM_TYPE_DEPOT,
@@ -309,6 +325,32 @@ class ItemType
 		bool showCount = true;
 };
 
+// the flags besides ITEMPROPERTY read for every item on a tile
+enum ItemTypeHotFlags : uint16_t {
+	ITEMTYPE_STACKABLE = 1 << 0,
+	ITEMTYPE_ALWAYSONTOP = 1 << 1,
+	ITEMTYPE_PICKUPABLE = 1 << 2,
+	ITEMTYPE_ALLOWPICKUPABLE = 1 << 3,
+	ITEMTYPE_GROUNDTILE = 1 << 4,
+	ITEMTYPE_MAGICFIELD = 1 << 5,
+	ITEMTYPE_SPLASH = 1 << 6,
+};
+
+// Tile and pathfinding checks look at every item on a tile, a copy of what
+// they read is packed apart from the rest of ItemType, 8 bytes per type.
+struct ItemTypeHot {
+	uint32_t properties = 0; // a bit per ITEMPROPERTY
+	uint16_t flags = 0;
+	uint8_t alwaysOnTopOrder = 0;
+
+	bool hasProperty(ITEMPROPERTY prop) const {
+		return (properties & (1U << prop)) != 0;
+	}
+	bool hasFlag(ItemTypeHotFlags flag) const {
+		return (flags & flag) != 0;
+	}
+};
+
 class Items
 {
 	public:
@@ -329,6 +371,13 @@ class Items
 		const ItemType& getItemType(size_t id) const;
 		ItemType& getItemType(size_t id);
 
+		const ItemTypeHot& getHot(size_t id) const {
+			if (id < hotItems.size()) {
+				return hotItems[id];
+			}
+			return hotItems.front();
+		}
+
 		uint16_t getItemIdByName(const std::string& name);
 
 		bool loadItems();
@@ -340,6 +389,9 @@ class Items
 		nameMap nameToItems;
 
 	protected:
+		void buildHotTable();
+
 		std::vector<ItemType> items;
+		std::vector<ItemTypeHot> hotItems;
 };
 #endif
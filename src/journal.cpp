@@ -0,0 +1,853 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#include "otpch.h"
+
+#include "journal.h"
+#include "configmanager.h"
+#include "game.h"
+#include "iologindata.h"
+#include "tools.h"
+
+#include <fstream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+extern ConfigManager g_config;
+extern Game g_game;
+
+PlayerJournal g_journal;
+
+static const std::string JOURNAL_DIRECTORY = "data/journal/";
+
+enum JournalRecord_t : uint8_t {
+	JOURNAL_RECORD_PLAYER = 1,
+	JOURNAL_RECORD_SAVED = 2,
+};
+
+enum JournalSection_t : uint8_t {
+	JOURNAL_SECTION_END = 0,
+	JOURNAL_SECTION_STORAGE = 1,
+	JOURNAL_SECTION_INVENTORY = 2,
+	JOURNAL_SECTION_DEPOT = 3,
+	JOURNAL_SECTION_SPELLS = 4,
+	JOURNAL_SECTION_MURDERS = 5,
+};
+
+// records are framed as size, checksum and body so a write torn by a crash
+// is recognized and replay stops there
+static uint32_t getChecksum(const char* data, size_t size)
+{
+	uint32_t a = 1, b = 0;
+	for (size_t i = 0; i < size; ++i) {
+		a = (a + static_cast<uint8_t>(data[i])) % 65521;
+		b = (b + a) % 65521;
+	}
+	return (b << 16) | a;
+}
+
+static void appendFramed(std::string& out, const char* data, size_t size)
+{
+	const uint32_t header[2] = {static_cast<uint32_t>(size), getChecksum(data, size)};
+	out.append(reinterpret_cast<const char*>(header), sizeof(header));
+	out.append(data, size);
+}
+
+static std::string getSegmentName(uint64_t segment)
+{
+	std::ostringstream ss;
+	ss << JOURNAL_DIRECTORY << std::setw(12) << std::setfill('0') << segment << ".journal";
+	return ss.str();
+}
+
+static void writeItemRows(PropWriteStream& stream, const std::vector<PlayerItemRow>& rows)
+{
+	stream.write<uint32_t>(rows.size());
+	for (const PlayerItemRow& row : rows) {
+		stream.write<int32_t>(row.pid);
+		stream.write<int32_t>(row.sid);
+		stream.write<uint16_t>(row.itemType);
+		stream.write<uint16_t>(row.count);
+		stream.writeString(row.attributes);
+	}
+}
+
+static bool readItemRows(PropStream& stream, std::vector<PlayerItemRow>& rows)
+{
+	uint32_t count;
+	if (!stream.read<uint32_t>(count)) {
+		return false;
+	}
+
+	rows.clear();
+	rows.reserve(count);
+	while (count--) {
+		int32_t pid, sid;
+		uint16_t itemType, itemCount;
+		std::string attributes;
+		if (!stream.read<int32_t>(pid) || !stream.read<int32_t>(sid) || !stream.read<uint16_t>(itemType) || !stream.read<uint16_t>(itemCount) || !stream.readString(attributes)) {
+			return false;
+		}
+		rows.emplace_back(pid, sid, itemType, itemCount, std::move(attributes));
+	}
+	return true;
+}
+
+void PlayerJournal::writeStats(PropWriteStream& stream, const Player* player)
+{
+	stream.writeString(player->getName());
+	stream.write<uint16_t>(player->group->id);
+	stream.write<uint16_t>(player->getVocationId());
+	stream.write<uint32_t>(player->level);
+	stream.write<uint64_t>(player->experience);
+	stream.write<int32_t>(player->health);
+	stream.write<int32_t>(player->healthMax);
+	stream.write<uint32_t>(player->mana);
+	stream.write<uint32_t>(player->manaMax);
+	stream.write<uint32_t>(player->magLevel);
+	stream.write<uint64_t>(player->manaSpent);
+	stream.write<uint8_t>(player->soul);
+	stream.write<uint32_t>(player->town->getID());
+
+	const Position& position = player->getLoginPosition();
+	stream.write<uint16_t>(position.x);
+	stream.write<uint16_t>(position.y);
+	stream.write<uint8_t>(position.z);
+
+	stream.write<uint32_t>(player->capacity);
+	stream.write<uint8_t>(player->sex);
+
+	const Outfit_t& outfit = player->defaultOutfit;
+	stream.write<uint16_t>(outfit.lookType);
+	stream.write<uint8_t>(outfit.lookHead);
+	stream.write<uint8_t>(outfit.lookBody);
+	stream.write<uint8_t>(outfit.lookLegs);
+	stream.write<uint8_t>(outfit.lookFeet);
+
+	if (g_game.getWorldType() != WORLD_TYPE_PVP_ENFORCED) {
+		stream.write<uint8_t>(1);
+		stream.write<int64_t>(player->getPlayerKillerEnd());
+		stream.write<uint8_t>(player->skull == SKULL_RED ? SKULL_RED : SKULL_NONE);
+	} else {
+		stream.write<uint8_t>(0);
+	}
+
+	stream.write<int64_t>(player->getLastLogout());
+	stream.write<uint64_t>(player->bankBalance);
+	for (uint8_t i = SKILL_FIRST; i <= SKILL_LAST; ++i) {
+		stream.write<uint16_t>(player->skills[i].level);
+		stream.write<uint64_t>(player->skills[i].tries);
+	}
+	stream.write<uint8_t>(player->blessings);
+
+	PropWriteStream conditions;
+	for (Condition* condition : player->conditions) {
+		if (condition->isPersistent()) {
+			condition->serialize(conditions);
+			conditions.write<uint8_t>(CONDITIONATTR_END);
+		}
+	}
+
+	size_t conditionsSize;
+	const char* conditionsData = conditions.getStream(conditionsSize);
+	stream.writeString(std::string(conditionsData, conditionsSize));
+}
+
+bool PlayerJournal::readStats(PropStream& stream, PlayerSaveSnapshot& snapshot)
+{
+	uint8_t soul, sex, saveSkull, blessings;
+	uint16_t x, y;
+	uint8_t z;
+	if (!stream.readString(snapshot.name) || !stream.read<uint16_t>(snapshot.groupId) || !stream.read<uint16_t>(snapshot.vocationId) ||
+	        !stream.read<uint32_t>(snapshot.level) || !stream.read<uint64_t>(snapshot.experience) ||
+	        !stream.read<int32_t>(snapshot.health) || !stream.read<int32_t>(snapshot.healthMax) ||
+	        !stream.read<uint32_t>(snapshot.mana) || !stream.read<uint32_t>(snapshot.manaMax) ||
+	        !stream.read<uint32_t>(snapshot.magLevel) || !stream.read<uint64_t>(snapshot.manaSpent) ||
+	        !stream.read<uint8_t>(soul) || !stream.read<uint32_t>(snapshot.townId) ||
+	        !stream.read<uint16_t>(x) || !stream.read<uint16_t>(y) || !stream.read<uint8_t>(z) ||
+	        !stream.read<uint32_t>(snapshot.capacity) || !stream.read<uint8_t>(sex)) {
+		return false;
+	}
+
+	snapshot.soul = soul;
+	snapshot.sex = static_cast<PlayerSex_t>(sex);
+	snapshot.loginPosition = Position(x, y, z);
+
+	Outfit_t& outfit = snapshot.outfit;
+	if (!stream.read<uint16_t>(outfit.lookType) || !stream.read<uint8_t>(outfit.lookHead) || !stream.read<uint8_t>(outfit.lookBody) ||
+	        !stream.read<uint8_t>(outfit.lookLegs) || !stream.read<uint8_t>(outfit.lookFeet) || !stream.read<uint8_t>(saveSkull)) {
+		return false;
+	}
+
+	snapshot.saveSkull = saveSkull != 0;
+	if (snapshot.saveSkull) {
+		int64_t skullTime;
+		uint8_t skull;
+		if (!stream.read<int64_t>(skullTime) || !stream.read<uint8_t>(skull)) {
+			return false;
+		}
+		snapshot.skullTime = skullTime;
+		snapshot.skull = static_cast<Skulls_t>(skull);
+	}
+
+	int64_t lastLogout;
+	if (!stream.read<int64_t>(lastLogout) || !stream.read<uint64_t>(snapshot.bankBalance)) {
+		return false;
+	}
+	snapshot.lastLogout = lastLogout;
+
+	for (uint8_t i = SKILL_FIRST; i <= SKILL_LAST; ++i) {
+		if (!stream.read<uint16_t>(snapshot.skills[i].level) || !stream.read<uint64_t>(snapshot.skills[i].tries)) {
+			return false;
+		}
+	}
+
+	if (!stream.read<uint8_t>(blessings) || !stream.readString(snapshot.conditions)) {
+		return false;
+	}
+	snapshot.blessings = blessings;
+	return true;
+}
+
+bool PlayerJournal::open()
+{
+	std::vector<boost::filesystem::path> paths;
+	if (boost::filesystem::is_directory(JOURNAL_DIRECTORY)) {
+		getFilesInDirectory(JOURNAL_DIRECTORY, ".journal", paths);
+	}
+
+	std::vector<std::string> files;
+	for (const boost::filesystem::path& path : paths) {
+		files.push_back(path.string());
+	}
+	std::sort(files.begin(), files.end());
+
+	// whatever the previous run left behind is replayed even when the
+	// journal has been switched off since
+	if (!files.empty()) {
+		std::cout << ">> Replaying " << files.size() << " player journal segment(s)" << std::endl;
+		if (!replayFiles(files)) {
+			return false;
+		}
+
+		for (const std::string& name : files) {
+			boost::system::error_code ec;
+			boost::filesystem::remove(name, ec);
+		}
+	}
+
+	enabled = g_config.getBoolean(ConfigManager::PLAYER_JOURNAL);
+	if (!enabled) {
+		return true;
+	}
+
+	boost::system::error_code ec;
+	boost::filesystem::create_directories(JOURNAL_DIRECTORY, ec);
+	if (ec) {
+		std::cout << "> ERROR: Unable to create " << JOURNAL_DIRECTORY << ": " << ec.message() << std::endl;
+		return false;
+	}
+
+	// the journal thread opens the first segment before anything else, so
+	// save markers always have a segment to go to
+	blocks.emplace_back(segment, std::string());
+	start();
+	return true;
+}
+
+void PlayerJournal::shutdown()
+{
+	if (!enabled) {
+		return;
+	}
+
+	flush();
+
+	// after a clean shutdown with every save written nothing is left to replay
+	std::lock_guard<std::mutex> lockGuard(blockLock);
+	if (!failedSaves) {
+		releaseBefore = std::numeric_limits<uint64_t>::max();
+	}
+	setState(THREAD_STATE_TERMINATED);
+	blockSignal.notify_one();
+}
+
+void PlayerJournal::recordPlayer(Player* player)
+{
+	if (!enabled) {
+		return;
+	}
+
+	const uint32_t guid = player->getGUID();
+	auto stateIt = players.find(guid);
+	if (stateIt == players.end()) {
+		// start from what the database holds, the player was just loaded
+		// or saved and only changes from here on need journaling
+		PlayerState& state = players[guid];
+		state.inventoryGeneration = player->savedInventoryGeneration;
+		state.depotGenerations = player->savedDepotGenerations;
+		state.spells = player->spellsModified ? std::numeric_limits<size_t>::max() : std::distance(player->learnedInstantSpellList.begin(), player->learnedInstantSpellList.end());
+		state.murders = player->murdersModified ? std::numeric_limits<size_t>::max() : player->murderTimeStamps.size();
+		stateIt = players.find(guid);
+	}
+
+	PlayerState& state = stateIt->second;
+
+	PropWriteStream statsStream;
+	writeStats(statsStream, player);
+
+	size_t statsSize;
+	const char* statsData = statsStream.getStream(statsSize);
+
+	const size_t spells = std::distance(player->learnedInstantSpellList.begin(), player->learnedInstantSpellList.end());
+	const size_t murders = player->murderTimeStamps.size();
+
+	bool depotsChanged = false;
+	for (const auto& it : player->depotLockerMap) {
+		auto generationIt = state.depotGenerations.find(it.first);
+		if (generationIt == state.depotGenerations.end() || generationIt->second != it.second->getGeneration()) {
+			depotsChanged = true;
+			break;
+		}
+	}
+
+	const bool statsChanged = state.stats.size() != statsSize || state.stats.compare(0, statsSize, statsData, statsSize) != 0;
+	const bool inventoryChanged = state.inventoryGeneration != player->inventoryGeneration;
+	if (!statsChanged && !inventoryChanged && !depotsChanged && state.spells == spells && state.murders == murders && !player->storage.hasChanges(PlayerStorage::CHANGE_JOURNAL)) {
+		return;
+	}
+
+	PropWriteStream body;
+	body.write<uint8_t>(JOURNAL_RECORD_PLAYER);
+	body.write<uint64_t>(sequence++);
+	body.write<uint32_t>(guid);
+	body.writeString(std::string(statsData, statsSize));
+
+	if (player->storage.hasChanges(PlayerStorage::CHANGE_JOURNAL)) {
+		std::vector<std::pair<uint32_t, int32_t>> values;
+		std::vector<uint32_t> removedKeys;
+		player->storage.getChanges(PlayerStorage::CHANGE_JOURNAL, values, removedKeys);
+
+		body.write<uint8_t>(JOURNAL_SECTION_STORAGE);
+		body.write<uint32_t>(values.size() + removedKeys.size());
+		for (const auto& it : values) {
+			body.write<uint32_t>(it.first);
+			body.write<uint8_t>(1);
+			body.write<int32_t>(it.second);
+		}
+		for (uint32_t key : removedKeys) {
+			body.write<uint32_t>(key);
+			body.write<uint8_t>(0);
+		}
+		player->storage.clearChanges(PlayerStorage::CHANGE_JOURNAL);
+	}
+
+	PropWriteStream attributes;
+	std::vector<PlayerItemRow> rows;
+	if (inventoryChanged) {
+		IOLoginData::snapshotInventory(player, rows, attributes);
+		body.write<uint8_t>(JOURNAL_SECTION_INVENTORY);
+		writeItemRows(body, rows);
+		state.inventoryGeneration = player->inventoryGeneration;
+	}
+
+	if (depotsChanged) {
+		for (const auto& it : player->depotLockerMap) {
+			auto generationIt = state.depotGenerations.find(it.first);
+			if (generationIt != state.depotGenerations.end() && generationIt->second == it.second->getGeneration()) {
+				continue;
+			}
+
+			rows.clear();
+			IOLoginData::snapshotDepot(it.first, it.second, rows, attributes);
+			body.write<uint8_t>(JOURNAL_SECTION_DEPOT);
+			body.write<uint32_t>(it.first);
+			writeItemRows(body, rows);
+			state.depotGenerations[it.first] = it.second->getGeneration();
+		}
+	}
+
+	if (state.spells != spells) {
+		body.write<uint8_t>(JOURNAL_SECTION_SPELLS);
+		body.write<uint32_t>(spells);
+		for (const std::string& spellName : player->learnedInstantSpellList) {
+			body.writeString(spellName);
+		}
+		state.spells = spells;
+	}
+
+	if (state.murders != murders) {
+		body.write<uint8_t>(JOURNAL_SECTION_MURDERS);
+		body.write<uint32_t>(murders);
+		for (time_t timestamp : player->murderTimeStamps) {
+			body.write<int64_t>(timestamp);
+		}
+		state.murders = murders;
+	}
+
+	body.write<uint8_t>(JOURNAL_SECTION_END);
+	state.stats.assign(statsData, statsSize);
+	appendRecord(body);
+}
+
+void PlayerJournal::recordPlayers()
+{
+	if (!enabled) {
+		return;
+	}
+
+	for (const auto& it : g_game.getPlayers()) {
+		recordPlayer(it.second);
+	}
+	flush();
+}
+
+void PlayerJournal::appendRecord(const PropWriteStream& body)
+{
+	size_t size;
+	const char* data = body.getStream(size);
+	appendFramed(buffer, data, size);
+}
+
+void PlayerJournal::flush()
+{
+	if (buffer.empty()) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lockGuard(blockLock);
+	blocks.emplace_back(segment, std::move(buffer));
+	buffer.clear();
+	blockSignal.notify_one();
+}
+
+void PlayerJournal::forgetPlayer(uint32_t guid)
+{
+	players.erase(guid);
+}
+
+uint64_t PlayerJournal::rotate()
+{
+	if (!enabled) {
+		return segment;
+	}
+
+	flush();
+
+	const uint64_t previous = segment++;
+
+	// an empty block makes the journal thread open the new segment now
+	// rather than with the next record
+	std::lock_guard<std::mutex> lockGuard(blockLock);
+	blocks.emplace_back(segment, std::string());
+	blockSignal.notify_one();
+	return previous;
+}
+
+void PlayerJournal::release(uint64_t segment)
+{
+	if (!enabled) {
+		return;
+	}
+
+	// a failed save leaves its progress only in the journal
+	if (failedSaves.exchange(false)) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lockGuard(blockLock);
+	releaseBefore = std::max<uint64_t>(releaseBefore, segment + 1);
+	blockSignal.notify_one();
+}
+
+void PlayerJournal::markSaved(uint32_t guid, uint64_t savedSequence)
+{
+	if (!enabled) {
+		return;
+	}
+
+	PropWriteStream body;
+	body.write<uint8_t>(JOURNAL_RECORD_SAVED);
+	body.write<uint32_t>(guid);
+	body.write<uint64_t>(savedSequence);
+
+	size_t size;
+	const char* data = body.getStream(size);
+
+	std::lock_guard<std::mutex> lockGuard(blockLock);
+	appendFramed(markers, data, size);
+	blockSignal.notify_one();
+}
+
+void PlayerJournal::markFailed()
+{
+	failedSaves = true;
+}
+
+PlayerJournalStats PlayerJournal::getStats()
+{
+	PlayerJournalStats stats;
+	stats.segment = segment;
+	stats.records = records;
+	stats.bytes = bytes;
+	stats.syncs = syncs;
+	stats.syncTime = syncTime;
+	return stats;
+}
+
+void PlayerJournal::threadMain()
+{
+	std::unique_lock<std::mutex> blockLockUnique(blockLock, std::defer_lock);
+	while (true) {
+		blockLockUnique.lock();
+		while (blocks.empty() && markers.empty() && releaseBefore == 0 && getState() != THREAD_STATE_TERMINATED) {
+			blockSignal.wait(blockLockUnique);
+		}
+
+		std::list<Block> pending;
+		pending.swap(blocks);
+
+		std::string pendingMarkers;
+		pendingMarkers.swap(markers);
+
+		const uint64_t removeBefore = releaseBefore;
+		releaseBefore = 0;
+
+		const bool terminated = getState() == THREAD_STATE_TERMINATED;
+		blockLockUnique.unlock();
+
+		if (!pending.empty() || !pendingMarkers.empty()) {
+			auto startTime = std::chrono::steady_clock::now();
+
+			bool written = true;
+			for (const Block& block : pending) {
+				written = writeBlock(block) && written;
+			}
+
+			// markers go to the segment currently open, a marker written
+			// after its records' segment was released is simply not needed
+			if (!pendingMarkers.empty()) {
+				written = writeBlock(Block(openedSegment, std::move(pendingMarkers))) && written;
+			}
+
+			if (file) {
+				std::fflush(file);
+#ifdef _WIN32
+				_commit(_fileno(file));
+#else
+				fsync(fileno(file));
+#endif
+				++syncs;
+				syncTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+			}
+
+			if (!written) {
+				std::cout << "[Warning - PlayerJournal::threadMain] Unable to write to the player journal." << std::endl;
+			}
+		}
+
+		if (terminated) {
+			if (file) {
+				std::fclose(file);
+				file = nullptr;
+				openedSegment = 0;
+			}
+
+			if (removeBefore != 0) {
+				removeSegments(removeBefore);
+			}
+			break;
+		}
+
+		if (removeBefore != 0) {
+			removeSegments(removeBefore);
+		}
+	}
+}
+
+bool PlayerJournal::writeBlock(const Block& block)
+{
+	if (block.segment != openedSegment && !openSegment(block.segment)) {
+		return false;
+	}
+
+	if (block.data.empty()) {
+		return true;
+	}
+
+	if (std::fwrite(block.data.data(), 1, block.data.size(), file) != block.data.size()) {
+		return false;
+	}
+
+	bytes += block.data.size();
+
+	// count the framed records in the block
+	for (size_t offset = 0; offset + 8 <= block.data.size();) {
+		uint32_t size;
+		memcpy(&size, block.data.data() + offset, sizeof(size));
+		offset += 8 + size;
+		++records;
+	}
+	return true;
+}
+
+bool PlayerJournal::openSegment(uint64_t segment)
+{
+	if (file) {
+		std::fflush(file);
+		std::fclose(file);
+	}
+
+	openedSegment = segment;
+	file = std::fopen(getSegmentName(segment).c_str(), "ab");
+	return file != nullptr;
+}
+
+void PlayerJournal::removeSegments(uint64_t before)
+{
+	std::vector<boost::filesystem::path> paths;
+	getFilesInDirectory(JOURNAL_DIRECTORY, ".journal", paths);
+	for (const boost::filesystem::path& path : paths) {
+		uint64_t number;
+		try {
+			number = std::stoull(path.stem().string());
+		} catch (const std::exception&) {
+			continue;
+		}
+
+		if (number < before && number != openedSegment) {
+			boost::system::error_code ec;
+			boost::filesystem::remove(path, ec);
+		}
+	}
+}
+
+static bool readFile(const std::string& name, std::string& contents)
+{
+	std::ifstream fileStream(name, std::ios::binary);
+	if (!fileStream.is_open()) {
+		return false;
+	}
+
+	contents.assign(std::istreambuf_iterator<char>(fileStream), std::istreambuf_iterator<char>());
+	return true;
+}
+
+// calls function with the body of every intact record, stops at a torn or
+// corrupt one since nothing after it can be trusted
+template <typename Function>
+static void forEachRecord(const std::string& name, const std::string& contents, Function function)
+{
+	size_t offset = 0;
+	while (offset + 8 <= contents.size()) {
+		uint32_t header[2];
+		memcpy(header, contents.data() + offset, sizeof(header));
+		offset += sizeof(header);
+
+		if (header[0] > contents.size() - offset || getChecksum(contents.data() + offset, header[0]) != header[1]) {
+			std::cout << "[Warning - PlayerJournal::replay] " << name << " is damaged after byte " << (offset - sizeof(header)) << ", ignoring the rest." << std::endl;
+			return;
+		}
+
+		PropStream body;
+		body.init(contents.data() + offset, header[0]);
+		offset += header[0];
+		function(body);
+	}
+}
+
+bool PlayerJournal::replayFiles(const std::vector<std::string>& files)
+{
+	std::vector<JournalSegment> segments(files.size());
+	for (size_t i = 0; i < files.size(); ++i) {
+		segments[i].name = files[i];
+		if (!readFile(files[i], segments[i].contents)) {
+			std::cout << "> ERROR: Unable to read " << files[i] << std::endl;
+			return false;
+		}
+	}
+
+	Database* db = Database::getInstance();
+	return replay(segments, [db](PlayerSaveSnapshot& snapshot) {
+		bool written = false;
+		for (uint32_t tries = 0; tries < 3 && !written; ++tries) {
+			written = IOLoginData::savePlayerSnapshot(*db, snapshot);
+		}
+		return written;
+	});
+}
+
+bool PlayerJournal::replay(const std::vector<JournalSegment>& segments, const std::function<bool(PlayerSaveSnapshot&)>& save)
+{
+	// pass one, the newest database save of every player
+	std::map<uint32_t, uint64_t> savedSequences;
+	for (const JournalSegment& segment : segments) {
+		forEachRecord(segment.name, segment.contents, [&savedSequences](PropStream& body) {
+			uint8_t type;
+			uint32_t guid;
+			uint64_t savedSequence;
+			if (!body.read<uint8_t>(type) || type != JOURNAL_RECORD_SAVED || !body.read<uint32_t>(guid) || !body.read<uint64_t>(savedSequence)) {
+				return;
+			}
+
+			uint64_t& sequence = savedSequences[guid];
+			sequence = std::max(sequence, savedSequence);
+		});
+	}
+
+	// pass two, merge what came after it
+	struct PendingPlayer {
+		PlayerSaveSnapshot snapshot;
+		std::map<uint32_t, std::pair<bool, int32_t>> storage;
+		std::map<uint32_t, std::vector<PlayerItemRow>> depots;
+	};
+
+	std::map<uint32_t, PendingPlayer> pending;
+	uint64_t damaged = 0;
+	for (const JournalSegment& segment : segments) {
+		forEachRecord(segment.name, segment.contents, [&](PropStream& body) {
+			uint8_t type;
+			uint64_t recordSequence;
+			uint32_t guid;
+			if (!body.read<uint8_t>(type) || type != JOURNAL_RECORD_PLAYER || !body.read<uint64_t>(recordSequence) || !body.read<uint32_t>(guid)) {
+				return;
+			}
+
+			auto savedIt = savedSequences.find(guid);
+			if (savedIt != savedSequences.end() && recordSequence < savedIt->second) {
+				return;
+			}
+
+			PendingPlayer& player = pending[guid];
+			PlayerSaveSnapshot& snapshot = player.snapshot;
+			snapshot.guid = guid;
+
+			std::string stats;
+			if (!body.readString(stats)) {
+				++damaged;
+				return;
+			}
+
+			PropStream statsStream;
+			statsStream.init(stats.data(), stats.size());
+			if (!readStats(statsStream, snapshot)) {
+				++damaged;
+				return;
+			}
+
+			uint8_t section;
+			while (body.read<uint8_t>(section) && section != JOURNAL_SECTION_END) {
+				bool valid = true;
+				switch (section) {
+					case JOURNAL_SECTION_STORAGE: {
+						uint32_t count;
+						valid = body.read<uint32_t>(count);
+						while (valid && count--) {
+							uint32_t key;
+							uint8_t present;
+							int32_t value = 0;
+							valid = body.read<uint32_t>(key) && body.read<uint8_t>(present) && (present == 0 || body.read<int32_t>(value));
+							if (valid) {
+								player.storage[key] = std::make_pair(present != 0, value);
+							}
+						}
+						break;
+					}
+
+					case JOURNAL_SECTION_INVENTORY:
+						valid = readItemRows(body, snapshot.items);
+						snapshot.saveItems = valid;
+						break;
+
+					case JOURNAL_SECTION_DEPOT: {
+						uint32_t depotId;
+						valid = body.read<uint32_t>(depotId) && readItemRows(body, player.depots[depotId]);
+						break;
+					}
+
+					case JOURNAL_SECTION_SPELLS: {
+						uint32_t count;
+						valid = body.read<uint32_t>(count);
+						snapshot.learnedSpells.clear();
+						while (valid && count--) {
+							std::string spellName;
+							valid = body.readString(spellName);
+							snapshot.learnedSpells.push_back(std::move(spellName));
+						}
+						snapshot.saveSpells = valid;
+						break;
+					}
+
+					case JOURNAL_SECTION_MURDERS: {
+						uint32_t count;
+						valid = body.read<uint32_t>(count);
+						snapshot.murders.clear();
+						while (valid && count--) {
+							int64_t timestamp;
+							valid = body.read<int64_t>(timestamp);
+							snapshot.murders.push_back(timestamp);
+						}
+						snapshot.saveMurders = valid;
+						break;
+					}
+
+					default:
+						valid = false;
+						break;
+				}
+
+				if (!valid) {
+					++damaged;
+					return;
+				}
+			}
+		});
+	}
+
+	if (damaged != 0) {
+		std::cout << "[Warning - PlayerJournal::replay] " << damaged << " journal record(s) could not be read." << std::endl;
+	}
+
+	size_t saved = 0;
+	for (auto& it : pending) {
+		PendingPlayer& player = it.second;
+		PlayerSaveSnapshot& snapshot = player.snapshot;
+		for (const auto& storageIt : player.storage) {
+			if (storageIt.second.first) {
+				snapshot.storage.emplace_back(storageIt.first, storageIt.second.second);
+			} else {
+				snapshot.removedStorageKeys.push_back(storageIt.first);
+			}
+		}
+
+		for (auto& depotIt : player.depots) {
+			snapshot.savedDepots.push_back(depotIt.first);
+			snapshot.depotItems.insert(snapshot.depotItems.end(), std::make_move_iterator(depotIt.second.begin()), std::make_move_iterator(depotIt.second.end()));
+		}
+
+		if (!save(snapshot)) {
+			std::cout << "> ERROR: Unable to replay the journal of player " << snapshot.name << " (" << it.first << ")." << std::endl;
+			return false;
+		}
+		++saved;
+	}
+
+	std::cout << ">> Restored " << saved << " player(s) from the journal" << std::endl;
+	return true;
+}
@@ -0,0 +1,142 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#ifndef FS_JOURNAL_H_4F0C2B7E91D84A6C8E53B1A7D29F6E10
+#define FS_JOURNAL_H_4F0C2B7E91D84A6C8E53B1A7D29F6E10
+
+#include <condition_variable>
+#include "thread_holder_base.h"
+#include "database.h"
+#include "fileloader.h"
+
+class Player;
+struct PlayerSaveSnapshot;
+
+struct PlayerJournalStats {
+	uint64_t segment;
+	uint64_t records;
+	uint64_t bytes;
+	uint64_t syncs;
+	uint64_t syncTime; // microseconds spent writing and syncing
+};
+
+// a journal segment file, by name and contents
+struct JournalSegment {
+	std::string name;
+	std::string contents;
+};
+
+/**
+ * Append-only local log of player progress between database saves.
+ *
+ * Every journal interval the dispatcher appends a record for each online
+ * player whose state changed since its last record, and hands the buffer to
+ * the journal thread, which writes and syncs it with one fsync. A database
+ * save of a player appends a marker so replay skips what the database
+ * already holds. On startup whatever a crashed run left behind is replayed
+ * into the database through IOLoginData::savePlayerSnapshot.
+ *
+ * The journal is split in numbered segments, a server save starts a new one
+ * and drops the older ones once every save of it has been written.
+ */
+class PlayerJournal : public ThreadHolder<PlayerJournal>
+{
+	public:
+		PlayerJournal() = default;
+
+		// replays the segments left by the previous run and opens a new one
+		bool open();
+		void shutdown();
+		void threadMain();
+
+		bool isEnabled() const {
+			return enabled;
+		}
+
+		// dispatcher side
+		void recordPlayer(Player* player);
+		void recordPlayers();
+		void flush();
+		void forgetPlayer(uint32_t guid);
+		uint64_t getSequence() const {
+			return sequence;
+		}
+		uint64_t rotate();
+		void release(uint64_t segment);
+
+		// any thread, once a database save up to sequence has committed
+		void markSaved(uint32_t guid, uint64_t savedSequence);
+		void markFailed();
+
+		PlayerJournalStats getStats();
+
+		// merges the records of segments, oldest first, that came after the
+		// last database save of each player into one snapshot per player and
+		// hands them to save, stops at the first one it could not write
+		static bool replay(const std::vector<JournalSegment>& segments, const std::function<bool(PlayerSaveSnapshot&)>& save);
+
+	private:
+		struct PlayerState {
+			std::string stats;
+			uint32_t inventoryGeneration = 0;
+			std::map<uint32_t, uint32_t> depotGenerations;
+			size_t spells = 0;
+			size_t murders = 0;
+		};
+
+		struct Block {
+			Block(uint64_t segment, std::string data) : segment(segment), data(std::move(data)) {}
+
+			uint64_t segment;
+			std::string data;
+		};
+
+		void appendRecord(const PropWriteStream& body);
+		bool writeBlock(const Block& block);
+		bool openSegment(uint64_t segment);
+		void removeSegments(uint64_t before);
+		bool replayFiles(const std::vector<std::string>& files);
+
+		static void writeStats(PropWriteStream& stream, const Player* player);
+		static bool readStats(PropStream& stream, PlayerSaveSnapshot& snapshot);
+
+		// dispatcher owned
+		std::map<uint32_t, PlayerState> players;
+		std::string buffer;
+		uint64_t sequence = 1;
+		uint64_t segment = 1;
+		bool enabled = false;
+
+		// handed to the journal thread
+		std::list<Block> blocks;
+		std::string markers;
+		uint64_t releaseBefore = 0;
+		std::mutex blockLock;
+		std::condition_variable blockSignal;
+		std::atomic<bool> failedSaves{false};
+
+		// journal thread owned
+		std::FILE* file = nullptr;
+		uint64_t openedSegment = 0;
+
+		std::atomic<uint64_t> records{0};
+		std::atomic<uint64_t> bytes{0};
+		std::atomic<uint64_t> syncs{0};
+		std::atomic<uint64_t> syncTime{0};
+};
+
+extern PlayerJournal g_journal;
+
+#endif
@@ -0,0 +1,1017 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+#include "otpch.h"
+
+#include "botclient.h"
+#include "botitems.h"
+#include "rsa.h"
+
+// same as map.h, which the bot does not link against
+static constexpr int32_t MAP_MAX_LAYERS = 16;
+
+static Position stepPosition(Direction direction, Position pos)
+{
+	switch (direction) {
+		case DIRECTION_NORTH: pos.y--; break;
+		case DIRECTION_SOUTH: pos.y++; break;
+		case DIRECTION_WEST: pos.x--; break;
+		case DIRECTION_EAST: pos.x++; break;
+		case DIRECTION_SOUTHWEST: pos.x--; pos.y++; break;
+		case DIRECTION_NORTHWEST: pos.x--; pos.y--; break;
+		case DIRECTION_NORTHEAST: pos.x++; pos.y--; break;
+		case DIRECTION_SOUTHEAST: pos.x++; pos.y++; break;
+		default: break;
+	}
+	return pos;
+}
+
+BotClient::BotClient(boost::asio::io_service& io_service, const BotOptions& options, const BotItems& items,
+                     const RSA& rsa, BotAccount account, uint32_t seed) :
+	io_service(io_service), socket(io_service), actionTimer(io_service),
+	options(options), items(items), rsa(rsa), account(std::move(account)), generator(seed) {}
+
+void BotClient::start()
+{
+	connectTime = clock::now();
+	if (options.skipLoginServer) {
+		state = STATE_GAME;
+		connect(options.gameEndpoint);
+	} else {
+		state = STATE_LOGINSERVER;
+		connect(options.loginEndpoint);
+	}
+}
+
+void BotClient::stop()
+{
+	if (state == STATE_CLOSED) {
+		return;
+	}
+
+	if (stats.loggedIn) {
+		// logout request, the server removes the player on its own once the
+		// socket is gone but this keeps the shutdown path realistic
+		BotOutputMessage msg;
+		msg.addByte(0x14);
+		send(msg, true);
+	}
+
+	state = STATE_CLOSED;
+	actionTimer.cancel();
+
+	boost::system::error_code error;
+	socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+	socket.close(error);
+}
+
+void BotClient::fail(const std::string& reason)
+{
+	if (state == STATE_CLOSED) {
+		return;
+	}
+
+	if (stats.error.empty()) {
+		stats.error = reason;
+	}
+
+	stats.disconnected = stats.loggedIn;
+	state = STATE_CLOSED;
+	actionTimer.cancel();
+
+	boost::system::error_code error;
+	socket.close(error);
+}
+
+void BotClient::connect(const boost::asio::ip::tcp::endpoint& endpoint)
+{
+	socket.async_connect(endpoint, std::bind(&BotClient::onConnect, shared_from_this(), std::placeholders::_1));
+}
+
+void BotClient::onConnect(const boost::system::error_code& error)
+{
+	if (state == STATE_CLOSED) {
+		return;
+	}
+
+	if (error) {
+		fail("connect: " + error.message());
+		return;
+	}
+
+	boost::system::error_code ignored;
+	socket.set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+
+	sendFirstMessage();
+	readHeader();
+}
+
+void BotClient::readHeader()
+{
+	boost::asio::async_read(socket, boost::asio::buffer(readBuffer, 2),
+	                        std::bind(&BotClient::onReadHeader, shared_from_this(), std::placeholders::_1));
+}
+
+void BotClient::onReadHeader(const boost::system::error_code& error)
+{
+	if (state == STATE_CLOSED) {
+		return;
+	}
+
+	if (error) {
+		fail("read: " + error.message());
+		return;
+	}
+
+	readLength = static_cast<uint16_t>(readBuffer[0] | readBuffer[1] << 8);
+	if (readLength == 0 || readLength % 8 != 0 || readLength > NETWORKMESSAGE_MAXSIZE - 2) {
+		fail("invalid frame length");
+		return;
+	}
+
+	boost::asio::async_read(socket, boost::asio::buffer(readBuffer, readLength),
+	                        std::bind(&BotClient::onReadBody, shared_from_this(), std::placeholders::_1));
+}
+
+void BotClient::onReadBody(const boost::system::error_code& error)
+{
+	if (state == STATE_CLOSED) {
+		return;
+	}
+
+	if (error) {
+		fail("read: " + error.message());
+		return;
+	}
+
+	stats.bytesReceived += readLength + 2;
+	++stats.framesReceived;
+
+	xtea::decrypt(readBuffer, readLength, key);
+
+	uint16_t innerLength = static_cast<uint16_t>(readBuffer[0] | readBuffer[1] << 8);
+	if (innerLength > readLength - 2) {
+		++stats.malformedFrames;
+		fail("invalid inner frame length");
+		return;
+	}
+
+	BotInputMessage msg(readBuffer + 2, innerLength);
+	if (state == STATE_LOGINSERVER) {
+		// the next read is started by onConnect of the game connection
+		parseLoginServerMessage(msg);
+		return;
+	}
+
+	parseGameMessage(msg);
+	if (state != STATE_CLOSED) {
+		readHeader();
+	}
+}
+
+void BotClient::send(BotOutputMessage& msg, bool encrypt)
+{
+	std::vector<uint8_t>& buffer = msg.getBuffer();
+
+	size_t start;
+	if (encrypt) {
+		uint16_t innerLength = msg.getLength();
+		memcpy(buffer.data() + 2, &innerLength, sizeof(innerLength));
+
+		size_t bodyLength = buffer.size() - 2;
+		if (bodyLength % 8 != 0) {
+			buffer.resize(buffer.size() + 8 - (bodyLength % 8), 0x33);
+			bodyLength = buffer.size() - 2;
+		}
+
+		xtea::encrypt(buffer.data() + 2, bodyLength, key);
+
+		uint16_t outerLength = bodyLength;
+		memcpy(buffer.data(), &outerLength, sizeof(outerLength));
+		start = 0;
+	} else {
+		uint16_t length = msg.getLength();
+		memcpy(buffer.data() + 2, &length, sizeof(length));
+		start = 2;
+	}
+
+	stats.bytesSent += buffer.size() - start;
+	writeQueue.emplace_back(buffer.begin() + start, buffer.end());
+	if (writeQueue.size() == 1) {
+		writeNext();
+	}
+}
+
+void BotClient::writeNext()
+{
+	boost::asio::async_write(socket, boost::asio::buffer(writeQueue.front()),
+	                         std::bind(&BotClient::onWrite, shared_from_this(), std::placeholders::_1));
+}
+
+void BotClient::onWrite(const boost::system::error_code& error)
+{
+	if (error) {
+		writeQueue.clear();
+		if (error != boost::asio::error::operation_aborted) {
+			fail("write: " + error.message());
+		}
+		return;
+	}
+
+	if (!writeQueue.empty()) {
+		writeQueue.pop_front();
+	}
+
+	if (!writeQueue.empty()) {
+		writeNext();
+	}
+}
+
+void BotClient::sendFirstMessage()
+{
+	// every connection negotiates a new XTEA key inside the RSA block
+	xtea::key xteaKey;
+	for (uint32_t& k : xteaKey) {
+		k = generator();
+	}
+
+	BotOutputMessage block;
+	block.addByte(0x00);
+	for (uint32_t k : xteaKey) {
+		block.add<uint32_t>(k);
+	}
+
+	if (state == STATE_GAME) {
+		block.addByte(0x00); // gamemaster flag
+		block.add<uint32_t>(account.number);
+		block.addString(account.character);
+		block.addString(account.password);
+	} else {
+		block.add<uint32_t>(account.number);
+		block.addString(account.password);
+	}
+
+	if (block.getLength() > 128) {
+		fail("account data does not fit the RSA block");
+		return;
+	}
+
+	std::vector<uint8_t>& rsaBuffer = block.getBuffer();
+	while (block.getLength() < 128) {
+		rsaBuffer.push_back(generator());
+	}
+	rsa.encrypt(reinterpret_cast<char*>(rsaBuffer.data() + BotOutputMessage::HEADER_LENGTH));
+
+	BotOutputMessage msg;
+	msg.addByte(state == STATE_GAME ? 0x0A : 0x01);
+	msg.add<uint16_t>(CLIENTOS_LINUX);
+	msg.add<uint16_t>(CLIENT_VERSION_MAX);
+	if (state == STATE_LOGINSERVER) {
+		// dat, spr and pic signatures
+		for (int i = 0; i < 12; ++i) {
+			msg.addByte(0x00);
+		}
+	}
+	msg.addBytes(rsaBuffer.data() + BotOutputMessage::HEADER_LENGTH, 128);
+	send(msg, false);
+
+	key = xtea::expand_key(xteaKey);
+}
+
+void BotClient::parseLoginServerMessage(BotInputMessage& msg)
+{
+	while (!msg.eof() && !msg.isOverrun()) {
+		uint8_t opcode = msg.getByte();
+		switch (opcode) {
+			case 0x0A:
+				fail("login server: " + msg.getString());
+				return;
+
+			case 0x14:
+				msg.skipString(); // motd
+				break;
+
+			case 0x1E:
+				fail("login server requested a client update");
+				return;
+
+			case 0x64: {
+				bool found = false;
+				uint8_t count = msg.getByte();
+				for (uint8_t i = 0; i < count; ++i) {
+					std::string name = msg.getString();
+					msg.skipString(); // world name
+					msg.skipBytes(6); // world ip and port
+					found = found || name == account.character;
+				}
+				msg.skipBytes(2); // premium days
+
+				if (!found) {
+					fail("character " + account.character + " is not on the account");
+					return;
+				}
+
+				// the login server closes the connection after the list, the
+				// configured game endpoint is used instead of the advertised
+				// one so the bots stay on loopback
+				boost::system::error_code error;
+				socket.close(error);
+				writeQueue.clear();
+
+				state = STATE_GAME;
+				connect(options.gameEndpoint);
+				return;
+			}
+
+			default:
+				++stats.unknownOpcodes;
+				fail("unknown login server opcode");
+				return;
+		}
+	}
+
+	fail("login server sent no character list");
+}
+
+void BotClient::parseGameMessage(BotInputMessage& msg)
+{
+	while (!msg.eof()) {
+		uint8_t opcode = msg.getByte();
+		if (!parseOpcode(opcode, msg)) {
+			// without the length of the unknown message the rest of the
+			// frame cannot be parsed either
+			++stats.unknownOpcodes;
+			return;
+		}
+
+		if (state == STATE_CLOSED) {
+			return;
+		}
+
+		if (msg.isOverrun()) {
+			++stats.malformedFrames;
+			return;
+		}
+	}
+}
+
+bool BotClient::parseOpcode(uint8_t opcode, BotInputMessage& msg)
+{
+	switch (opcode) {
+		case 0x0A: // login
+			playerId = msg.get<uint32_t>();
+			msg.skipBytes(3); // beat duration, can report bugs
+			if (!stats.loggedIn) {
+				stats.loggedIn = true;
+				stats.loginTime = elapsedMicroseconds(connectTime) / 1000;
+				scheduleAction();
+			}
+			break;
+
+		case 0x0B: // gamemaster flags
+			msg.skipBytes(32);
+			break;
+
+		case 0x14: // disconnect
+			fail("disconnected: " + msg.getString());
+			break;
+
+		case 0x16: // waiting list
+			fail("waiting list: " + msg.getString());
+			break;
+
+		case 0x1E:
+			onPing();
+			break;
+
+		case 0x64: {
+			Position pos = msg.getPosition();
+			centralPos = pos;
+			parseMapDescription(msg, pos.x - 8, pos.y - 6, pos.z, 18, 14);
+			setPlayerPosition(pos);
+			break;
+		}
+
+		case 0x65:
+			--centralPos.y;
+			parseMapDescription(msg, centralPos.x - 8, centralPos.y - 6, centralPos.z, 18, 1);
+			break;
+
+		case 0x66:
+			++centralPos.x;
+			parseMapDescription(msg, centralPos.x + 9, centralPos.y - 6, centralPos.z, 1, 14);
+			break;
+
+		case 0x67:
+			++centralPos.y;
+			parseMapDescription(msg, centralPos.x - 8, centralPos.y + 7, centralPos.z, 18, 1);
+			break;
+
+		case 0x68:
+			--centralPos.x;
+			parseMapDescription(msg, centralPos.x - 8, centralPos.y - 6, centralPos.z, 1, 14);
+			break;
+
+		case 0x69: {
+			Position pos = msg.getPosition();
+			parseTileDescription(msg, pos);
+			break;
+		}
+
+		case 0x6A: { // add thing
+			Position pos = msg.getPosition();
+			uint16_t value = msg.peek<uint16_t>();
+			if (value == 0x61 || value == 0x62 || value == 0x63) {
+				if (parseCreature(msg) == playerId) {
+					setPlayerPosition(pos);
+				}
+			} else {
+				parseItem(msg);
+			}
+			break;
+		}
+
+		case 0x6B: { // update thing
+			msg.getPosition();
+			msg.getByte();
+			uint16_t value = msg.peek<uint16_t>();
+			if (value == 0x61 || value == 0x62 || value == 0x63) {
+				parseCreature(msg);
+			} else {
+				parseItem(msg);
+			}
+			break;
+		}
+
+		case 0x6C: // remove thing
+			msg.getPosition();
+			msg.getByte();
+			break;
+
+		case 0x6D: { // move creature
+			Position oldPos = msg.getPosition();
+			msg.getByte();
+			Position newPos = msg.getPosition();
+			if (oldPos == playerPos) {
+				setPlayerPosition(newPos);
+			}
+			break;
+		}
+
+		case 0x6E: { // open container
+			msg.getByte();
+			parseItem(msg);
+			msg.skipString();
+			msg.skipBytes(2); // capacity, has parent
+			uint8_t count = msg.getByte();
+			for (uint8_t i = 0; i < count && !msg.isOverrun(); ++i) {
+				parseItem(msg);
+			}
+			break;
+		}
+
+		case 0x6F:
+			msg.getByte();
+			break;
+
+		case 0x70:
+			msg.getByte();
+			parseItem(msg);
+			break;
+
+		case 0x71:
+			msg.skipBytes(2);
+			parseItem(msg);
+			break;
+
+		case 0x72:
+			msg.skipBytes(2);
+			break;
+
+		case 0x78: // inventory item
+			msg.getByte();
+			parseItem(msg);
+			break;
+
+		case 0x79:
+			msg.getByte();
+			break;
+
+		case 0x7D:
+		case 0x7E: { // trade
+			msg.skipString();
+			uint8_t count = msg.getByte();
+			for (uint8_t i = 0; i < count && !msg.isOverrun(); ++i) {
+				parseItem(msg);
+			}
+			break;
+		}
+
+		case 0x7F:
+			break;
+
+		case 0x82: // world light
+			msg.skipBytes(2);
+			break;
+
+		case 0x83: // magic effect
+			msg.getPosition();
+			msg.getByte();
+			break;
+
+		case 0x84: // animated text
+			msg.getPosition();
+			msg.getByte();
+			msg.skipString();
+			break;
+
+		case 0x85: // distance effect
+			msg.getPosition();
+			msg.getPosition();
+			msg.getByte();
+			break;
+
+		case 0x86: // square
+		case 0x8C: // health
+		case 0x90: // skull
+		case 0x91: // shield
+			msg.skipBytes(5);
+			break;
+
+		case 0x8D: // creature light
+			msg.skipBytes(6);
+			break;
+
+		case 0x8E: // outfit
+			msg.get<uint32_t>();
+			parseOutfit(msg);
+			break;
+
+		case 0x8F: // speed
+			msg.skipBytes(6);
+			break;
+
+		case 0x96: // text window
+			msg.get<uint32_t>();
+			parseItem(msg);
+			msg.get<uint16_t>();
+			msg.skipString();
+			msg.skipString();
+			break;
+
+		case 0x97: // house window
+			msg.skipBytes(5);
+			msg.skipString();
+			break;
+
+		case 0xA0: // stats
+			msg.skipBytes(20);
+			break;
+
+		case 0xA1: // skills
+			msg.skipBytes(2 * (SKILL_LAST + 1));
+			break;
+
+		case 0xA2: // icons
+			msg.getByte();
+			break;
+
+		case 0xA3: // cancel target
+			attackedCreatureId = 0;
+			break;
+
+		case 0xA7: // fight modes
+			msg.skipBytes(3);
+			break;
+
+		case 0xAA:
+			parseCreatureSpeak(msg);
+			break;
+
+		case 0xAB: { // channel list
+			uint8_t count = msg.getByte();
+			for (uint8_t i = 0; i < count && !msg.isOverrun(); ++i) {
+				msg.get<uint16_t>();
+				msg.skipString();
+			}
+			break;
+		}
+
+		case 0xAC: // open channel
+		case 0xB2: // private channel
+			msg.get<uint16_t>();
+			msg.skipString();
+			break;
+
+		case 0xAD: // open private
+		case 0xAF: // remove report
+		case 0xB0: // cancel report
+			msg.skipString();
+			break;
+
+		case 0xAE: // rule violations channel
+		case 0xB3: // close private
+			msg.get<uint16_t>();
+			break;
+
+		case 0xB1: // lock report
+			break;
+
+		case 0xB4: // text message
+			msg.getByte();
+			msg.skipString();
+			break;
+
+		case 0xB5: // cancel walk
+			msg.getByte();
+			finishMove(true);
+			break;
+
+		case 0xBE:
+			parseFloorChangeUp(msg);
+			break;
+
+		case 0xBF:
+			parseFloorChangeDown(msg);
+			break;
+
+		case 0xC8: // outfit window
+			parseOutfit(msg);
+			msg.skipBytes(4);
+			break;
+
+		case 0xD2: // vip
+			msg.get<uint32_t>();
+			msg.skipString();
+			msg.getByte();
+			break;
+
+		case 0xD3:
+		case 0xD4: // vip login/logout
+			msg.get<uint32_t>();
+			break;
+
+		default:
+			return false;
+	}
+	return true;
+}
+
+void BotClient::parseMapDescription(BotInputMessage& msg, int32_t x, int32_t y, int32_t z, int32_t width, int32_t height)
+{
+	// same floor range as ProtocolGame::GetMapDescription
+	int32_t startz, endz, zstep;
+	if (z > 7) {
+		startz = z - 2;
+		endz = std::min<int32_t>(MAP_MAX_LAYERS - 1, z + 2);
+		zstep = 1;
+	} else {
+		startz = 7;
+		endz = 0;
+		zstep = -1;
+	}
+
+	int32_t skip = 0;
+	for (int32_t nz = startz; nz != endz + zstep; nz += zstep) {
+		parseFloorDescription(msg, x, y, nz, width, height, z - nz, skip);
+	}
+}
+
+void BotClient::parseFloorDescription(BotInputMessage& msg, int32_t x, int32_t y, int32_t z, int32_t width, int32_t height, int32_t offset, int32_t& skip)
+{
+	for (int32_t nx = 0; nx < width; nx++) {
+		for (int32_t ny = 0; ny < height; ny++) {
+			if (msg.isOverrun()) {
+				return;
+			}
+
+			if (skip == 0) {
+				skip = parseTileDescription(msg, Position(x + nx + offset, y + ny + offset, z));
+			} else {
+				--skip;
+			}
+		}
+	}
+}
+
+int32_t BotClient::parseTileDescription(BotInputMessage& msg, const Position& pos)
+{
+	// a tile is a list of things terminated by a (skip, 0xFF) marker
+	uint16_t tileGroundId = 0;
+	for (int32_t stackpos = 0; !msg.isOverrun(); ++stackpos) {
+		uint16_t value = msg.peek<uint16_t>();
+		if (value >= 0xFF00) {
+			msg.get<uint16_t>();
+			return value & 0xFF;
+		}
+
+		if (value == 0x61 || value == 0x62 || value == 0x63) {
+			if (parseCreature(msg) == playerId) {
+				setPlayerPosition(pos);
+				groundId = tileGroundId;
+			}
+		} else {
+			uint16_t itemId = parseItem(msg);
+			if (stackpos == 0) {
+				tileGroundId = itemId;
+			}
+		}
+	}
+	return 0;
+}
+
+uint32_t BotClient::parseCreature(BotInputMessage& msg)
+{
+	uint16_t type = msg.get<uint16_t>();
+	if (type == 0x63) { // turn
+		uint32_t id = msg.get<uint32_t>();
+		msg.getByte();
+		return id;
+	}
+
+	uint32_t id;
+	if (type == 0x61) {
+		knownCreatures.erase(msg.get<uint32_t>());
+		id = msg.get<uint32_t>();
+		msg.skipString();
+	} else {
+		id = msg.get<uint32_t>();
+	}
+
+	if (id != playerId && knownCreatures.size() < 150) {
+		knownCreatures.insert(id);
+	}
+
+	msg.skipBytes(2); // health, direction
+	parseOutfit(msg);
+	msg.skipBytes(6); // light, speed, skull, shield
+	return id;
+}
+
+uint16_t BotClient::parseItem(BotInputMessage& msg)
+{
+	uint16_t id = msg.get<uint16_t>();
+	if (items.hasCountByte(id)) {
+		msg.getByte();
+	}
+	return id;
+}
+
+void BotClient::parseOutfit(BotInputMessage& msg)
+{
+	if (msg.get<uint16_t>() != 0) {
+		msg.skipBytes(4);
+	} else {
+		msg.get<uint16_t>();
+	}
+}
+
+void BotClient::parseCreatureSpeak(BotInputMessage& msg)
+{
+	msg.get<uint32_t>(); // statement id
+	msg.skipString();
+	switch (msg.getByte()) {
+		case TALKTYPE_SAY:
+		case TALKTYPE_WHISPER:
+		case TALKTYPE_YELL:
+		case TALKTYPE_MONSTER_SAY:
+		case TALKTYPE_MONSTER_YELL:
+			msg.getPosition();
+			break;
+
+		case TALKTYPE_CHANNEL_Y:
+		case TALKTYPE_CHANNEL_R1:
+		case TALKTYPE_CHANNEL_R2:
+		case TALKTYPE_CHANNEL_O:
+			msg.get<uint16_t>();
+			break;
+
+		case TALKTYPE_RVR_CHANNEL:
+			msg.get<uint32_t>();
+			break;
+
+		default:
+			break;
+	}
+	msg.skipString();
+}
+
+void BotClient::parseFloorChangeUp(BotInputMessage& msg)
+{
+	// mirrors ProtocolGame::MoveUpCreature, centralPos still is the old position
+	int32_t z = centralPos.z - 1;
+	int32_t skip = 0;
+	if (z == 7) {
+		for (int32_t nz = 5, offset = 3; nz >= 0; --nz, ++offset) {
+			parseFloorDescription(msg, centralPos.x - 8, centralPos.y - 6, nz, 18, 14, offset, skip);
+		}
+	} else if (z > 7) {
+		parseFloorDescription(msg, centralPos.x - 8, centralPos.y - 6, centralPos.z - 3, 18, 14, 3, skip);
+	}
+
+	centralPos = Position(centralPos.x + 1, centralPos.y + 1, z);
+}
+
+void BotClient::parseFloorChangeDown(BotInputMessage& msg)
+{
+	// mirrors ProtocolGame::MoveDownCreature
+	int32_t z = centralPos.z + 1;
+	int32_t skip = 0;
+	if (z == 8) {
+		for (int32_t nz = z, offset = -1; nz <= z + 2; ++nz, --offset) {
+			parseFloorDescription(msg, centralPos.x - 8, centralPos.y - 6, nz, 18, 14, offset, skip);
+		}
+	} else if (z > 8 && z < 14) {
+		parseFloorDescription(msg, centralPos.x - 8, centralPos.y - 6, z + 2, 18, 14, -3, skip);
+	}
+
+	centralPos = Position(centralPos.x - 1, centralPos.y - 1, z);
+}
+
+void BotClient::setPlayerPosition(const Position& pos)
+{
+	if (pos == playerPos) {
+		return;
+	}
+
+	playerPos = pos;
+	finishMove(false);
+}
+
+void BotClient::finishMove(bool rejected)
+{
+	if (!movePending) {
+		return;
+	}
+
+	movePending = false;
+	stats.moveLatency.push_back(elapsedMicroseconds(moveTime));
+	if (rejected) {
+		++stats.movesRejected;
+	}
+}
+
+void BotClient::onPing()
+{
+	// classic clients share 0x1E for the server ping and for the answer to
+	// our own 0x1D, the first 0x1E after a 0x1D is taken as its answer
+	if (pingPending) {
+		pingPending = false;
+		stats.pingLatency.push_back(elapsedMicroseconds(pingTime));
+		return;
+	}
+
+	BotOutputMessage pong;
+	pong.addByte(0x1E);
+	send(pong, true);
+
+	// the server pings every 5 seconds, measuring right after one keeps
+	// the next server ping from being mistaken for our answer
+	BotOutputMessage ping;
+	ping.addByte(0x1D);
+	send(ping, true);
+
+	pingPending = true;
+	pingTime = clock::now();
+}
+
+void BotClient::scheduleAction()
+{
+	// jitter keeps thousands of bots from acting in lockstep
+	std::uniform_int_distribution<uint32_t> jitter(options.actionInterval / 2, options.actionInterval + options.actionInterval / 2);
+	actionTimer.expires_from_now(boost::posix_time::milliseconds(jitter(generator)));
+	actionTimer.async_wait(std::bind(&BotClient::onAction, shared_from_this(), std::placeholders::_1));
+}
+
+void BotClient::onAction(const boost::system::error_code& error)
+{
+	if (error || state != STATE_GAME) {
+		return;
+	}
+
+	if (movePending && elapsedMicroseconds(moveTime) / 1000 >= options.ackTimeout) {
+		movePending = false;
+		++stats.movesTimedOut;
+	}
+
+	if (pingPending && elapsedMicroseconds(pingTime) / 1000 >= options.ackTimeout) {
+		pingPending = false;
+		++stats.pingsTimedOut;
+	}
+
+	uint32_t totalWeight = options.walkWeight + options.sayWeight + options.attackWeight + options.useWeight;
+	if (totalWeight != 0) {
+		uint32_t roll = std::uniform_int_distribution<uint32_t>(0, totalWeight - 1)(generator);
+		if (roll < options.walkWeight) {
+			walk();
+		} else if ((roll -= options.walkWeight) < options.sayWeight) {
+			say();
+		} else if ((roll -= options.sayWeight) < options.attackWeight) {
+			attack();
+		} else {
+			useGround();
+		}
+	}
+
+	scheduleAction();
+}
+
+void BotClient::walk()
+{
+	if (movePending) {
+		return;
+	}
+
+	static const Direction directions[] = {
+		DIRECTION_NORTH, DIRECTION_EAST, DIRECTION_SOUTH, DIRECTION_WEST,
+		DIRECTION_NORTHEAST, DIRECTION_SOUTHEAST, DIRECTION_SOUTHWEST, DIRECTION_NORTHWEST
+	};
+
+	Direction direction = directions[std::uniform_int_distribution<size_t>(0, 7)(generator)];
+	Position target = stepPosition(direction, playerPos);
+	if (target.x < options.areaFrom.x || target.x > options.areaTo.x || target.y < options.areaFrom.y || target.y > options.areaTo.y) {
+		// head back towards the area instead of leaving it
+		if (playerPos.x < options.areaFrom.x) {
+			direction = DIRECTION_EAST;
+		} else if (playerPos.x > options.areaTo.x) {
+			direction = DIRECTION_WEST;
+		} else if (playerPos.y < options.areaFrom.y) {
+			direction = DIRECTION_SOUTH;
+		} else if (playerPos.y > options.areaTo.y) {
+			direction = DIRECTION_NORTH;
+		} else {
+			return;
+		}
+	}
+
+	// indexed by Direction, see ProtocolGame::parsePacket
+	static const uint8_t opcodes[] = {0x65, 0x66, 0x67, 0x68, 0x6C, 0x6B, 0x6D, 0x6A};
+
+	BotOutputMessage msg;
+	msg.addByte(opcodes[direction]);
+	send(msg, true);
+
+	++stats.movesSent;
+	movePending = true;
+	moveTime = clock::now();
+}
+
+void BotClient::say()
+{
+	BotOutputMessage msg;
+	msg.addByte(0x96);
+	msg.addByte(TALKTYPE_SAY);
+	msg.addString("load test " + std::to_string(++sayCounter));
+	send(msg, true);
+	++stats.says;
+}
+
+void BotClient::attack()
+{
+	BotOutputMessage msg;
+	if (attackedCreatureId != 0 || knownCreatures.empty()) {
+		msg.addByte(0xBE);
+		attackedCreatureId = 0;
+	} else {
+		auto it = knownCreatures.begin();
+		std::advance(it, std::uniform_int_distribution<size_t>(0, knownCreatures.size() - 1)(generator));
+		attackedCreatureId = *it;
+
+		msg.addByte(0xA1);
+		msg.add<uint32_t>(attackedCreatureId);
+	}
+	send(msg, true);
+	++stats.attacks;
+}
+
+void BotClient::useGround()
+{
+	if (groundId == 0) {
+		return;
+	}
+
+	BotOutputMessage msg;
+	msg.addByte(0x82);
+	msg.addPosition(playerPos);
+	msg.add<uint16_t>(groundId);
+	msg.addByte(0x00); // stackpos
+	msg.addByte(0x00); // container index
+	send(msg, true);
+	++stats.uses;
+}
+
+uint32_t BotClient::elapsedMicroseconds(clock::time_point since) const
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - since).count();
+}
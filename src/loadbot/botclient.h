@@ -0,0 +1,179 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+#ifndef FS_BOTCLIENT_H_0DE3EE2BB3E24FCC9E0DBF81897A4B4F
+#define FS_BOTCLIENT_H_0DE3EE2BB3E24FCC9E0DBF81897A4B4F
+
+#include "botmessage.h"
+#include "const.h"
+#include "enums.h"
+#include "xtea.h"
+
+#include <deque>
+#include <random>
+#include <unordered_set>
+
+class BotItems;
+class RSA;
+
+struct BotAccount
+{
+	uint32_t number = 0;
+	std::string password;
+	std::string character;
+};
+
+struct BotOptions
+{
+	boost::asio::ip::tcp::endpoint loginEndpoint;
+	boost::asio::ip::tcp::endpoint gameEndpoint;
+	bool skipLoginServer = false;
+
+	// bots walk inside [areaFrom, areaTo] on their current floor
+	Position areaFrom;
+	Position areaTo;
+
+	uint32_t actionInterval = 1000;
+	uint32_t walkWeight = 70;
+	uint32_t sayWeight = 10;
+	uint32_t attackWeight = 10;
+	uint32_t useWeight = 10;
+
+	uint32_t ackTimeout = 5000;
+};
+
+struct BotStats
+{
+	// microseconds from sending the request to the reply that answers it
+	std::vector<uint32_t> moveLatency;
+	std::vector<uint32_t> pingLatency;
+
+	uint64_t movesSent = 0;
+	uint64_t movesRejected = 0;
+	uint64_t movesTimedOut = 0;
+	uint64_t pingsTimedOut = 0;
+	uint64_t says = 0;
+	uint64_t attacks = 0;
+	uint64_t uses = 0;
+
+	uint64_t bytesSent = 0;
+	uint64_t bytesReceived = 0;
+	uint64_t framesReceived = 0;
+	uint64_t unknownOpcodes = 0;
+	uint64_t malformedFrames = 0;
+
+	uint32_t loginTime = 0;
+	bool loggedIn = false;
+	bool disconnected = false;
+	std::string error;
+};
+
+class BotClient : public std::enable_shared_from_this<BotClient>
+{
+	public:
+		BotClient(boost::asio::io_service& io_service, const BotOptions& options, const BotItems& items,
+		          const RSA& rsa, BotAccount account, uint32_t seed);
+
+		// non-copyable
+		BotClient(const BotClient&) = delete;
+		BotClient& operator=(const BotClient&) = delete;
+
+		void start();
+		void stop();
+
+		const BotStats& getStats() const {
+			return stats;
+		}
+
+	private:
+		typedef std::chrono::steady_clock clock;
+
+		enum State {
+			STATE_LOGINSERVER,
+			STATE_GAME,
+			STATE_CLOSED,
+		};
+
+		void connect(const boost::asio::ip::tcp::endpoint& endpoint);
+		void onConnect(const boost::system::error_code& error);
+		void readHeader();
+		void onReadHeader(const boost::system::error_code& error);
+		void onReadBody(const boost::system::error_code& error);
+		void send(BotOutputMessage& msg, bool encrypt);
+		void writeNext();
+		void onWrite(const boost::system::error_code& error);
+		void fail(const std::string& reason);
+
+		void sendFirstMessage();
+		void parseLoginServerMessage(BotInputMessage& msg);
+		void parseGameMessage(BotInputMessage& msg);
+		bool parseOpcode(uint8_t opcode, BotInputMessage& msg);
+
+		void parseMapDescription(BotInputMessage& msg, int32_t x, int32_t y, int32_t z, int32_t width, int32_t height);
+		void parseFloorDescription(BotInputMessage& msg, int32_t x, int32_t y, int32_t z, int32_t width, int32_t height, int32_t offset, int32_t& skip);
+		int32_t parseTileDescription(BotInputMessage& msg, const Position& pos);
+		uint32_t parseCreature(BotInputMessage& msg);
+		uint16_t parseItem(BotInputMessage& msg);
+		void parseOutfit(BotInputMessage& msg);
+		void parseCreatureSpeak(BotInputMessage& msg);
+		void parseFloorChangeUp(BotInputMessage& msg);
+		void parseFloorChangeDown(BotInputMessage& msg);
+
+		void setPlayerPosition(const Position& pos);
+		void finishMove(bool rejected);
+		void onPing();
+
+		void scheduleAction();
+		void onAction(const boost::system::error_code& error);
+		void walk();
+		void say();
+		void attack();
+		void useGround();
+
+		uint32_t elapsedMicroseconds(clock::time_point since) const;
+
+		boost::asio::io_service& io_service;
+		boost::asio::ip::tcp::socket socket;
+		boost::asio::deadline_timer actionTimer;
+
+		const BotOptions& options;
+		const BotItems& items;
+		const RSA& rsa;
+		BotAccount account;
+		std::mt19937 generator;
+
+		State state = STATE_LOGINSERVER;
+		xtea::round_keys key;
+		uint8_t readBuffer[NETWORKMESSAGE_MAXSIZE];
+		uint16_t readLength = 0;
+		std::deque<std::vector<uint8_t>> writeQueue;
+
+		uint32_t playerId = 0;
+		Position playerPos;
+		Position centralPos;
+		uint16_t groundId = 0;
+		std::unordered_set<uint32_t> knownCreatures;
+		uint32_t attackedCreatureId = 0;
+		uint32_t sayCounter = 0;
+
+		clock::time_point connectTime;
+		clock::time_point moveTime;
+		clock::time_point pingTime;
+		bool movePending = false;
+		bool pingPending = false;
+
+		BotStats stats;
+};
+
+#endif
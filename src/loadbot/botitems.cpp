@@ -0,0 +1,210 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+#include "otpch.h"
+
+#include "botitems.h"
+
+#include <cctype>
+#include <fstream>
+
+struct ItemToken
+{
+	enum Type {
+		END,
+		IDENTIFIER,
+		NUMBER,
+		STRING,
+		SPECIAL,
+	};
+
+	Type type = END;
+	std::string text;
+	int32_t number = 0;
+	char special = 0;
+};
+
+class ItemTokenizer
+{
+	public:
+		explicit ItemTokenizer(std::string data) : data(std::move(data)) {}
+
+		ItemToken next() {
+			skipBlanks();
+
+			ItemToken token;
+			if (pos >= data.size()) {
+				return token;
+			}
+
+			char c = data[pos];
+			if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+				token.type = ItemToken::IDENTIFIER;
+				while (pos < data.size() && (std::isalnum(static_cast<unsigned char>(data[pos])) || data[pos] == '_')) {
+					token.text.push_back(std::tolower(static_cast<unsigned char>(data[pos++])));
+				}
+			} else if (std::isdigit(static_cast<unsigned char>(c)) || (c == '-' && pos + 1 < data.size() && std::isdigit(static_cast<unsigned char>(data[pos + 1])))) {
+				token.type = ItemToken::NUMBER;
+				size_t end;
+				token.number = std::stoi(data.substr(pos, 12), &end);
+				pos += end;
+			} else if (c == '"') {
+				token.type = ItemToken::STRING;
+				++pos;
+				while (pos < data.size() && data[pos] != '"') {
+					if (data[pos] == '\\' && pos + 1 < data.size()) {
+						++pos;
+					}
+					token.text.push_back(data[pos++]);
+				}
+				++pos;
+			} else {
+				token.type = ItemToken::SPECIAL;
+				token.special = c;
+				++pos;
+			}
+			return token;
+		}
+
+	private:
+		void skipBlanks() {
+			while (pos < data.size()) {
+				if (data[pos] == '#') {
+					while (pos < data.size() && data[pos] != '\n') {
+						++pos;
+					}
+				} else if (std::isspace(static_cast<unsigned char>(data[pos]))) {
+					++pos;
+				} else {
+					break;
+				}
+			}
+		}
+
+		std::string data;
+		size_t pos = 0;
+};
+
+enum ItemGroup {
+	GROUP_OTHER,
+	GROUP_FLUID,
+	GROUP_SPLASH,
+};
+
+struct ItemEntry
+{
+	uint16_t id = 0;
+	uint16_t disguiseId = 0;
+	ItemGroup group = GROUP_OTHER;
+	bool stackable = false;
+	bool disguise = false;
+};
+
+static bool isSpecial(const ItemToken& token, char c)
+{
+	return token.type == ItemToken::SPECIAL && token.special == c;
+}
+
+static void applyFlag(ItemEntry& entry, const std::string& flag)
+{
+	// mirrors the group/stackable assignments of Items::loadItems, a later
+	// group flag overrides an earlier one there as well
+	if (flag == "cumulative") {
+		entry.stackable = true;
+	} else if (flag == "disguise") {
+		entry.disguise = true;
+	} else if (flag == "fluidcontainer") {
+		entry.group = GROUP_FLUID;
+	} else if (flag == "splash") {
+		entry.group = GROUP_SPLASH;
+	} else if (flag == "bank" || flag == "quiver" || flag == "multiweapon" || flag == "multishot" ||
+	           flag == "key" || flag == "magicfield" || flag == "weapon" || flag == "armor") {
+		entry.group = GROUP_OTHER;
+	}
+}
+
+bool BotItems::load(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "[Error - BotItems::load] Cannot open " << filename << std::endl;
+		return false;
+	}
+
+	std::ostringstream ss;
+	ss << file.rdbuf();
+	ItemTokenizer tokenizer(ss.str());
+
+	std::vector<ItemEntry> entries;
+	ItemEntry* current = nullptr;
+
+	ItemToken token = tokenizer.next();
+	while (token.type != ItemToken::END) {
+		if (token.type != ItemToken::IDENTIFIER) {
+			token = tokenizer.next();
+			continue;
+		}
+
+		std::string key = token.text;
+		if (!isSpecial(tokenizer.next(), '=')) {
+			std::cout << "[Error - BotItems::load] '=' expected after " << key << std::endl;
+			return false;
+		}
+
+		token = tokenizer.next();
+		if (key == "typeid") {
+			if (token.type != ItemToken::NUMBER || token.number < 0 || token.number > 0xFFFF) {
+				std::cout << "[Error - BotItems::load] Invalid TypeID" << std::endl;
+				return false;
+			}
+
+			entries.emplace_back();
+			current = &entries.back();
+			current->id = token.number;
+		} else if (isSpecial(token, '{')) {
+			// Flags = {A,B}, Attributes/MagicField = {Key=Value,...}
+			std::string lastIdentifier;
+			bool afterEquals = false;
+			for (token = tokenizer.next(); token.type != ItemToken::END && !isSpecial(token, '}'); token = tokenizer.next()) {
+				if (isSpecial(token, '=')) {
+					afterEquals = true;
+					continue;
+				}
+
+				if (afterEquals) {
+					if (current && key == "attributes" && lastIdentifier == "disguisetarget" && token.type == ItemToken::NUMBER) {
+						current->disguiseId = token.number;
+					}
+					afterEquals = false;
+				} else if (token.type == ItemToken::IDENTIFIER) {
+					lastIdentifier = token.text;
+					if (current && key == "flags") {
+						applyFlag(*current, token.text);
+					}
+				}
+			}
+		}
+
+		token = tokenizer.next();
+	}
+
+	for (const ItemEntry& entry : entries) {
+		if (!entry.stackable && entry.group != GROUP_FLUID && entry.group != GROUP_SPLASH) {
+			continue;
+		}
+
+		countByte[entry.disguise ? entry.disguiseId : entry.id] = true;
+	}
+	return true;
+}
@@ -0,0 +1,37 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+#ifndef FS_BOTITEMS_H_D50DB8C9985A4597979EBD6A5D4A0F22
+#define FS_BOTITEMS_H_D50DB8C9985A4597979EBD6A5D4A0F22
+
+#include <string>
+#include <vector>
+
+// The client decides whether an item is followed by a count/fluid byte
+// from its own object table; the bot reads the same decision out of
+// items.srv instead of shipping a copy of Tibia.dat.
+class BotItems
+{
+	public:
+		bool load(const std::string& filename);
+
+		bool hasCountByte(uint16_t clientId) const {
+			return countByte[clientId];
+		}
+
+	private:
+		std::vector<bool> countByte = std::vector<bool>(0x10000, false);
+};
+
+#endif
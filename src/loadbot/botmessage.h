@@ -0,0 +1,152 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+#ifndef FS_BOTMESSAGE_H_976308DB581E4A93920E5DDAAB2D8AA3
+#define FS_BOTMESSAGE_H_976308DB581E4A93920E5DDAAB2D8AA3
+
+#include "position.h"
+
+// Byte readers/writers for the bot side of the wire format. They do not
+// reuse NetworkMessage because that one drags in the item and creature
+// model of the server.
+class BotInputMessage
+{
+	public:
+		BotInputMessage(const uint8_t* buffer, size_t length) : buffer(buffer), length(length) {}
+
+		uint8_t getByte() {
+			return get<uint8_t>();
+		}
+
+		template<typename T>
+		T get() {
+			if (!canRead(sizeof(T))) {
+				return 0;
+			}
+
+			T v;
+			memcpy(&v, buffer + position, sizeof(T));
+			position += sizeof(T);
+			return v;
+		}
+
+		template<typename T>
+		T peek() {
+			if (!canRead(sizeof(T))) {
+				return 0;
+			}
+
+			T v;
+			memcpy(&v, buffer + position, sizeof(T));
+			return v;
+		}
+
+		std::string getString() {
+			uint16_t stringLen = get<uint16_t>();
+			if (!canRead(stringLen)) {
+				return std::string();
+			}
+
+			const char* v = reinterpret_cast<const char*>(buffer) + position;
+			position += stringLen;
+			return std::string(v, stringLen);
+		}
+
+		Position getPosition() {
+			Position pos;
+			pos.x = get<uint16_t>();
+			pos.y = get<uint16_t>();
+			pos.z = getByte();
+			return pos;
+		}
+
+		void skipBytes(size_t count) {
+			if (canRead(count)) {
+				position += count;
+			}
+		}
+
+		void skipString() {
+			skipBytes(get<uint16_t>());
+		}
+
+		bool eof() const {
+			return position >= length;
+		}
+
+		bool isOverrun() const {
+			return overrun;
+		}
+
+	private:
+		bool canRead(size_t size) {
+			if (overrun || position + size > length) {
+				overrun = true;
+				return false;
+			}
+			return true;
+		}
+
+		const uint8_t* buffer;
+		size_t length;
+		size_t position = 0;
+		bool overrun = false;
+};
+
+class BotOutputMessage
+{
+	public:
+		// room for the plain and the encrypted length headers
+		static constexpr size_t HEADER_LENGTH = 4;
+
+		BotOutputMessage() : buffer(HEADER_LENGTH) {}
+
+		void addByte(uint8_t value) {
+			buffer.push_back(value);
+		}
+
+		template<typename T>
+		void add(T value) {
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+			buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+		}
+
+		void addBytes(const uint8_t* bytes, size_t size) {
+			buffer.insert(buffer.end(), bytes, bytes + size);
+		}
+
+		void addString(const std::string& value) {
+			add<uint16_t>(value.size());
+			buffer.insert(buffer.end(), value.begin(), value.end());
+		}
+
+		void addPosition(const Position& pos) {
+			add<uint16_t>(pos.x);
+			add<uint16_t>(pos.y);
+			addByte(pos.z);
+		}
+
+		size_t getLength() const {
+			return buffer.size() - HEADER_LENGTH;
+		}
+
+		std::vector<uint8_t>& getBuffer() {
+			return buffer;
+		}
+
+	private:
+		std::vector<uint8_t> buffer;
+};
+
+#endif
@@ -0,0 +1,363 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+#include "otpch.h"
+
+#include "botclient.h"
+#include "botitems.h"
+#include "rsa.h"
+
+#include <fstream>
+
+static void printUsage(const char* program)
+{
+	std::cout << "Usage: " << program << " --accounts <file> [options]\n"
+	          << "\n"
+	          << "  --accounts <file>      one bot per line: <account> <password> <character name>\n"
+	          << "  --host <ip>            server address (default 127.0.0.1)\n"
+	          << "  --login-port <port>    login server port (default 7171)\n"
+	          << "  --game-port <port>     game server port (default 7172)\n"
+	          << "  --no-login-server      connect straight to the game server\n"
+	          << "  --bots <n>             number of bots (default: one per account)\n"
+	          << "  --threads <n>          network threads (default 1)\n"
+	          << "  --ramp <ms>            delay between two bot logins (default 20)\n"
+	          << "  --duration <s>         measured run time after the last login (default 60)\n"
+	          << "  --area <x1,y1,x2,y2>   bots walk inside this rectangle\n"
+	          << "  --interval <ms>        mean time between two bot actions (default 1000)\n"
+	          << "  --weights <w,s,a,u>    walk, say, attack and use weights (default 70,10,10,10)\n"
+	          << "  --key <file>           RSA key (default key.pem)\n"
+	          << "  --items <file>         item definitions (default data/items/items.srv)\n"
+	          << "  --csv                  print the summary as a CSV header and row\n";
+}
+
+static bool parseNumbers(const std::string& value, std::vector<uint32_t>& numbers, size_t count)
+{
+	numbers.clear();
+
+	std::istringstream ss(value);
+	std::string part;
+	while (std::getline(ss, part, ',')) {
+		try {
+			numbers.push_back(std::stoul(part));
+		} catch (const std::exception&) {
+			return false;
+		}
+	}
+	return numbers.size() == count;
+}
+
+static bool loadAccounts(const std::string& filename, std::vector<BotAccount>& accounts)
+{
+	std::ifstream file(filename);
+	if (!file.is_open()) {
+		std::cout << "> ERROR: Cannot open " << filename << std::endl;
+		return false;
+	}
+
+	for (std::string line; std::getline(file, line);) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		BotAccount account;
+		std::istringstream ss(line);
+		ss >> account.number >> account.password >> std::ws;
+		std::getline(ss, account.character);
+		while (!account.character.empty() && std::isspace(static_cast<unsigned char>(account.character.back()))) {
+			account.character.pop_back();
+		}
+
+		if (account.number == 0 || account.password.empty() || account.character.empty()) {
+			std::cout << "> ERROR: Invalid account line: " << line << std::endl;
+			return false;
+		}
+		accounts.push_back(std::move(account));
+	}
+	return true;
+}
+
+struct LatencySummary
+{
+	size_t count = 0;
+	double p50 = 0, p90 = 0, p99 = 0, p999 = 0, max = 0;
+};
+
+static LatencySummary summarize(std::vector<uint32_t>& samples)
+{
+	LatencySummary summary;
+	summary.count = samples.size();
+	if (samples.empty()) {
+		return summary;
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	auto percentile = [&samples](double p) {
+		size_t index = static_cast<size_t>(std::ceil(p * samples.size()));
+		return samples[std::max<size_t>(index, 1) - 1] / 1000.;
+	};
+
+	summary.p50 = percentile(0.50);
+	summary.p90 = percentile(0.90);
+	summary.p99 = percentile(0.99);
+	summary.p999 = percentile(0.999);
+	summary.max = samples.back() / 1000.;
+	return summary;
+}
+
+static void printLatency(const std::string& name, const LatencySummary& summary)
+{
+	std::cout << std::left << std::setw(12) << name << std::right
+	          << " samples " << std::setw(9) << summary.count
+	          << std::fixed << std::setprecision(2)
+	          << "  p50 " << std::setw(8) << summary.p50
+	          << "  p90 " << std::setw(8) << summary.p90
+	          << "  p99 " << std::setw(8) << summary.p99
+	          << "  p99.9 " << std::setw(8) << summary.p999
+	          << "  max " << std::setw(8) << summary.max << " ms" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	BotOptions options;
+	options.areaFrom = Position(0, 0, 0);
+	options.areaTo = Position(0xFFFF, 0xFFFF, 15);
+
+	std::string host = "127.0.0.1";
+	uint16_t loginPort = 7171;
+	uint16_t gamePort = 7172;
+	std::string accountsFile;
+	std::string keyFile = "key.pem";
+	std::string itemsFile = "data/items/items.srv";
+	size_t botCount = 0;
+	size_t threadCount = 1;
+	uint32_t ramp = 20;
+	uint32_t duration = 60;
+	bool csv = false;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--no-login-server") {
+			options.skipLoginServer = true;
+			continue;
+		} else if (arg == "--csv") {
+			csv = true;
+			continue;
+		} else if (arg == "--help" || i + 1 >= argc) {
+			printUsage(argv[0]);
+			return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+
+		std::string value = argv[++i];
+		std::vector<uint32_t> numbers;
+		try {
+			if (arg == "--accounts") {
+				accountsFile = value;
+			} else if (arg == "--host") {
+				host = value;
+			} else if (arg == "--login-port") {
+				loginPort = std::stoul(value);
+			} else if (arg == "--game-port") {
+				gamePort = std::stoul(value);
+			} else if (arg == "--bots") {
+				botCount = std::stoul(value);
+			} else if (arg == "--threads") {
+				threadCount = std::max<size_t>(1, std::stoul(value));
+			} else if (arg == "--ramp") {
+				ramp = std::stoul(value);
+			} else if (arg == "--duration") {
+				duration = std::stoul(value);
+			} else if (arg == "--interval") {
+				options.actionInterval = std::max<uint32_t>(2, std::stoul(value));
+			} else if (arg == "--key") {
+				keyFile = value;
+			} else if (arg == "--items") {
+				itemsFile = value;
+			} else if (arg == "--area" && parseNumbers(value, numbers, 4)) {
+				options.areaFrom = Position(std::min(numbers[0], numbers[2]), std::min(numbers[1], numbers[3]), 0);
+				options.areaTo = Position(std::max(numbers[0], numbers[2]), std::max(numbers[1], numbers[3]), 15);
+			} else if (arg == "--weights" && parseNumbers(value, numbers, 4)) {
+				options.walkWeight = numbers[0];
+				options.sayWeight = numbers[1];
+				options.attackWeight = numbers[2];
+				options.useWeight = numbers[3];
+			} else {
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		} catch (const std::exception&) {
+			std::cout << "> ERROR: Invalid value for " << arg << ": " << value << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (accountsFile.empty()) {
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	std::vector<BotAccount> accounts;
+	if (!loadAccounts(accountsFile, accounts) || accounts.empty()) {
+		std::cout << "> ERROR: No bot accounts loaded." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (botCount == 0 || botCount > accounts.size()) {
+		botCount = accounts.size();
+	}
+
+	BotItems items;
+	if (!items.load(itemsFile)) {
+		return EXIT_FAILURE;
+	}
+
+	RSA rsa;
+	try {
+		rsa.loadPEM(keyFile);
+	} catch (const std::exception& e) {
+		std::cout << "> ERROR: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	boost::system::error_code error;
+	auto address = boost::asio::ip::address::from_string(host, error);
+	if (error) {
+		std::cout << "> ERROR: Invalid host " << host << std::endl;
+		return EXIT_FAILURE;
+	}
+	options.loginEndpoint = boost::asio::ip::tcp::endpoint(address, loginPort);
+	options.gameEndpoint = boost::asio::ip::tcp::endpoint(address, gamePort);
+
+	// one io_service per thread, a bot never migrates so its handlers need
+	// no synchronization
+	std::vector<std::unique_ptr<boost::asio::io_service>> services;
+	std::vector<std::unique_ptr<boost::asio::io_service::work>> works;
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < threadCount; ++i) {
+		services.emplace_back(new boost::asio::io_service);
+		works.emplace_back(new boost::asio::io_service::work(*services.back()));
+	}
+	for (auto& service : services) {
+		boost::asio::io_service* ioService = service.get();
+		threads.emplace_back([ioService]() { ioService->run(); });
+	}
+
+	std::cout << ">> Starting " << botCount << " bots on " << threadCount << " thread(s)" << std::endl;
+
+	std::vector<std::shared_ptr<BotClient>> bots;
+	std::random_device seeder;
+	for (size_t i = 0; i < botCount; ++i) {
+		boost::asio::io_service& service = *services[i % threadCount];
+		auto bot = std::make_shared<BotClient>(service, options, items, rsa, accounts[i], seeder());
+		bots.push_back(bot);
+		service.post(std::bind(&BotClient::start, bot));
+
+		if (ramp != 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(ramp));
+		}
+	}
+
+	std::cout << ">> All bots started, measuring for " << duration << " seconds" << std::endl;
+	std::this_thread::sleep_for(std::chrono::seconds(duration));
+
+	for (size_t i = 0; i < bots.size(); ++i) {
+		services[i % threadCount]->post(std::bind(&BotClient::stop, bots[i]));
+	}
+
+	// give the logout packets a moment to leave before tearing down
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+	works.clear();
+	for (auto& service : services) {
+		service->stop();
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	std::vector<uint32_t> moveLatency, pingLatency, loginTime;
+	BotStats total;
+	size_t loggedIn = 0, disconnected = 0, failed = 0;
+	std::map<std::string, size_t> errors;
+	for (const auto& bot : bots) {
+		const BotStats& stats = bot->getStats();
+		moveLatency.insert(moveLatency.end(), stats.moveLatency.begin(), stats.moveLatency.end());
+		pingLatency.insert(pingLatency.end(), stats.pingLatency.begin(), stats.pingLatency.end());
+
+		if (stats.loggedIn) {
+			++loggedIn;
+			loginTime.push_back(stats.loginTime * 1000);
+		}
+		if (stats.disconnected) {
+			++disconnected;
+		} else if (!stats.loggedIn) {
+			++failed;
+		}
+		if (!stats.error.empty()) {
+			++errors[stats.error];
+		}
+
+		total.movesSent += stats.movesSent;
+		total.movesRejected += stats.movesRejected;
+		total.movesTimedOut += stats.movesTimedOut;
+		total.pingsTimedOut += stats.pingsTimedOut;
+		total.says += stats.says;
+		total.attacks += stats.attacks;
+		total.uses += stats.uses;
+		total.bytesSent += stats.bytesSent;
+		total.bytesReceived += stats.bytesReceived;
+		total.framesReceived += stats.framesReceived;
+		total.unknownOpcodes += stats.unknownOpcodes;
+		total.malformedFrames += stats.malformedFrames;
+	}
+
+	LatencySummary move = summarize(moveLatency);
+	LatencySummary ping = summarize(pingLatency);
+	LatencySummary login = summarize(loginTime);
+
+	if (csv) {
+		std::cout << "bots,logged_in,disconnected,failed,"
+		          << "move_samples,move_p50,move_p90,move_p99,move_p999,move_max,"
+		          << "ping_samples,ping_p50,ping_p90,ping_p99,ping_p999,ping_max,"
+		          << "login_p50,login_p99,moves_sent,moves_rejected,moves_timed_out,pings_timed_out,"
+		          << "bytes_sent,bytes_received,frames_received,unknown_opcodes,malformed_frames" << std::endl;
+		std::cout << std::fixed << std::setprecision(3)
+		          << bots.size() << ',' << loggedIn << ',' << disconnected << ',' << failed << ','
+		          << move.count << ',' << move.p50 << ',' << move.p90 << ',' << move.p99 << ',' << move.p999 << ',' << move.max << ','
+		          << ping.count << ',' << ping.p50 << ',' << ping.p90 << ',' << ping.p99 << ',' << ping.p999 << ',' << ping.max << ','
+		          << login.p50 << ',' << login.p99 << ',' << total.movesSent << ',' << total.movesRejected << ','
+		          << total.movesTimedOut << ',' << total.pingsTimedOut << ','
+		          << total.bytesSent << ',' << total.bytesReceived << ',' << total.framesReceived << ','
+		          << total.unknownOpcodes << ',' << total.malformedFrames << std::endl;
+		return EXIT_SUCCESS;
+	}
+
+	std::cout << std::endl;
+	std::cout << "Bots:     " << bots.size() << " started, " << loggedIn << " logged in, "
+	          << disconnected << " disconnected, " << failed << " failed" << std::endl;
+	printLatency("Login", login);
+	printLatency("Move ack", move);
+	printLatency("Ping", ping);
+	std::cout << "Actions:  " << total.movesSent << " moves (" << total.movesRejected << " rejected, "
+	          << total.movesTimedOut << " timed out), " << total.says << " says, "
+	          << total.attacks << " attacks, " << total.uses << " uses, "
+	          << total.pingsTimedOut << " pings timed out" << std::endl;
+	std::cout << "Traffic:  " << total.bytesSent << " bytes sent, " << total.bytesReceived << " bytes received in "
+	          << total.framesReceived << " frames" << std::endl;
+	std::cout << "Protocol: " << total.unknownOpcodes << " unknown opcodes, "
+	          << total.malformedFrames << " malformed frames" << std::endl;
+	for (const auto& it : errors) {
+		std::cout << "Error:    " << it.second << "x " << it.first << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
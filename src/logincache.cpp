@@ -0,0 +1,346 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#include "otpch.h"
+
+#include "logincache.h"
+#include "database.h"
+#include "databasetasks.h"
+#include "tools.h"
+
+extern DatabaseTasks g_databaseTasks;
+
+LoginCache g_loginCache;
+
+void LoginCache::load()
+{
+	Data newData;
+	loadData(*Database::getInstance(), newData);
+
+	std::cout << ">> Cached " << newData.accounts.size() << " accounts, " << newData.characters.size() << " characters and " << (newData.accountBans.size() + newData.ipBans.size()) << " bans" << std::endl;
+
+	std::lock_guard<std::mutex> lockGuard(lock);
+	data = std::move(newData);
+}
+
+void LoginCache::refresh()
+{
+	{
+		std::lock_guard<std::mutex> lockGuard(lock);
+		if (refreshing) {
+			return;
+		}
+		refreshing = true;
+	}
+
+	// key 0 runs after the ban writes queued before it, the ones queued
+	// after it are replayed by replace()
+	g_databaseTasks.addJob([this](Database& db) {
+		Data newData;
+		loadData(db, newData);
+		replace(newData);
+		return true;
+	});
+}
+
+void LoginCache::replace(Data& newData)
+{
+	std::lock_guard<std::mutex> lockGuard(lock);
+	for (const Change& change : pendingChanges) {
+		change(newData);
+	}
+	pendingChanges.clear();
+	refreshing = false;
+
+	data = std::move(newData);
+}
+
+void LoginCache::apply(const Change& change)
+{
+	std::lock_guard<std::mutex> lockGuard(lock);
+	change(data);
+	if (refreshing) {
+		pendingChanges.push_back(change);
+	}
+}
+
+void LoginCache::loadData(Database& db, Data& data)
+{
+	DBResult_ptr result = db.storeQuery("SELECT `id`, `password`, `type`, `premdays`, `lastday` FROM `accounts`");
+	if (result) {
+		do {
+			uint32_t accountId = result->getNumber<uint32_t>("id");
+			CachedAccount& cachedAccount = data.accounts[accountId];
+			cachedAccount.password = result->getString("password");
+
+			Account& account = cachedAccount.account;
+			account.id = accountId;
+			account.accountType = static_cast<AccountType_t>(result->getNumber<int32_t>("type"));
+			account.premiumDays = result->getNumber<uint16_t>("premdays");
+			account.lastDay = result->getNumber<time_t>("lastday");
+		} while (result->next());
+	}
+
+	result = db.storeQuery("SELECT `id`, `name`, `account_id`, `group_id`, `deletion` FROM `players`");
+	if (result) {
+		do {
+			CachedCharacter character;
+			character.guid = result->getNumber<uint32_t>("id");
+			character.name = result->getString("name");
+			character.accountId = result->getNumber<uint32_t>("account_id");
+			character.groupId = result->getNumber<uint16_t>("group_id");
+			character.deleted = result->getNumber<uint64_t>("deletion") != 0;
+			addCharacter(data, character);
+		} while (result->next());
+	}
+
+	result = db.storeQuery("SELECT `account_id`, `reason`, `banned_at`, `expires_at`, `banned_by`, (SELECT `name` FROM `players` WHERE `id` = `banned_by`) AS `name` FROM `account_bans`");
+	if (result) {
+		do {
+			CachedBan& ban = data.accountBans[result->getNumber<uint32_t>("account_id")];
+			ban.reason = result->getString("reason");
+			ban.bannedBy = result->getString("name");
+			ban.bannedAt = result->getNumber<time_t>("banned_at");
+			ban.expiresAt = result->getNumber<time_t>("expires_at");
+			ban.bannedById = result->getNumber<uint32_t>("banned_by");
+		} while (result->next());
+	}
+
+	result = db.storeQuery("SELECT `ip`, `reason`, `banned_at`, `expires_at`, `banned_by`, (SELECT `name` FROM `players` WHERE `id` = `banned_by`) AS `name` FROM `ip_bans`");
+	if (result) {
+		do {
+			CachedBan& ban = data.ipBans[result->getNumber<uint32_t>("ip")];
+			ban.reason = result->getString("reason");
+			ban.bannedBy = result->getString("name");
+			ban.bannedAt = result->getNumber<time_t>("banned_at");
+			ban.expiresAt = result->getNumber<time_t>("expires_at");
+			ban.bannedById = result->getNumber<uint32_t>("banned_by");
+		} while (result->next());
+	}
+
+	result = db.storeQuery("SELECT `player_id` FROM `player_namelocks`");
+	if (result) {
+		do {
+			data.namelocks.insert(result->getNumber<uint32_t>("player_id"));
+		} while (result->next());
+	}
+
+	for (auto& it : data.accounts) {
+		std::vector<std::string>& characters = it.second.account.characters;
+		std::sort(characters.begin(), characters.end());
+	}
+}
+
+void LoginCache::addCharacter(Data& data, const CachedCharacter& character)
+{
+	data.characters[asLowerCaseString(character.name)] = character;
+	if (character.deleted) {
+		return;
+	}
+
+	auto it = data.accounts.find(character.accountId);
+	if (it == data.accounts.end()) {
+		return;
+	}
+
+	std::vector<std::string>& characters = it->second.account.characters;
+	if (std::find(characters.begin(), characters.end(), character.name) == characters.end()) {
+		characters.push_back(character.name);
+	}
+}
+
+bool LoginCache::getAccount(uint32_t accountId, Account& account) const
+{
+	std::lock_guard<std::mutex> lockGuard(lock);
+	auto it = data.accounts.find(accountId);
+	if (it == data.accounts.end()) {
+		return false;
+	}
+
+	account = it->second.account;
+	return true;
+}
+
+bool LoginCache::getAccount(uint32_t accountId, Account& account, std::string& password) const
+{
+	std::lock_guard<std::mutex> lockGuard(lock);
+	auto it = data.accounts.find(accountId);
+	if (it == data.accounts.end()) {
+		return false;
+	}
+
+	account = it->second.account;
+	password = it->second.password;
+	return true;
+}
+
+bool LoginCache::getCharacter(const std::string& name, CachedCharacter& character) const
+{
+	std::lock_guard<std::mutex> lockGuard(lock);
+	auto it = data.characters.find(asLowerCaseString(name));
+	if (it == data.characters.end()) {
+		return false;
+	}
+
+	character = it->second;
+	return true;
+}
+
+bool LoginCache::getAccountBan(uint32_t accountId, CachedBan& ban) const
+{
+	std::lock_guard<std::mutex> lockGuard(lock);
+	auto it = data.accountBans.find(accountId);
+	if (it == data.accountBans.end()) {
+		return false;
+	}
+
+	ban = it->second;
+	return true;
+}
+
+bool LoginCache::getIpBan(uint32_t ip, CachedBan& ban) const
+{
+	std::lock_guard<std::mutex> lockGuard(lock);
+	auto it = data.ipBans.find(ip);
+	if (it == data.ipBans.end()) {
+		return false;
+	}
+
+	ban = it->second;
+	return true;
+}
+
+bool LoginCache::isNamelocked(uint32_t guid) const
+{
+	std::lock_guard<std::mutex> lockGuard(lock);
+	return data.namelocks.find(guid) != data.namelocks.end();
+}
+
+void LoginCache::setAccount(const Account& account, const std::string& password)
+{
+	apply([account, password](Data& data) {
+		CachedAccount& cachedAccount = data.accounts[account.id];
+		cachedAccount.account = account;
+		cachedAccount.password = password;
+	});
+}
+
+void LoginCache::setPassword(uint32_t accountId, const std::string& password)
+{
+	apply([accountId, password](Data& data) {
+		auto it = data.accounts.find(accountId);
+		if (it != data.accounts.end()) {
+			it->second.password = password;
+		}
+	});
+}
+
+void LoginCache::setCharacter(const CachedCharacter& character)
+{
+	apply([character](Data& data) {
+		addCharacter(data, character);
+
+		auto it = data.accounts.find(character.accountId);
+		if (it != data.accounts.end()) {
+			std::vector<std::string>& characters = it->second.account.characters;
+			std::sort(characters.begin(), characters.end());
+		}
+	});
+}
+
+void LoginCache::setPremium(uint32_t accountId, uint16_t premiumDays, time_t lastDay)
+{
+	apply([=](Data& data) {
+		auto it = data.accounts.find(accountId);
+		if (it != data.accounts.end()) {
+			it->second.account.premiumDays = premiumDays;
+			it->second.account.lastDay = lastDay;
+		}
+	});
+}
+
+void LoginCache::addPremiumDays(uint32_t accountId, int32_t days)
+{
+	std::lock_guard<std::mutex> lockGuard(lock);
+
+	auto it = data.accounts.find(accountId);
+	if (it == data.accounts.end()) {
+		return;
+	}
+
+	uint16_t& premiumDays = it->second.account.premiumDays;
+	premiumDays = static_cast<uint16_t>(std::max<int32_t>(0, premiumDays + days));
+
+	// a reload may already have read the updated row, so it is given the
+	// resulting value rather than the difference a second time
+	if (refreshing) {
+		const uint16_t value = premiumDays;
+		pendingChanges.push_back([accountId, value](Data& data) {
+			auto it = data.accounts.find(accountId);
+			if (it != data.accounts.end()) {
+				it->second.account.premiumDays = value;
+			}
+		});
+	}
+}
+
+void LoginCache::setAccountType(uint32_t accountId, AccountType_t accountType)
+{
+	apply([=](Data& data) {
+		auto it = data.accounts.find(accountId);
+		if (it != data.accounts.end()) {
+			it->second.account.accountType = accountType;
+		}
+	});
+}
+
+void LoginCache::setCharacterGroup(const std::string& name, uint16_t groupId)
+{
+	const std::string key = asLowerCaseString(name);
+	apply([key, groupId](Data& data) {
+		auto it = data.characters.find(key);
+		if (it != data.characters.end()) {
+			it->second.groupId = groupId;
+		}
+	});
+}
+
+void LoginCache::setAccountBan(uint32_t accountId, const CachedBan& ban)
+{
+	apply([accountId, ban](Data& data) {
+		data.accountBans[accountId] = ban;
+	});
+}
+
+void LoginCache::removeAccountBan(uint32_t accountId)
+{
+	apply([accountId](Data& data) {
+		data.accountBans.erase(accountId);
+	});
+}
+
+void LoginCache::setIpBan(uint32_t ip, const CachedBan& ban)
+{
+	apply([ip, ban](Data& data) {
+		data.ipBans[ip] = ban;
+	});
+}
+
+void LoginCache::removeIpBan(uint32_t ip)
+{
+	apply([ip](Data& data) {
+		data.ipBans.erase(ip);
+	});
+}
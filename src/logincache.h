@@ -0,0 +1,107 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#ifndef FS_LOGINCACHE_H_8B2E5D7C1A3F4E6B9D0C2A4F6E8B1D3C
+#define FS_LOGINCACHE_H_8B2E5D7C1A3F4E6B9D0C2A4F6E8B1D3C
+
+#include "account.h"
+
+#include <unordered_set>
+
+class Database;
+
+struct CachedAccount {
+	Account account;
+	std::string password;
+};
+
+struct CachedCharacter {
+	std::string name;
+	uint32_t guid = 0;
+	uint32_t accountId = 0;
+	uint16_t groupId = 0;
+	bool deleted = false;
+};
+
+struct CachedBan {
+	std::string reason;
+	std::string bannedBy;
+	time_t bannedAt = 0;
+	time_t expiresAt = 0;
+	uint32_t bannedById = 0;
+};
+
+/**
+ * Accounts, their characters, bans and namelocks kept in memory so a login
+ * does not have to query the database.
+ *
+ * Loaded at startup and reloaded every loginCacheRefreshInterval on a
+ * database worker to pick up changes made outside the server. The server's
+ * own writes update it directly, changes made while a reload is running are
+ * applied again on top of what the reload read. Lookups may come from the
+ * network and the dispatcher thread, every access takes the lock.
+ */
+class LoginCache
+{
+	public:
+		void load();
+		void refresh();
+
+		bool getAccount(uint32_t accountId, Account& account) const;
+		bool getAccount(uint32_t accountId, Account& account, std::string& password) const;
+		bool getCharacter(const std::string& name, CachedCharacter& character) const;
+		bool getAccountBan(uint32_t accountId, CachedBan& ban) const;
+		bool getIpBan(uint32_t ip, CachedBan& ban) const;
+		bool isNamelocked(uint32_t guid) const;
+
+		// called after the server itself changed the database
+		void setAccount(const Account& account, const std::string& password);
+		void setPassword(uint32_t accountId, const std::string& password);
+		void setCharacter(const CachedCharacter& character);
+		void setPremium(uint32_t accountId, uint16_t premiumDays, time_t lastDay);
+		void addPremiumDays(uint32_t accountId, int32_t days);
+		void setAccountType(uint32_t accountId, AccountType_t accountType);
+		void setCharacterGroup(const std::string& name, uint16_t groupId);
+		void setAccountBan(uint32_t accountId, const CachedBan& ban);
+		void removeAccountBan(uint32_t accountId);
+		void setIpBan(uint32_t ip, const CachedBan& ban);
+		void removeIpBan(uint32_t ip);
+
+	private:
+		struct Data {
+			std::unordered_map<uint32_t, CachedAccount> accounts;
+			std::unordered_map<std::string, CachedCharacter> characters;
+			std::unordered_map<uint32_t, CachedBan> accountBans;
+			std::unordered_map<uint32_t, CachedBan> ipBans;
+			std::unordered_set<uint32_t> namelocks;
+		};
+
+		typedef std::function<void(Data&)> Change;
+
+		static void loadData(Database& db, Data& data);
+		static void addCharacter(Data& data, const CachedCharacter& character);
+
+		void apply(const Change& change);
+		void replace(Data& newData);
+
+		Data data;
+		std::vector<Change> pendingChanges;
+		bool refreshing = false;
+		mutable std::mutex lock;
+};
+
+extern LoginCache g_loginCache;
+
+#endif
@@ -34,6 +34,8 @@
 #include "monster.h"
 #include "scheduler.h"
 #include "databasetasks.h"
+#include "ban.h"
+#include "objectpool.h"
 
 extern Chat* g_chat;
 extern Game g_game;
@@ -1589,6 +1591,8 @@ void LuaScriptInterface::registerFunctions()
 	registerEnumIn("configKeys", ConfigManager::WARN_UNSAFE_SCRIPTS)
 	registerEnumIn("configKeys", ConfigManager::CONVERT_UNSAFE_SCRIPTS)
 	registerEnumIn("configKeys", ConfigManager::TELEPORT_NEWBIES)
+	registerEnumIn("configKeys", ConfigManager::PLAYER_JOURNAL)
+	registerEnumIn("configKeys", ConfigManager::ASYNC_PLAYER_LOAD)
 
 	registerEnumIn("configKeys", ConfigManager::MAP_NAME)
 	registerEnumIn("configKeys", ConfigManager::HOUSE_RENT_PERIOD)
@@ -1642,6 +1646,15 @@ void LuaScriptInterface::registerFunctions()
 	registerEnumIn("configKeys", ConfigManager::NEWBIE_TOWN)
 	registerEnumIn("configKeys", ConfigManager::NEWBIE_LEVEL_THRESHOLD)
 	registerEnumIn("configKeys", ConfigManager::EXTRA_ONLINE)
+	registerEnumIn("configKeys", ConfigManager::SEND_QUEUE_SOFT_LIMIT)
+	registerEnumIn("configKeys", ConfigManager::MAX_SEND_QUEUE_BYTES)
+	registerEnumIn("configKeys", ConfigManager::MAX_SEND_QUEUE_MESSAGES)
+	registerEnumIn("configKeys", ConfigManager::DATABASE_WORKERS)
+	registerEnumIn("configKeys", ConfigManager::DATABASE_BATCH_SIZE)
+	registerEnumIn("configKeys", ConfigManager::DATABASE_BATCH_DELAY)
+	registerEnumIn("configKeys", ConfigManager::PLAYER_JOURNAL_INTERVAL)
+	registerEnumIn("configKeys", ConfigManager::LOGIN_CACHE_REFRESH_INTERVAL)
+	registerEnumIn("configKeys", ConfigManager::PLAYER_PREWARM_TIME)
 
 	// os
 	registerMethod("os", "mtime", LuaScriptInterface::luaSystemTime);
@@ -1680,6 +1693,13 @@ void LuaScriptInterface::registerFunctions()
 
 	registerMethod("Game", "startRaid", LuaScriptInterface::luaGameStartRaid);
 
+	registerMethod("Game", "getServerStats", LuaScriptInterface::luaGameGetServerStats);
+
+	registerMethod("Game", "addAccountBan", LuaScriptInterface::luaGameAddAccountBan);
+	registerMethod("Game", "removeAccountBan", LuaScriptInterface::luaGameRemoveAccountBan);
+	registerMethod("Game", "addIpBan", LuaScriptInterface::luaGameAddIpBan);
+	registerMethod("Game", "removeIpBan", LuaScriptInterface::luaGameRemoveIpBan);
+
 	// Variant
 	registerClass("Variant", "", LuaScriptInterface::luaVariantCreate);
 
@@ -1997,6 +2017,8 @@ void LuaScriptInterface::registerFunctions()
 
 	registerMethod("Player", "getStorageValue", LuaScriptInterface::luaPlayerGetStorageValue);
 	registerMethod("Player", "setStorageValue", LuaScriptInterface::luaPlayerSetStorageValue);
+	registerMethod("Player", "getStorageValues", LuaScriptInterface::luaPlayerGetStorageValues);
+	registerMethod("Player", "setStorageValues", LuaScriptInterface::luaPlayerSetStorageValues);
 
 	registerMethod("Player", "addItem", LuaScriptInterface::luaPlayerAddItem);
 	registerMethod("Player", "addItemEx", LuaScriptInterface::luaPlayerAddItemEx);
@@ -3611,6 +3633,7 @@ int LuaScriptInterface::luaConfigManagerGetBoolean(lua_State* L)
 const luaL_Reg LuaScriptInterface::luaDatabaseTable[] = {
 	{"query", LuaScriptInterface::luaDatabaseExecute},
 	{"asyncQuery", LuaScriptInterface::luaDatabaseAsyncExecute},
+	{"batchQuery", LuaScriptInterface::luaDatabaseBatchExecute},
 	{"storeQuery", LuaScriptInterface::luaDatabaseStoreQuery},
 	{"asyncStoreQuery", LuaScriptInterface::luaDatabaseAsyncStoreQuery},
 	{"escapeString", LuaScriptInterface::luaDatabaseEscapeString},
@@ -3626,33 +3649,54 @@ int LuaScriptInterface::luaDatabaseExecute(lua_State* L)
 	return 1;
 }
 
-int LuaScriptInterface::luaDatabaseAsyncExecute(lua_State* L)
+// takes the callback of db.asyncQuery or db.batchQuery from the top of the stack
+static std::function<void(DBResult_ptr, bool)> popExecuteCallback(lua_State* L)
 {
-	std::function<void(DBResult_ptr, bool)> callback;
-	if (lua_gettop(L) > 1) {
-		int32_t ref = luaL_ref(L, LUA_REGISTRYINDEX);
-		auto scriptId = getScriptEnv()->getScriptId();
-		callback = [ref, scriptId](DBResult_ptr, bool success) {
-			lua_State* luaState = g_luaEnvironment.getLuaState();
-			if (!luaState) {
-				return;
-			}
-
-			if (!LuaScriptInterface::reserveScriptEnv()) {
-				luaL_unref(luaState, LUA_REGISTRYINDEX, ref);
-				return;
-			}
+	if (!LuaScriptInterface::isFunction(L, -1)) {
+		lua_pop(L, 1);
+		return nullptr;
+	}
 
-			lua_rawgeti(luaState, LUA_REGISTRYINDEX, ref);
-			pushBoolean(luaState, success);
-			auto env = getScriptEnv();
-			env->setScriptId(scriptId, &g_luaEnvironment);
-			g_luaEnvironment.callFunction(1);
+	int32_t ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	auto scriptId = LuaScriptInterface::getScriptEnv()->getScriptId();
+	return [ref, scriptId](DBResult_ptr, bool success) {
+		lua_State* luaState = g_luaEnvironment.getLuaState();
+		if (!luaState) {
+			return;
+		}
 
+		if (!LuaScriptInterface::reserveScriptEnv()) {
 			luaL_unref(luaState, LUA_REGISTRYINDEX, ref);
-		};
-	}
-	g_databaseTasks.addTask(getString(L, -1), callback);
+			return;
+		}
+
+		lua_rawgeti(luaState, LUA_REGISTRYINDEX, ref);
+		LuaScriptInterface::pushBoolean(luaState, success);
+		auto env = LuaScriptInterface::getScriptEnv();
+		env->setScriptId(scriptId, &g_luaEnvironment);
+		g_luaEnvironment.callFunction(1);
+
+		luaL_unref(luaState, LUA_REGISTRYINDEX, ref);
+	};
+}
+
+int LuaScriptInterface::luaDatabaseAsyncExecute(lua_State* L)
+{
+	// db.asyncQuery(query[, callback[, key]])
+	// queries sharing a key run in order, unrelated keys may run in parallel
+	const uint32_t key = getNumber<uint32_t>(L, 3, 0);
+	lua_settop(L, 2);
+	g_databaseTasks.addTask(getString(L, 1), popExecuteCallback(L), false, key);
+	return 0;
+}
+
+int LuaScriptInterface::luaDatabaseBatchExecute(lua_State* L)
+{
+	// db.batchQuery(query[, callback[, key]])
+	// like db.asyncQuery, for small writes that may be committed together
+	const uint32_t key = getNumber<uint32_t>(L, 3, 0);
+	lua_settop(L, 2);
+	g_databaseTasks.addBatchedTask(getString(L, 1), popExecuteCallback(L), key);
 	return 0;
 }
 
@@ -3668,8 +3712,12 @@ int LuaScriptInterface::luaDatabaseStoreQuery(lua_State* L)
 
 int LuaScriptInterface::luaDatabaseAsyncStoreQuery(lua_State* L)
 {
+	// db.asyncStoreQuery(query[, callback[, key]])
+	const uint32_t key = getNumber<uint32_t>(L, 3, 0);
+	lua_settop(L, 2);
+
 	std::function<void(DBResult_ptr, bool)> callback;
-	if (lua_gettop(L) > 1) {
+	if (isFunction(L, 2)) {
 		int32_t ref = luaL_ref(L, LUA_REGISTRYINDEX);
 		auto scriptId = getScriptEnv()->getScriptId();
 		callback = [ref, scriptId](DBResult_ptr result, bool) {
@@ -3696,7 +3744,7 @@ int LuaScriptInterface::luaDatabaseAsyncStoreQuery(lua_State* L)
 			luaL_unref(luaState, LUA_REGISTRYINDEX, ref);
 		};
 	}
-	g_databaseTasks.addTask(getString(L, -1), callback, true);
+	g_databaseTasks.addTask(getString(L, 1), callback, true, key);
 	return 0;
 }
 
@@ -4183,6 +4231,143 @@ int LuaScriptInterface::luaGameStartRaid(lua_State* L)
 	return 1;
 }
 
+int LuaScriptInterface::luaGameGetServerStats(lua_State* L)
+{
+	// Game.getServerStats()
+	lua_createtable(L, 0, 5);
+
+	// send queues of the connected players, by player name
+	lua_createtable(L, 0, g_game.getPlayers().size());
+	for (const auto& it : g_game.getPlayers()) {
+		Player* player = it.second;
+		if (!player->client) {
+			continue;
+		}
+
+		Connection_ptr connection = player->client->getConnection();
+		if (!connection) {
+			continue;
+		}
+
+		const SendQueueStats stats = connection->getSendQueueStats();
+		lua_createtable(L, 0, 4);
+		setField(L, "bytes", stats.bytes);
+		setField(L, "messages", stats.messages);
+		setField(L, "peakBytes", stats.peakBytes);
+		setField(L, "peakMessages", stats.peakMessages);
+		lua_setfield(L, -2, player->getName().c_str());
+	}
+	lua_setfield(L, -2, "sendQueues");
+
+	// slab pools of items, monsters and conditions
+	const std::vector<ObjectPoolStats> poolStats = ObjectPool::getAllStats();
+	lua_createtable(L, poolStats.size(), 0);
+
+	int index = 0;
+	for (const ObjectPoolStats& pool : poolStats) {
+		lua_createtable(L, 0, 7);
+		setField(L, "name", pool.name);
+		setField(L, "objectSize", pool.objectSize);
+		setField(L, "inUse", pool.inUse);
+		setField(L, "peakInUse", pool.peakInUse);
+		setField(L, "capacity", pool.capacity);
+		setField(L, "allocations", pool.allocations);
+		setField(L, "fallbacks", pool.fallbacks);
+		lua_rawseti(L, -2, ++index);
+	}
+	lua_setfield(L, -2, "objectPools");
+
+	// database workers, in worker order
+	const std::vector<DatabaseWorkerStats> workerStats = g_databaseTasks.getStats();
+	lua_createtable(L, workerStats.size(), 0);
+
+	index = 0;
+	for (const DatabaseWorkerStats& worker : workerStats) {
+		lua_createtable(L, 0, 8);
+		setField(L, "queued", worker.queued);
+		setField(L, "peakQueued", worker.peakQueued);
+		setField(L, "executed", worker.executed);
+		setField(L, "busyTime", worker.busyTime / 1000);
+		setField(L, "commits", worker.commits);
+		setField(L, "batches", worker.batches);
+		setField(L, "averageLatency", worker.executed != 0 ? worker.latency / worker.executed / 1000. : 0.);
+		setField(L, "peakLatency", worker.peakLatency / 1000.);
+		lua_rawseti(L, -2, ++index);
+	}
+	lua_setfield(L, -2, "databaseWorkers");
+
+	// player loads with asyncPlayerLoad off and on
+	lua_createtable(L, 0, 2);
+	for (bool async : {false, true}) {
+		const PlayerLoadStats stats = IOLoginData::getLoadStats(async);
+		lua_createtable(L, 0, 4);
+		setField(L, "logins", stats.logins);
+		setField(L, "prewarmed", stats.prewarmed);
+		setField(L, "dispatcherTime", stats.logins != 0 ? stats.dispatcherTime / stats.logins / 1000. : 0.);
+		setField(L, "totalTime", stats.logins != 0 ? stats.totalTime / stats.logins / 1000. : 0.);
+		lua_setfield(L, -2, async ? "async" : "sync");
+	}
+	lua_setfield(L, -2, "playerLoads");
+
+	// decay queue, busyTime in microseconds
+	const DecayStats decayStats = g_game.getDecayStats();
+	lua_createtable(L, 0, 4);
+	setField(L, "queued", decayStats.queued);
+	setField(L, "passes", decayStats.passes);
+	setField(L, "expired", decayStats.expired);
+	setField(L, "busyTime", decayStats.busyTime);
+	lua_setfield(L, -2, "decay");
+	return 1;
+}
+
+int LuaScriptInterface::luaGameAddAccountBan(lua_State* L)
+{
+	// Game.addAccountBan(accountId, reason, expiresAt[, bannedBy])
+	uint32_t accountId = getNumber<uint32_t>(L, 1);
+	const std::string& reason = getString(L, 2);
+	time_t expiresAt = getNumber<time_t>(L, 3);
+
+	Player* player = getPlayer(L, 4);
+	if (player) {
+		pushBoolean(L, IOBan::addAccountBan(accountId, reason, expiresAt, player->getGUID(), player->getName()));
+	} else {
+		pushBoolean(L, IOBan::addAccountBan(accountId, reason, expiresAt, 0, std::string()));
+	}
+	return 1;
+}
+
+int LuaScriptInterface::luaGameRemoveAccountBan(lua_State* L)
+{
+	// Game.removeAccountBan(accountId)
+	IOBan::removeAccountBan(getNumber<uint32_t>(L, 1));
+	pushBoolean(L, true);
+	return 1;
+}
+
+int LuaScriptInterface::luaGameAddIpBan(lua_State* L)
+{
+	// Game.addIpBan(ip, reason, expiresAt[, bannedBy])
+	uint32_t ip = getNumber<uint32_t>(L, 1);
+	const std::string& reason = getString(L, 2);
+	time_t expiresAt = getNumber<time_t>(L, 3);
+
+	Player* player = getPlayer(L, 4);
+	if (player) {
+		pushBoolean(L, IOBan::addIpBan(ip, reason, expiresAt, player->getGUID(), player->getName()));
+	} else {
+		pushBoolean(L, IOBan::addIpBan(ip, reason, expiresAt, 0, std::string()));
+	}
+	return 1;
+}
+
+int LuaScriptInterface::luaGameRemoveIpBan(lua_State* L)
+{
+	// Game.removeIpBan(ip)
+	IOBan::removeIpBan(getNumber<uint32_t>(L, 1));
+	pushBoolean(L, true);
+	return 1;
+}
+
 // Variant
 int LuaScriptInterface::luaVariantCreate(lua_State* L)
 {
@@ -5677,7 +5862,9 @@ int LuaScriptInterface::luaItemGetAttribute(lua_State* L)
 		attribute = ITEM_ATTRIBUTE_NONE;
 	}
 
-	if (ItemAttributes::isIntAttrType(attribute)) {
+	if (attribute == ITEM_ATTRIBUTE_DURATION) {
+		lua_pushnumber(L, item->getDuration());
+	} else if (ItemAttributes::isIntAttrType(attribute)) {
 		lua_pushnumber(L, item->getIntAttr(attribute));
 	} else if (ItemAttributes::isStrAttrType(attribute)) {
 		pushString(L, item->getStrAttr(attribute));
@@ -5705,7 +5892,13 @@ int LuaScriptInterface::luaItemSetAttribute(lua_State* L)
 		attribute = ITEM_ATTRIBUTE_NONE;
 	}
 
-	if (ItemAttributes::isIntAttrType(attribute)) {
+	if (attribute == ITEM_ATTRIBUTE_DURATION) {
+		item->setDuration(getNumber<int32_t>(L, 3));
+		pushBoolean(L, true);
+	} else if (attribute == ITEM_ATTRIBUTE_DECAYSTATE) {
+		item->setDecaying(getNumber<ItemDecayState_t>(L, 3));
+		pushBoolean(L, true);
+	} else if (ItemAttributes::isIntAttrType(attribute)) {
 		item->setIntAttr(attribute, getNumber<int32_t>(L, 3));
 		pushBoolean(L, true);
 	} else if (ItemAttributes::isStrAttrType(attribute)) {
@@ -5735,6 +5928,12 @@ int LuaScriptInterface::luaItemRemoveAttribute(lua_State* L)
 		attribute = ITEM_ATTRIBUTE_NONE;
 	}
 
+	// a decaying item keeps its time left in the duration attribute only
+	// once it stops
+	if (attribute == ITEM_ATTRIBUTE_DURATION || attribute == ITEM_ATTRIBUTE_DECAYSTATE) {
+		item->setDecaying(DECAYING_FALSE);
+	}
+
 	item->removeAttribute(attribute);
 	pushBoolean(L, true);
 	return 1;
@@ -7951,6 +8150,49 @@ int LuaScriptInterface::luaPlayerSetStorageValue(lua_State* L)
 	return 1;
 }
 
+int LuaScriptInterface::luaPlayerGetStorageValues(lua_State* L)
+{
+	// player:getStorageValues({key, ...})
+	Player* player = getUserdata<Player>(L, 1);
+	if (!player || !isTable(L, 2)) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	int size = lua_objlen(L, 2);
+	lua_createtable(L, size, 0);
+	for (int index = 1; index <= size; ++index) {
+		lua_rawgeti(L, 2, index);
+		uint32_t key = getNumber<uint32_t>(L, -1);
+		lua_pop(L, 1);
+
+		int32_t value;
+		player->getStorageValue(key, value);
+		lua_pushnumber(L, value);
+		lua_rawseti(L, -2, index);
+	}
+	return 1;
+}
+
+int LuaScriptInterface::luaPlayerSetStorageValues(lua_State* L)
+{
+	// player:setStorageValues({[key] = value, ...})
+	Player* player = getUserdata<Player>(L, 1);
+	if (!player || !isTable(L, 2)) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	lua_pushnil(L);
+	while (lua_next(L, 2) != 0) {
+		player->addStorageValue(getNumber<uint32_t>(L, -2), getNumber<int32_t>(L, -1));
+		lua_pop(L, 1);
+	}
+
+	pushBoolean(L, true);
+	return 1;
+}
+
 int LuaScriptInterface::luaPlayerAddItem(lua_State* L)
 {
 	// player:addItem(itemId[, count = 1[, canDropOnMap = true[, subType = 1[, slot = CONST_SLOT_WHEREEVER]]]])
@@ -9613,17 +9855,20 @@ int LuaScriptInterface::luaHouseBid(lua_State* L)
 	// house:bid(bidValue)
 	House* house = getUserdata<House>(L, 1);
 	if (house) {
-		Player* player;
-		if (isNumber(L, 2)) {
-			const uint32_t ownerId = house->getOwner();
-
-			Player player(nullptr);
-			IOLoginData::loadPlayerById(&player, ownerId);
+		uint32_t bidvalue = getNumber<uint32_t>(L, 2);
+		if (bidvalue > 0) {
+			// the owner is read on the database workers and charged once it is in
+			const uint32_t townId = house->getTownId();
+			IOLoginData::loadOfflinePlayer(house->getOwner(), [townId, bidvalue](Player* player) {
+				if (!player) {
+					return;
+				}
 
-			uint32_t bidvalue = getNumber<uint32_t>(L, 2);
-			if(bidvalue > 0){
-				g_game.removeMoney(player.getDepotLocker(house->getTownId(), true), bidvalue, FLAG_NOLIMIT);
-			}
+				g_game.removeMoney(player->getDepotLocker(townId, true), bidvalue, FLAG_NOLIMIT);
+				if (player->isOffline()) {
+					IOLoginData::savePlayer(player);
+				}
+			});
 		}
 
 		pushBoolean(L, true);
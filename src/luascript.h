@@ -387,7 +387,7 @@ class LuaScriptInterface
 		static const luaL_Reg luaBitReg[7];
 #endif
 		static const luaL_Reg luaConfigManagerTable[4];
-		static const luaL_Reg luaDatabaseTable[9];
+		static const luaL_Reg luaDatabaseTable[10];
 		static const luaL_Reg luaResultTable[6];
 
 		static int protectedCall(lua_State* L, int nargs, int nresults);
@@ -491,6 +491,7 @@ class LuaScriptInterface
 
 		static int luaDatabaseExecute(lua_State* L);
 		static int luaDatabaseAsyncExecute(lua_State* L);
+		static int luaDatabaseBatchExecute(lua_State* L);
 		static int luaDatabaseStoreQuery(lua_State* L);
 		static int luaDatabaseAsyncStoreQuery(lua_State* L);
 		static int luaDatabaseEscapeString(lua_State* L);
@@ -546,6 +547,13 @@ class LuaScriptInterface
 
 		static int luaGameStartRaid(lua_State* L);
 
+		static int luaGameGetServerStats(lua_State* L);
+
+		static int luaGameAddAccountBan(lua_State* L);
+		static int luaGameRemoveAccountBan(lua_State* L);
+		static int luaGameAddIpBan(lua_State* L);
+		static int luaGameRemoveIpBan(lua_State* L);
+
 		// Variant
 		static int luaVariantCreate(lua_State* L);
 
@@ -858,6 +866,8 @@ class LuaScriptInterface
 
 		static int luaPlayerGetStorageValue(lua_State* L);
 		static int luaPlayerSetStorageValue(lua_State* L);
+		static int luaPlayerGetStorageValues(lua_State* L);
+		static int luaPlayerSetStorageValues(lua_State* L);
 
 		static int luaPlayerAddItem(lua_State* L);
 		static int luaPlayerAddItemEx(lua_State* L);
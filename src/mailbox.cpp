@@ -104,33 +104,47 @@ bool Mailbox::sendItem(Item* item) const
 
 	Player* player = g_game.getPlayerByName(receiver);
 	if (player) {
-		DepotLocker* depotLocker = player->getDepotLocker(town->getID(), true);
-		if (depotLocker) {
-			if (g_game.internalMoveItem(item->getParent(), depotLocker, INDEX_WHEREEVER,
-				item, item->getItemCount(), nullptr, FLAG_NOLIMIT) == RETURNVALUE_NOERROR) {
-				g_game.transformItem(item, item->getID() + 1);
-				player->onReceiveMail();
-				return true;
-			}
-		}
-	} else {
-		Player tmpPlayer(nullptr);
-		if (!IOLoginData::loadPlayerByName(&tmpPlayer, receiver)) {
-			return false;
-		}
+		return deliverItem(player, item, town->getID());
+	}
 
-		DepotLocker* depotLocker = tmpPlayer.getDepotLocker(town->getID(), true);
-		if (depotLocker) {
-			if (g_game.internalMoveItem(item->getParent(), depotLocker, INDEX_WHEREEVER,
-				item, item->getItemCount(), nullptr, FLAG_NOLIMIT) == RETURNVALUE_NOERROR) {
-				g_game.transformItem(item, item->getID() + 1);
-				IOLoginData::savePlayer(&tmpPlayer);
-				return true;
-			}
+	// the receiver is read on the database workers, the item waits on the
+	// mailbox until it is in
+	item->incrementReferenceCounter();
+	const uint32_t townId = town->getID();
+	IOLoginData::loadOfflinePlayer(receiver, [item, townId](Player* player) {
+		if (player) {
+			deliverItem(player, item, townId);
 		}
+		g_game.ReleaseItem(item);
+	});
+	return true;
+}
+
+bool Mailbox::deliverItem(Player* player, Item* item, uint32_t townId)
+{
+	// the item may have been picked up again while the receiver was read
+	Tile* tile = item->getTile();
+	if (!tile || item->getParent() != tile || !tile->getMailbox()) {
+		return false;
+	}
+
+	DepotLocker* depotLocker = player->getDepotLocker(townId, true);
+	if (!depotLocker) {
+		return false;
 	}
 
-	return false;
+	if (g_game.internalMoveItem(tile, depotLocker, INDEX_WHEREEVER,
+		item, item->getItemCount(), nullptr, FLAG_NOLIMIT) != RETURNVALUE_NOERROR) {
+		return false;
+	}
+
+	g_game.transformItem(item, item->getID() + 1);
+	if (player->isOffline()) {
+		IOLoginData::savePlayer(player);
+	} else {
+		player->onReceiveMail();
+	}
+	return true;
 }
 
 bool Mailbox::getDestination(Item* item, std::string& name, std::string& town) const
@@ -55,6 +55,8 @@ class Mailbox final : public Item, public Cylinder
 		bool getDestination(Item* item, std::string& name, std::string& town) const;
 		bool sendItem(Item* item) const;
 
+		static bool deliverItem(Player* player, Item* item, uint32_t townId);
+
 		static bool canSend(const Item* item);
 };
 
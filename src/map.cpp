@@ -47,28 +47,9 @@ bool Map::loadMap(const std::string& identifier, bool loadHouses)
 	return true;
 }
 
-bool Map::save()
+size_t Map::save(const std::function<void(bool)>& callback)
 {
-	bool saved = false;
-	for (uint32_t tries = 0; tries < 3; tries++) {
-		if (IOMapSerialize::saveHouseInfo()) {
-			saved = true;
-			break;
-		}
-	}
-
-	if (!saved) {
-		return false;
-	}
-
-	saved = false;
-	for (uint32_t tries = 0; tries < 3; tries++) {
-		if (IOMapSerialize::saveHouseItems()) {
-			saved = true;
-			break;
-		}
-	}
-	return saved;
+	return IOMapSerialize::saveHouses(callback);
 }
 
 Tile* Map::getTile(uint16_t x, uint16_t y, uint8_t z) const
@@ -242,11 +223,14 @@ void Map::moveCreature(Creature& creature, Tile& newTile, bool forceTeleport/* =
 	getSpectators(list, oldPos, true);
 	getSpectators(list, newPos, true);
 
+	bool oldIndexPerViewer;
+	const int32_t oldIndex = oldTile.getClientIndexOfCreature(&creature, oldIndexPerViewer);
+
 	std::vector<int32_t> oldStackPosVector;
 	for (Creature* spectator : list) {
 		if (Player* tmpPlayer = spectator->getPlayer()) {
 			if (tmpPlayer->canSeeCreature(&creature)) {
-				oldStackPosVector.push_back(oldTile.getClientIndexOfCreature(tmpPlayer, &creature));
+				oldStackPosVector.push_back(oldIndexPerViewer ? oldTile.getClientIndexOfCreature(tmpPlayer, &creature) : oldIndex);
 			} else {
 				oldStackPosVector.push_back(-1);
 			}
@@ -283,13 +267,16 @@ void Map::moveCreature(Creature& creature, Tile& newTile, bool forceTeleport/* =
 	}
 
 	//send to client
+	bool newStackposPerViewer;
+	const int32_t newStackpos = newTile.getStackposOfCreature(&creature, newStackposPerViewer);
+
 	size_t i = 0;
 	for (Creature* spectator : list) {
 		if (Player* tmpPlayer = spectator->getPlayer()) {
 			//Use the correct stackpos
 			int32_t stackpos = oldStackPosVector[i++];
 			if (stackpos != -1) {
-				tmpPlayer->sendCreatureMove(&creature, newPos, newTile.getStackposOfCreature(tmpPlayer, &creature), oldPos, stackpos, teleport);
+				tmpPlayer->sendCreatureMove(&creature, newPos, newStackposPerViewer ? newTile.getStackposOfCreature(tmpPlayer, &creature) : newStackpos, oldPos, stackpos, teleport);
 			}
 		}
 	}
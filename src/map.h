@@ -181,10 +181,11 @@ class Map
 		bool loadMap(const std::string& identifier, bool loadHouses);
 
 		/**
-		  * Save a map.
-		  * \returns true if the map was saved successfully
+		  * Queue a save of every house on the database workers.
+		  * \param callback called on the dispatcher as each house is written
+		  * \returns the number of houses queued
 		  */
-		static bool save();
+		static size_t save(const std::function<void(bool)>& callback);
 
 		/**
 		  * Get a single tile.
@@ -18,6 +18,7 @@
 #include "game.h"
 #include "spells.h"
 #include "configmanager.h"
+#include "objectpool.h"
 
 extern ConfigManager g_config;
 extern Game g_game;
@@ -28,6 +29,22 @@ int32_t Monster::despawnRadius;
 
 uint32_t Monster::monsterAutoID = 0x40000000;
 
+static ObjectPool& getMonsterPool()
+{
+	static ObjectPool& pool = ObjectPool::create("Monster", sizeof(Monster));
+	return pool;
+}
+
+void* Monster::operator new(size_t size)
+{
+	return getMonsterPool().allocate(size);
+}
+
+void Monster::operator delete(void* object, size_t size)
+{
+	getMonsterPool().deallocate(object, size);
+}
+
 Monster* Monster::createMonster(const std::string& name)
 {
 	MonsterType* mType = g_monsters.getMonsterType(name);
@@ -44,6 +44,10 @@ class Monster final : public Creature
 		explicit Monster(MonsterType* mtype);
 		~Monster();
 
+		// allocated from the monster pool
+		static void* operator new(size_t size);
+		static void operator delete(void* object, size_t size);
+
 		// non-copyable
 		Monster(const Monster&) = delete;
 		Monster& operator=(const Monster&) = delete;
@@ -40,61 +40,133 @@ uint32_t Monsters::getLootRandom()
 	return uniform_random(0, MAX_LOOTCHANCE);
 }
 
-void MonsterType::createLoot(Container* corpse)
+void MonsterType::compileLoot()
 {
-	if (g_config.getNumber(ConfigManager::RATE_LOOT) == 0) {
-		corpse->startDecaying();
-		return;
-	}
+	CompiledLoot& loot = info.compiledLoot;
+	loot.lootRate = g_config.getNumber(ConfigManager::RATE_LOOT);
+	loot.moneyRate = g_config.getNumber(ConfigManager::MONEY_RATE);
+	loot.blocks.clear();
 
-	Item* bagItem = Item::CreateItem(2853, 1);
-	if (!bagItem) {
-		return;
+	// top level loot is rolled last to first
+	for (auto it = info.lootItems.rbegin(), end = info.lootItems.rend(); it != end; ++it) {
+		compileLootBlock(*it);
 	}
+	loot.blocks.shrink_to_fit();
+}
 
-	Container* bagContainer = bagItem->getContainer();
-	if (!bagContainer) {
-		return;
+void MonsterType::compileLootBlock(const LootBlock& lootBlock)
+{
+	CompiledLoot& loot = info.compiledLoot;
+	const ItemType& itemType = Item::items[lootBlock.id];
+
+	CompiledLootBlock compiled;
+	compiled.block = &lootBlock;
+	compiled.threshold = loot.lootRate * lootBlock.chance;
+	compiled.countMax = lootBlock.countmax + 1;
+	compiled.next = 0;
+	compiled.id = lootBlock.id;
+	compiled.stackable = itemType.stackable;
+	compiled.bagLoot = itemType.weaponType != WEAPON_NONE || itemType.stopTime || itemType.decayTime;
+	if (compiled.stackable && lootBlock.id == 3031) {
+		compiled.countMax *= loot.moneyRate;
 	}
 
-	if (g_game.internalAddItem(corpse, bagItem) != RETURNVALUE_NOERROR) {
-		corpse->internalAddThing(bagItem);
+	const uint32_t index = loot.blocks.size();
+	loot.blocks.push_back(compiled);
+	for (const LootBlock& childBlock : lootBlock.childLoot) {
+		compileLootBlock(childBlock);
 	}
+	loot.blocks[index].next = loot.blocks.size();
+}
 
-	bool includeBagLoot = false;
-	for (auto it = info.lootItems.rbegin(), end = info.lootItems.rend(); it != end; ++it) {
-		std::vector<Item*> itemList = createLootItem(*it);
-		if (itemList.empty()) {
-			continue;
+static bool addLootItem(std::vector<Item*>& itemList, Item* item, size_t capacity)
+{
+	// stack the same way Game::internalAddItem would, newest stack first
+	if (item->isStackable() && g_config.getBoolean(ConfigManager::STACK_CUMULATIVES)) {
+		for (auto it = itemList.rbegin(), end = itemList.rend(); it != end; ++it) {
+			Item* stackItem = *it;
+			if (stackItem->getItemCount() >= 100 || !stackItem->equals(item)) {
+				continue;
+			}
+
+			uint8_t n = std::min<uint32_t>(100 - stackItem->getItemCount(), item->getItemCount());
+			stackItem->setItemCount(stackItem->getItemCount() + n);
+			if (n == item->getItemCount()) {
+				delete item;
+				return true;
+			}
+
+			item->setItemCount(item->getItemCount() - n);
+			break;
 		}
+	}
+
+	if (itemList.size() >= capacity) {
+		return false;
+	}
+
+	itemList.push_back(item);
+	return true;
+}
 
+void MonsterType::createLoot(Container* corpse)
+{
+	CompiledLoot& loot = info.compiledLoot;
+	if (loot.lootRate != g_config.getNumber(ConfigManager::RATE_LOOT) || loot.moneyRate != g_config.getNumber(ConfigManager::MONEY_RATE)) {
+		compileLoot();
+	}
+
+	if (loot.lootRate == 0) {
+		corpse->startDecaying();
+		return;
+	}
+
+	// the corpse was put on the map in this same dispatcher task, so nobody can
+	// have it open yet: the loot is gathered detached and added without going
+	// through the add queries or sending container updates
+	const uint16_t bagId = 2853;
+	const size_t bagCapacity = Item::items[bagId].maxItems;
+
+	std::vector<Item*> itemList, bagItems, corpseItems;
+	const std::vector<CompiledLootBlock>& blocks = loot.blocks;
+	for (uint32_t index = 0, size = blocks.size(); index != size; index = blocks[index].next) {
+		const CompiledLootBlock& lootBlock = blocks[index];
+
+		itemList.clear();
+		createLootItem(lootBlock, itemList);
 		for (Item* item : itemList) {
 			//check containers
 			if (Container* container = item->getContainer()) {
-				if (!createLootContainer(container, *it)) {
+				if (!createLootContainer(container, index)) {
 					delete container;
 					continue;
 				}
 			}
 
-			const ItemType& itemType = Item::items[item->getID()];
-			if (itemType.weaponType != WEAPON_NONE ||
-				itemType.stopTime ||
-				itemType.decayTime) {
-				includeBagLoot = true;
-				if (g_game.internalAddItem(bagContainer, item) != RETURNVALUE_NOERROR) {
-					corpse->internalAddThing(item);
-				}
-			} else {
-				if (g_game.internalAddItem(corpse, item) != RETURNVALUE_NOERROR) {
-					corpse->internalAddThing(item);
-				}
+			if (!lootBlock.bagLoot || !addLootItem(bagItems, item, bagCapacity)) {
+				addLootItem(corpseItems, item, std::numeric_limits<size_t>::max());
+			}
+		}
+	}
+
+	if (!bagItems.empty()) {
+		Item* bagItem = Item::CreateItem(bagId, 1);
+		Container* bagContainer = bagItem ? bagItem->getContainer() : nullptr;
+		if (bagContainer) {
+			for (Item* item : bagItems) {
+				bagContainer->internalAddThing(item);
+			}
+			corpse->internalAddThing(bagItem);
+		} else {
+			delete bagItem;
+			for (Item* item : bagItems) {
+				corpse->internalAddThing(item);
 			}
 		}
 	}
 
-	if (!includeBagLoot) {
-		g_game.internalRemoveItem(bagItem);
+	for (Item* item : corpseItems) {
+		corpse->internalAddThing(item);
 	}
 
 	if (g_config.getBoolean(ConfigManager::SHOW_MONSTER_LOOT)) {
@@ -116,27 +188,20 @@ void MonsterType::createLoot(Container* corpse)
 	corpse->startDecaying();
 }
 
-std::vector<Item*> MonsterType::createLootItem(const LootBlock& lootBlock)
+void MonsterType::createLootItem(const CompiledLootBlock& lootBlock, std::vector<Item*>& itemList)
 {
 	int32_t itemCount = 0;
 
 	uint32_t randvalue = Monsters::getLootRandom();
-	uint32_t extraMoney = g_config.getNumber(ConfigManager::MONEY_RATE);
-	uint32_t countMax = lootBlock.countmax + 1;
-
-	if (randvalue < g_config.getNumber(ConfigManager::RATE_LOOT) * lootBlock.chance) {
-		if (Item::items[lootBlock.id].stackable) {
-			if (lootBlock.id == 3031) {
-				countMax *= extraMoney;
-			}
-
-			itemCount = randvalue % countMax;
+	if (randvalue < lootBlock.threshold) {
+		if (lootBlock.stackable) {
+			itemCount = randvalue % lootBlock.countMax;
 		} else {
 			itemCount = 1;
 		}
 	}
 
-	std::vector<Item*> itemList;
+	const LootBlock& block = *lootBlock.block;
 	while (itemCount > 0) {
 		uint16_t n = static_cast<uint16_t>(std::min<int32_t>(itemCount, 100));
 		Item* tmpItem = Item::CreateItem(lootBlock.id, n);
@@ -146,35 +211,37 @@ std::vector<Item*> MonsterType::createLootItem(const LootBlock& lootBlock)
 
 		itemCount -= n;
 
-		if (lootBlock.subType != -1) {
-			tmpItem->setSubType(lootBlock.subType);
+		if (block.subType != -1) {
+			tmpItem->setSubType(block.subType);
 		}
 
-		if (lootBlock.actionId != -1) {
-			tmpItem->setActionId(lootBlock.actionId);
+		if (block.actionId != -1) {
+			tmpItem->setActionId(block.actionId);
 		}
 
-		if (!lootBlock.text.empty()) {
-			tmpItem->setText(lootBlock.text);
+		if (!block.text.empty()) {
+			tmpItem->setText(block.text);
 		}
 
 		itemList.push_back(tmpItem);
 	}
-	return itemList;
 }
 
-bool MonsterType::createLootContainer(Container* parent, const LootBlock& lootblock)
+bool MonsterType::createLootContainer(Container* parent, uint32_t index)
 {
-	auto it = lootblock.childLoot.begin(), end = lootblock.childLoot.end();
+	const std::vector<CompiledLootBlock>& blocks = info.compiledLoot.blocks;
+	uint32_t it = index + 1, end = blocks[index].next;
 	if (it == end) {
 		return true;
 	}
 
-	for (; it != end && parent->size() < parent->capacity(); ++it) {
-		auto itemList = createLootItem(*it);
+	std::vector<Item*> itemList;
+	for (; it != end && parent->size() < parent->capacity(); it = blocks[it].next) {
+		itemList.clear();
+		createLootItem(blocks[it], itemList);
 		for (Item* tmpItem : itemList) {
 			if (Container* container = tmpItem->getContainer()) {
-				if (!createLootContainer(container, *it)) {
+				if (!createLootContainer(container, it)) {
 					delete container;
 				} else {
 					parent->internalAddThing(container);
@@ -999,6 +1066,7 @@ bool Monsters::loadMonster(const std::string& file, const std::string& monsterNa
 	mType->info.defenseSpells.shrink_to_fit();
 	mType->info.voiceVector.shrink_to_fit();
 	mType->info.scripts.shrink_to_fit();
+	mType->compileLoot();
 	return true;
 }
 
@@ -41,6 +41,24 @@ struct LootBlock {
 	}
 };
 
+// a LootBlock with the loot and money rates applied; child loot follows its
+// container block in the same vector
+struct CompiledLootBlock {
+	const LootBlock* block; // subType, actionId and text
+	uint32_t threshold; // drops while the loot roll is below this
+	uint32_t countMax;
+	uint32_t next; // index past this block's child loot
+	uint16_t id;
+	bool stackable;
+	bool bagLoot; // weapons and items that decay go into a bag
+};
+
+struct CompiledLoot {
+	std::vector<CompiledLootBlock> blocks;
+	int32_t lootRate = -1;
+	int32_t moneyRate = -1;
+};
+
 struct summonBlock_t {
 	std::string name;
 	uint32_t chance;
@@ -91,6 +109,7 @@ class MonsterType
 		std::vector<voiceBlock_t> voiceVector;
 
 		std::vector<LootBlock> lootItems;
+		CompiledLoot compiledLoot;
 		std::vector<std::string> scripts;
 		std::vector<spellBlock_t> attackSpells;
 		std::vector<spellBlock_t> defenseSpells;
@@ -155,9 +174,13 @@ class MonsterType
 
 		MonsterInfo info;
 
+		void compileLoot();
 		void createLoot(Container* corpse);
-		bool createLootContainer(Container* parent, const LootBlock& lootblock);
-		std::vector<Item*> createLootItem(const LootBlock& lootBlock);
+		bool createLootContainer(Container* parent, uint32_t index);
+		void createLootItem(const CompiledLootBlock& lootBlock, std::vector<Item*>& itemList);
+
+	private:
+		void compileLootBlock(const LootBlock& lootBlock);
 };
 
 class Monsters
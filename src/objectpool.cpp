@@ -0,0 +1,132 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#include "otpch.h"
+
+#include "objectpool.h"
+
+// slabs are about this big, or one object for bigger objects
+static constexpr size_t SLAB_SIZE = 64 * 1024;
+
+static std::mutex poolsLock;
+
+static std::vector<ObjectPool*>& getPools()
+{
+	static std::vector<ObjectPool*>& pools = *new std::vector<ObjectPool*>();
+	return pools;
+}
+
+static size_t getStride(size_t objectSize)
+{
+	const size_t alignment = alignof(std::max_align_t);
+	return (std::max(objectSize, sizeof(void*)) + alignment - 1) / alignment * alignment;
+}
+
+ObjectPool::ObjectPool(std::string name, size_t objectSize) :
+	name(std::move(name)), objectSize(objectSize), stride(getStride(objectSize)) {}
+
+ObjectPool& ObjectPool::create(std::string name, size_t objectSize)
+{
+	ObjectPool* pool = new ObjectPool(std::move(name), objectSize);
+
+	std::lock_guard<std::mutex> lockClass(poolsLock);
+	getPools().push_back(pool);
+	return *pool;
+}
+
+void* ObjectPool::allocate(size_t size)
+{
+	std::lock_guard<std::mutex> lockClass(lock);
+	if (size != objectSize) {
+		++fallbacks;
+		return ::operator new(size);
+	}
+
+	if (!freeList) {
+		addSlab();
+	}
+
+	FreeObject* object = freeList;
+	freeList = object->next;
+
+	++allocations;
+	if (++inUse > peakInUse) {
+		peakInUse = inUse;
+	}
+	return object;
+}
+
+void ObjectPool::deallocate(void* object, size_t size)
+{
+	if (!object) {
+		return;
+	}
+
+	if (size != objectSize) {
+		::operator delete(object);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lockClass(lock);
+	FreeObject* freeObject = static_cast<FreeObject*>(object);
+	freeObject->next = freeList;
+	freeList = freeObject;
+	--inUse;
+}
+
+void ObjectPool::addSlab()
+{
+	const size_t objects = std::max<size_t>(1, SLAB_SIZE / stride);
+	char* slab = static_cast<char*>(::operator new(objects * stride));
+	slabs.push_back(slab);
+
+	// threaded back to front so objects are handed out in address order
+	for (size_t i = objects; i-- > 0; ) {
+		FreeObject* object = reinterpret_cast<FreeObject*>(slab + i * stride);
+		object->next = freeList;
+		freeList = object;
+	}
+}
+
+ObjectPoolStats ObjectPool::getStats() const
+{
+	std::lock_guard<std::mutex> lockClass(lock);
+
+	ObjectPoolStats stats;
+	stats.name = name;
+	stats.objectSize = objectSize;
+	stats.inUse = inUse;
+	stats.peakInUse = peakInUse;
+	stats.capacity = slabs.size() * std::max<size_t>(1, SLAB_SIZE / stride);
+	stats.allocations = allocations;
+	stats.fallbacks = fallbacks;
+	return stats;
+}
+
+std::vector<ObjectPoolStats> ObjectPool::getAllStats()
+{
+	std::vector<ObjectPool*> pools;
+	{
+		std::lock_guard<std::mutex> lockClass(poolsLock);
+		pools = getPools();
+	}
+
+	std::vector<ObjectPoolStats> stats;
+	stats.reserve(pools.size());
+	for (const ObjectPool* pool : pools) {
+		stats.push_back(pool->getStats());
+	}
+	return stats;
+}
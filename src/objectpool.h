@@ -0,0 +1,81 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#ifndef FS_OBJECTPOOL_H_6D1F8B3A5C7E4A2D9B0E1C3F5A7D9B2E
+#define FS_OBJECTPOOL_H_6D1F8B3A5C7E4A2D9B0E1C3F5A7D9B2E
+
+struct ObjectPoolStats {
+	std::string name;
+	size_t objectSize;
+	uint64_t inUse;
+	uint64_t peakInUse;
+	uint64_t capacity;
+	uint64_t allocations;
+	uint64_t fallbacks; // derived types without a pool of their own
+};
+
+/**
+ * Fixed size objects carved out of slabs, with a free list per type.
+ *
+ * A pooled class routes its operator new and delete here. Classes derived
+ * from it that are bigger and have no pool of their own fall back to the
+ * global heap, the size the operators are given tells them apart. Freed
+ * objects go back to the free list and slabs are kept for the uptime, so
+ * long uptimes reuse the same memory instead of fragmenting the heap.
+ *
+ * Items are also created and freed on the database workers, every call
+ * takes the lock. Pools are never destroyed, objects may outlive static
+ * destruction.
+ */
+class ObjectPool
+{
+	public:
+		// pools are registered for the statistics and never destroyed
+		static ObjectPool& create(std::string name, size_t objectSize);
+
+		// non-copyable
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		void* allocate(size_t size);
+		void deallocate(void* object, size_t size);
+
+		ObjectPoolStats getStats() const;
+		static std::vector<ObjectPoolStats> getAllStats();
+
+	private:
+		ObjectPool(std::string name, size_t objectSize);
+
+		struct FreeObject {
+			FreeObject* next;
+		};
+
+		void addSlab();
+
+		const std::string name;
+		const size_t objectSize;
+		const size_t stride;
+
+		mutable std::mutex lock;
+		FreeObject* freeList = nullptr;
+		std::vector<char*> slabs;
+
+		uint64_t inUse = 0;
+		uint64_t peakInUse = 0;
+		uint64_t allocations = 0;
+		uint64_t fallbacks = 0;
+};
+
+#endif
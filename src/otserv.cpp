@@ -30,6 +30,8 @@
 #include "databasemanager.h"
 #include "scheduler.h"
 #include "databasetasks.h"
+#include "journal.h"
+#include "logincache.h"
 
 DatabaseTasks g_databaseTasks;
 Dispatcher g_dispatcher;
@@ -110,6 +112,10 @@ int main(int argc, char* argv[])
 	g_scheduler.join();
 	g_databaseTasks.join();
 	g_dispatcher.join();
+
+	// every save has been written or has failed by now
+	g_journal.shutdown();
+	g_journal.join();
 	return 0;
 }
 
@@ -180,7 +186,17 @@ void mainLoader(int, char*[], ServiceManager* services)
 		startupErrorMessage("The database you have specified in config.lua is empty, please import the schema.sql to your database.");
 		return;
 	}
-	g_databaseTasks.start();
+	if (!g_databaseTasks.start()) {
+		startupErrorMessage("Failed to connect the database workers.");
+		return;
+	}
+
+	if (!g_journal.open()) {
+		startupErrorMessage("Failed to restore the player journal.");
+		return;
+	}
+
+	g_loginCache.load();
 
 	if (g_config.getBoolean(ConfigManager::OPTIMIZE_DATABASE) && !DatabaseManager::optimizeTables()) {
 		std::cout << "> No tables were optimized." << std::endl;
@@ -273,5 +289,6 @@ void mainLoader(int, char*[], ServiceManager* services)
 
 	g_game.start(services);
 	g_game.setGameState(GAME_STATE_NORMAL);
+	ProtocolStatus::updateStatusCache();
 	g_loaderSignal.notify_all();
 }
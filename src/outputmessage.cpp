@@ -17,9 +17,6 @@
 #include "outputmessage.h"
 #include "protocol.h"
 #include "lockfree.h"
-#include "scheduler.h"
-
-extern Scheduler g_scheduler;
 
 const uint16_t OUTPUTMESSAGE_FREE_LIST_CAPACITY = 2048;
 const std::chrono::milliseconds OUTPUTMESSAGE_AUTOSEND_DELAY {10};
@@ -32,12 +29,6 @@ class OutputMessageAllocator
 		struct rebind {typedef LockfreePoolingAllocator<U, OUTPUTMESSAGE_FREE_LIST_CAPACITY> other;};
 };
 
-void OutputMessagePool::scheduleSendAll()
-{
-	auto functor = std::bind(&OutputMessagePool::sendAll, this);
-	g_scheduler.addEvent(createSchedulerTask(OUTPUTMESSAGE_AUTOSEND_DELAY.count(), functor));
-}
-
 void OutputMessagePool::sendAll()
 {
 	//dispatcher thread
@@ -47,9 +38,18 @@ void OutputMessagePool::sendAll()
 			protocol->send(std::move(msg));
 		}
 	}
+	bufferedProtocols.clear();
+}
+
+void OutputMessagePool::flush(bool queueEmpty)
+{
+	//dispatcher thread
+	if (bufferedProtocols.empty()) {
+		return;
+	}
 
-	if (!bufferedProtocols.empty()) {
-		scheduleSendAll();
+	if (queueEmpty || (OTSYS_TIME() - oldestBufferTime) >= OUTPUTMESSAGE_AUTOSEND_DELAY.count()) {
+		sendAll();
 	}
 }
 
@@ -57,9 +57,9 @@ void OutputMessagePool::addProtocolToAutosend(Protocol_ptr protocol)
 {
 	//dispatcher thread
 	if (bufferedProtocols.empty()) {
-		scheduleSendAll();
+		oldestBufferTime = OTSYS_TIME();
 	}
-	bufferedProtocols.emplace_back(protocol);
+	bufferedProtocols.emplace_back(std::move(protocol));
 }
 
 void OutputMessagePool::removeProtocolFromAutosend(const Protocol_ptr& protocol)
@@ -67,6 +67,7 @@ void OutputMessagePool::removeProtocolFromAutosend(const Protocol_ptr& protocol)
 	//dispatcher thread
 	auto it = std::find(bufferedProtocols.begin(), bufferedProtocols.end(), protocol);
 	if (it != bufferedProtocols.end()) {
+		protocol->getCurrentBuffer().reset();
 		std::swap(*it, bufferedProtocols.back());
 		bufferedProtocols.pop_back();
 	}
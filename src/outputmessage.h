@@ -82,7 +82,11 @@ class OutputMessagePool
 		}
 
 		void sendAll();
-		void scheduleSendAll();
+
+		// Called by the dispatcher after each task. Pending buffers are sent once
+		// the task queue has drained, or earlier if the oldest one has waited
+		// longer than the autosend delay while the dispatcher stays busy.
+		void flush(bool queueEmpty);
 
 		static OutputMessage_ptr getOutputMessage();
 
@@ -90,9 +94,10 @@ class OutputMessagePool
 		void removeProtocolFromAutosend(const Protocol_ptr& protocol);
 	private:
 		OutputMessagePool() = default;
-		//NOTE: A vector is used here because this container is mostly read
-		//and relatively rarely modified (only when a client connects/disconnects)
+		//NOTE: only protocols with a pending output buffer are kept here, each
+		//one at most once; the list is emptied on every flush
 		std::vector<Protocol_ptr> bufferedProtocols;
+		int64_t oldestBufferTime = 0;
 };
 
 
@@ -553,22 +553,15 @@ uint16_t Player::getLookCorpse() const
 
 void Player::addStorageValue(const uint32_t key, const int32_t value)
 {
-	if (value != -1) {
-		storageMap[key] = value;
-	} else {
-		storageMap.erase(key);
-	}
+	storage.set(key, value);
 }
 
 bool Player::getStorageValue(const uint32_t key, int32_t& value) const
 {
-	auto it = storageMap.find(key);
-	if (it == storageMap.end()) {
+	if (!storage.get(key, value)) {
 		value = 0;
 		return false;
 	}
-
-	value = it->second;
 	return true;
 }
 
@@ -972,19 +965,21 @@ void Player::onRemoveCreature(Creature* creature, bool isLogout)
 			guild->removeMember(this);
 		}
 
-		IOLoginData::updateOnlineStatus(guid, false);
-
-		bool saved = false;
-		for (uint32_t tries = 0; tries < 3; ++tries) {
-			if (IOLoginData::savePlayer(this)) {
-				saved = true;
-				break;
+		// decay is paused while offline, the save keeps the time left
+		for (int32_t slot = CONST_SLOT_FIRST; slot <= CONST_SLOT_LAST; ++slot) {
+			Item* item = inventory[slot];
+			if (item) {
+				g_game.stopDecay(item);
 			}
 		}
 
-		if (!saved) {
-			std::cout << "Error while saving player: " << getName() << std::endl;
+		for (const auto& it : depotLockerMap) {
+			g_game.stopDecay(it.second);
 		}
+
+		IOLoginData::updateOnlineStatus(guid, false);
+
+		IOLoginData::savePlayer(this);
 	}
 }
 
@@ -1187,6 +1182,10 @@ void Player::onThink(uint32_t interval)
 
 	sendPing();
 
+	if (client) {
+		client->sendDeferredUpdates();
+	}
+
 	MessageBufferTicks += interval;
 	if (MessageBufferTicks >= 1500) {
 		MessageBufferTicks = 0;
@@ -2565,6 +2564,15 @@ uint32_t Player::getItemTypeCount(uint16_t itemId, int32_t subType /*= -1*/) con
 		}
 
 		if (Container* container = item->getContainer()) {
+			if (subType == -1) {
+				count += container->getHeldItemCount(itemId);
+				continue;
+			}
+
+			if (container->getHeldItemCount(itemId) == 0) {
+				continue;
+			}
+
 			for (ContainerIterator it = container->iterator(); it.hasNext(); it.advance()) {
 				if ((*it)->getID() == itemId) {
 					count += Item::countByType(*it, subType);
@@ -2620,6 +2628,10 @@ bool Player::removeItemOfType(uint16_t itemId, uint32_t amount, int32_t subType,
 				}
 			}
 
+			if (container->getHeldItemCount(itemId) == 0) {
+				continue;
+			}
+
 			for (ContainerIterator it = container->iterator(); it.hasNext(); it.advance()) {
 				Item* containerItem = *it;
 				if (containerItem->getID() == itemId) {
@@ -2653,8 +2665,8 @@ std::map<uint32_t, uint32_t>& Player::getAllItemTypeCount(std::map<uint32_t, uin
 		countMap[item->getID()] += Item::countByType(item, -1);
 
 		if (Container* container = item->getContainer()) {
-			for (ContainerIterator it = container->iterator(); it.hasNext(); it.advance()) {
-				countMap[(*it)->getID()] += Item::countByType(*it, -1);
+			for (const auto& heldItemCount : container->getHeldItemCounts()) {
+				countMap[heldItemCount.first] += heldItemCount.second;
 			}
 		}
 	}
@@ -3409,6 +3421,7 @@ void Player::addUnjustifiedDead(const Player* attacked)
 
 	// current unjustified kill!
 	murderTimeStamps.push_back(std::time(nullptr));
+	murdersModified = true;
 
 	sendTextMessage(MESSAGE_STATUS_WARNING, "Warning! The murder of " + attacked->getName() + " was not justified.");
 
@@ -3492,12 +3505,14 @@ void Player::learnInstantSpell(const std::string& spellName)
 {
 	if (!hasLearnedInstantSpell(spellName)) {
 		learnedInstantSpellList.push_front(spellName);
+		spellsModified = true;
 	}
 }
 
 void Player::forgetInstantSpell(const std::string& spellName)
 {
 	learnedInstantSpellList.remove(spellName);
+	spellsModified = true;
 }
 
 bool Player::hasLearnedInstantSpell(const std::string& spellName) const
@@ -3645,35 +3660,19 @@ void Player::sendClosePrivate(uint16_t channelId)
 
 uint64_t Player::getMoney() const
 {
-	std::vector<const Container*> containers;
 	uint64_t moneyCount = 0;
-
 	for (int32_t i = CONST_SLOT_FIRST; i <= CONST_SLOT_LAST; ++i) {
 		Item* item = inventory[i];
 		if (!item) {
 			continue;
 		}
 
-		const Container* container = item->getContainer();
-		if (container) {
-			containers.push_back(container);
+		if (const Container* container = item->getContainer()) {
+			moneyCount += container->getHeldWorth();
 		} else {
 			moneyCount += item->getWorth();
 		}
 	}
-
-	size_t i = 0;
-	while (i < containers.size()) {
-		const Container* container = containers[i++];
-		for (const Item* item : container->getItemList()) {
-			const Container* tmpContainer = item->getContainer();
-			if (tmpContainer) {
-				containers.push_back(tmpContainer);
-			} else {
-				moneyCount += item->getWorth();
-			}
-		}
-	}
 	return moneyCount;
 }
 
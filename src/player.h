@@ -27,6 +27,7 @@
 #include "guild.h"
 #include "groups.h"
 #include "town.h"
+#include "playerstorage.h"
 
 class BehaviourDatabase;
 class House;
@@ -263,6 +264,10 @@ class Player final : public Creature, public Cylinder
 		void addStorageValue(const uint32_t key, const int32_t value);
 		bool getStorageValue(const uint32_t key, int32_t& value) const;
 
+		void incrementInventoryGeneration() {
+			++inventoryGeneration;
+		}
+
 		void setGroup(Group* newGroup) {
 			group = newGroup;
 		}
@@ -948,7 +953,7 @@ class Player final : public Creature, public Cylinder
 
 		std::map<uint8_t, OpenContainer> openContainers;
 		std::map<uint32_t, DepotLocker*> depotLockerMap;
-		std::map<uint32_t, int32_t> storageMap;
+		PlayerStorage storage;
 
 		std::vector<OutfitEntry> outfits;
 		GuildWarList guildWarList;
@@ -959,6 +964,14 @@ class Player final : public Creature, public Cylinder
 
 		std::list<time_t> murderTimeStamps;
 
+		// what changed since the last save, see IOLoginData::snapshotPlayer
+		std::map<uint32_t, uint32_t> savedDepotGenerations;
+		uint32_t inventoryGeneration = 0;
+		uint32_t savedInventoryGeneration = 0;
+		bool spellsModified = false;
+		bool murdersModified = false;
+		bool fullSaveRequired = false;
+
 		std::string name;
 		std::string guildNick;
 
@@ -1087,6 +1100,7 @@ class Player final : public Creature, public Cylinder
 		friend class Map;
 		friend class Actions;
 		friend class IOLoginData;
+		friend class PlayerJournal;
 		friend class ProtocolGame;
 		friend class BehaviourDatabase;
 		friend class ConjureSpell;
@@ -0,0 +1,177 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#include "otpch.h"
+
+#include "playerstorage.h"
+
+size_t PlayerStorage::find(uint32_t key) const
+{
+	// branchless lower bound, the keys are searched on every quest check
+	size_t size = keys.size();
+	if (size == 0) {
+		return 0;
+	}
+
+	const uint32_t* base = keys.data();
+	while (size > 1) {
+		size_t half = size / 2;
+		base = base[half] < key ? base + half : base;
+		size -= half;
+	}
+	return (base - keys.data()) + (*base < key);
+}
+
+bool PlayerStorage::get(uint32_t key, int32_t& value) const
+{
+	size_t index = find(key);
+	if (index == keys.size() || keys[index] != key || (flags[index] & REMOVED)) {
+		return false;
+	}
+
+	value = values[index];
+	return true;
+}
+
+bool PlayerStorage::set(uint32_t key, int32_t value)
+{
+	size_t index = find(key);
+	const bool found = index != keys.size() && keys[index] == key;
+
+	if (value == -1) {
+		if (!found || (flags[index] & REMOVED)) {
+			return false;
+		}
+
+		flags[index] |= REMOVED;
+		++removedEntries;
+	} else if (found) {
+		if (flags[index] & REMOVED) {
+			flags[index] &= ~REMOVED;
+			--removedEntries;
+		} else if (values[index] == value) {
+			return false;
+		}
+		values[index] = value;
+	} else {
+		keys.insert(keys.begin() + index, key);
+		values.insert(values.begin() + index, value);
+		flags.insert(flags.begin() + index, 0);
+	}
+
+	setChanged(index);
+	return true;
+}
+
+void PlayerStorage::setChanged(size_t index)
+{
+	uint8_t& entryFlags = flags[index];
+	if (!(entryFlags & CHANGE_SAVE)) {
+		entryFlags |= CHANGE_SAVE;
+		++changedEntries[getChangeIndex(CHANGE_SAVE)];
+	}
+
+	if (!(entryFlags & CHANGE_JOURNAL)) {
+		entryFlags |= CHANGE_JOURNAL;
+		++changedEntries[getChangeIndex(CHANGE_JOURNAL)];
+	}
+}
+
+void PlayerStorage::load(const std::vector<std::pair<uint32_t, int32_t>>& storage)
+{
+	std::vector<std::pair<uint32_t, int32_t>> sorted;
+	sorted.reserve(storage.size());
+	for (const auto& it : storage) {
+		if (it.second != -1) {
+			sorted.push_back(it);
+		}
+	}
+	std::sort(sorted.begin(), sorted.end());
+
+	keys.clear();
+	values.clear();
+	keys.reserve(sorted.size());
+	values.reserve(sorted.size());
+	for (const auto& it : sorted) {
+		keys.push_back(it.first);
+		values.push_back(it.second);
+	}
+	flags.assign(sorted.size(), 0);
+
+	changedEntries[0] = changedEntries[1] = 0;
+	removedEntries = 0;
+}
+
+void PlayerStorage::getValues(std::vector<std::pair<uint32_t, int32_t>>& storage) const
+{
+	storage.reserve(storage.size() + size());
+	for (size_t index = 0, size = keys.size(); index < size; ++index) {
+		if (!(flags[index] & REMOVED)) {
+			storage.emplace_back(keys[index], values[index]);
+		}
+	}
+}
+
+void PlayerStorage::getChanges(Change_t change, std::vector<std::pair<uint32_t, int32_t>>& storage, std::vector<uint32_t>& removedKeys) const
+{
+	if (!hasChanges(change)) {
+		return;
+	}
+
+	for (size_t index = 0, size = keys.size(); index < size; ++index) {
+		if (!(flags[index] & change)) {
+			continue;
+		}
+
+		if (flags[index] & REMOVED) {
+			removedKeys.push_back(keys[index]);
+		} else {
+			storage.emplace_back(keys[index], values[index]);
+		}
+	}
+}
+
+void PlayerStorage::clearChanges(Change_t change)
+{
+	uint32_t& changed = changedEntries[getChangeIndex(change)];
+	if (changed == 0) {
+		return;
+	}
+
+	for (uint8_t& entryFlags : flags) {
+		entryFlags &= ~change;
+	}
+	changed = 0;
+
+	// tombstones both the save and the journal have written are dropped
+	if (removedEntries != 0) {
+		size_t size = 0;
+		for (size_t index = 0; index < keys.size(); ++index) {
+			if (flags[index] == REMOVED) {
+				continue;
+			}
+
+			keys[size] = keys[index];
+			values[size] = values[index];
+			flags[size] = flags[index];
+			++size;
+		}
+
+		removedEntries -= keys.size() - size;
+		keys.resize(size);
+		values.resize(size);
+		flags.resize(size);
+	}
+}
@@ -0,0 +1,71 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#ifndef FS_PLAYERSTORAGE_H_ECD15BA09CF848C4BE26D24ABC8ED734
+#define FS_PLAYERSTORAGE_H_ECD15BA09CF848C4BE26D24ABC8ED734
+
+/**
+ * A player's storage values, in flat arrays sorted by key. The keys are kept
+ * apart from the values so a lookup only searches the keys.
+ *
+ * Every entry remembers whether the next save and the next journal record
+ * still have to write it, so neither has to keep a set of keys of its own.
+ * Erased keys stay behind as tombstones until both have written them.
+ * Setting a value of -1 erases the key, as it always has.
+ */
+class PlayerStorage
+{
+	public:
+		enum Change_t : uint8_t {
+			CHANGE_SAVE = 1 << 0,
+			CHANGE_JOURNAL = 1 << 1,
+		};
+
+		bool get(uint32_t key, int32_t& value) const;
+		bool set(uint32_t key, int32_t value);
+
+		// replaces everything without marking it changed, for loading
+		void load(const std::vector<std::pair<uint32_t, int32_t>>& storage);
+
+		size_t size() const {
+			return keys.size() - removedEntries;
+		}
+
+		void getValues(std::vector<std::pair<uint32_t, int32_t>>& storage) const;
+
+		bool hasChanges(Change_t change) const {
+			return changedEntries[getChangeIndex(change)] != 0;
+		}
+		void getChanges(Change_t change, std::vector<std::pair<uint32_t, int32_t>>& storage, std::vector<uint32_t>& removedKeys) const;
+		void clearChanges(Change_t change);
+
+	private:
+		static constexpr uint8_t REMOVED = 1 << 2;
+
+		static size_t getChangeIndex(Change_t change) {
+			return change == CHANGE_SAVE ? 0 : 1;
+		}
+
+		size_t find(uint32_t key) const;
+		void setChanged(size_t index);
+
+		std::vector<uint32_t> keys;
+		std::vector<int32_t> values;
+		std::vector<uint8_t> flags;
+		uint32_t changedEntries[2] = {};
+		uint32_t removedEntries = 0;
+};
+
+#endif
@@ -46,6 +46,7 @@ OutputMessage_ptr Protocol::getOutputBuffer(int32_t size)
 	//dispatcher thread
 	if (!outputBuffer) {
 		outputBuffer = OutputMessagePool::getOutputMessage();
+		OutputMessagePool::getInstance().addProtocolToAutosend(shared_from_this());
 	} else if ((outputBuffer->getLength() + size) > NetworkMessage::MAX_PROTOCOL_BODY_LENGTH) {
 		send(outputBuffer);
 		outputBuffer = OutputMessagePool::getOutputMessage();
@@ -55,37 +56,13 @@ OutputMessage_ptr Protocol::getOutputBuffer(int32_t size)
 
 void Protocol::XTEA_encrypt(OutputMessage& msg) const
 {
-	const uint32_t delta = 0x61C88647;
-
 	// The message must be a multiple of 8
 	size_t paddingBytes = msg.getLength() % 8;
 	if (paddingBytes != 0) {
 		msg.addPaddingBytes(8 - paddingBytes);
 	}
 
-	uint8_t* buffer = msg.getOutputBuffer();
-	const size_t messageLength = msg.getLength();
-	size_t readPos = 0;
-	const uint32_t k[] = {key[0], key[1], key[2], key[3]};
-	while (readPos < messageLength) {
-		uint32_t v0;
-		memcpy(&v0, buffer + readPos, 4);
-		uint32_t v1;
-		memcpy(&v1, buffer + readPos + 4, 4);
-
-		uint32_t sum = 0;
-
-		for (int32_t i = 32; --i >= 0;) {
-			v0 += ((v1 << 4 ^ v1 >> 5) + v1) ^ (sum + k[sum & 3]);
-			sum -= delta;
-			v1 += ((v0 << 4 ^ v0 >> 5) + v0) ^ (sum + k[(sum >> 11) & 3]);
-		}
-
-		memcpy(buffer + readPos, &v0, 4);
-		readPos += 4;
-		memcpy(buffer + readPos, &v1, 4);
-		readPos += 4;
-	}
+	xtea::encrypt(msg.getOutputBuffer(), msg.getLength(), key);
 }
 
 bool Protocol::XTEA_decrypt(NetworkMessage& msg) const
@@ -94,31 +71,7 @@ bool Protocol::XTEA_decrypt(NetworkMessage& msg) const
 		return false;
 	}
 
-	const uint32_t delta = 0x61C88647;
-
-	uint8_t* buffer = msg.getBuffer() + msg.getBufferPosition();
-	const size_t messageLength = (msg.getLength() - 6);
-	size_t readPos = 0;
-	const uint32_t k[] = {key[0], key[1], key[2], key[3]};
-	while (readPos < messageLength) {
-		uint32_t v0;
-		memcpy(&v0, buffer + readPos, 4);
-		uint32_t v1;
-		memcpy(&v1, buffer + readPos + 4, 4);
-
-		uint32_t sum = 0xC6EF3720;
-
-		for (int32_t i = 32; --i >= 0;) {
-			v1 -= ((v0 << 4 ^ v0 >> 5) + v0) ^ (sum + k[(sum >> 11) & 3]);
-			sum += delta;
-			v0 -= ((v1 << 4 ^ v1 >> 5) + v1) ^ (sum + k[sum & 3]);
-		}
-
-		memcpy(buffer + readPos, &v0, 4);
-		readPos += 4;
-		memcpy(buffer + readPos, &v1, 4);
-		readPos += 4;
-	}
+	xtea::decrypt(msg.getBuffer() + msg.getBufferPosition(), msg.getLength() - 2, key);
 
 	int innerLength = msg.get<uint16_t>();
 	if (innerLength > msg.getLength() - 4) {
@@ -16,6 +16,7 @@
 #define FS_PROTOCOL_H_D71405071ACF4137A4B1203899DE80E1
 
 #include "connection.h"
+#include "xtea.h"
 
 class Protocol : public std::enable_shared_from_this<Protocol>
 {
@@ -44,6 +45,13 @@ class Protocol : public std::enable_shared_from_this<Protocol>
 
 		uint32_t getIP() const;
 
+		bool isSendQueueCongested() const {
+			if (auto connection = getConnection()) {
+				return connection->isSendQueueCongested();
+			}
+			return false;
+		}
+
 		//Use this function for autosend messages only
 		OutputMessage_ptr getOutputBuffer(int32_t size);
 
@@ -67,7 +75,7 @@ class Protocol : public std::enable_shared_from_this<Protocol>
 			encryptionEnabled = true;
 		}
 		void setXTEAKey(const uint32_t* key) {
-			memcpy(this->key, key, sizeof(*key) * 4);
+			this->key = xtea::expand_key({{key[0], key[1], key[2], key[3]}});
 		}
 
 		void XTEA_encrypt(OutputMessage& msg) const;
@@ -84,7 +92,7 @@ class Protocol : public std::enable_shared_from_this<Protocol>
 		OutputMessage_ptr outputBuffer;
 	private:
 		const ConnectionWeak_ptr connection;
-		uint32_t key[4] = {};
+		xtea::round_keys key = {};
 		bool encryptionEnabled = false;
 		bool rawMessages = false;
 };
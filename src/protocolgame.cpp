@@ -35,6 +35,12 @@ extern Actions actions;
 extern CreatureEvents* g_creatureEvents;
 extern Chat* g_chat;
 
+// microseconds since start
+static uint64_t getLoginTime(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
 void ProtocolGame::release()
 {
 	//dispatcher thread
@@ -51,6 +57,8 @@ void ProtocolGame::release()
 void ProtocolGame::login(const std::string& name, uint32_t accountId, OperatingSystem_t operatingSystem)
 {
 	//dispatcher thread
+	const std::chrono::steady_clock::time_point loginStart = std::chrono::steady_clock::now();
+
 	Player* foundPlayer = g_game.getPlayerByName(name);
 	if (!foundPlayer || g_config.getBoolean(ConfigManager::ALLOW_CLONES)) {
 		player = new Player(getThis());
@@ -119,27 +127,33 @@ void ProtocolGame::login(const std::string& name, uint32_t accountId, OperatingS
 			return;
 		}
 
-		if (!IOLoginData::loadPlayerByName(player, name)) {
-			disconnectClient("Your character could not be loaded.");
-			return;
-		}
-
-		player->setOperatingSystem(operatingSystem);
-
-		if (!g_game.placeCreature(player, player->getLoginPosition())) {
-			if (!g_game.placeCreature(player, player->getTemplePosition(), false, true)) {
-				disconnectClient("Temple position is wrong. Contact the administrator.");
+		// a save of the character still being written is waited for on the
+		// database workers, the asynchronous load below queues behind it
+		if (!g_config.getBoolean(ConfigManager::ASYNC_PLAYER_LOAD) && !IOLoginData::hasPendingSave(player->getGUID())) {
+			if (!IOLoginData::loadPlayerByName(player, name)) {
+				disconnectClient("Your character could not be loaded.");
 				return;
 			}
+
+			finishLogin(operatingSystem);
+			const uint64_t loginTime = getLoginTime(loginStart);
+			IOLoginData::addLoginTime(loginTime, loginTime, false);
+			return;
 		}
 
-		if (operatingSystem >= CLIENTOS_OTCLIENT_LINUX) {
-			player->registerCreatureEvent("ExtendedOpcode");
+		if (IOLoginData::isPlayerLoading(player->getGUID())) {
+			disconnectClient("You are already logged in.");
+			return;
 		}
 
-		player->lastIP = player->getIP();
-		player->lastLoginSaved = std::max<time_t>(time(nullptr), player->lastLoginSaved + 1);
-		acceptPackets = true;
+		// the rows are read on the database workers, the dispatcher only
+		// hands them to the player once they are all in
+		const uint64_t dispatcherTime = getLoginTime(loginStart);
+		auto thisPtr = getThis();
+		Player* loadingPlayer = player;
+		IOLoginData::loadPlayerData(player->getGUID(), player->getAccount(), [thisPtr, loadingPlayer, operatingSystem, loginStart, dispatcherTime](const std::shared_ptr<PlayerLoadData>& data) {
+			thisPtr->onPlayerLoaded(loadingPlayer, *data, operatingSystem, loginStart, dispatcherTime);
+		});
 	} else {
 		if (eventConnect != 0 || !g_config.getBoolean(ConfigManager::REPLACE_KICK_ON_LOGIN)) {
 			//Already trying to connect
@@ -156,7 +170,50 @@ void ProtocolGame::login(const std::string& name, uint32_t accountId, OperatingS
 			connect(foundPlayer->getID(), operatingSystem);
 		}
 	}
-	OutputMessagePool::getInstance().addProtocolToAutosend(shared_from_this());
+}
+
+void ProtocolGame::onPlayerLoaded(Player* loadingPlayer, PlayerLoadData& data, OperatingSystem_t operatingSystem, std::chrono::steady_clock::time_point loginStart, uint64_t dispatcherTime)
+{
+	//dispatcher thread
+	if (player != loadingPlayer || isConnectionExpired()) {
+		return;
+	}
+
+	const std::chrono::steady_clock::time_point applyStart = std::chrono::steady_clock::now();
+
+	Player* foundPlayer = g_game.getPlayerByGUID(player->getGUID());
+	if (foundPlayer && !g_config.getBoolean(ConfigManager::ALLOW_CLONES)) {
+		disconnectClient("You are already logged in.");
+		return;
+	}
+
+	if (!IOLoginData::applyPlayerLoad(player, data)) {
+		disconnectClient("Your character could not be loaded.");
+		return;
+	}
+
+	finishLogin(operatingSystem);
+	IOLoginData::addLoginTime(dispatcherTime + getLoginTime(applyStart), getLoginTime(loginStart), true);
+}
+
+void ProtocolGame::finishLogin(OperatingSystem_t operatingSystem)
+{
+	player->setOperatingSystem(operatingSystem);
+
+	if (!g_game.placeCreature(player, player->getLoginPosition())) {
+		if (!g_game.placeCreature(player, player->getTemplePosition(), false, true)) {
+			disconnectClient("Temple position is wrong. Contact the administrator.");
+			return;
+		}
+	}
+
+	if (operatingSystem >= CLIENTOS_OTCLIENT_LINUX) {
+		player->registerCreatureEvent("ExtendedOpcode");
+	}
+
+	player->lastIP = player->getIP();
+	player->lastLoginSaved = std::max<time_t>(time(nullptr), player->lastLoginSaved + 1);
+	acceptPackets = true;
 }
 
 void ProtocolGame::connect(uint32_t playerId, OperatingSystem_t operatingSystem)
@@ -1372,6 +1429,15 @@ void ProtocolGame::sendMagicEffect(const Position& pos, uint8_t type)
 
 void ProtocolGame::sendCreatureHealth(const Creature* creature)
 {
+	// a congested client only needs the latest health of other creatures,
+	// it is sent by sendDeferredUpdates once the queue has drained
+	if (creature != player && isSendQueueCongested()) {
+		deferredHealthUpdates.insert(creature->getID());
+		return;
+	}
+
+	deferredHealthUpdates.erase(creature->getID());
+
 	NetworkMessage msg;
 	msg.addByte(0x8C);
 	msg.add<uint32_t>(creature->getID());
@@ -1379,6 +1445,22 @@ void ProtocolGame::sendCreatureHealth(const Creature* creature)
 	writeToOutputBuffer(msg);
 }
 
+void ProtocolGame::sendDeferredUpdates()
+{
+	if (deferredHealthUpdates.empty() || isSendQueueCongested()) {
+		return;
+	}
+
+	std::unordered_set<uint32_t> creatureIds;
+	creatureIds.swap(deferredHealthUpdates);
+	for (uint32_t creatureId : creatureIds) {
+		const Creature* creature = g_game.getCreatureByID(creatureId);
+		if (creature && knownCreatureSet.find(creatureId) != knownCreatureSet.end() && canSee(creature)) {
+			sendCreatureHealth(creature);
+		}
+	}
+}
+
 //tile
 void ProtocolGame::sendMapDescription(const Position& pos)
 {
@@ -28,6 +28,7 @@ class Container;
 class Tile;
 class Connection;
 class Quest;
+struct PlayerLoadData;
 class ProtocolGame;
 typedef std::shared_ptr<ProtocolGame> ProtocolGame_ptr;
 
@@ -66,6 +67,8 @@ class ProtocolGame final : public Protocol
 			return std::static_pointer_cast<ProtocolGame>(shared_from_this());
 		}
 		void connect(uint32_t playerId, OperatingSystem_t operatingSystem);
+		void onPlayerLoaded(Player* loadingPlayer, PlayerLoadData& data, OperatingSystem_t operatingSystem, std::chrono::steady_clock::time_point loginStart, uint64_t dispatcherTime);
+		void finishLogin(OperatingSystem_t operatingSystem);
 		void sendUpdateRequest();
 		void disconnectClient(const std::string& message) const;
 		void writeToOutputBuffer(const NetworkMessage& msg);
@@ -146,6 +149,7 @@ class ProtocolGame final : public Protocol
 		void sendDistanceShoot(const Position& from, const Position& to, uint8_t type);
 		void sendMagicEffect(const Position& pos, uint8_t type);
 		void sendCreatureHealth(const Creature* creature);
+		void sendDeferredUpdates();
 		void sendSkills();
 		void sendPing();
 		void sendPingBack();
@@ -255,6 +259,7 @@ class ProtocolGame final : public Protocol
 		}
 
 		std::unordered_set<uint32_t> knownCreatureSet;
+		std::unordered_set<uint32_t> deferredHealthUpdates;
 		Player* player = nullptr;
 
 		uint32_t eventConnect = 0;
@@ -94,6 +94,9 @@ void ProtocolLogin::getCharacterList(uint32_t accountNumber, const std::string&
 	send(output);
 
 	disconnect();
+
+	// the game login usually follows within a second or two
+	IOLoginData::prewarmPlayer(account);
 }
 
 void ProtocolLogin::onRecvFirstMessage(NetworkMessage& msg)
@@ -18,11 +18,17 @@
 #include "configmanager.h"
 #include "game.h"
 #include "outputmessage.h"
+#include "scheduler.h"
 
 extern ConfigManager g_config;
 extern Game g_game;
 
+static constexpr int32_t STATUS_CACHE_CHECK_INTERVAL = 1000;
+static constexpr int64_t STATUS_CACHE_MAX_AGE = 5000;
+
 std::map<uint32_t, int64_t> ProtocolStatus::ipConnectMap;
+std::shared_ptr<const StatusCache> ProtocolStatus::statusCache;
+std::mutex ProtocolStatus::statusCacheLock;
 const uint64_t ProtocolStatus::start = OTSYS_TIME();
 int32_t extraOn = g_config.getNumber(ConfigManager::EXTRA_ONLINE);
 
@@ -53,12 +59,21 @@ void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg)
 
 	ipConnectMap[ip] = OTSYS_TIME();
 
+	//io thread, answers come from the cache unless it has not been built yet
+	auto cache = getStatusCache();
+	auto self = std::static_pointer_cast<ProtocolStatus>(shared_from_this());
+
 	switch (msg.getByte()) {
 		//XML info protocol
 		case 0xFF: {
 			if (msg.getString(4) == "info") {
-				g_dispatcher.addTask(createTask(std::bind(&ProtocolStatus::sendStatusString,
-									  std::static_pointer_cast<ProtocolStatus>(shared_from_this()))));
+				if (cache) {
+					sendStatusString(cache);
+				} else {
+					g_dispatcher.addTask(createTask([self]() {
+						self->sendStatusString(buildStatusCache());
+					}));
+				}
 				return;
 			}
 			break;
@@ -71,8 +86,14 @@ void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg)
 			if (requestedInfo & REQUEST_PLAYER_STATUS_INFO) {
 				characterName = msg.getString();
 			}
-			g_dispatcher.addTask(createTask(std::bind(&ProtocolStatus::sendInfo, std::static_pointer_cast<ProtocolStatus>(shared_from_this()),
-								  requestedInfo, characterName)));
+
+			if (cache) {
+				sendInfo(cache, requestedInfo, characterName);
+			} else {
+				g_dispatcher.addTask(createTask([self, requestedInfo, characterName]() {
+					self->sendInfo(buildStatusCache(), requestedInfo, characterName);
+				}));
+			}
 			return;
 		}
 
@@ -82,11 +103,32 @@ void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg)
 	disconnect();
 }
 
-void ProtocolStatus::sendStatusString()
+std::shared_ptr<const StatusCache> ProtocolStatus::getStatusCache()
 {
-	auto output = OutputMessagePool::getOutputMessage();
+	std::lock_guard<std::mutex> lockClass(statusCacheLock);
+	return statusCache;
+}
 
-	setRawMessages(true);
+void ProtocolStatus::updateStatusCache()
+{
+	//dispatcher thread
+	auto cache = getStatusCache();
+	if (!cache || cache->playersOnline != g_game.getPlayersOnline() || (OTSYS_TIME() - cache->updateTime) >= STATUS_CACHE_MAX_AGE) {
+		auto newCache = buildStatusCache();
+
+		std::lock_guard<std::mutex> lockClass(statusCacheLock);
+		statusCache = std::move(newCache);
+	}
+
+	g_scheduler.addEvent(createSchedulerTask(STATUS_CACHE_CHECK_INTERVAL, &ProtocolStatus::updateStatusCache));
+}
+
+std::shared_ptr<const StatusCache> ProtocolStatus::buildStatusCache()
+{
+	//dispatcher thread
+	auto cache = std::make_shared<StatusCache>();
+	cache->playersOnline = g_game.getPlayersOnline();
+	cache->updateTime = OTSYS_TIME();
 
 	pugi::xml_document doc;
 
@@ -114,7 +156,7 @@ void ProtocolStatus::sendStatusString()
 
 	pugi::xml_node players = tsqp.append_child("players");
 
-	uint32_t real = g_game.getPlayersOnline() + extraOn;
+	uint32_t real = cache->playersOnline + extraOn;
 
 	/*
 	std::map<uint32_t, uint32_t> listIP;
@@ -168,69 +210,101 @@ void ProtocolStatus::sendStatusString()
 
 	std::ostringstream ss;
 	doc.save(ss, "", pugi::format_raw);
+	cache->statusString = ss.str();
+
+	NetworkMessage& basicInfo = cache->basicInfo;
+	basicInfo.addByte(0x10);
+	basicInfo.addString(g_config.getString(ConfigManager::SERVER_NAME));
+	basicInfo.addString(g_config.getString(ConfigManager::IP));
+	basicInfo.addString(std::to_string(g_config.getNumber(ConfigManager::LOGIN_PORT)));
+
+	NetworkMessage& ownerInfo = cache->ownerInfo;
+	ownerInfo.addByte(0x11);
+	ownerInfo.addString(g_config.getString(ConfigManager::OWNER_NAME));
+	ownerInfo.addString(g_config.getString(ConfigManager::OWNER_EMAIL));
+
+	NetworkMessage& miscInfo = cache->miscInfo;
+	miscInfo.addByte(0x12);
+	miscInfo.addString(g_config.getString(ConfigManager::MOTD));
+	miscInfo.addString(g_config.getString(ConfigManager::LOCATION));
+	miscInfo.addString(g_config.getString(ConfigManager::URL));
+
+	NetworkMessage& playersInfo = cache->playersInfo;
+	playersInfo.addByte(0x20);
+	playersInfo.add<uint32_t>(real);
+	playersInfo.add<uint32_t>(g_config.getNumber(ConfigManager::MAX_PLAYERS));
+	playersInfo.add<uint32_t>(g_game.getPlayersRecord());
+
+	NetworkMessage& mapInfo = cache->mapInfo;
+	mapInfo.addByte(0x30);
+	mapInfo.addString(g_config.getString(ConfigManager::MAP_NAME));
+	mapInfo.addString(g_config.getString(ConfigManager::MAP_AUTHOR));
+	mapInfo.add<uint16_t>(mapWidth);
+	mapInfo.add<uint16_t>(mapHeight);
+
+	NetworkMessage& extPlayersInfo = cache->extPlayersInfo;
+	extPlayersInfo.addByte(0x21); // players info - online players list
+
+	const auto& onlinePlayers = g_game.getPlayers();
+	extPlayersInfo.add<uint32_t>(onlinePlayers.size());
+	for (const auto& it : onlinePlayers) {
+		extPlayersInfo.addString(it.second->getName());
+		extPlayersInfo.add<uint32_t>(it.second->getLevel());
+		cache->onlinePlayerNames.insert(asLowerCaseString(it.second->getName()));
+	}
 
-	std::string data = ss.str();
+	NetworkMessage& softwareInfo = cache->softwareInfo;
+	softwareInfo.addByte(0x23); // server software info
+	softwareInfo.addString(STATUS_SERVER_NAME);
+	softwareInfo.addString(STATUS_SERVER_VERSION);
+	softwareInfo.addString(CLIENT_VERSION_STR);
+	return cache;
+}
+
+void ProtocolStatus::sendStatusString(const std::shared_ptr<const StatusCache>& cache)
+{
+	auto output = OutputMessagePool::getOutputMessage();
+
+	setRawMessages(true);
+
+	const std::string& data = cache->statusString;
 	output->addBytes(data.c_str(), data.size());
 	send(output);
 	disconnect();
 }
 
-void ProtocolStatus::sendInfo(uint16_t requestedInfo, const std::string& characterName)
+void ProtocolStatus::sendInfo(const std::shared_ptr<const StatusCache>& cache, uint16_t requestedInfo, const std::string& characterName)
 {
 	auto output = OutputMessagePool::getOutputMessage();
 
 	if (requestedInfo & REQUEST_BASIC_SERVER_INFO) {
-		output->addByte(0x10);
-		output->addString(g_config.getString(ConfigManager::SERVER_NAME));
-		output->addString(g_config.getString(ConfigManager::IP));
-		output->addString(std::to_string(g_config.getNumber(ConfigManager::LOGIN_PORT)));
+		output->append(cache->basicInfo);
 	}
 
 	if (requestedInfo & REQUEST_OWNER_SERVER_INFO) {
-		output->addByte(0x11);
-		output->addString(g_config.getString(ConfigManager::OWNER_NAME));
-		output->addString(g_config.getString(ConfigManager::OWNER_EMAIL));
+		output->append(cache->ownerInfo);
 	}
 
 	if (requestedInfo & REQUEST_MISC_SERVER_INFO) {
-		output->addByte(0x12);
-		output->addString(g_config.getString(ConfigManager::MOTD));
-		output->addString(g_config.getString(ConfigManager::LOCATION));
-		output->addString(g_config.getString(ConfigManager::URL));
+		output->append(cache->miscInfo);
 		output->add<uint64_t>((OTSYS_TIME() - ProtocolStatus::start) / 1000);
 	}
 
 	if (requestedInfo & REQUEST_PLAYERS_INFO) {
-		output->addByte(0x20);
-		output->add<uint32_t>((g_game.getPlayersOnline() + extraOn));
-		output->add<uint32_t>(g_config.getNumber(ConfigManager::MAX_PLAYERS));
-		output->add<uint32_t>(g_game.getPlayersRecord());
+		output->append(cache->playersInfo);
 	}
 
 	if (requestedInfo & REQUEST_MAP_INFO) {
-		output->addByte(0x30);
-		output->addString(g_config.getString(ConfigManager::MAP_NAME));
-		output->addString(g_config.getString(ConfigManager::MAP_AUTHOR));
-		uint32_t mapWidth, mapHeight;
-		g_game.getMapDimensions(mapWidth, mapHeight);
-		output->add<uint16_t>(mapWidth);
-		output->add<uint16_t>(mapHeight);
+		output->append(cache->mapInfo);
 	}
 
 	if (requestedInfo & REQUEST_EXT_PLAYERS_INFO) {
-		output->addByte(0x21); // players info - online players list
-
-		const auto& players = g_game.getPlayers();
-		output->add<uint32_t>(players.size());
-		for (const auto& it : players) {
-			output->addString(it.second->getName());
-			output->add<uint32_t>(it.second->getLevel());
-		}
+		output->append(cache->extPlayersInfo);
 	}
 
 	if (requestedInfo & REQUEST_PLAYER_STATUS_INFO) {
 		output->addByte(0x22); // players info - online status info of a player
-		if (g_game.getPlayerByName(characterName) != nullptr) {
+		if (cache->onlinePlayerNames.find(asLowerCaseString(characterName)) != cache->onlinePlayerNames.end()) {
 			output->addByte(0x01);
 		} else {
 			output->addByte(0x00);
@@ -238,10 +312,7 @@ void ProtocolStatus::sendInfo(uint16_t requestedInfo, const std::string& charact
 	}
 
 	if (requestedInfo & REQUEST_SERVER_SOFTWARE_INFO) {
-		output->addByte(0x23); // server software info
-		output->addString(STATUS_SERVER_NAME);
-		output->addString(STATUS_SERVER_VERSION);
-		output->addString(CLIENT_VERSION_STR);
+		output->append(cache->softwareInfo);
 	}
 	send(output);
 	disconnect();
@@ -15,9 +15,27 @@
 #ifndef FS_STATUS_H_8B28B354D65B4C0483E37AD1CA316EB4
 #define FS_STATUS_H_8B28B354D65B4C0483E37AD1CA316EB4
 
+#include <unordered_set>
+
 #include "networkmessage.h"
 #include "protocol.h"
 
+// Everything a status request can ask for, built on the dispatcher and then
+// shared read-only with the I/O thread that answers the requests
+struct StatusCache {
+	std::string statusString;
+	NetworkMessage basicInfo;
+	NetworkMessage ownerInfo;
+	NetworkMessage miscInfo; // uptime is appended when sent
+	NetworkMessage playersInfo;
+	NetworkMessage mapInfo;
+	NetworkMessage extPlayersInfo;
+	NetworkMessage softwareInfo;
+	std::unordered_set<std::string> onlinePlayerNames;
+	uint32_t playersOnline = 0;
+	int64_t updateTime = 0;
+};
+
 class ProtocolStatus final : public Protocol
 {
 	public:
@@ -33,13 +51,21 @@ class ProtocolStatus final : public Protocol
 
 		void onRecvFirstMessage(NetworkMessage& msg) final;
 
-		void sendStatusString();
-		void sendInfo(uint16_t requestedInfo, const std::string& characterName);
+		void sendStatusString(const std::shared_ptr<const StatusCache>& cache);
+		void sendInfo(const std::shared_ptr<const StatusCache>& cache, uint16_t requestedInfo, const std::string& characterName);
+
+		// dispatcher thread, reschedules itself
+		static void updateStatusCache();
 
 		static const uint64_t start;
 
 	protected:
+		static std::shared_ptr<const StatusCache> getStatusCache();
+		static std::shared_ptr<const StatusCache> buildStatusCache();
+
 		static std::map<uint32_t, int64_t> ipConnectMap;
+		static std::shared_ptr<const StatusCache> statusCache;
+		static std::mutex statusCacheLock;
 };
 
 #endif
@@ -30,6 +30,7 @@ class RSA
 
 		void loadPEM(const std::string& filename);
 		void decrypt(char* msg) const;
+		void encrypt(char* msg) const;
 
 	private:
 		CryptoPP::RSA::PrivateKey pk;
@@ -16,6 +16,7 @@
 
 #include "tasks.h"
 #include "game.h"
+#include "outputmessage.h"
 
 extern Game g_game;
 
@@ -37,6 +38,7 @@ void Dispatcher::threadMain()
 			// take the first task
 			Task* task = taskList.front();
 			taskList.pop_front();
+			bool lastInBatch = taskList.empty();
 			taskLockUnique.unlock();
 
 			if (!task->hasExpired()) {
@@ -47,6 +49,9 @@ void Dispatcher::threadMain()
 				g_game.map.clearSpectatorCache();
 			}
 			delete task;
+
+			// send what this batch of tasks buffered before going idle
+			OutputMessagePool::getInstance().flush(lastInBatch);
 		} else {
 			taskLockUnique.unlock();
 		}
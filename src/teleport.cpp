@@ -16,9 +16,26 @@
 
 #include "teleport.h"
 #include "game.h"
+#include "objectpool.h"
 
 extern Game g_game;
 
+static ObjectPool& getTeleportPool()
+{
+	static ObjectPool& pool = ObjectPool::create("Teleport", sizeof(Teleport));
+	return pool;
+}
+
+void* Teleport::operator new(size_t size)
+{
+	return getTeleportPool().allocate(size);
+}
+
+void Teleport::operator delete(void* object, size_t size)
+{
+	getTeleportPool().deallocate(object, size);
+}
+
 Attr_ReadValue Teleport::readAttr(AttrTypes_t attr, PropStream& propStream)
 {
 	if (attr == ATTR_TELE_DEST) {
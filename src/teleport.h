@@ -22,6 +22,10 @@ class Teleport final : public Item, public Cylinder
 	public:
 		explicit Teleport(uint16_t type) : Item(type) {};
 
+		// allocated from the teleport pool
+		static void* operator new(size_t size);
+		static void operator delete(void* object, size_t size);
+
 		Teleport* getTeleport() final {
 			return this;
 		}
@@ -0,0 +1,259 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#define BOOST_TEST_MODULE containers
+
+#include "../otpch.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "../container.h"
+
+#include "testitems.h"
+
+// what the aggregates of a container should hold, counted from its tree
+static bool checkHeldItems(const Container* container)
+{
+	uint32_t items = 0;
+	uint64_t worth = 0;
+	std::map<uint16_t, uint32_t> counts;
+	for (ContainerIterator it = container->iterator(); it.hasNext(); it.advance()) {
+		const Item* item = *it;
+		++items;
+
+		switch (item->getID()) {
+			case ITEM_GOLD_COIN: worth += item->getItemCount(); break;
+			case ITEM_PLATINUM_COIN: worth += item->getItemCount() * 100; break;
+			case ITEM_CRYSTAL_COIN: worth += item->getItemCount() * 10000; break;
+			default: break;
+		}
+
+		if (item->getItemCount() != 0) {
+			counts[item->getID()] += item->getItemCount();
+		}
+	}
+
+	bool matches = container->getHeldItemCounts() == HeldItemCounts(counts.begin(), counts.end());
+	for (const auto& it : counts) {
+		matches = matches && container->getHeldItemCount(it.first) == it.second;
+	}
+
+	BOOST_CHECK_EQUAL(container->getItemHoldingCount(), items);
+	BOOST_CHECK_EQUAL(container->getHeldWorth(), worth);
+	BOOST_CHECK_MESSAGE(matches, "held item counts differ from the recount");
+	BOOST_CHECK(container->checkHeldItems());
+	return matches && container->getItemHoldingCount() == items && container->getHeldWorth() == worth && container->checkHeldItems();
+}
+
+// the container and every container inside it
+static void getContainers(Container* container, std::vector<Container*>& containers)
+{
+	containers.push_back(container);
+	for (Item* item : container->getItemList()) {
+		if (Container* subContainer = item->getContainer()) {
+			getContainers(subContainer, containers);
+		}
+	}
+}
+
+static bool checkTree(Container* root)
+{
+	std::vector<Container*> containers;
+	getContainers(root, containers);
+
+	bool matches = true;
+	for (const Container* container : containers) {
+		matches = checkHeldItems(container) && matches;
+	}
+	return matches;
+}
+
+static Container* createContainer(uint16_t id = 0)
+{
+	Item* item = Item::CreateItem(id != 0 ? id : getItemPools().containers.front());
+	BOOST_REQUIRE(item && item->getContainer());
+	return item->getContainer();
+}
+
+BOOST_AUTO_TEST_CASE(nested_adds_and_removes)
+{
+	Container* backpack = createContainer();
+	Container* bag = createContainer();
+
+	backpack->addThing(Item::CreateItem(ITEM_GOLD_COIN, 50));
+	bag->addThing(Item::CreateItem(ITEM_PLATINUM_COIN, 20));
+	bag->addThing(Item::CreateItem(ITEM_GOLD_COIN, 7));
+	checkTree(bag);
+
+	// the bag brings what it holds along
+	backpack->addThing(bag);
+	checkTree(backpack);
+	BOOST_CHECK_EQUAL(backpack->getItemHoldingCount(), 4);
+	BOOST_CHECK_EQUAL(backpack->getHeldWorth(), 2057);
+	BOOST_CHECK_EQUAL(backpack->getHeldItemCount(ITEM_GOLD_COIN), 57);
+
+	// part of a stack
+	Item* platinum = bag->getItemByIndex(1);
+	BOOST_REQUIRE_EQUAL(platinum->getID(), ITEM_PLATINUM_COIN);
+	bag->removeThing(platinum, 5);
+	checkTree(backpack);
+	BOOST_CHECK_EQUAL(backpack->getHeldWorth(), 1557);
+
+	// a whole stack
+	bag->removeThing(platinum, platinum->getItemCount());
+	checkTree(backpack);
+	BOOST_CHECK_EQUAL(backpack->getHeldItemCount(ITEM_PLATINUM_COIN), 0);
+
+	// the bag takes what it holds with it
+	backpack->removeThing(bag, 1);
+	checkTree(backpack);
+	checkTree(bag);
+	BOOST_CHECK_EQUAL(backpack->getItemHoldingCount(), 1);
+	BOOST_CHECK_EQUAL(backpack->getHeldWorth(), 50);
+}
+
+BOOST_AUTO_TEST_CASE(transform_and_replace)
+{
+	Container* backpack = createContainer();
+	Container* bag = createContainer();
+	backpack->addThing(bag);
+
+	Item* coins = Item::CreateItem(ITEM_GOLD_COIN, 100);
+	bag->addThing(coins);
+	checkTree(backpack);
+
+	// changing money, the stack turns into another coin
+	bag->updateThing(coins, ITEM_PLATINUM_COIN, 1);
+	checkTree(backpack);
+	BOOST_CHECK_EQUAL(backpack->getHeldWorth(), 100);
+	BOOST_CHECK_EQUAL(backpack->getHeldItemCount(ITEM_GOLD_COIN), 0);
+
+	// a container replacing an item counts with its contents
+	Container* pouch = createContainer();
+	pouch->addThing(Item::CreateItem(ITEM_CRYSTAL_COIN, 2));
+	pouch->addThing(Item::CreateItem(getItemPools().plain.front()));
+	bag->replaceThing(bag->getThingIndex(coins), pouch);
+	checkTree(backpack);
+	BOOST_CHECK_EQUAL(backpack->getItemHoldingCount(), 4);
+	BOOST_CHECK_EQUAL(backpack->getHeldWorth(), 20000);
+
+	// and takes them away when it is replaced
+	backpack->replaceThing(backpack->getThingIndex(bag), Item::CreateItem(getItemPools().plain.front()));
+	checkTree(backpack);
+	BOOST_CHECK_EQUAL(backpack->getItemHoldingCount(), 1);
+	BOOST_CHECK_EQUAL(backpack->getHeldWorth(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(clone_keeps_counts)
+{
+	Container* backpack = createContainer();
+	Container* bag = createContainer();
+	bag->addThing(Item::CreateItem(ITEM_PLATINUM_COIN, 3));
+	backpack->addThing(bag);
+	backpack->addThing(Item::CreateItem(getItemPools().stackables.front(), 12));
+
+	Item* clone = backpack->clone();
+	BOOST_REQUIRE(clone->getContainer());
+	checkTree(clone->getContainer());
+	BOOST_CHECK(clone->getContainer()->getHeldItemCounts() == backpack->getHeldItemCounts());
+}
+
+// random adds, removes, transforms, replaces and moves on one tree, with
+// every container recounted after each of them
+BOOST_AUTO_TEST_CASE(random_changes_match_recount)
+{
+	const ItemPools& pools = getItemPools();
+
+	auto createItem = [&pools](Random& random, bool allowContainer) -> Item* {
+		switch (random(0, allowContainer ? 3 : 2)) {
+			case 0: return Item::CreateItem(coinIds[random(0, 2)], random(1, 100));
+			case 1: return Item::CreateItem(random.pick(pools.stackables), random(1, 100));
+			case 2: return Item::CreateItem(random.pick(pools.plain));
+			default: break;
+		}
+
+		Container* container = createContainer(random.pick(pools.containers));
+		for (size_t i = random(0, 3); i > 0; --i) {
+			container->addThing(Item::CreateItem(coinIds[random(0, 2)], random(1, 100)));
+		}
+		return container;
+	};
+
+	Container* root = createContainer();
+	runRandomChanges(46, 3000, [&](Random& random) -> size_t {
+		std::vector<Container*> containers;
+		getContainers(root, containers);
+
+		std::vector<Item*> items;
+		for (ContainerIterator it = root->iterator(); it.hasNext(); it.advance()) {
+			items.push_back(*it);
+		}
+
+		const size_t action = items.empty() ? 0 : random(0, 4);
+		if (action == 0) {
+			Container* container = containers[random(0, containers.size() - 1)];
+			if (container->size() < container->capacity() && items.size() < 300) {
+				container->addThing(createItem(random, true));
+			}
+			return action;
+		}
+
+		Item* item = items[random(0, items.size() - 1)];
+		Container* parent = item->getParent()->getContainer();
+		BOOST_REQUIRE(parent);
+
+		switch (action) {
+			case 1: {
+				const uint32_t count = item->isStackable() ? random(1, item->getItemCount()) : item->getItemCount();
+				parent->removeThing(item, count);
+				break;
+			}
+
+			case 2: {
+				if (isCoin(item->getID())) {
+					parent->updateThing(item, coinIds[random(0, 2)], random(1, 100));
+				} else if (item->isStackable()) {
+					parent->updateThing(item, item->getID(), random(1, 100));
+				} else if (!item->getContainer()) {
+					parent->updateThing(item, random.pick(pools.plain), 1);
+				}
+				break;
+			}
+
+			case 3:
+				parent->replaceThing(parent->getThingIndex(item), createItem(random, true));
+				break;
+
+			default: {
+				// into a container that is not the item or inside it
+				Container* target = containers[random(0, containers.size() - 1)];
+				const Container* moved = item->getContainer();
+				bool inside = false;
+				for (Cylinder* cylinder = target; moved && cylinder; cylinder = cylinder->getParent()) {
+					inside = inside || cylinder == moved;
+				}
+
+				if (!inside && target->size() < target->capacity()) {
+					parent->removeThing(item, item->getItemCount());
+					target->addThing(item);
+				}
+				break;
+			}
+		}
+		return action;
+	}, [&root]() {
+		return checkTree(root);
+	});
+}
@@ -0,0 +1,426 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#define BOOST_TEST_MODULE databasetasks
+
+#include "../otpch.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <random>
+#include <set>
+
+#include "../configmanager.h"
+#include "../databasetasks.h"
+#include "../tasks.h"
+
+// The workers run against an in-memory stand-in for the connection that logs
+// every statement, and the dispatcher only collects the callbacks for the
+// test to run. Both are linked in place of database.cpp and tasks.cpp.
+
+ConfigManager g_config;
+Dispatcher g_dispatcher;
+
+static int32_t configNumbers[ConfigManager::LAST_INTEGER_CONFIG] = {};
+
+int32_t ConfigManager::getNumber(integer_config_t what) const
+{
+	return configNumbers[what];
+}
+
+struct FakeStatement {
+	std::string query;
+	std::thread::id thread;
+};
+
+static std::mutex fakeLock;
+static std::vector<FakeStatement> statements;
+// statements it returns true for fail, after they were logged
+static std::function<bool(const std::string&)> failStatement;
+
+// time a statement takes on the server and the flush at the end of every
+// transaction, a write outside of one is a transaction of its own
+static std::chrono::microseconds roundTrip(0);
+static std::chrono::microseconds flush(0);
+static thread_local bool inTransaction = false;
+
+static bool fakeExecute(const std::string& query)
+{
+	bool success;
+	{
+		std::lock_guard<std::mutex> lockClass(fakeLock);
+		statements.push_back({query, std::this_thread::get_id()});
+		success = !failStatement || !failStatement(query);
+	}
+
+	if (roundTrip.count() != 0) {
+		bool flushed = !inTransaction;
+		if (query == "BEGIN") {
+			inTransaction = true;
+			flushed = false;
+		} else if (query == "COMMIT" || query == "ROLLBACK") {
+			inTransaction = false;
+		}
+		std::this_thread::sleep_for(flushed ? roundTrip + flush : roundTrip);
+	}
+	return success;
+}
+
+Database::~Database() {}
+DBStatement::~DBStatement() {}
+
+bool Database::connect()
+{
+	return true;
+}
+
+bool Database::executeQuery(const std::string& query)
+{
+	return fakeExecute(query);
+}
+
+DBResult_ptr Database::storeQuery(const std::string& query)
+{
+	fakeExecute(query);
+	return nullptr;
+}
+
+bool Database::beginTransaction()
+{
+	return fakeExecute("BEGIN");
+}
+
+bool Database::rollback()
+{
+	return fakeExecute("ROLLBACK");
+}
+
+bool Database::commit()
+{
+	return fakeExecute("COMMIT");
+}
+
+static std::mutex dispatcherLock;
+static std::condition_variable dispatcherSignal;
+static std::list<Task*> dispatcherTasks;
+
+void Dispatcher::addTask(Task* task, bool)
+{
+	{
+		std::lock_guard<std::mutex> lockClass(dispatcherLock);
+		dispatcherTasks.push_back(task);
+	}
+	dispatcherSignal.notify_one();
+}
+
+// runs the callbacks handed to the dispatcher, on this thread, until done
+// returns true or nothing arrived for a while
+static bool runCallbacks(const std::function<bool()>& done)
+{
+	std::unique_lock<std::mutex> lockUnique(dispatcherLock);
+	while (!done()) {
+		if (dispatcherTasks.empty() && !dispatcherSignal.wait_for(lockUnique, std::chrono::seconds(10), []() { return !dispatcherTasks.empty(); })) {
+			return false;
+		}
+
+		Task* task = dispatcherTasks.front();
+		dispatcherTasks.pop_front();
+		lockUnique.unlock();
+		(*task)();
+		delete task;
+		lockUnique.lock();
+	}
+	return true;
+}
+
+static void startTasks(DatabaseTasks& tasks, int32_t workers, int32_t batchSize, int32_t batchDelay)
+{
+	roundTrip = std::chrono::microseconds(0);
+	flush = std::chrono::microseconds(0);
+	configNumbers[ConfigManager::DATABASE_WORKERS] = workers;
+	configNumbers[ConfigManager::DATABASE_BATCH_SIZE] = batchSize;
+	configNumbers[ConfigManager::DATABASE_BATCH_DELAY] = batchDelay;
+	statements.clear();
+	failStatement = nullptr;
+	BOOST_REQUIRE(tasks.start());
+}
+
+static void stopTasks(DatabaseTasks& tasks)
+{
+	tasks.shutdown();
+	tasks.join();
+}
+
+BOOST_AUTO_TEST_CASE(keyed_jobs_keep_their_order)
+{
+	DatabaseTasks tasks;
+	startTasks(tasks, 4, 1, 0);
+
+	static constexpr uint32_t KEYS = 64;
+	static constexpr uint32_t JOBS = 200;
+
+	std::mutex runLock;
+	std::map<uint32_t, std::vector<uint32_t>> ran;
+	std::map<uint32_t, std::set<std::thread::id>> threads;
+	std::map<uint32_t, std::vector<uint32_t>> called;
+	size_t callbacks = 0;
+
+	// interleaved over the keys, every job takes a different amount of time
+	// so the workers drift apart
+	std::mt19937 rng(33);
+	for (uint32_t job = 0; job < JOBS; ++job) {
+		for (uint32_t key = 1; key <= KEYS; ++key) {
+			const uint32_t spin = rng() % 2000;
+			BOOST_REQUIRE(tasks.addJob([&, key, job, spin](Database&) {
+				for (volatile uint32_t i = 0; i < spin; ++i) {}
+
+				std::lock_guard<std::mutex> lockClass(runLock);
+				ran[key].push_back(job);
+				threads[key].insert(std::this_thread::get_id());
+				return true;
+			}, [&, key, job](DBResult_ptr, bool success) {
+				BOOST_CHECK(success);
+				called[key].push_back(job);
+				++callbacks;
+			}, key));
+		}
+	}
+
+	BOOST_REQUIRE(runCallbacks([&]() { return callbacks == KEYS * JOBS; }));
+	stopTasks(tasks);
+
+	std::set<std::thread::id> allThreads;
+	for (uint32_t key = 1; key <= KEYS; ++key) {
+		BOOST_REQUIRE_EQUAL(ran[key].size(), JOBS);
+		BOOST_REQUIRE_EQUAL(called[key].size(), JOBS);
+		for (uint32_t job = 0; job < JOBS; ++job) {
+			BOOST_REQUIRE_EQUAL(ran[key][job], job);
+			BOOST_REQUIRE_EQUAL(called[key][job], job);
+		}
+
+		BOOST_CHECK_EQUAL(threads[key].size(), 1);
+		allThreads.insert(threads[key].begin(), threads[key].end());
+	}
+
+	// the keys are spread over every worker but the unkeyed one
+	BOOST_CHECK_EQUAL(allThreads.size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(batched_writes_keep_their_order)
+{
+	DatabaseTasks tasks;
+	startTasks(tasks, 3, 8, 2);
+
+	static constexpr uint32_t KEYS = 16;
+	static constexpr uint32_t WRITES = 300;
+
+	// batched writes with plain tasks and jobs between them on every key,
+	// each logs "key write" on the connection
+	size_t callbacks = 0;
+	std::mt19937 rng(37);
+	for (uint32_t write = 0; write < WRITES; ++write) {
+		for (uint32_t key = 1; key <= KEYS; ++key) {
+			std::ostringstream query;
+			query << key << ' ' << write;
+
+			auto callback = [&callbacks](DBResult_ptr, bool success) {
+				BOOST_CHECK(success);
+				++callbacks;
+			};
+
+			switch (rng() % 4) {
+				case 0:
+					tasks.addTask(query.str(), callback, false, key);
+					break;
+
+				case 1: {
+					const std::string text = query.str();
+					tasks.addJob([text](Database& db) {
+						return db.executeQuery(text);
+					}, callback, key);
+					break;
+				}
+
+				default:
+					tasks.addBatchedTask(query.str(), callback, key);
+					break;
+			}
+		}
+	}
+
+	BOOST_REQUIRE(runCallbacks([&]() { return callbacks == KEYS * WRITES; }));
+	stopTasks(tasks);
+
+	std::map<uint32_t, uint32_t> nextWrite;
+	size_t transactions = 0;
+	for (const FakeStatement& statement : statements) {
+		if (statement.query == "BEGIN") {
+			++transactions;
+			continue;
+		}
+
+		if (statement.query == "COMMIT" || statement.query == "ROLLBACK") {
+			continue;
+		}
+
+		uint32_t key, write;
+		std::istringstream(statement.query) >> key >> write;
+		BOOST_REQUIRE_EQUAL(write, nextWrite[key]);
+		++nextWrite[key];
+	}
+
+	for (uint32_t key = 1; key <= KEYS; ++key) {
+		BOOST_CHECK_EQUAL(nextWrite[key], WRITES);
+	}
+	BOOST_CHECK(transactions > 0);
+}
+
+BOOST_AUTO_TEST_CASE(barrier_waits_for_every_worker)
+{
+	DatabaseTasks tasks;
+	startTasks(tasks, 4, 1, 0);
+
+	std::atomic<uint32_t> finished(0);
+	for (uint32_t key = 0; key < 32; ++key) {
+		tasks.addJob([&finished](Database&) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			++finished;
+			return true;
+		}, nullptr, key);
+	}
+
+	bool reached = false;
+	BOOST_REQUIRE(tasks.addBarrier([&]() {
+		BOOST_CHECK_EQUAL(finished, 32);
+		reached = true;
+	}));
+
+	BOOST_REQUIRE(runCallbacks([&]() { return reached; }));
+	stopTasks(tasks);
+}
+
+// queues writes that the worker takes as one batch, and returns how each
+// of them was reported
+static std::vector<bool> runBatch(DatabaseTasks& tasks, const std::vector<std::string>& queries)
+{
+	std::vector<bool> results(queries.size());
+	size_t callbacks = 0;
+	for (size_t i = 0; i < queries.size(); ++i) {
+		tasks.addBatchedTask(queries[i], [&results, &callbacks, i](DBResult_ptr, bool success) {
+			results[i] = success;
+			++callbacks;
+		});
+	}
+
+	BOOST_REQUIRE(runCallbacks([&]() { return callbacks == queries.size(); }));
+	return results;
+}
+
+static size_t countStatements(const std::string& query)
+{
+	std::lock_guard<std::mutex> lockClass(fakeLock);
+	return std::count_if(statements.begin(), statements.end(), [&query](const FakeStatement& statement) {
+		return statement.query == query;
+	});
+}
+
+BOOST_AUTO_TEST_CASE(failed_write_is_retried_alone)
+{
+	DatabaseTasks tasks;
+	startTasks(tasks, 1, 8, 50);
+	failStatement = [](const std::string& query) {
+		return query == "bad";
+	};
+
+	std::vector<bool> results = runBatch(tasks, {"first", "bad", "last"});
+	stopTasks(tasks);
+
+	// rolled back before COMMIT, so every write ran again on its own
+	BOOST_CHECK_EQUAL(countStatements("ROLLBACK"), 1);
+	BOOST_CHECK_EQUAL(countStatements("first"), 2);
+	BOOST_CHECK_EQUAL(countStatements("last"), 1);
+	BOOST_CHECK(results[0]);
+	BOOST_CHECK(!results[1]);
+	BOOST_CHECK(results[2]);
+}
+
+BOOST_AUTO_TEST_CASE(failed_commit_is_not_replayed)
+{
+	DatabaseTasks tasks;
+	startTasks(tasks, 1, 8, 50);
+	failStatement = [](const std::string& query) {
+		return query == "COMMIT";
+	};
+
+	std::vector<bool> results = runBatch(tasks, {"INSERT 1", "INSERT 2", "INSERT 3"});
+	stopTasks(tasks);
+
+	// the server may have applied them, running them again could insert
+	// the rows twice
+	BOOST_CHECK_EQUAL(countStatements("COMMIT"), 1);
+	for (const char* query : {"INSERT 1", "INSERT 2", "INSERT 3"}) {
+		BOOST_CHECK_EQUAL(countStatements(query), 1);
+	}
+	for (bool success : results) {
+		BOOST_CHECK(!success);
+	}
+}
+
+// a burst of small writes on the unkeyed worker, each one its own commit or
+// batched, against a server taking 100 us a statement and 500 us a flush
+BOOST_AUTO_TEST_CASE(burst_of_small_writes)
+{
+	static constexpr uint32_t WRITES = 1000;
+
+	DatabaseWorkerStats results[2];
+	double elapsed[2];
+	for (int batched = 0; batched < 2; ++batched) {
+		DatabaseTasks tasks;
+		startTasks(tasks, 1, 64, 5);
+		roundTrip = std::chrono::microseconds(100);
+		flush = std::chrono::microseconds(500);
+
+		size_t callbacks = 0;
+		auto callback = [&callbacks](DBResult_ptr, bool success) {
+			BOOST_CHECK(success);
+			++callbacks;
+		};
+
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t write = 0; write < WRITES; ++write) {
+			const std::string query = "INSERT " + std::to_string(write);
+			if (batched) {
+				tasks.addBatchedTask(query, callback);
+			} else {
+				tasks.addTask(query, callback);
+			}
+		}
+
+		BOOST_REQUIRE(runCallbacks([&]() { return callbacks == WRITES; }));
+		elapsed[batched] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		results[batched] = tasks.getStats().front();
+		stopTasks(tasks);
+
+		const DatabaseWorkerStats& stats = results[batched];
+		std::cout << (batched ? "batched" : "one by one") << ": " << WRITES << " writes in " << elapsed[batched] * 1000 << " ms (" << WRITES / elapsed[batched] << "/s), "
+			<< stats.commits << " commits, "
+			<< "queue latency " << stats.latency / std::max<uint64_t>(1, stats.executed) / 1000 << " ms mean, "
+			<< stats.peakLatency / 1000 << " ms max" << std::endl;
+	}
+
+	BOOST_CHECK_EQUAL(results[0].commits, WRITES);
+	BOOST_CHECK(results[1].commits * 16 <= WRITES);
+	BOOST_CHECK(elapsed[1] < elapsed[0]);
+}
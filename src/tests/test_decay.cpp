@@ -0,0 +1,187 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#define BOOST_TEST_MODULE decay
+
+#include "../otpch.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <chrono>
+#include <random>
+
+#include "../decay.h"
+
+// the queue never looks at its items, numbers stand in for them
+static Item* fakeItem(uintptr_t id)
+{
+	return reinterpret_cast<Item*>(id);
+}
+
+static uintptr_t itemId(const DecayEntry& entry)
+{
+	return reinterpret_cast<uintptr_t>(entry.item);
+}
+
+// a clock far from zero, the queue starts from whatever time it is first given
+static const int64_t START = 1700000000000;
+
+// runs the queue a tick at a time until end, and checks every entry comes out
+// within half a tick of its time
+static size_t drain(DecayQueue& queue, int64_t start, int64_t end, std::vector<DecayEntry>& taken)
+{
+	std::vector<DecayEntry> expired;
+	for (int64_t now = start; now <= end; now += DecayQueue::TICK) {
+		expired.clear();
+		queue.takeExpired(now, expired);
+		for (const DecayEntry& entry : expired) {
+			BOOST_REQUIRE_MESSAGE(entry.decayTime - DecayQueue::TICK / 2 <= now, "item " << itemId(entry) << " came out early");
+			BOOST_REQUIRE_MESSAGE(entry.decayTime + DecayQueue::TICK > now, "item " << itemId(entry) << " came out late");
+		}
+		taken.insert(taken.end(), expired.begin(), expired.end());
+	}
+	return taken.size();
+}
+
+BOOST_AUTO_TEST_CASE(near_items_expire_on_time)
+{
+	DecayQueue queue;
+	std::vector<DecayEntry> expired;
+	queue.takeExpired(START, expired);
+
+	for (uintptr_t i = 1; i <= 1000; ++i) {
+		queue.add(fakeItem(i), START + i * 37);
+	}
+	BOOST_CHECK_EQUAL(queue.size(), 1000);
+
+	std::vector<DecayEntry> taken;
+	BOOST_CHECK_EQUAL(drain(queue, START, START + 1000 * 37 + DecayQueue::TICK, taken), 1000);
+	BOOST_CHECK_EQUAL(queue.size(), 0);
+
+	// one tick may hold several items, the order between ticks is kept
+	for (size_t i = 1; i < taken.size(); ++i) {
+		BOOST_CHECK(taken[i - 1].decayTime <= taken[i].decayTime + DecayQueue::TICK);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(far_items_cascade_on_time)
+{
+	DecayQueue queue;
+	std::vector<DecayEntry> expired;
+	queue.takeExpired(START, expired);
+
+	// past the near wheel, past several turns of it and past the far wheel
+	const int64_t turn = DecayQueue::TICK * DecayQueue::NEAR_SLOTS;
+	const int64_t times[] = {turn - 1, turn, turn + 1, 3 * turn + 125, 17 * turn, DecayQueue::FAR_SLOTS * turn + 5 * turn};
+
+	uintptr_t id = 1;
+	for (int64_t time : times) {
+		queue.add(fakeItem(id++), START + time);
+	}
+
+	std::vector<DecayEntry> taken;
+	BOOST_CHECK_EQUAL(drain(queue, START, START + times[5] + DecayQueue::TICK, taken), 6);
+	BOOST_CHECK_EQUAL(queue.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(past_items_expire_on_next_pass)
+{
+	DecayQueue queue;
+	std::vector<DecayEntry> expired;
+	queue.takeExpired(START, expired);
+
+	queue.add(fakeItem(1), START - 10000);
+	queue.add(fakeItem(2), START);
+
+	queue.takeExpired(START + DecayQueue::TICK, expired);
+	BOOST_CHECK_EQUAL(expired.size(), 2);
+	BOOST_CHECK_EQUAL(queue.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(removed_items_do_not_expire)
+{
+	DecayQueue queue;
+	std::vector<DecayEntry> expired;
+	queue.takeExpired(START, expired);
+
+	// near, far, out of the far wheel's reach and one left in
+	const int64_t turn = DecayQueue::TICK * DecayQueue::NEAR_SLOTS;
+	const int64_t times[] = {1000, 5 * turn, (DecayQueue::FAR_SLOTS + 3) * turn, 2000};
+
+	uintptr_t id = 1;
+	for (int64_t time : times) {
+		queue.add(fakeItem(id++), START + time);
+	}
+
+	// a couple of turns in, the out of reach entry is no longer in the slot
+	// the queue would pick for it now
+	std::vector<DecayEntry> taken;
+	drain(queue, START, START + 2 * turn, taken);
+	BOOST_CHECK_EQUAL(taken.size(), 2);
+	BOOST_CHECK_EQUAL(queue.size(), 2);
+
+	BOOST_CHECK(!queue.remove(fakeItem(1), START + times[0]));
+	BOOST_CHECK(!queue.remove(fakeItem(2), START + times[0]));
+	BOOST_CHECK(queue.remove(fakeItem(2), START + times[1]));
+	BOOST_CHECK(queue.remove(fakeItem(3), START + times[2]));
+	BOOST_CHECK(!queue.remove(fakeItem(3), START + times[2]));
+	BOOST_CHECK_EQUAL(queue.size(), 0);
+
+	taken.clear();
+	queue.add(fakeItem(5), START + 2 * turn + 1000);
+	queue.add(fakeItem(6), START + 2 * turn + 1000);
+	BOOST_CHECK(queue.remove(fakeItem(5), START + 2 * turn + 1000));
+	drain(queue, START + 2 * turn, START + 2 * turn + 2000, taken);
+	BOOST_REQUIRE_EQUAL(taken.size(), 1);
+	BOOST_CHECK_EQUAL(itemId(taken[0]), 6);
+}
+
+// the queue behind 100k decaying items on the map, replaces dropping them on
+// a live server to measure it
+BOOST_AUTO_TEST_CASE(throughput)
+{
+	const size_t count = 100000;
+	const int64_t span = 30 * 60 * 1000;
+
+	std::mt19937 generator(7);
+	std::uniform_int_distribution<int64_t> distribution(1, span);
+
+	DecayQueue queue;
+	std::vector<DecayEntry> expired;
+	queue.takeExpired(START, expired);
+
+	auto start = std::chrono::steady_clock::now();
+	for (uintptr_t i = 1; i <= count; ++i) {
+		queue.add(fakeItem(i), START + distribution(generator));
+	}
+	std::chrono::duration<double, std::milli> queued = std::chrono::steady_clock::now() - start;
+
+	// a pass per tick, as Game::checkDecay runs it
+	size_t taken = 0;
+	size_t passes = 0;
+	start = std::chrono::steady_clock::now();
+	for (int64_t now = START; now <= START + span + DecayQueue::TICK; now += DecayQueue::TICK) {
+		expired.clear();
+		queue.takeExpired(now, expired);
+		taken += expired.size();
+		++passes;
+	}
+	std::chrono::duration<double, std::milli> drained = std::chrono::steady_clock::now() - start;
+
+	BOOST_CHECK_EQUAL(taken, count);
+	BOOST_CHECK_EQUAL(queue.size(), 0);
+
+	std::cout << count << " items: queued in " << queued.count() << " ms, " << passes << " passes in " << drained.count() << " ms (" << drained.count() * 1000 / passes << " us per pass)" << std::endl;
+}
@@ -0,0 +1,360 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#define BOOST_TEST_MODULE journal
+
+#include "../otpch.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "../iologindata.h"
+#include "../journal.h"
+
+// Segments are built in memory in the format PlayerJournal writes them and
+// replayed without a database, the snapshots it would save are collected.
+
+static uint32_t getChecksum(const std::string& data)
+{
+	uint32_t a = 1, b = 0;
+	for (char c : data) {
+		a = (a + static_cast<uint8_t>(c)) % 65521;
+		b = (b + a) % 65521;
+	}
+	return (b << 16) | a;
+}
+
+static void appendFramed(std::string& segment, const PropWriteStream& body)
+{
+	size_t size;
+	const char* data = body.getStream(size);
+	const std::string record(data, size);
+	const uint32_t header[2] = {static_cast<uint32_t>(size), getChecksum(record)};
+	segment.append(reinterpret_cast<const char*>(header), sizeof(header));
+	segment.append(record);
+}
+
+struct TestRecord {
+	TestRecord(uint64_t sequence, uint32_t guid, uint32_t level) : sequence(sequence), guid(guid), level(level) {}
+
+	uint64_t sequence;
+	uint32_t guid;
+	uint32_t level;
+	std::map<uint32_t, std::pair<bool, int32_t>> storage;
+	std::vector<uint16_t> inventory;
+	bool saveInventory = false;
+	std::map<uint32_t, std::vector<uint16_t>> depots;
+	std::vector<std::string> spells;
+	bool saveSpells = false;
+};
+
+static void writeItems(PropWriteStream& body, const std::vector<uint16_t>& itemTypes)
+{
+	body.write<uint32_t>(itemTypes.size());
+	int32_t sid = 100;
+	for (uint16_t itemType : itemTypes) {
+		body.write<int32_t>(0);
+		body.write<int32_t>(sid++);
+		body.write<uint16_t>(itemType);
+		body.write<uint16_t>(1);
+		body.writeString(std::string());
+	}
+}
+
+static void appendPlayer(std::string& segment, const TestRecord& record)
+{
+	PropWriteStream stats;
+	stats.writeString("Player " + std::to_string(record.guid));
+	stats.write<uint16_t>(1); // group
+	stats.write<uint16_t>(2); // vocation
+	stats.write<uint32_t>(record.level);
+	stats.write<uint64_t>(record.level * 1000);
+	stats.write<int32_t>(150);
+	stats.write<int32_t>(185);
+	stats.write<uint32_t>(35);
+	stats.write<uint32_t>(55);
+	stats.write<uint32_t>(3); // magic level
+	stats.write<uint64_t>(0);
+	stats.write<uint8_t>(100); // soul
+	stats.write<uint32_t>(1); // town
+	stats.write<uint16_t>(32097);
+	stats.write<uint16_t>(32219);
+	stats.write<uint8_t>(7);
+	stats.write<uint32_t>(40000); // capacity
+	stats.write<uint8_t>(PLAYERSEX_MALE);
+	stats.write<uint16_t>(128);
+	stats.write<uint8_t>(78);
+	stats.write<uint8_t>(69);
+	stats.write<uint8_t>(58);
+	stats.write<uint8_t>(76);
+	stats.write<uint8_t>(0); // no skull saved
+	stats.write<int64_t>(0); // last logout
+	stats.write<uint64_t>(0); // bank balance
+	for (uint8_t i = SKILL_FIRST; i <= SKILL_LAST; ++i) {
+		stats.write<uint16_t>(10);
+		stats.write<uint64_t>(0);
+	}
+	stats.write<uint8_t>(0); // blessings
+	stats.writeString(std::string()); // conditions
+
+	size_t statsSize;
+	const char* statsData = stats.getStream(statsSize);
+
+	PropWriteStream body;
+	body.write<uint8_t>(1); // player record
+	body.write<uint64_t>(record.sequence);
+	body.write<uint32_t>(record.guid);
+	body.writeString(std::string(statsData, statsSize));
+
+	if (!record.storage.empty()) {
+		body.write<uint8_t>(1);
+		body.write<uint32_t>(record.storage.size());
+		for (const auto& it : record.storage) {
+			body.write<uint32_t>(it.first);
+			body.write<uint8_t>(it.second.first ? 1 : 0);
+			if (it.second.first) {
+				body.write<int32_t>(it.second.second);
+			}
+		}
+	}
+
+	if (record.saveInventory) {
+		body.write<uint8_t>(2);
+		writeItems(body, record.inventory);
+	}
+
+	for (const auto& it : record.depots) {
+		body.write<uint8_t>(3);
+		body.write<uint32_t>(it.first);
+		writeItems(body, it.second);
+	}
+
+	if (record.saveSpells) {
+		body.write<uint8_t>(4);
+		body.write<uint32_t>(record.spells.size());
+		for (const std::string& spell : record.spells) {
+			body.writeString(spell);
+		}
+	}
+
+	body.write<uint8_t>(0); // end
+	appendFramed(segment, body);
+}
+
+static void appendSaved(std::string& segment, uint32_t guid, uint64_t savedSequence)
+{
+	PropWriteStream body;
+	body.write<uint8_t>(2); // saved marker
+	body.write<uint32_t>(guid);
+	body.write<uint64_t>(savedSequence);
+	appendFramed(segment, body);
+}
+
+static std::map<uint32_t, PlayerSaveSnapshot> replay(const std::vector<std::string>& contents, bool* result = nullptr)
+{
+	std::vector<JournalSegment> segments;
+	for (size_t i = 0; i < contents.size(); ++i) {
+		segments.push_back({"segment " + std::to_string(i + 1), contents[i]});
+	}
+
+	std::map<uint32_t, PlayerSaveSnapshot> saved;
+	bool replayed = PlayerJournal::replay(segments, [&saved](PlayerSaveSnapshot& snapshot) {
+		BOOST_CHECK(saved.find(snapshot.guid) == saved.end());
+		saved[snapshot.guid] = snapshot;
+		return true;
+	});
+
+	if (result) {
+		*result = replayed;
+	} else {
+		BOOST_CHECK(replayed);
+	}
+	return saved;
+}
+
+static std::vector<uint16_t> getItemTypes(const std::vector<PlayerItemRow>& rows)
+{
+	std::vector<uint16_t> itemTypes;
+	for (const PlayerItemRow& row : rows) {
+		itemTypes.push_back(row.itemType);
+	}
+	return itemTypes;
+}
+
+BOOST_AUTO_TEST_CASE(replays_what_came_after_the_last_save)
+{
+	std::string first, second;
+	appendPlayer(first, {1, 7, 10});
+	appendPlayer(first, {2, 8, 20});
+	appendPlayer(first, {3, 7, 11});
+
+	// guid 7 was saved up to sequence 4, guid 8 never was
+	appendSaved(second, 7, 4);
+	appendPlayer(second, {4, 8, 21});
+
+	std::map<uint32_t, PlayerSaveSnapshot> saved = replay({first, second});
+	BOOST_CHECK(saved.find(7) == saved.end());
+	BOOST_REQUIRE(saved.find(8) != saved.end());
+	BOOST_CHECK_EQUAL(saved[8].level, 21);
+	BOOST_CHECK_EQUAL(saved[8].name, "Player 8");
+	BOOST_CHECK_EQUAL(saved[8].experience, 21000);
+	BOOST_CHECK(saved[8].loginPosition == Position(32097, 32219, 7));
+
+	// a marker in a later segment covers the records of earlier ones, the
+	// records at or after its sequence are replayed
+	std::string third;
+	appendPlayer(third, {5, 7, 12});
+	saved = replay({first, second, third});
+	BOOST_REQUIRE(saved.find(7) != saved.end());
+	BOOST_CHECK_EQUAL(saved[7].level, 12);
+
+	// the marker carries the first sequence the save did not cover
+	std::string boundary;
+	appendPlayer(boundary, {1, 7, 10});
+	appendSaved(boundary, 7, 2);
+	appendPlayer(boundary, {2, 7, 11});
+	saved = replay({boundary});
+	BOOST_CHECK_EQUAL(saved[7].level, 11);
+}
+
+BOOST_AUTO_TEST_CASE(merges_the_sections_of_every_record)
+{
+	TestRecord first{1, 7, 10};
+	first.storage[100] = {true, 1};
+	first.storage[101] = {true, 2};
+	first.saveInventory = true;
+	first.inventory = {2400, 2401};
+	first.depots[1] = {2148};
+	first.depots[2] = {2152};
+	first.saveSpells = true;
+	first.spells = {"light healing"};
+
+	TestRecord second{2, 7, 11};
+	second.storage[100] = {true, 5};
+	second.storage[101] = {false, 0};
+	second.depots[1] = {2160, 2160};
+
+	TestRecord third{3, 7, 12};
+	third.saveInventory = true;
+	third.inventory = {2402};
+
+	std::string segment;
+	appendPlayer(segment, first);
+	appendPlayer(segment, second);
+	appendPlayer(segment, third);
+
+	std::map<uint32_t, PlayerSaveSnapshot> saved = replay({segment});
+	BOOST_REQUIRE(saved.find(7) != saved.end());
+	const PlayerSaveSnapshot& snapshot = saved[7];
+
+	BOOST_CHECK_EQUAL(snapshot.level, 12);
+
+	BOOST_REQUIRE_EQUAL(snapshot.storage.size(), 1);
+	BOOST_CHECK_EQUAL(snapshot.storage[0].first, 100);
+	BOOST_CHECK_EQUAL(snapshot.storage[0].second, 5);
+	BOOST_REQUIRE_EQUAL(snapshot.removedStorageKeys.size(), 1);
+	BOOST_CHECK_EQUAL(snapshot.removedStorageKeys[0], 101);
+
+	BOOST_CHECK(snapshot.saveItems);
+	BOOST_CHECK(getItemTypes(snapshot.items) == std::vector<uint16_t>{2402});
+
+	// the newest rows of each depot, every depot that changed is rewritten
+	BOOST_CHECK(snapshot.savedDepots == (std::vector<uint32_t>{1, 2}));
+	BOOST_CHECK(getItemTypes(snapshot.depotItems) == (std::vector<uint16_t>{2160, 2160, 2152}));
+
+	BOOST_CHECK(snapshot.saveSpells);
+	BOOST_CHECK(snapshot.learnedSpells == std::vector<std::string>{"light healing"});
+	BOOST_CHECK(!snapshot.saveMurders);
+}
+
+BOOST_AUTO_TEST_CASE(stops_at_a_torn_record)
+{
+	std::string intact;
+	appendPlayer(intact, {1, 7, 10});
+	appendPlayer(intact, {2, 8, 20});
+
+	// a crash in the middle of the last write
+	std::string torn;
+	appendPlayer(torn, {3, 7, 11});
+	std::string segment = intact + torn.substr(0, torn.size() / 2);
+
+	std::map<uint32_t, PlayerSaveSnapshot> saved = replay({segment});
+	BOOST_CHECK_EQUAL(saved[7].level, 10);
+	BOOST_CHECK_EQUAL(saved[8].level, 20);
+
+	// a damaged byte ends the segment there, the next one still replays
+	std::string damaged = intact;
+	appendPlayer(damaged, {3, 7, 11});
+	appendPlayer(damaged, {4, 8, 21});
+	damaged[intact.size() + 20] ^= 0x55;
+
+	std::string next;
+	appendPlayer(next, {5, 9, 30});
+
+	saved = replay({damaged, next});
+	BOOST_CHECK_EQUAL(saved[7].level, 10);
+	BOOST_CHECK_EQUAL(saved[8].level, 20);
+	BOOST_CHECK_EQUAL(saved[9].level, 30);
+}
+
+BOOST_AUTO_TEST_CASE(fails_when_a_player_cannot_be_written)
+{
+	std::string segment;
+	appendPlayer(segment, {1, 7, 10});
+
+	std::vector<JournalSegment> segments = {{"segment 1", segment}};
+	BOOST_CHECK(!PlayerJournal::replay(segments, [](PlayerSaveSnapshot&) {
+		return false;
+	}));
+
+	BOOST_CHECK(PlayerJournal::replay({}, [](PlayerSaveSnapshot&) {
+		return false;
+	}));
+}
+
+// an hour of journal for 1000 players, a record a minute with some storage
+// and every tenth one with the inventory, replayed after a crash
+BOOST_AUTO_TEST_CASE(replay_throughput)
+{
+	static constexpr uint32_t PLAYERS = 1000;
+	static constexpr uint32_t RECORDS = 60;
+
+	std::string segment;
+	uint64_t sequence = 1;
+	for (uint32_t minute = 0; minute < RECORDS; ++minute) {
+		for (uint32_t guid = 1; guid <= PLAYERS; ++guid) {
+			TestRecord record{sequence++, guid, 100 + minute};
+			for (uint32_t key = 0; key < 5; ++key) {
+				record.storage[1000 + (minute * 5 + key) % 40] = {true, static_cast<int32_t>(minute)};
+			}
+			if (minute % 10 == 0) {
+				record.saveInventory = true;
+				record.inventory.assign(30, 2148);
+			}
+			appendPlayer(segment, record);
+		}
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	std::map<uint32_t, PlayerSaveSnapshot> saved = replay({segment});
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	BOOST_REQUIRE_EQUAL(saved.size(), PLAYERS);
+	BOOST_CHECK_EQUAL(saved[PLAYERS].level, 100 + RECORDS - 1);
+	BOOST_CHECK_EQUAL(saved[PLAYERS].items.size(), 30);
+
+	const size_t records = PLAYERS * RECORDS;
+	std::cout << records << " records, " << segment.size() / 1024 << " kB (" << segment.size() / records << " bytes a record), replayed in "
+		<< elapsed.count() << " ms (" << records / elapsed.count() * 1000 << " records/s)" << std::endl;
+}
@@ -0,0 +1,134 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#define BOOST_TEST_MODULE logincache
+
+#include "../otpch.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "../logincache.h"
+
+// The cache filled the way the server's own writes fill it, no database.
+
+static constexpr uint32_t ACCOUNTS = 100000;
+
+static std::string getName(uint32_t accountId, uint32_t character)
+{
+	return "Player " + std::to_string(accountId) + " " + std::to_string(character);
+}
+
+static void fillCache(LoginCache& cache)
+{
+	for (uint32_t accountId = 1; accountId <= ACCOUNTS; ++accountId) {
+		Account account;
+		account.id = accountId;
+		for (uint32_t i = 0; i < 3; ++i) {
+			account.characters.push_back(getName(accountId, i));
+		}
+		cache.setAccount(account, "hash " + std::to_string(accountId));
+
+		for (uint32_t i = 0; i < 3; ++i) {
+			CachedCharacter character;
+			character.name = getName(accountId, i);
+			character.guid = accountId * 3 + i;
+			character.accountId = accountId;
+			cache.setCharacter(character);
+		}
+	}
+}
+
+// the lookups of a game world login: ip ban, account and password, account
+// ban, character and namelock
+static bool login(const LoginCache& cache, uint32_t accountId, uint32_t ip)
+{
+	CachedBan ban;
+	if (cache.getIpBan(ip, ban)) {
+		return false;
+	}
+
+	Account account;
+	std::string password;
+	if (!cache.getAccount(accountId, account, password) || password != "hash " + std::to_string(accountId)) {
+		return false;
+	}
+
+	if (cache.getAccountBan(accountId, ban)) {
+		return false;
+	}
+
+	CachedCharacter character;
+	if (!cache.getCharacter(getName(accountId, accountId % 3), character) || character.accountId != accountId) {
+		return false;
+	}
+	return !cache.isNamelocked(character.guid);
+}
+
+BOOST_AUTO_TEST_CASE(bans_issued_in_game_apply_at_once)
+{
+	LoginCache cache;
+	fillCache(cache);
+	BOOST_CHECK(login(cache, 7, 0x0100007F));
+
+	CachedBan ban;
+	ban.reason = "botting";
+	ban.expiresAt = time(nullptr) + 3600;
+	cache.setAccountBan(7, ban);
+	BOOST_CHECK(!login(cache, 7, 0x0100007F));
+	BOOST_CHECK(login(cache, 8, 0x0100007F));
+
+	cache.removeAccountBan(7);
+	BOOST_CHECK(login(cache, 7, 0x0100007F));
+
+	cache.setIpBan(0x0200007F, ban);
+	BOOST_CHECK(!login(cache, 7, 0x0200007F));
+	BOOST_CHECK(login(cache, 7, 0x0100007F));
+
+	cache.setPassword(7, "new hash");
+	BOOST_CHECK(!login(cache, 7, 0x0100007F));
+}
+
+// logins served from memory, on one thread and on four at once as the
+// network threads would
+BOOST_AUTO_TEST_CASE(login_lookup_timing)
+{
+	LoginCache cache;
+	fillCache(cache);
+
+	static constexpr uint32_t LOGINS = 400000;
+	for (uint32_t threads : {1, 4}) {
+		std::atomic<uint32_t> succeeded(0);
+		const auto start = std::chrono::steady_clock::now();
+
+		std::vector<std::thread> workers;
+		for (uint32_t thread = 0; thread < threads; ++thread) {
+			workers.emplace_back([&, thread]() {
+				uint32_t local = 0;
+				for (uint32_t i = thread; i < LOGINS; i += threads) {
+					local += login(cache, 1 + (i * 7919) % ACCOUNTS, 0x0100007F);
+				}
+				succeeded += local;
+			});
+		}
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+
+		std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+		BOOST_CHECK_EQUAL(succeeded, LOGINS);
+		std::cout << threads << " thread(s): " << LOGINS << " logins against " << ACCOUNTS << " accounts in " << elapsed.count() / 1000
+			<< " ms, " << elapsed.count() / LOGINS << " us a login" << std::endl;
+	}
+}
@@ -0,0 +1,184 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#define BOOST_TEST_MODULE objectpool
+
+#include "../otpch.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <random>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "../objectpool.h"
+
+// A day of loot, corpses and decay squeezed into a few seconds: the number
+// of live items and containers follows the players online over 24 hours,
+// objects die in random order and texts of random sizes come and go between
+// them. The same run goes through the pools and through the global heap.
+
+static constexpr size_t ITEM_SIZE = 32; // sizeof(Item)
+static constexpr size_t CONTAINER_SIZE = 176; // sizeof(Container)
+static constexpr size_t HOURS = 24;
+static constexpr size_t CHANGES_PER_HOUR = 500000;
+
+struct SoakResult {
+	double nanoseconds; // per allocation and free
+	size_t peakObjects;
+	size_t heapFree; // bytes the heap holds but does not hand out
+	size_t heapUsed;
+};
+
+static size_t getHeapFree()
+{
+#ifdef __GLIBC__
+	struct mallinfo2 info = mallinfo2();
+	return info.fordblks;
+#else
+	return 0;
+#endif
+}
+
+static size_t getHeapUsed()
+{
+#ifdef __GLIBC__
+	return mallinfo2().uordblks;
+#else
+	return 0;
+#endif
+}
+
+static SoakResult soak(ObjectPool* itemPool, ObjectPool* containerPool)
+{
+	std::mt19937 generator(43);
+	std::vector<std::pair<void*, size_t>> objects;
+	std::vector<std::string> texts;
+
+	auto allocate = [&](size_t size) {
+		ObjectPool* pool = size == ITEM_SIZE ? itemPool : containerPool;
+		void* object = pool ? pool->allocate(size) : ::operator new(size);
+		objects.emplace_back(object, size);
+	};
+
+	auto release = [&]() {
+		const size_t index = generator() % objects.size();
+		std::swap(objects[index], objects.back());
+		const auto& object = objects.back();
+		ObjectPool* pool = object.second == ITEM_SIZE ? itemPool : containerPool;
+		if (pool) {
+			pool->deallocate(object.first, object.second);
+		} else {
+			::operator delete(object.first);
+		}
+		objects.pop_back();
+	};
+
+	SoakResult result = {};
+	const auto start = std::chrono::steady_clock::now();
+	size_t changes = 0;
+	for (size_t hour = 0; hour < HOURS; ++hour) {
+		// 40k objects at night, 200k in the evening
+		const double daylight = (1 - std::cos(hour * 2 * M_PI / HOURS)) / 2;
+		const size_t target = 40000 + static_cast<size_t>(160000 * daylight);
+
+		for (size_t i = 0; i < CHANGES_PER_HOUR; ++i) {
+			if (objects.size() < target ? generator() % 8 != 0 : generator() % 8 == 0) {
+				allocate(generator() % 8 == 0 ? CONTAINER_SIZE : ITEM_SIZE);
+			} else if (!objects.empty()) {
+				release();
+			}
+
+			if (i % 16 == 0) {
+				if (texts.size() < 20000) {
+					texts.emplace_back(16 + generator() % 500, 'x');
+				} else {
+					texts[generator() % texts.size()] = std::string(16 + generator() % 500, 'y');
+				}
+			}
+			++changes;
+		}
+		result.peakObjects = std::max(result.peakObjects, objects.size());
+	}
+
+	// back to the night, what the heap keeps from the evening
+	while (objects.size() > 40000) {
+		release();
+		++changes;
+	}
+	result.nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / changes;
+	result.heapFree = getHeapFree();
+	result.heapUsed = getHeapUsed();
+
+	while (!objects.empty()) {
+		release();
+	}
+	return result;
+}
+
+// allocation throughput alone: 200k items allocated and freed in random
+// order, ten times over
+static double churn(ObjectPool* pool)
+{
+	std::mt19937 generator(47);
+	std::vector<void*> objects(200000);
+
+	const auto start = std::chrono::steady_clock::now();
+	for (int round = 0; round < 10; ++round) {
+		for (void*& object : objects) {
+			object = pool ? pool->allocate(ITEM_SIZE) : ::operator new(ITEM_SIZE);
+		}
+
+		std::shuffle(objects.begin(), objects.end(), generator);
+		for (void* object : objects) {
+			if (pool) {
+				pool->deallocate(object, ITEM_SIZE);
+			} else {
+				::operator delete(object);
+			}
+		}
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (10 * objects.size());
+}
+
+// ctest runs each case in a process of its own, so neither heap holds what
+// the other run left
+BOOST_AUTO_TEST_CASE(soak_global_heap)
+{
+	SoakResult result = soak(nullptr, nullptr);
+	std::cout << "global heap: " << churn(nullptr) << " ns per allocation and free; soak " << result.nanoseconds << " ns per change, peak " << result.peakObjects << " objects, at night "
+		<< result.heapUsed / 1024 << " kB used and " << result.heapFree / 1024 << " kB free in the heap" << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(soak_pools)
+{
+	ObjectPool& itemPool = ObjectPool::create("Item", ITEM_SIZE);
+	ObjectPool& containerPool = ObjectPool::create("Container", CONTAINER_SIZE);
+
+	SoakResult result = soak(&itemPool, &containerPool);
+
+	const ObjectPoolStats items = itemPool.getStats();
+	const ObjectPoolStats containers = containerPool.getStats();
+	BOOST_CHECK_EQUAL(items.inUse, 0);
+	BOOST_CHECK_EQUAL(containers.inUse, 0);
+	BOOST_CHECK(items.capacity >= items.peakInUse);
+	BOOST_CHECK_EQUAL(items.fallbacks + containers.fallbacks, 0);
+
+	std::cout << "pools: " << churn(&itemPool) << " ns per allocation and free; soak " << result.nanoseconds << " ns per change, peak " << result.peakObjects << " objects, slabs for "
+		<< items.capacity << " items and " << containers.capacity << " containers (peaks " << items.peakInUse << " and " << containers.peakInUse
+		<< "), at night " << result.heapUsed / 1024 << " kB used and " << result.heapFree / 1024 << " kB free in the heap" << std::endl;
+}
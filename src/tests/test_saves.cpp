@@ -0,0 +1,276 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#define BOOST_TEST_MODULE saves
+
+#include "../otpch.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "../depotlocker.h"
+#include "../house.h"
+#include "../iologindata.h"
+#include "../iomapserialize.h"
+
+#include "testitems.h"
+
+// The dispatcher side of a server save, the part the game waits for, on
+// item trees built from items.srv. Writing the rows needs a MySQL server.
+
+static constexpr uint32_t PLAYERS = 1000;
+static constexpr uint32_t HOUSES = 500;
+
+// fills a container with items and stacks, and bags holding more
+static void fillContainer(Container* container, Random& random, size_t items, size_t bags)
+{
+	const ItemPools& pools = getItemPools();
+	for (size_t i = 0; i < bags; ++i) {
+		Container* bag = Item::CreateItem(random.pick(pools.containers))->getContainer();
+		fillContainer(bag, random, random(5, 19), 0);
+		container->internalAddThing(bag);
+	}
+
+	for (size_t i = 0; i < items; ++i) {
+		if (random(0, 3) == 0) {
+			container->internalAddThing(Item::CreateItem(random.pick(pools.stackables), random(1, 100)));
+		} else {
+			container->internalAddThing(Item::CreateItem(random.pick(pools.plain)));
+		}
+	}
+}
+
+// the item trees of a player: a carried backpack and a depot chest full of
+// backpacks, each in a locker so IOLoginData::snapshotDepot flattens it the
+// way a save does
+struct PlayerTrees {
+	DepotLocker* inventory;
+	DepotLocker* depot;
+	uint32_t savedInventoryGeneration = 0;
+	uint32_t savedDepotGeneration = 0;
+};
+
+static DepotLocker* createTree(Random& random, size_t items, size_t bags)
+{
+	DepotLocker* locker = new DepotLocker(ITEM_LOCKER1);
+	Container* container = Item::CreateItem(getItemPools().containers.front())->getContainer();
+	fillContainer(container, random, items, bags);
+	locker->internalAddThing(container);
+	return locker;
+}
+
+static std::vector<PlayerTrees> createPlayers(uint32_t seed)
+{
+	Random random(seed);
+	std::vector<PlayerTrees> players(PLAYERS);
+	for (PlayerTrees& trees : players) {
+		trees.inventory = createTree(random, random(10, 19), random(0, 3));
+		trees.depot = createTree(random, random(0, 20), random(0, 10));
+	}
+	return players;
+}
+
+struct SnapshotResult {
+	size_t rows = 0;
+	size_t bytes = 0; // attribute blobs
+	double milliseconds = 0;
+};
+
+static void snapshotTree(uint32_t id, DepotLocker* tree, SnapshotResult& result)
+{
+	std::vector<PlayerItemRow> rows;
+	PropWriteStream stream;
+	IOLoginData::snapshotDepot(id, tree, rows, stream);
+
+	result.rows += rows.size();
+	for (const PlayerItemRow& row : rows) {
+		result.bytes += row.attributes.size();
+	}
+}
+
+BOOST_AUTO_TEST_CASE(player_snapshots)
+{
+	std::vector<PlayerTrees> players = createPlayers(31);
+
+	SnapshotResult result;
+	const auto start = std::chrono::steady_clock::now();
+	for (const PlayerTrees& trees : players) {
+		snapshotTree(1, trees.inventory, result);
+		snapshotTree(2, trees.depot, result);
+	}
+	result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	BOOST_CHECK(result.rows > PLAYERS * 50);
+	std::cout << PLAYERS << " players, " << result.rows << " item rows (" << result.bytes / 1024 << " kB of attributes): snapshot in "
+		<< result.milliseconds << " ms, " << result.milliseconds * 1000 / PLAYERS << " us a player" << std::endl;
+}
+
+// a save after a while of play: most players moved something they carry,
+// few went to the depot; only the trees whose generation moved are written
+BOOST_AUTO_TEST_CASE(incremental_player_rows)
+{
+	std::vector<PlayerTrees> players = createPlayers(32);
+
+	SnapshotResult full;
+	for (PlayerTrees& trees : players) {
+		snapshotTree(1, trees.inventory, full);
+		snapshotTree(2, trees.depot, full);
+		trees.savedInventoryGeneration = trees.inventory->getGeneration();
+		trees.savedDepotGeneration = trees.depot->getGeneration();
+	}
+
+	Random random(33);
+	const ItemPools& pools = getItemPools();
+	for (PlayerTrees& trees : players) {
+		if (random(0, 9) < 6) {
+			trees.inventory->internalAddThing(Item::CreateItem(random.pick(pools.plain)));
+		}
+		if (random(0, 9) == 0) {
+			trees.depot->internalAddThing(Item::CreateItem(random.pick(pools.plain)));
+		}
+	}
+
+	SnapshotResult changed;
+	size_t trees = 0;
+	for (PlayerTrees& player : players) {
+		if (player.inventory->getGeneration() != player.savedInventoryGeneration) {
+			snapshotTree(1, player.inventory, changed);
+			++trees;
+		}
+		if (player.depot->getGeneration() != player.savedDepotGeneration) {
+			snapshotTree(2, player.depot, changed);
+			++trees;
+		}
+	}
+
+	BOOST_CHECK(trees > 0 && trees < PLAYERS);
+	BOOST_CHECK(changed.rows < full.rows / 2);
+	std::cout << "full save " << full.rows << " item rows, " << trees << " changed trees " << changed.rows << " item rows" << std::endl;
+}
+
+// houses of 20 to 60 tiles, a ground on each and furniture, loose items
+// and a chest on some
+static std::vector<House*> createHouses(uint32_t seed)
+{
+	Random random(seed);
+	const ItemPools& pools = getItemPools();
+
+	std::vector<House*> houses;
+	for (uint32_t id = 1; id <= HOUSES; ++id) {
+		House* house = new House(id);
+		const uint16_t baseX = 1000 + (id % 50) * 10;
+		const uint16_t baseY = 1000 + (id / 50) * 10;
+		for (size_t i = random(20, 60); i != 0; --i) {
+			HouseTile* houseTile = new HouseTile(baseX + i % 8, baseY + i / 8, 7, house);
+			house->addTile(houseTile);
+
+			Tile* tile = houseTile;
+			tile->internalAddThing(Item::CreateItem(random.pick(pools.grounds)));
+
+			const size_t contents = random(0, 9);
+			if (contents < 3) {
+				tile->internalAddThing(Item::CreateItem(random.pick(pools.plain)));
+			} else if (contents == 3) {
+				Container* chest = Item::CreateItem(random.pick(pools.containers))->getContainer();
+				fillContainer(chest, random, random(1, 15), 0);
+				tile->internalAddThing(chest);
+			}
+		}
+		houses.push_back(house);
+	}
+	return houses;
+}
+
+struct HouseSnapshotResult {
+	size_t houses = 0;
+	size_t infos = 0; // houses rows
+	size_t rows = 0; // tile_store rows
+	size_t bytes = 0;
+};
+
+static HouseSnapshotResult snapshotHouses(const std::vector<House*>& houses, bool fullSave)
+{
+	HouseSnapshotResult result;
+	for (House* house : houses) {
+		if (!fullSave && !house->isInfoModified() && !house->isItemsModified()) {
+			continue;
+		}
+
+		HouseSaveSnapshot snapshot;
+		IOMapSerialize::snapshotHouse(house, snapshot, fullSave);
+		++result.houses;
+		result.infos += snapshot.saveInfo;
+		result.rows += snapshot.tiles.size();
+		for (const std::string& tile : snapshot.tiles) {
+			result.bytes += tile.size();
+		}
+
+		// as if the write had committed
+		house->setSavedInfoGeneration(snapshot.infoGeneration);
+		house->setSavedItemsGeneration(snapshot.itemsGeneration);
+	}
+	return result;
+}
+
+// the freeze of a server save: one pass over every online player and every
+// house, the writes are left to the database workers
+BOOST_AUTO_TEST_CASE(server_save_freeze)
+{
+	std::vector<PlayerTrees> players = createPlayers(35);
+	std::vector<House*> houses = createHouses(35);
+
+	SnapshotResult playerResult;
+	const auto start = std::chrono::steady_clock::now();
+	for (const PlayerTrees& trees : players) {
+		snapshotTree(1, trees.inventory, playerResult);
+		snapshotTree(2, trees.depot, playerResult);
+	}
+	HouseSnapshotResult houseResult = snapshotHouses(houses, true);
+	std::chrono::duration<double, std::milli> freeze = std::chrono::steady_clock::now() - start;
+
+	BOOST_CHECK_EQUAL(houseResult.houses, HOUSES);
+	std::cout << "server save of " << PLAYERS << " players (" << playerResult.rows << " item rows) and " << HOUSES << " houses ("
+		<< houseResult.rows << " tiles, " << houseResult.bytes / 1024 << " kB): " << freeze.count() << " ms freeze" << std::endl;
+}
+
+// a save after some play: a few owners moved things around, more paid
+// their rent; unchanged houses are skipped, items and info apart
+BOOST_AUTO_TEST_CASE(incremental_house_rows)
+{
+	std::vector<House*> houses = createHouses(36);
+	HouseSnapshotResult full = snapshotHouses(houses, true);
+
+	Random random(37);
+	const ItemPools& pools = getItemPools();
+	for (House* house : houses) {
+		if (random(0, 19) == 0) {
+			const HouseTileList& tiles = house->getTiles();
+			Tile* tile = *std::next(tiles.begin(), random(0, tiles.size() - 1));
+			tile->internalAddThing(Item::CreateItem(random.pick(pools.plain)));
+		}
+		if (random(0, 9) == 0) {
+			house->setPaidUntil(time(nullptr) + 7 * 24 * 60 * 60);
+		}
+	}
+
+	HouseSnapshotResult changed = snapshotHouses(houses, false);
+	BOOST_CHECK(changed.houses > 0 && changed.houses < HOUSES / 4);
+	BOOST_CHECK(changed.rows < full.rows / 10);
+
+	// nothing changed since, nothing is written
+	BOOST_CHECK_EQUAL(snapshotHouses(houses, false).houses, 0);
+
+	std::cout << "full house save " << full.houses << " houses, " << full.rows << " tiles, " << full.bytes / 1024 << " kB; incremental "
+		<< changed.houses << " houses (" << changed.infos << " info), " << changed.rows << " tiles, " << changed.bytes / 1024 << " kB" << std::endl;
+}
@@ -0,0 +1,309 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#define BOOST_TEST_MODULE tiles
+
+#include "../otpch.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "../tile.h"
+
+#include "testitems.h"
+
+// the property of an item type as Item::hasProperty read it from the item
+// type before the packed table, kept as the reference the mask must match
+static bool hasReferenceProperty(uint16_t id, ITEMPROPERTY prop)
+{
+	const ItemType& it = Item::items[id];
+	switch (prop) {
+		case CONST_PROP_BLOCKSOLID: return it.blockSolid;
+		case CONST_PROP_MOVEABLE: return it.moveable;
+		case CONST_PROP_HASHEIGHT: return it.hasHeight;
+		case CONST_PROP_BLOCKPROJECTILE: return it.blockProjectile;
+		case CONST_PROP_BLOCKPATH: return it.blockPathFind;
+		case CONST_PROP_ISVERTICAL: return it.isVertical;
+		case CONST_PROP_ISHORIZONTAL: return it.isHorizontal;
+		case CONST_PROP_IMMOVABLEBLOCKSOLID: return it.blockSolid && !it.moveable;
+		case CONST_PROP_IMMOVABLEBLOCKPATH: return it.blockPathFind && !it.moveable;
+		case CONST_PROP_IMMOVABLENOFIELDBLOCKPATH: return !it.isMagicField() && it.blockPathFind && !it.moveable;
+		case CONST_PROP_NOFIELDBLOCKPATH: return !it.isMagicField() && it.blockPathFind;
+		case CONST_PROP_SUPPORTHANGABLE: return it.isHorizontal || it.isVertical;
+		case CONST_PROP_UNLAY: return !it.allowPickupable;
+		default: return false;
+	}
+}
+
+// every item on the tile, the ground first
+static std::vector<Item*> getItems(Tile* tile)
+{
+	std::vector<Item*> items;
+	if (Item* ground = tile->getGround()) {
+		items.push_back(ground);
+	}
+	if (TileItemVector* tileItems = tile->getItemList()) {
+		items.insert(items.end(), tileItems->begin(), tileItems->end());
+	}
+	return items;
+}
+
+// the tile flags set and cleared with the property of the same meaning
+static const std::pair<ITEMPROPERTY, uint32_t> propertyFlags[] = {
+	{CONST_PROP_BLOCKSOLID, TILESTATE_BLOCKSOLID},
+	{CONST_PROP_IMMOVABLEBLOCKSOLID, TILESTATE_IMMOVABLEBLOCKSOLID},
+	{CONST_PROP_BLOCKPATH, TILESTATE_BLOCKPATH},
+	{CONST_PROP_NOFIELDBLOCKPATH, TILESTATE_NOFIELDBLOCKPATH},
+	{CONST_PROP_IMMOVABLENOFIELDBLOCKPATH, TILESTATE_IMMOVABLENOFIELDBLOCKPATH},
+	{CONST_PROP_SUPPORTHANGABLE, TILESTATE_SUPPORTS_HANGABLE},
+};
+
+// the mask, the flags derived from it and the lookups that skip an item,
+// against the properties recounted item by item
+static bool checkProperties(Tile* tile)
+{
+	const std::vector<Item*> items = getItems(tile);
+
+	bool matches = true;
+	for (uint8_t i = CONST_PROP_BLOCKSOLID; i <= CONST_PROP_UNLAY; ++i) {
+		const ITEMPROPERTY prop = static_cast<ITEMPROPERTY>(i);
+
+		bool expected = false;
+		for (const Item* item : items) {
+			expected = expected || hasReferenceProperty(item->getID(), prop);
+		}
+
+		if (tile->hasProperty(prop) != expected) {
+			BOOST_ERROR("property " << static_cast<int>(prop) << " is " << tile->hasProperty(prop) << ", recounted " << expected);
+			matches = false;
+		}
+
+		for (const Item* exclude : items) {
+			bool expectedWithout = false;
+			for (const Item* item : items) {
+				expectedWithout = expectedWithout || (item != exclude && hasReferenceProperty(item->getID(), prop));
+			}
+
+			if (tile->hasProperty(exclude, prop) != expectedWithout) {
+				BOOST_ERROR("property " << static_cast<int>(prop) << " without item " << exclude->getID() << " is " << !expectedWithout << ", recounted " << expectedWithout);
+				matches = false;
+			}
+		}
+	}
+
+	for (const auto& it : propertyFlags) {
+		if (tile->hasFlag(it.second) != tile->hasProperty(it.first)) {
+			BOOST_ERROR("flag " << it.second << " does not follow property " << static_cast<int>(it.first));
+			matches = false;
+		}
+	}
+
+	if (!tile->checkProperties()) {
+		BOOST_ERROR("Tile::checkProperties disagrees with the mask");
+		matches = false;
+	}
+	return matches;
+}
+
+// the item types of the pool the item belongs to
+static const std::vector<uint16_t>& getPool(uint16_t id)
+{
+	const ItemPools& pools = getItemPools();
+	const ItemType& it = Item::items[id];
+	if (it.isGroundTile()) {
+		return pools.grounds;
+	} else if (it.alwaysOnTop) {
+		return pools.tops.at(it.alwaysOnTopOrder);
+	} else if (it.isMagicField()) {
+		return pools.fields;
+	}
+	return pools.downs;
+}
+
+static uint16_t findItemType(const std::vector<uint16_t>& pool, ITEMPROPERTY prop, bool hasProp = true)
+{
+	for (uint16_t id : pool) {
+		if (hasReferenceProperty(id, prop) == hasProp) {
+			return id;
+		}
+	}
+	BOOST_FAIL("no item type " << (hasProp ? "with" : "without") << " property " << static_cast<int>(prop));
+	return 0;
+}
+
+BOOST_AUTO_TEST_CASE(add_remove_and_transform)
+{
+	const ItemPools& pools = getItemPools();
+	Tile* tile = new DynamicTile(100, 100, 7);
+
+	tile->addThing(Item::CreateItem(findItemType(pools.grounds, CONST_PROP_BLOCKSOLID, false)));
+	BOOST_CHECK(checkProperties(tile));
+
+	// two blocking items, removing one keeps the tile blocked
+	const uint16_t blockingId = findItemType(pools.downs, CONST_PROP_BLOCKSOLID);
+	Item* first = Item::CreateItem(blockingId);
+	Item* second = Item::CreateItem(blockingId);
+	tile->addThing(first);
+	tile->addThing(second);
+	BOOST_CHECK(checkProperties(tile));
+	BOOST_CHECK(tile->hasProperty(CONST_PROP_BLOCKSOLID));
+
+	tile->removeThing(first, 1);
+	BOOST_CHECK(checkProperties(tile));
+	BOOST_CHECK(tile->hasProperty(CONST_PROP_BLOCKSOLID));
+
+	// the last one going, or turning into an item that does not block, clears it
+	tile->updateThing(second, findItemType(pools.downs, CONST_PROP_BLOCKSOLID, false), 1);
+	BOOST_CHECK(checkProperties(tile));
+	BOOST_CHECK(!tile->hasProperty(CONST_PROP_BLOCKSOLID));
+
+	tile->replaceThing(tile->getThingIndex(second), Item::CreateItem(blockingId));
+	BOOST_CHECK(checkProperties(tile));
+	BOOST_CHECK(tile->hasProperty(CONST_PROP_BLOCKSOLID));
+
+	// a wall that can hold a hangable item
+	Item* hook = Item::CreateItem(findItemType(pools.items, CONST_PROP_SUPPORTHANGABLE));
+	tile->addThing(hook);
+	BOOST_CHECK(checkProperties(tile));
+	tile->removeThing(hook, 1);
+	BOOST_CHECK(checkProperties(tile));
+
+	tile->removeThing(tile->getGround(), 1);
+	BOOST_CHECK(checkProperties(tile));
+}
+
+// random adds, removes, transforms and replaces on one tile, recounted after
+// each of them
+BOOST_AUTO_TEST_CASE(random_changes_match_recount)
+{
+	const ItemPools& pools = getItemPools();
+
+	std::vector<const std::vector<uint16_t>*> addPools;
+	addPools.push_back(&pools.downs);
+	for (const auto& it : pools.tops) {
+		addPools.push_back(&it.second);
+	}
+
+	Tile* tile = new DynamicTile(100, 100, 7);
+	runRandomChanges(49, 3000, [&](Random& random) -> size_t {
+		const std::vector<Item*> items = getItems(tile);
+		const size_t action = items.empty() ? 0 : random(0, 4);
+
+		switch (action) {
+			case 0: {
+				// a ground or field already there would be released through
+				// the move events, which are not loaded here
+				uint16_t id;
+				if (!tile->getGround()) {
+					id = random.pick(pools.grounds);
+				} else if (!tile->getFieldItem() && random(0, 5) == 0) {
+					id = random.pick(pools.fields);
+				} else {
+					id = random.pick(*addPools[random(0, addPools.size() - 1)]);
+				}
+
+				if (items.size() < 20) {
+					tile->addThing(Item::CreateItem(id));
+				}
+				break;
+			}
+
+			case 1:
+				if (items.size() < 20) {
+					tile->internalAddThing(Item::CreateItem(random.pick(*addPools[random(0, addPools.size() - 1)])));
+				}
+				break;
+
+			case 2: {
+				Item* item = items[random(0, items.size() - 1)];
+				tile->removeThing(item, item->isStackable() ? random(1, item->getItemCount()) : 1);
+				break;
+			}
+
+			case 3: {
+				Item* item = items[random(0, items.size() - 1)];
+				tile->updateThing(item, random.pick(getPool(item->getID())), 1);
+				break;
+			}
+
+			default: {
+				Item* item = items[random(0, items.size() - 1)];
+				tile->replaceThing(tile->getThingIndex(item), Item::CreateItem(random.pick(getPool(item->getID()))));
+				break;
+			}
+		}
+		return action;
+	}, [tile]() {
+		return checkProperties(tile);
+	});
+}
+
+// every property of 10k tiles read from the mask against walking the items
+// as hasProperty did before it, and the cost of keeping the mask on adds
+// and removes
+BOOST_AUTO_TEST_CASE(lookup_timing)
+{
+	const ItemPools& pools = getItemPools();
+	Random random(50);
+
+	std::vector<Tile*> tiles;
+	for (uint16_t x = 0; x < 10000; ++x) {
+		Tile* tile = new DynamicTile(100 + x % 100, 100 + x / 100, 7);
+		tile->addThing(Item::CreateItem(random.pick(pools.grounds)));
+		for (size_t i = random(0, 4); i != 0; --i) {
+			tile->addThing(Item::CreateItem(random.pick(pools.downs)));
+		}
+		tiles.push_back(tile);
+	}
+
+	static constexpr size_t ROUNDS = 20;
+	size_t found[2] = {};
+	std::chrono::duration<double, std::milli> elapsed[2];
+	for (int walk = 0; walk < 2; ++walk) {
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t round = 0; round < ROUNDS; ++round) {
+			for (Tile* tile : tiles) {
+				for (uint8_t i = CONST_PROP_BLOCKSOLID; i <= CONST_PROP_UNLAY; ++i) {
+					const ITEMPROPERTY prop = static_cast<ITEMPROPERTY>(i);
+					if (!walk) {
+						found[walk] += tile->hasProperty(prop);
+						continue;
+					}
+
+					bool has = tile->getGround()->hasProperty(prop);
+					if (const TileItemVector* items = tile->getItemList()) {
+						for (auto it = items->begin(); !has && it != items->end(); ++it) {
+							has = (*it)->hasProperty(prop);
+						}
+					}
+					found[walk] += has;
+				}
+			}
+		}
+		elapsed[walk] = std::chrono::steady_clock::now() - start;
+	}
+	BOOST_CHECK_EQUAL(found[0], found[1]);
+
+	const size_t lookups = ROUNDS * tiles.size() * (CONST_PROP_UNLAY - CONST_PROP_BLOCKSOLID + 1);
+	std::cout << lookups << " lookups: mask " << elapsed[0].count() * 1e6 / lookups << " ns, item walk " << elapsed[1].count() * 1e6 / lookups << " ns per lookup" << std::endl;
+
+	const auto start = std::chrono::steady_clock::now();
+	for (Tile* tile : tiles) {
+		Item* item = Item::CreateItem(random.pick(pools.downs));
+		tile->addThing(item);
+		tile->removeThing(item, 1);
+	}
+	std::chrono::duration<double, std::milli> changed = std::chrono::steady_clock::now() - start;
+	std::cout << tiles.size() << " adds and removes in " << changed.count() << " ms" << std::endl;
+}
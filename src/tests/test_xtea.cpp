@@ -0,0 +1,143 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#define BOOST_TEST_MODULE xtea
+
+#include "../otpch.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <chrono>
+#include <random>
+
+#include "../xtea.h"
+
+// the per-block loop Protocol used before the cipher was vectorized
+static void encryptReference(uint8_t* buffer, size_t length, const xtea::key& k)
+{
+	const uint32_t delta = 0x61C88647;
+	for (size_t readPos = 0; readPos < length; readPos += 8) {
+		uint32_t v0, v1;
+		memcpy(&v0, buffer + readPos, 4);
+		memcpy(&v1, buffer + readPos + 4, 4);
+
+		uint32_t sum = 0;
+		for (int32_t i = 32; --i >= 0;) {
+			v0 += ((v1 << 4 ^ v1 >> 5) + v1) ^ (sum + k[sum & 3]);
+			sum -= delta;
+			v1 += ((v0 << 4 ^ v0 >> 5) + v0) ^ (sum + k[(sum >> 11) & 3]);
+		}
+
+		memcpy(buffer + readPos, &v0, 4);
+		memcpy(buffer + readPos + 4, &v1, 4);
+	}
+}
+
+static void decryptReference(uint8_t* buffer, size_t length, const xtea::key& k)
+{
+	const uint32_t delta = 0x61C88647;
+	for (size_t readPos = 0; readPos < length; readPos += 8) {
+		uint32_t v0, v1;
+		memcpy(&v0, buffer + readPos, 4);
+		memcpy(&v1, buffer + readPos + 4, 4);
+
+		uint32_t sum = 0xC6EF3720;
+		for (int32_t i = 32; --i >= 0;) {
+			v1 -= ((v0 << 4 ^ v0 >> 5) + v0) ^ (sum + k[(sum >> 11) & 3]);
+			sum += delta;
+			v0 -= ((v1 << 4 ^ v1 >> 5) + v1) ^ (sum + k[sum & 3]);
+		}
+
+		memcpy(buffer + readPos, &v0, 4);
+		memcpy(buffer + readPos + 4, &v1, 4);
+	}
+}
+
+static const xtea::implementation implementations[] = {xtea::SCALAR, xtea::SSE2, xtea::AVX2};
+static const char* implementationNames[] = {"scalar", "sse2", "avx2"};
+
+BOOST_AUTO_TEST_CASE(matches_reference)
+{
+	std::mt19937 rng(772);
+	std::vector<uint8_t> plain, expected, actual;
+
+	for (int run = 0; run < 2000; ++run) {
+		xtea::key k;
+		for (uint32_t& word : k) {
+			word = rng();
+		}
+		const xtea::round_keys roundKeys = xtea::expand_key(k);
+
+		// every tail length up to two AVX2 iterations, then packet sized ones
+		size_t length = (run < 17 ? run : rng() % 3072) * 8;
+		plain.resize(length);
+		for (uint8_t& byte : plain) {
+			byte = rng();
+		}
+
+		expected = plain;
+		encryptReference(expected.data(), length, k);
+
+		for (xtea::implementation impl : implementations) {
+			if (!xtea::is_supported(impl)) {
+				continue;
+			}
+
+			actual = plain;
+			xtea::encrypt(actual.data(), length, roundKeys, impl);
+			BOOST_REQUIRE_MESSAGE(actual == expected, implementationNames[impl] << " encrypt differs, length " << length);
+
+			xtea::decrypt(actual.data(), length, roundKeys, impl);
+			BOOST_REQUIRE_MESSAGE(actual == plain, implementationNames[impl] << " decrypt differs, length " << length);
+		}
+
+		actual = plain;
+		xtea::encrypt(actual.data(), length, roundKeys);
+		BOOST_REQUIRE(actual == expected);
+
+		decryptReference(expected.data(), length, k);
+		BOOST_REQUIRE(expected == plain);
+		xtea::decrypt(actual.data(), length, roundKeys);
+		BOOST_REQUIRE(actual == plain);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(throughput)
+{
+	const xtea::key k = {{0x01234567, 0x89ABCDEF, 0xFEDCBA98, 0x76543210}};
+	const xtea::round_keys roundKeys = xtea::expand_key(k);
+
+	for (size_t length : {64, 4096, 24576}) {
+		std::vector<uint8_t> buffer(length, 0x5A);
+		const size_t passes = (64 << 20) / length;
+
+		auto measure = [&](const std::function<void()>& pass) {
+			auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < passes; ++i) {
+				pass();
+			}
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			return (length * passes) / elapsed.count() / (1 << 20);
+		};
+
+		std::cout << "encrypt " << length << " B: reference " << static_cast<int>(measure([&]() { encryptReference(buffer.data(), length, k); })) << " MB/s";
+		for (xtea::implementation impl : implementations) {
+			if (xtea::is_supported(impl)) {
+				std::cout << ", " << implementationNames[impl] << ' ' << static_cast<int>(measure([&]() { xtea::encrypt(buffer.data(), length, roundKeys, impl); })) << " MB/s";
+			}
+		}
+		std::cout << std::endl;
+	}
+}
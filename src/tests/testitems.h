@@ -0,0 +1,135 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+
+#ifndef FS_TESTITEMS_H_5460404E9EA74230AD98D21B26B85CC3
+#define FS_TESTITEMS_H_5460404E9EA74230AD98D21B26B85CC3
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+
+#include "../item.h"
+
+// item types from the repository's items.srv for the tests of the game
+// core, included once by each test after the Boost.Test runner
+
+// the item types of items.srv, read from the repository root
+struct ItemsFixture {
+	ItemsFixture() {
+		if (!Item::items.loadItems()) {
+			throw std::runtime_error("unable to load data/items/items.srv, run from the repository root");
+		}
+	}
+};
+BOOST_GLOBAL_FIXTURE(ItemsFixture);
+
+static const uint16_t coinIds[] = {ITEM_GOLD_COIN, ITEM_PLATINUM_COIN, ITEM_CRYSTAL_COIN};
+
+inline bool isCoin(uint16_t id)
+{
+	return std::find(std::begin(coinIds), std::end(coinIds), id) != std::end(coinIds);
+}
+
+// item types found in items.srv, by what containers and tiles do with them
+struct ItemPools {
+	// pickupable, coins left out
+	std::vector<uint16_t> containers;
+	std::vector<uint16_t> stackables;
+	std::vector<uint16_t> plain;
+
+	// by where they go on a tile, splashes, teleports, mailboxes and
+	// containers left out
+	std::vector<uint16_t> grounds;
+	std::map<uint8_t, std::vector<uint16_t>> tops;
+	std::vector<uint16_t> downs;
+	std::vector<uint16_t> fields;
+	std::vector<uint16_t> items; // tops and downs
+};
+
+inline const ItemPools& getItemPools()
+{
+	static ItemPools pools;
+	if (!pools.grounds.empty()) {
+		return pools;
+	}
+
+	for (size_t id = 100; id < Item::items.size(); ++id) {
+		const ItemType& it = Item::items[id];
+		if (it.id == 0) {
+			continue;
+		}
+
+		if (it.pickupable && !isCoin(id)) {
+			if (it.type == ITEM_TYPE_CONTAINER && it.maxItems >= 4) {
+				pools.containers.push_back(id);
+			} else if (it.stackable) {
+				pools.stackables.push_back(id);
+			} else if (!it.hasSubType() && it.type == ITEM_TYPE_NONE) {
+				pools.plain.push_back(id);
+			}
+		}
+
+		if (it.isSplash() || it.isTeleport() || it.isMailbox() || it.isContainer()) {
+			continue;
+		}
+
+		if (it.isGroundTile()) {
+			pools.grounds.push_back(id);
+		} else if (it.alwaysOnTop) {
+			pools.tops[it.alwaysOnTopOrder].push_back(id);
+			pools.items.push_back(id);
+		} else if (it.isMagicField()) {
+			pools.fields.push_back(id);
+		} else {
+			pools.downs.push_back(id);
+			pools.items.push_back(id);
+		}
+	}
+
+	BOOST_REQUIRE(!pools.containers.empty() && !pools.stackables.empty() && !pools.plain.empty());
+	BOOST_REQUIRE(!pools.grounds.empty() && !pools.tops.empty() && !pools.downs.empty() && !pools.fields.empty());
+	return pools;
+}
+
+// seeded so a failing run can be repeated
+class Random
+{
+	public:
+		explicit Random(uint32_t seed) : generator(seed) {}
+
+		size_t operator()(size_t min, size_t max) {
+			return std::uniform_int_distribution<size_t>(min, max)(generator);
+		}
+
+		uint16_t pick(const std::vector<uint16_t>& pool) {
+			return pool[(*this)(0, pool.size() - 1)];
+		}
+
+	private:
+		std::mt19937 generator;
+};
+
+// runs steps random changes, each returns the action it took, and stops at
+// the first one check does not agree with
+inline void runRandomChanges(uint32_t seed, size_t steps, const std::function<size_t(Random&)>& change, const std::function<bool()>& check)
+{
+	Random random(seed);
+	for (size_t step = 0; step < steps; ++step) {
+		const size_t action = change(random);
+		BOOST_REQUIRE_MESSAGE(check(), "went wrong at step " << step << ", action " << action);
+	}
+}
+
+#endif
@@ -32,43 +32,71 @@ extern MoveEvents* g_moveEvents;
 StaticTile real_nullptr_tile(0xFFFF, 0xFFFF, 0xFF);
 Tile& Tile::nullptr_tile = real_nullptr_tile;
 
-bool Tile::hasProperty(ITEMPROPERTY prop) const
+static_assert(CONST_PROP_UNLAY < 16, "Tile::properties has a bit per item property");
+
+bool Tile::hasProperty(const Item* exclude, ITEMPROPERTY prop) const
 {
-	if (ground && ground->hasProperty(prop)) {
+	assert(exclude);
+
+	if (!hasProperty(prop)) {
+		return false;
+	}
+
+	if (ground && exclude != ground && ground->hasProperty(prop)) {
 		return true;
 	}
 
 	if (const TileItemVector* items = getItemList()) {
 		for (const Item* item : *items) {
-			if (item->hasProperty(prop)) {
+			if (item != exclude && item->hasProperty(prop)) {
 				return true;
 			}
 		}
 	}
+
 	return false;
 }
 
-bool Tile::hasProperty(const Item* exclude, ITEMPROPERTY prop) const
+bool Tile::checkProperties() const
 {
-	assert(exclude);
+	for (uint8_t prop = CONST_PROP_BLOCKSOLID; prop <= CONST_PROP_UNLAY; ++prop) {
+		bool found = ground && ground->hasProperty(static_cast<ITEMPROPERTY>(prop));
+		if (const TileItemVector* items = getItemList()) {
+			for (const Item* item : *items) {
+				found = found || item->hasProperty(static_cast<ITEMPROPERTY>(prop));
+			}
+		}
 
-	if (ground && exclude != ground && ground->hasProperty(prop)) {
-		return true;
+		if (found != hasProperty(static_cast<ITEMPROPERTY>(prop))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void Tile::updateProperties(const Item* exclude)
+{
+	uint16_t mask = 0;
+	if (ground && ground != exclude) {
+		mask |= Item::items.getHot(ground->getID()).properties;
 	}
 
 	if (const TileItemVector* items = getItemList()) {
 		for (const Item* item : *items) {
-			if (item != exclude && item->hasProperty(prop)) {
-				return true;
+			if (item != exclude) {
+				mask |= Item::items.getHot(item->getID()).properties;
 			}
 		}
 	}
-
-	return false;
+	properties = mask;
 }
 
 bool Tile::hasHeight(uint32_t n) const
 {
+	if (n != 0 && !hasProperty(CONST_PROP_HASHEIGHT)) {
+		return false;
+	}
+
 	uint32_t height = 0;
 
 	if (ground) {
@@ -309,7 +337,7 @@ Item* Tile::getItemByTopOrder(int32_t topOrder)
 	//4: creatures
 	if (TileItemVector* items = getItemList()) {
 		for (auto it = ItemVector::const_reverse_iterator(items->getEndTopItem()), end = ItemVector::const_reverse_iterator(items->getBeginTopItem()); it != end; ++it) {
-			if (Item::items[(*it)->getID()].alwaysOnTopOrder == topOrder) {
+			if (Item::items.getHot((*it)->getID()).alwaysOnTopOrder == topOrder) {
 				return (*it);
 			}
 		}
@@ -542,17 +570,13 @@ ReturnValue Tile::queryAdd(int32_t, const Thing& thing, uint32_t, uint32_t flags
 			}
 		} else {
 			//FLAG_IGNOREBLOCKITEM is set
-			if (ground) {
-				const ItemType& iiType = Item::items[ground->getID()];
-				if (iiType.blockSolid) {
-					return RETURNVALUE_NOTPOSSIBLE;
-				}
+			if (ground && ground->hasProperty(CONST_PROP_BLOCKSOLID)) {
+				return RETURNVALUE_NOTPOSSIBLE;
 			}
 
 			if (const auto items = getItemList()) {
 				for (const Item* item : *items) {
-					const ItemType& iiType = Item::items[item->getID()];
-					if (iiType.blockSolid && !iiType.moveable) {
+					if (item->hasProperty(CONST_PROP_IMMOVABLEBLOCKSOLID)) {
 						return RETURNVALUE_NOTPOSSIBLE;
 					}
 				}
@@ -596,14 +620,14 @@ ReturnValue Tile::queryAdd(int32_t, const Thing& thing, uint32_t, uint32_t flags
 			}
 		} else {
 			if (ground) {
-				const ItemType& iiType = Item::items[ground->getID()];
-				if (iiType.blockSolid) {
-					if (!iiType.allowPickupable || item->isMagicField() || item->isBlocking()) {
+				const ItemTypeHot& groundType = Item::items.getHot(ground->getID());
+				if (groundType.hasProperty(CONST_PROP_BLOCKSOLID)) {
+					if (!groundType.hasFlag(ITEMTYPE_ALLOWPICKUPABLE) || item->isMagicField() || item->isBlocking()) {
 						if (!item->isPickupable()) {
 							return RETURNVALUE_NOTENOUGHROOM;
 						}
 
-						if (!iiType.hasHeight || iiType.pickupable || iiType.isBed()) {
+						if (!groundType.hasProperty(CONST_PROP_HASHEIGHT) || groundType.hasFlag(ITEMTYPE_PICKUPABLE) || Item::items[ground->getID()].isBed()) {
 							return RETURNVALUE_NOTENOUGHROOM;
 						}
 					}
@@ -612,12 +636,12 @@ ReturnValue Tile::queryAdd(int32_t, const Thing& thing, uint32_t, uint32_t flags
 
 			if (items) {
 				for (const Item* tileItem : *items) {
-					const ItemType& iiType = Item::items[tileItem->getID()];
-					if (!iiType.blockSolid) {
+					const ItemTypeHot& tileItemType = Item::items.getHot(tileItem->getID());
+					if (!tileItemType.hasProperty(CONST_PROP_BLOCKSOLID)) {
 						continue;
 					}
 
-					if (iiType.allowPickupable && !item->isMagicField() && !item->isBlocking()) {
+					if (tileItemType.hasFlag(ITEMTYPE_ALLOWPICKUPABLE) && !item->isMagicField() && !item->isBlocking()) {
 						continue;
 					}
 
@@ -625,7 +649,7 @@ ReturnValue Tile::queryAdd(int32_t, const Thing& thing, uint32_t, uint32_t flags
 						return RETURNVALUE_NOTENOUGHROOM;
 					}
 
-					if (!iiType.hasHeight || iiType.pickupable || iiType.isBed()) {
+					if (!tileItemType.hasProperty(CONST_PROP_HASHEIGHT) || tileItemType.hasFlag(ITEMTYPE_PICKUPABLE) || Item::items[tileItem->getID()].isBed()) {
 						return RETURNVALUE_NOTENOUGHROOM;
 					}
 				}
@@ -739,7 +763,7 @@ void Tile::addThing(int32_t, Thing* thing)
 			if (items) {
 				for (auto it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end; ++it) {
 					//Note: this is different from internalAddThing
-					if (itemType.alwaysOnTopOrder <= Item::items[(*it)->getID()].alwaysOnTopOrder) {
+					if (itemType.alwaysOnTopOrder <= Item::items.getHot((*it)->getID()).alwaysOnTopOrder) {
 						items->insert(it, item);
 						isInserted = true;
 						break;
@@ -1084,6 +1108,45 @@ int32_t Tile::getStackposOfCreature(const Player* player, const Creature* creatu
 	return -1;
 }
 
+int32_t Tile::getClientIndexOfCreature(const Creature* creature, bool& perViewer) const
+{
+	int32_t n;
+	if (ground) {
+		n = 1;
+	} else {
+		n = 0;
+	}
+
+	const TileItemVector* items = getItemList();
+	if (items) {
+		n += items->getTopItemCount();
+	}
+
+	perViewer = false;
+	if (const CreatureVector* creatures = getCreatures()) {
+		for (const Creature* c : boost::adaptors::reverse(*creatures)) {
+			if (c == creature) {
+				return n;
+			}
+
+			if (c->isInGhostMode() || (!c->getPlayer() && c->isInvisible())) {
+				perViewer = true;
+			}
+			++n;
+		}
+	}
+	return -1;
+}
+
+int32_t Tile::getStackposOfCreature(const Creature* creature, bool& perViewer) const
+{
+	int32_t n = getClientIndexOfCreature(creature, perViewer);
+	if (n >= 10) {
+		return -1;
+	}
+	return n;
+}
+
 int32_t Tile::getStackposOfItem(const Player* player, const Item* item) const
 {
 	int32_t n = 0;
@@ -1306,7 +1369,7 @@ void Tile::internalAddThing(uint32_t, Thing* thing)
 		if (itemType.alwaysOnTop) {
 			bool isInserted = false;
 			for (auto it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end; ++it) {
-				if (Item::items[(*it)->getID()].alwaysOnTopOrder > itemType.alwaysOnTopOrder) {
+				if (Item::items.getHot((*it)->getID()).alwaysOnTopOrder > itemType.alwaysOnTopOrder) {
 					items->insert(it, item);
 					isInserted = true;
 					break;
@@ -1327,6 +1390,8 @@ void Tile::internalAddThing(uint32_t, Thing* thing)
 
 void Tile::setTileFlags(const Item* item)
 {
+	properties |= Item::items.getHot(item->getID()).properties;
+
 	if (item->hasProperty(CONST_PROP_IMMOVABLEBLOCKSOLID)) {
 		setFlag(TILESTATE_IMMOVABLEBLOCKSOLID);
 	}
@@ -1387,27 +1452,29 @@ void Tile::setTileFlags(const Item* item)
 
 void Tile::resetTileFlags(const Item* item)
 {
-	if (item->hasProperty(CONST_PROP_BLOCKSOLID) && !hasProperty(item, CONST_PROP_BLOCKSOLID)) {
+	updateProperties(item);
+
+	if (item->hasProperty(CONST_PROP_BLOCKSOLID) && !hasProperty(CONST_PROP_BLOCKSOLID)) {
 		resetFlag(TILESTATE_BLOCKSOLID);
 	}
 
-	if (item->hasProperty(CONST_PROP_IMMOVABLEBLOCKSOLID) && !hasProperty(item, CONST_PROP_IMMOVABLEBLOCKSOLID)) {
+	if (item->hasProperty(CONST_PROP_IMMOVABLEBLOCKSOLID) && !hasProperty(CONST_PROP_IMMOVABLEBLOCKSOLID)) {
 		resetFlag(TILESTATE_IMMOVABLEBLOCKSOLID);
 	}
 
-	if (item->hasProperty(CONST_PROP_BLOCKPATH) && !hasProperty(item, CONST_PROP_BLOCKPATH)) {
+	if (item->hasProperty(CONST_PROP_BLOCKPATH) && !hasProperty(CONST_PROP_BLOCKPATH)) {
 		resetFlag(TILESTATE_BLOCKPATH);
 	}
 
-	if (item->hasProperty(CONST_PROP_NOFIELDBLOCKPATH) && !hasProperty(item, CONST_PROP_NOFIELDBLOCKPATH)) {
+	if (item->hasProperty(CONST_PROP_NOFIELDBLOCKPATH) && !hasProperty(CONST_PROP_NOFIELDBLOCKPATH)) {
 		resetFlag(TILESTATE_NOFIELDBLOCKPATH);
 	}
 
-	if (item->hasProperty(CONST_PROP_IMMOVABLEBLOCKPATH) && !hasProperty(item, CONST_PROP_IMMOVABLEBLOCKPATH)) {
+	if (item->hasProperty(CONST_PROP_IMMOVABLEBLOCKPATH) && !hasProperty(CONST_PROP_IMMOVABLEBLOCKPATH)) {
 		resetFlag(TILESTATE_IMMOVABLEBLOCKPATH);
 	}
 
-	if (item->hasProperty(CONST_PROP_IMMOVABLENOFIELDBLOCKPATH) && !hasProperty(item, CONST_PROP_IMMOVABLENOFIELDBLOCKPATH)) {
+	if (item->hasProperty(CONST_PROP_IMMOVABLENOFIELDBLOCKPATH) && !hasProperty(CONST_PROP_IMMOVABLENOFIELDBLOCKPATH)) {
 		resetFlag(TILESTATE_IMMOVABLENOFIELDBLOCKPATH);
 	}
 
@@ -22,6 +22,7 @@
 #include "tools.h"
 
 class Creature;
+class House;
 class Teleport;
 class Mailbox;
 class MagicField;
@@ -161,6 +162,17 @@ class Tile : public Cylinder
 			return false;
 		}
 
+		Tile* getTile() final {
+			return this;
+		}
+		const Tile* getTile() const final {
+			return this;
+		}
+
+		virtual House* getHouse() {
+			return nullptr;
+		}
+
 		MagicField* getFieldItem() const;
 		Teleport* getTeleportItem() const;
 		Mailbox* getMailbox() const;
@@ -189,8 +201,11 @@ class Tile : public Cylinder
 		uint32_t getTopItemCount() const;
 		uint32_t getDownItemCount() const;
 
-		bool hasProperty(ITEMPROPERTY prop) const;
+		bool hasProperty(ITEMPROPERTY prop) const {
+			return (properties & (1U << prop)) != 0;
+		}
 		bool hasProperty(const Item* exclude, ITEMPROPERTY prop) const;
+		bool checkProperties() const;
 
 		inline bool hasFlag(uint32_t flag) const {
 			return hasBitSet(flag, this->flags);
@@ -220,6 +235,11 @@ class Tile : public Cylinder
 
 		int32_t getClientIndexOfCreature(const Player* player, const Creature* creature) const;
 		int32_t getStackposOfCreature(const Player* player, const Creature* creature) const;
+		// what every player that can see all creatures on the tile gets, perViewer
+		// is set when a ghost or invisible creature stands in front of it and the
+		// player overloads have to be asked for each spectator instead
+		int32_t getClientIndexOfCreature(const Creature* creature, bool& perViewer) const;
+		int32_t getStackposOfCreature(const Creature* creature, bool& perViewer) const;
 		int32_t getStackposOfItem(const Player* player, const Item* item) const;
 
 		//cylinder implementations
@@ -277,11 +297,13 @@ class Tile : public Cylinder
 
 		void setTileFlags(const Item* item);
 		void resetTileFlags(const Item* item);
+		void updateProperties(const Item* exclude);
 
 	protected:
 		Item* ground = nullptr;
 		Position tilePos;
 		uint32_t flags = 0;
+		uint16_t properties = 0; // a bit per ITEMPROPERTY any item on the tile has
 };
 
 // Used for walkable tiles, where there is high likeliness of
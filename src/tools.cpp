@@ -332,14 +332,15 @@ IntegerVec vectorAtoi(const StringVec& stringVector)
 
 std::mt19937& getRandomGenerator()
 {
-	static std::random_device rd;
-	static std::mt19937 generator(rd());
+	// items are also created on the database workers while players load,
+	// so every thread draws from its own generator
+	thread_local std::mt19937 generator(std::random_device{}());
 	return generator;
 }
 
 int32_t uniform_random(int32_t minNumber, int32_t maxNumber)
 {
-	static std::uniform_int_distribution<int32_t> uniformRand;
+	thread_local std::uniform_int_distribution<int32_t> uniformRand;
 	if (minNumber == maxNumber) {
 		return minNumber;
 	} else if (minNumber > maxNumber) {
@@ -350,7 +351,7 @@ int32_t uniform_random(int32_t minNumber, int32_t maxNumber)
 
 int32_t normal_random(int32_t minNumber, int32_t maxNumber)
 {
-	static std::normal_distribution<float> normalRand(0.5f, 0.25f);
+	thread_local std::normal_distribution<float> normalRand(0.5f, 0.25f);
 	if (minNumber == maxNumber) {
 		return minNumber;
 	} else if (minNumber > maxNumber) {
@@ -372,7 +373,7 @@ int32_t normal_random(int32_t minNumber, int32_t maxNumber)
 
 bool boolean_random(double probability/* = 0.5*/)
 {
-	static std::bernoulli_distribution booleanRand;
+	thread_local std::bernoulli_distribution booleanRand;
 	return booleanRand(getRandomGenerator(), std::bernoulli_distribution::param_type(probability));
 }
 
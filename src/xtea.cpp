@@ -0,0 +1,321 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+#include "otpch.h"
+
+#include "xtea.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XTEA_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define XTEA_HAS_AVX2
+#define XTEA_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define XTEA_HAS_AVX2
+#define XTEA_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace xtea {
+
+namespace {
+
+constexpr uint32_t delta = 0x61C88647;
+
+void encryptScalar(uint8_t* data, size_t length, const round_keys& k)
+{
+	for (size_t pos = 0; pos < length; pos += 8) {
+		uint32_t v0, v1;
+		memcpy(&v0, data + pos, 4);
+		memcpy(&v1, data + pos + 4, 4);
+
+		for (int32_t i = 0; i < 64; i += 2) {
+			v0 += ((v1 << 4 ^ v1 >> 5) + v1) ^ k[i];
+			v1 += ((v0 << 4 ^ v0 >> 5) + v0) ^ k[i + 1];
+		}
+
+		memcpy(data + pos, &v0, 4);
+		memcpy(data + pos + 4, &v1, 4);
+	}
+}
+
+void decryptScalar(uint8_t* data, size_t length, const round_keys& k)
+{
+	for (size_t pos = 0; pos < length; pos += 8) {
+		uint32_t v0, v1;
+		memcpy(&v0, data + pos, 4);
+		memcpy(&v1, data + pos + 4, 4);
+
+		for (int32_t i = 64; i > 0; i -= 2) {
+			v1 -= ((v0 << 4 ^ v0 >> 5) + v0) ^ k[i - 1];
+			v0 -= ((v1 << 4 ^ v1 >> 5) + v1) ^ k[i - 2];
+		}
+
+		memcpy(data + pos, &v0, 4);
+		memcpy(data + pos + 4, &v1, 4);
+	}
+}
+
+/*
+ * The vector kernels load interleaved blocks (v0 v1 v0 v1 ...) and split
+ * them into one register of v0 words and one of v1 words. Shuffling with
+ * (3, 1, 2, 0) swaps the middle words of each 128-bit lane, and is its own
+ * inverse, so the same steps in reverse order restore the block layout.
+ */
+
+#ifdef XTEA_HAS_SSE2
+// 4 blocks (32 bytes) per iteration, returns the number of bytes processed
+size_t encryptSSE2(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t pos = 0;
+	for (; pos + 32 <= length; pos += 32) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 16));
+		a = _mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0));
+		b = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i v0 = _mm_unpacklo_epi64(a, b);
+		__m128i v1 = _mm_unpackhi_epi64(a, b);
+
+		for (int32_t i = 0; i < 64; i += 2) {
+			__m128i f = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v1, 4), _mm_srli_epi32(v1, 5)), v1);
+			v0 = _mm_add_epi32(v0, _mm_xor_si128(f, _mm_set1_epi32(k[i])));
+			f = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v0, 4), _mm_srli_epi32(v0, 5)), v0);
+			v1 = _mm_add_epi32(v1, _mm_xor_si128(f, _mm_set1_epi32(k[i + 1])));
+		}
+
+		a = _mm_shuffle_epi32(_mm_unpacklo_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));
+		b = _mm_shuffle_epi32(_mm_unpackhi_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(data + pos), a);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(data + pos + 16), b);
+	}
+	return pos;
+}
+
+size_t decryptSSE2(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t pos = 0;
+	for (; pos + 32 <= length; pos += 32) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 16));
+		a = _mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0));
+		b = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i v0 = _mm_unpacklo_epi64(a, b);
+		__m128i v1 = _mm_unpackhi_epi64(a, b);
+
+		for (int32_t i = 64; i > 0; i -= 2) {
+			__m128i f = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v0, 4), _mm_srli_epi32(v0, 5)), v0);
+			v1 = _mm_sub_epi32(v1, _mm_xor_si128(f, _mm_set1_epi32(k[i - 1])));
+			f = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v1, 4), _mm_srli_epi32(v1, 5)), v1);
+			v0 = _mm_sub_epi32(v0, _mm_xor_si128(f, _mm_set1_epi32(k[i - 2])));
+		}
+
+		a = _mm_shuffle_epi32(_mm_unpacklo_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));
+		b = _mm_shuffle_epi32(_mm_unpackhi_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(data + pos), a);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(data + pos + 16), b);
+	}
+	return pos;
+}
+#endif
+
+#ifdef XTEA_HAS_AVX2
+// 8 blocks (64 bytes) per iteration, returns the number of bytes processed
+XTEA_TARGET_AVX2 size_t encryptAVX2(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t pos = 0;
+	for (; pos + 64 <= length; pos += 64) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 32));
+		a = _mm256_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0));
+		b = _mm256_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0));
+		__m256i v0 = _mm256_unpacklo_epi64(a, b);
+		__m256i v1 = _mm256_unpackhi_epi64(a, b);
+
+		for (int32_t i = 0; i < 64; i += 2) {
+			__m256i f = _mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v1, 4), _mm256_srli_epi32(v1, 5)), v1);
+			v0 = _mm256_add_epi32(v0, _mm256_xor_si256(f, _mm256_set1_epi32(k[i])));
+			f = _mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v0, 4), _mm256_srli_epi32(v0, 5)), v0);
+			v1 = _mm256_add_epi32(v1, _mm256_xor_si256(f, _mm256_set1_epi32(k[i + 1])));
+		}
+
+		a = _mm256_shuffle_epi32(_mm256_unpacklo_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));
+		b = _mm256_shuffle_epi32(_mm256_unpackhi_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(data + pos), a);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(data + pos + 32), b);
+	}
+	return pos;
+}
+
+XTEA_TARGET_AVX2 size_t decryptAVX2(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t pos = 0;
+	for (; pos + 64 <= length; pos += 64) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 32));
+		a = _mm256_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0));
+		b = _mm256_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0));
+		__m256i v0 = _mm256_unpacklo_epi64(a, b);
+		__m256i v1 = _mm256_unpackhi_epi64(a, b);
+
+		for (int32_t i = 64; i > 0; i -= 2) {
+			__m256i f = _mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v0, 4), _mm256_srli_epi32(v0, 5)), v0);
+			v1 = _mm256_sub_epi32(v1, _mm256_xor_si256(f, _mm256_set1_epi32(k[i - 1])));
+			f = _mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v1, 4), _mm256_srli_epi32(v1, 5)), v1);
+			v0 = _mm256_sub_epi32(v0, _mm256_xor_si256(f, _mm256_set1_epi32(k[i - 2])));
+		}
+
+		a = _mm256_shuffle_epi32(_mm256_unpacklo_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));
+		b = _mm256_shuffle_epi32(_mm256_unpackhi_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(data + pos), a);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(data + pos + 32), b);
+	}
+	return pos;
+}
+
+bool detectAVX2()
+{
+#if defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#else
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+
+	__cpuid(info, 1);
+	// OSXSAVE and AVX, then make sure the OS saves the YMM registers
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#endif
+}
+
+const bool hasAVX2 = detectAVX2();
+#endif
+
+}
+
+round_keys expand_key(const key& k)
+{
+	round_keys expanded;
+	uint32_t sum = 0;
+	for (size_t i = 0; i < expanded.size(); i += 2) {
+		expanded[i] = sum + k[sum & 3];
+		sum -= delta;
+		expanded[i + 1] = sum + k[(sum >> 11) & 3];
+	}
+	return expanded;
+}
+
+void encrypt(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t pos = 0;
+#ifdef XTEA_HAS_AVX2
+	if (hasAVX2) {
+		pos = encryptAVX2(data, length, k);
+	}
+#endif
+#ifdef XTEA_HAS_SSE2
+	pos += encryptSSE2(data + pos, length - pos, k);
+#endif
+	encryptScalar(data + pos, length - pos, k);
+}
+
+void decrypt(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t pos = 0;
+#ifdef XTEA_HAS_AVX2
+	if (hasAVX2) {
+		pos = decryptAVX2(data, length, k);
+	}
+#endif
+#ifdef XTEA_HAS_SSE2
+	pos += decryptSSE2(data + pos, length - pos, k);
+#endif
+	decryptScalar(data + pos, length - pos, k);
+}
+
+bool is_supported(implementation impl)
+{
+	switch (impl) {
+		case SCALAR:
+			return true;
+#ifdef XTEA_HAS_SSE2
+		case SSE2:
+			return true;
+#endif
+#ifdef XTEA_HAS_AVX2
+		case AVX2:
+			return hasAVX2;
+#endif
+		default:
+			return false;
+	}
+}
+
+void encrypt(uint8_t* data, size_t length, const round_keys& k, implementation impl)
+{
+	size_t pos = 0;
+	switch (impl) {
+#ifdef XTEA_HAS_SSE2
+		case SSE2:
+			pos = encryptSSE2(data, length, k);
+			break;
+#endif
+#ifdef XTEA_HAS_AVX2
+		case AVX2:
+			if (hasAVX2) {
+				pos = encryptAVX2(data, length, k);
+			}
+			break;
+#endif
+		default:
+			break;
+	}
+	encryptScalar(data + pos, length - pos, k);
+}
+
+void decrypt(uint8_t* data, size_t length, const round_keys& k, implementation impl)
+{
+	size_t pos = 0;
+	switch (impl) {
+#ifdef XTEA_HAS_SSE2
+		case SSE2:
+			pos = decryptSSE2(data, length, k);
+			break;
+#endif
+#ifdef XTEA_HAS_AVX2
+		case AVX2:
+			if (hasAVX2) {
+				pos = decryptAVX2(data, length, k);
+			}
+			break;
+#endif
+		default:
+			break;
+	}
+	decryptScalar(data + pos, length - pos, k);
+}
+
+}
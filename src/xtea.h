@@ -0,0 +1,49 @@
+/*
+ * YurOTS, a free game server emulator 
+ * Official Repository on Github <https://github.com/RafaelTolomeotti/yurOTS-Tibinha>
+ * Copyright (C) 2024 - RafaelTolomeotti <https://github.com/RafaelTolomeotti>
+ * A fork of The Forgotten Server(Mark Samman) branch 1.2 and part of Nostalrius(Alejandro Mujica) repositories.
+ *
+ * The MIT License (MIT). Copyright © 2020 <YurOTS>
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+*/
+
+#ifndef FS_XTEA_H_64BD889C8F4F46289A4D080CC75E13AA
+#define FS_XTEA_H_64BD889C8F4F46289A4D080CC75E13AA
+
+#include <array>
+
+namespace xtea {
+
+typedef std::array<uint32_t, 4> key;
+typedef std::array<uint32_t, 64> round_keys;
+
+// Precomputes (sum + k[...]) for each of the 32 rounds, so the per-block
+// loop does not depend on the key layout and all lanes share one schedule.
+round_keys expand_key(const key& k);
+
+// Both functions work in place on a buffer whose length is a multiple of 8.
+// Blocks are independent, so several of them are processed at once when the
+// CPU supports it (SSE2/AVX2), otherwise the scalar loop is used.
+void encrypt(uint8_t* data, size_t length, const round_keys& k);
+void decrypt(uint8_t* data, size_t length, const round_keys& k);
+
+// The same with one implementation forced, so the tests can compare them.
+// The blocks the vector kernel leaves over go through the scalar loop.
+enum implementation {
+	SCALAR,
+	SSE2,
+	AVX2,
+};
+
+bool is_supported(implementation impl);
+void encrypt(uint8_t* data, size_t length, const round_keys& k, implementation impl);
+void decrypt(uint8_t* data, size_t length, const round_keys& k, implementation impl);
+
+}
+
+#endif